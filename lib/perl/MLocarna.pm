@@ -36,6 +36,7 @@ our @EXPORT      =
         clone_hash
         compute_alignment_from_seqs
         compute_alignment_score
+        complete_score_matrix
         constraint_annotation_is_valid_or_die
         constrain_sequences_from_reliable_structures
         convert_alifold_dp_to_pp
@@ -47,6 +48,8 @@ our @EXPORT      =
         find_in_exec_path_or_error
         forget_normalized_seqnames
         get_normalized_seqname
+        guide_tree_pairs
+        kmer_similarity_matrix
         loh_names
         loh_sort
         new_intermediate_name
@@ -2451,6 +2454,9 @@ sub get_alignment_edges($$)
 ## returns ref to 2D-array of scores (symmetric),
 ##         indices are positions in name string
 ##
+## Entries of pairs without alignment stay undefined (see
+## complete_score_matrix).
+##
 ########################################
 sub extract_score_matrix_from_alignments {
     my ($names,$pairwise_alns_ref) = @_;
@@ -2463,6 +2469,8 @@ sub extract_score_matrix_from_alignments {
 	$score_matrix[$a][$a] = 0; ## set diagonal to 0
 	for (my $b=0; $b<$a; $b++) {
 
+	    next unless defined $pairwise_alns[$a][$b];
+
 	    my @aln = @{ $pairwise_alns[$a][$b] };
 
 	    $aln[0] =~ /Score: (\S+)/ || die "Cannot extract score for sequence $a vs. $b.\n";
@@ -2482,6 +2490,184 @@ sub extract_score_matrix_from_alignments {
 }
 
 
+########################################
+## kmer_similarity_matrix($seqs,$k)
+##
+## compute cheap sequence similarities of all pairs of sequences
+##
+## arg $seqs  ref to list of sequences (hashes with entry seq)
+## arg $k     length of the k-mers
+##
+## The similarity of two sequences is the number of their shared
+## k-mers (counted with multiplicity) divided by the number of k-mers
+## in the shorter sequence. Shared k-mers are counted via an index of
+## the k-mer occurrences, such that sequence pairs are only touched
+## for k-mers that they share.
+##
+## returns ref to 2D-array of similarities between 0 and 1
+## (symmetric), indices are positions in the list of sequences
+##
+########################################
+sub kmer_similarity_matrix {
+    my ($seqs,$k) = @_;
+
+    my $n = int(@$seqs);
+
+    my %occurrences; ## k-mer -> list of [ sequence index, count ]
+    my @num_kmers;   ## number of k-mers per sequence
+
+    for (my $a=0; $a<$n; $a++) {
+	my $seq = uc($seqs->[$a]->{seq});
+	$seq =~ tr/T/U/;
+	$seq =~ s/[^A-Z]//g; ## remove gaps and other non-letters
+
+	my %counts;
+	for (my $i=0; $i+$k<=length($seq); $i++) {
+	    $counts{substr($seq,$i,$k)}++;
+	}
+	$num_kmers[$a] = length($seq)-$k+1;
+
+	while (my ($kmer,$count) = each %counts) {
+	    push @{ $occurrences{$kmer} }, [ $a, $count ];
+	}
+    }
+
+    ## count shared k-mers
+    my @shared;
+    for (my $a=0; $a<$n; $a++) {
+	$shared[$a] = [ (0) x $n ];
+    }
+    foreach my $occ (values %occurrences) {
+	for (my $x=0; $x<@$occ; $x++) {
+	    my ($a,$count_a) = @{ $occ->[$x] };
+	    for (my $y=0; $y<$x; $y++) {
+		my ($b,$count_b) = @{ $occ->[$y] };
+		$shared[$a][$b] += min($count_a,$count_b);
+	    }
+	}
+    }
+
+    my @similarity;
+    for (my $a=0; $a<$n; $a++) {
+	$similarity[$a][$a] = 1;
+	for (my $b=0; $b<$a; $b++) {
+	    my $denom = min($num_kmers[$a],$num_kmers[$b]);
+	    my $sim = ($denom>0) ? ($shared[$a][$b] + $shared[$b][$a]) / $denom : 0;
+	    $similarity[$a][$b] = $sim;
+	    $similarity[$b][$a] = $sim;
+	}
+    }
+
+    return \@similarity;
+}
+
+########################################
+## guide_tree_pairs($similarity,$neighbors,$samples)
+##
+## select the sequence pairs that are aligned for the guide tree
+##
+## arg $similarity  ref to 2D-array of (cheap) similarities
+## arg $neighbors   number of most similar sequences per sequence
+## arg $samples     number of additional pairs, which are drawn at random
+##
+## The random pairs cover distant sequences and allow relating the
+## scores of the selected pairs to the similarities (see
+## complete_score_matrix). The sample is reproducible.
+##
+## returns list of pairs [$a,$b] with $a>$b
+##
+########################################
+sub guide_tree_pairs {
+    my ($similarity,$neighbors,$samples) = @_;
+
+    my $n = int(@$similarity);
+
+    my %selected;
+
+    for (my $i=0; $i<$n; $i++) {
+	my $row = $similarity->[$i];
+	my @others = sort { $row->[$b] <=> $row->[$a] || $a <=> $b }
+	    grep { $_ != $i } 0..$n-1;
+
+	foreach my $j (@others[0..min($neighbors,$#others+1)-1]) {
+	    $selected{ ($i>$j) ? "$i $j" : "$j $i" } = 1;
+	}
+    }
+
+    my $num_pairs = $n*($n-1)/2;
+    srand(1);
+    for (my $k=0; $k<$samples && keys(%selected)<$num_pairs; ) {
+	my $i = int(rand($n));
+	my $j = int(rand($n));
+	next if $i==$j;
+	my $key = ($i>$j) ? "$i $j" : "$j $i";
+	next if exists $selected{$key};
+	$selected{$key} = 1;
+	$k++;
+    }
+
+    return sort { $a->[0] <=> $b->[0] || $a->[1] <=> $b->[1] }
+	map { [ split / /, $_ ] } keys %selected;
+}
+
+########################################
+## complete_score_matrix($score_matrix,$similarity)
+##
+## estimate missing scores from cheap similarities
+##
+## arg $score_matrix  ref to 2D-array of scores (symmetric), where
+##                    scores of pairs that were not aligned are undefined
+## arg $similarity    ref to 2D-array of (cheap) similarities
+##
+## Fits the scores of the aligned pairs as linear function of the
+## similarities (least squares) and fills the missing entries by this
+## function. Scores of failed alignments (-inf) are not used for the
+## fit.
+##
+## modifies $score_matrix
+##
+########################################
+sub complete_score_matrix {
+    my ($score_matrix,$similarity) = @_;
+
+    my $n = int(@$similarity);
+
+    my ($num,$sum_x,$sum_y,$sum_xx,$sum_xy) = (0,0,0,0,0);
+
+    for (my $a=0; $a<$n; $a++) {
+	for (my $b=0; $b<$a; $b++) {
+	    my $y = $score_matrix->[$a][$b];
+	    next if !defined($y) || $y <= -1e8;
+	    my $x = $similarity->[$a][$b];
+	    $num++;
+	    $sum_x += $x;
+	    $sum_y += $y;
+	    $sum_xx += $x*$x;
+	    $sum_xy += $x*$y;
+	}
+    }
+
+    my $slope = 0;
+    my $intercept = ($num>0) ? $sum_y/$num : 0;
+    my $var = $num*$sum_xx - $sum_x*$sum_x;
+    if ($num>1 && $var>0) {
+	$slope = ($num*$sum_xy - $sum_x*$sum_y) / $var;
+	$intercept = ($sum_y - $slope*$sum_x) / $num;
+    }
+
+    for (my $a=0; $a<$n; $a++) {
+	$score_matrix->[$a][$a] = 0 unless defined $score_matrix->[$a][$a];
+	for (my $b=0; $b<$a; $b++) {
+	    next if defined $score_matrix->[$a][$b];
+	    my $score = sprintf("%.0f", $intercept + $slope*$similarity->[$a][$b]);
+	    $score_matrix->[$a][$b] = $score;
+	    $score_matrix->[$b][$a] = $score;
+	}
+    }
+
+    return;
+}
+
 ########################################
 ## compute reliability of an alignment as reliability for the best structure
 sub aln_reliability_beststruct_fromfile {
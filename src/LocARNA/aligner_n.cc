@@ -3,6 +3,7 @@
 
 #include "aligner_n.hh"
 #include "anchor_constraints.hh"
+#include "parallel.hh"
 #include "trace_controller.hh"
 // #include "d_matrix.hh"
 
@@ -39,9 +40,7 @@ namespace LocARNA {
           IBmat(a.IBmat),
           IADmat(a.IADmat),
           IBDmat(a.IBDmat),
-          Emat(a.Emat),
-          Fmat(a.Fmat),
-          M(a.M),
+          mef_(a.mef_),
           gapCostMatA(a.gapCostMatA),
           gapCostMatB(a.gapCostMatB),
           min_i(a.min_i),
@@ -85,11 +84,7 @@ namespace LocARNA {
         IBDmat.resize(bpsA.num_bps(), bpsB.num_bps());
         IBDmat.fill(infty_score_t::neg_infty);
 
-        M.resize(mapperA.get_max_info_vec_size() + 1,
-                 mapperB.get_max_info_vec_size() + 1);
-        Emat.resize(mapperA.get_max_info_vec_size() + 1,
-                    mapperB.get_max_info_vec_size() + 1);
-        Fmat.resize(mapperA.get_max_info_vec_size() + 1,
+        mef_.resize(mapperA.get_max_info_vec_size() + 1,
                     mapperB.get_max_info_vec_size() + 1);
 
         gapCostMatA.resize(seqA.length() + 3, seqA.length() + 3);
@@ -222,8 +217,11 @@ namespace LocARNA {
                               matidx_t j_index,
                               seq_pos_t i_seq_pos,
                               seq_pos_t i_prev_seq_pos,
+                              const MEFMatrices &mef,
                               ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef.M;
+        const ScoreMatrix &Emat = mef.E;
 
         bool constraints_aligned_pos_A = false; // TOcheck: Probably
                                                 // unnecessary, constraints are
@@ -250,8 +248,11 @@ namespace LocARNA {
                               matidx_t j_index,
                               seq_pos_t j_seq_pos,
                               seq_pos_t j_prev_seq_pos,
+                              const MEFMatrices &mef,
                               ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef.M;
+        const ScoreMatrix &Fmat = mef.F;
 
         bool constraints_aligned_pos_B = false;
         // TOcheck: Probably unnecessary, constraints are not considered
@@ -276,8 +277,12 @@ namespace LocARNA {
                               index_t bl,
                               matidx_t i_index,
                               matidx_t j_index,
+                              MEFMatrices &mef,
                               ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef.M;
+        ScoreMatrix &Emat = mef.E;
+        ScoreMatrix &Fmat = mef.F;
 
         bool constraints_alowed_edge = true;
         // constraints are ignored,
@@ -330,14 +335,14 @@ namespace LocARNA {
 
         // base del, for efficiency compute_E/F entry invoked within
         // compute_M_entry
-        Emat(i_index, j_index) = compute_E_entry(al, i_index, j_index,
-                                                 i_seq_pos, i_prev_seq_pos, sv);
+        Emat(i_index, j_index) = compute_E_entry(
+            al, i_index, j_index, i_seq_pos, i_prev_seq_pos, mef, sv);
         max_score =
             std::max(max_score, (tainted_infty_score_t)Emat(i_index, j_index));
 
         // base ins
-        Fmat(i_index, j_index) = compute_F_entry(bl, i_index, j_index,
-                                                 j_seq_pos, j_prev_seq_pos, sv);
+        Fmat(i_index, j_index) = compute_F_entry(
+            bl, i_index, j_index, j_seq_pos, j_prev_seq_pos, mef, sv);
         max_score =
             std::max(max_score, (tainted_infty_score_t)Fmat(i_index, j_index));
 
@@ -431,6 +436,217 @@ namespace LocARNA {
         return max_score;
     }
 
+    // Compute all entries of the matrices M, E and F row by row
+    template <class ScoringView>
+    void
+    AlignerN::fill_M_rows(index_t al,
+                          index_t bl,
+                          MEFMatrices &mef,
+                          ScoringView sv) {
+        const Scoring *scoring = sv.scoring();
+        M_matrix_t &M = mef.M;
+        ScoreMatrix &Emat = mef.E;
+        ScoreMatrix &Fmat = mef.F;
+
+        const matidx_t rows = mapperA.number_of_valid_mat_pos(al);
+        const matidx_t cols = mapperB.number_of_valid_mat_pos(bl);
+        const score_t indel_opening = scoring->indel_opening();
+        const infty_score_t neg_infty = infty_score_t::neg_infty;
+
+        // gather an arc right-adjacent to a position of the left end
+        // xl; gap_cost is the gap cost between two positions
+        auto gather_arc = [indel_opening](const BasePairs &bps,
+                                          const SparsificationMapper &mapper,
+                                          index_t xl,
+                                          ArcIdx arcIdx,
+                                          auto gap_cost) {
+            const Arc &arc = bps.arc(arcIdx);
+            matidx_t left_index_before =
+                mapper.first_valid_mat_pos_before(xl, arc.left());
+            seq_pos_t left_seq_pos_before =
+                mapper.get_pos_in_seq_new(xl, left_index_before);
+
+            score_t opening = 0;
+            if (left_seq_pos_before < (arc.left() - 1)) {
+                // implicit base deletion/insertion because of
+                // sparsification
+                opening = indel_opening;
+            }
+            return GatheredArc{&arc, left_index_before,
+                               gap_cost(left_seq_pos_before, arc.left()),
+                               opening};
+        };
+
+        // ----------------------------------------
+        // gather the columns
+        //
+        mef.posB.resize(cols);
+        mef.gapB.resize(cols);
+        mef.insB.resize(cols);
+        mef.openingB.resize(cols);
+        mef.unpairedB.resize(cols);
+        mef.arcsB_begin.resize(cols + 1);
+        mef.arcsB.clear();
+        mef.basematchB.resize(cols);
+        mef.matchM.resize(cols);
+
+        for (matidx_t j_index = 1; j_index < cols; j_index++) {
+            seq_pos_t j_seq_pos = mapperB.get_pos_in_seq_new(bl, j_index);
+            seq_pos_t j_prev_seq_pos =
+                mapperB.get_pos_in_seq_new(bl, j_index - 1);
+
+            mef.posB[j_index] = j_seq_pos;
+            mef.gapB[j_index] =
+                getGapCostBetween<false>(j_prev_seq_pos, j_seq_pos);
+            mef.insB[j_index] =
+                getGapCostBetween<false>(j_prev_seq_pos, j_seq_pos) +
+                scoring->gapB(j_seq_pos);
+            mef.openingB[j_index] =
+                (j_prev_seq_pos < (j_seq_pos - 1)) ? indel_opening : 0;
+            mef.unpairedB[j_index] = mapperB.pos_unpaired(bl, j_index);
+
+            mef.arcsB_begin[j_index] = mef.arcsB.size();
+            for (ArcIdx arcIdx : mapperB.valid_arcs_right_adj(bl, j_index)) {
+                mef.arcsB.push_back(gather_arc(
+                    bpsB, mapperB, bl, arcIdx,
+                    [this](pos_type left_side, pos_type right_side) {
+                        return getGapCostBetween<false>(left_side,
+                                                        right_side);
+                    }));
+            }
+        }
+        mef.arcsB_begin[cols] = mef.arcsB.size();
+
+        // ----------------------------------------
+        // fill the rows
+        //
+        for (matidx_t i_index = 1; i_index < rows; i_index++) {
+            seq_pos_t i_seq_pos = mapperA.get_pos_in_seq_new(al, i_index);
+            seq_pos_t i_prev_seq_pos =
+                mapperA.get_pos_in_seq_new(al, i_index - 1);
+
+            const infty_score_t gapA =
+                getGapCostBetween<true>(i_prev_seq_pos, i_seq_pos);
+            const infty_score_t delA =
+                getGapCostBetween<true>(i_prev_seq_pos, i_seq_pos) +
+                scoring->gapA(i_seq_pos);
+            const score_t opening_cost_A =
+                (i_prev_seq_pos < (i_seq_pos - 1)) ? indel_opening : 0;
+            const bool unpairedA = mapperA.pos_unpaired(al, i_index);
+
+            mef.arcsA.clear();
+            for (ArcIdx arcIdx : mapperA.valid_arcs_right_adj(al, i_index)) {
+                mef.arcsA.push_back(gather_arc(
+                    bpsA, mapperA, al, arcIdx,
+                    [this](pos_type left_side, pos_type right_side) {
+                        return getGapCostBetween<true>(left_side,
+                                                       right_side);
+                    }));
+            }
+
+            // the rows i_index-1 and i_index of the matrices; since E
+            // and the base match candidates only depend on the previous
+            // row, the following loops run over contiguous arrays
+            infty_score_t *E_row = &Emat(i_index, 0);
+            const infty_score_t *E_prev = &Emat(i_index - 1, 0);
+            const infty_score_t *F_prev = &Fmat(i_index - 1, 0);
+            const infty_score_t *M_prev = &M(i_index - 1, 0);
+
+            // base deletion
+            if (i_seq_pos <= al) {
+                std::fill(E_row + 1, E_row + cols, neg_infty);
+            } else {
+                for (matidx_t j_index = 1; j_index < cols; j_index++) {
+                    E_row[j_index] =
+                        std::max(delA + E_prev[j_index],
+                                 delA + M_prev[j_index] + indel_opening);
+                }
+            }
+
+            // base match; the base match scores of the row are gathered
+            // first, the candidates are then computed on contiguous arrays
+            for (matidx_t j_index = 1; j_index < cols; j_index++) {
+                mef.basematchB[j_index] =
+                    scoring->basematch(i_seq_pos, mef.posB[j_index]);
+            }
+            const infty_score_t *gapB = mef.gapB.data();
+            const score_t *basematchB = mef.basematchB.data();
+            const score_t *openingB = mef.openingB.data();
+            const char *unpairedB = mef.unpairedB.data();
+            infty_score_t *matchM = mef.matchM.data();
+            for (matidx_t j_index = 1; j_index < cols; j_index++) {
+                infty_score_t gap_match_score =
+                    gapA + gapB[j_index] + basematchB[j_index];
+
+                tainted_infty_score_t score =
+                    std::max(gap_match_score + openingB[j_index] +
+                                 E_prev[j_index - 1],
+                             gap_match_score + opening_cost_A +
+                                 F_prev[j_index - 1]);
+                score = std::max(score,
+                                 gap_match_score + opening_cost_A +
+                                     openingB[j_index] + M_prev[j_index - 1]);
+
+                matchM[j_index] = (unpairedA && unpairedB[j_index])
+                    ? std::max(score, (tainted_infty_score_t)E_row[j_index])
+                    : (tainted_infty_score_t)E_row[j_index];
+            }
+
+            // arc match
+            if (!mef.arcsA.empty()) {
+                for (matidx_t j_index = 1; j_index < cols; j_index++) {
+                    tainted_infty_score_t max_score = mef.matchM[j_index];
+
+                    for (const GatheredArc &a : mef.arcsA) {
+                        for (size_t k = mef.arcsB_begin[j_index];
+                             k < mef.arcsB_begin[j_index + 1]; k++) {
+                            const GatheredArc &b = mef.arcsB[k];
+
+                            infty_score_t gap_match_score = a.gap + b.gap +
+                                sv.D(*a.arc, *b.arc) +
+                                scoring->arcmatch(*a.arc, *b.arc);
+
+                            tainted_infty_score_t arc_match_score =
+                                gap_match_score + a.opening + b.opening +
+                                M(a.left_index_before, b.left_index_before);
+                            arc_match_score = std::max(
+                                arc_match_score,
+                                (gap_match_score + b.opening +
+                                 Emat(a.left_index_before,
+                                      b.left_index_before)));
+                            arc_match_score = std::max(
+                                arc_match_score,
+                                (gap_match_score + a.opening +
+                                 Fmat(a.left_index_before,
+                                      b.left_index_before)));
+
+                            max_score = std::max(max_score, arc_match_score);
+                        }
+                    }
+
+                    mef.matchM[j_index] = max_score;
+                }
+            }
+
+            // base insertion and M, depending on the left neighbors
+            for (matidx_t j_index = 1; j_index < cols; j_index++) {
+                if (mef.posB[j_index] <= bl) {
+                    Fmat(i_index, j_index) = infty_score_t::neg_infty;
+                } else {
+                    infty_score_t extend_score =
+                        Fmat(i_index, j_index - 1) + mef.insB[j_index];
+                    infty_score_t open_score = M(i_index, j_index - 1) +
+                        mef.insB[j_index] + indel_opening;
+                    Fmat(i_index, j_index) =
+                        std::max(extend_score, open_score);
+                }
+                M(i_index, j_index) =
+                    std::max((tainted_infty_score_t)mef.matchM[j_index],
+                             (tainted_infty_score_t)Fmat(i_index, j_index));
+            }
+        }
+    }
+
     // initializing matrix M
     //
     template <class ScoringView>
@@ -439,8 +655,12 @@ namespace LocARNA {
                          pos_type ar,
                          pos_type bl,
                          pos_type br,
+                         MEFMatrices &mef,
                          ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        M_matrix_t &M = mef.M;
+        ScoreMatrix &Emat = mef.E;
+        ScoreMatrix &Fmat = mef.F;
 
         // alignments that have empty subsequence in A (i=al) and
         // end with gap in alistr of B do not exist ==> -infty
@@ -594,16 +814,22 @@ namespace LocARNA {
     AlignerN::fill_M_entries(pos_type al,
                              pos_type ar,
                              pos_type bl,
-                             pos_type br) {
+                             pos_type br,
+                             MEFMatrices &mef) {
         assert(br > 0); // todo: adding appropriate assertions
 
         // initialize M
-        init_M_E_F(al, ar, bl, br, def_scoring_view);
+        init_M_E_F(al, ar, bl, br, mef, def_scoring_view);
 
         if (trace_debugging_output) {
             std::cout << "init_M finished" << std::endl;
         }
 
+        if (params->row_kernel_) {
+            fill_M_rows(al, bl, mef, def_scoring_view);
+            return;
+        }
+
         // iterate through valid entries
         for (matidx_t i_index = 1;
              i_index < mapperA.number_of_valid_mat_pos(al); i_index++) {
@@ -618,8 +844,8 @@ namespace LocARNA {
             for (matidx_t j_index = 1;
                  j_index < mapperB.number_of_valid_mat_pos(bl); j_index++) {
                 // E and F matrix entries will be computed by compute_M_entry
-                M(i_index, j_index) =
-                    compute_M_entry(al, bl, i_index, j_index, def_scoring_view);
+                mef.M(i_index, j_index) = compute_M_entry(
+                    al, bl, i_index, j_index, mef, def_scoring_view);
                 // toask: where should we care about non_default scoring views
 
                 // if (trace_debugging_output) {
@@ -640,10 +866,16 @@ namespace LocARNA {
     // for the subproblem al,bl,max_ar,max_br
     // pre: M,IA,IB matrices are computed by a call to
     void
-    AlignerN::fill_D_entries(pos_type al, pos_type bl) {
+    AlignerN::fill_D_entries(pos_type al,
+                             pos_type bl,
+                             const MEFMatrices &mef) {
         assert(!params->no_lonely_pairs_); // take special care of noLP in this
                                            // method
 
+        const M_matrix_t &M = mef.M;
+        const ScoreMatrix &Emat = mef.E;
+        const ScoreMatrix &Fmat = mef.F;
+
         if (trace_debugging_output) {
             std::cout << "fill_D_entries al: " << al << " bl: " << bl
                       << std::endl;
@@ -768,6 +1000,53 @@ namespace LocARNA {
         }
     }
 
+    // fill IA, IB and D entries of the left ends al,bl
+    void
+    AlignerN::fill_left_ends(pos_type al, pos_type bl, MEFMatrices &mef) {
+        const BasePairs::LeftAdjList &adjlA = bpsA.left_adjlist_s(al);
+        const BasePairs::LeftAdjList &adjlB = bpsB.left_adjlist_s(bl);
+
+        // ------------------------------------------------------------
+        // from aligner.cc: find maximum arc ends
+        pos_type max_ar = al;
+        pos_type max_br = bl;
+
+        // get the maximal right ends of any arc match with left ends
+        // (al,bl)
+        // in noLP mode, we don't consider cases without immediately
+        // enclosing arc match
+        arc_matches.get_max_right_ends(al, bl, &max_ar, &max_br,
+                                       params->no_lonely_pairs_);
+
+        // check whether there is an arc match at all
+        if (al == max_ar || bl == max_br)
+            return;
+
+        // compute matrix M
+        //          stopwatch.start("compM");
+        fill_M_entries(al, max_ar, bl, max_br, mef);
+        //          stopwatch.stop("compM");
+
+        // compute IA
+        //          stopwatch.start("compIA");
+        for (auto arcB = adjlB.begin(); arcB->right() <= r.endB(); ++arcB) {
+            fill_IA_entries(al, *arcB, max_ar);
+        }
+        //          stopwatch.stop("compIA");
+
+        // comput IB
+        //          stopwatch.start("compIB");
+        for (auto arcA = adjlA.begin(); arcA->right() <= r.endA(); ++arcA) {
+            fill_IB_entries(*arcA, bl, max_br);
+        }
+        //          stopwatch.stop("compIB");
+
+        // ------------------------------------------------------------
+        // now fill matrix D entries
+        //
+        fill_D_entries(al, bl, mef);
+    }
+
     // compute all entries D
     void
     AlignerN::align_D() {
@@ -776,84 +1055,102 @@ namespace LocARNA {
         initGapCostMat<false>(
             def_scoring_view); // gap costs B //tocheck:always def_score view!
 
-        // for al in r.endA() .. r.startA
-
-        for (pos_type al = r.endA() + 1; al > r.startA();) {
-            al--;
-            if (trace_debugging_output)
-                std::cout << "align_D al: " << al << std::endl;
-
-            const BasePairs::LeftAdjList &adjlA = bpsA.left_adjlist_s(al);
-            if (adjlA.size()==1) {
-                if (trace_debugging_output)
-                    std::cout << "empty left_adjlist(al=)" << al << std::endl;
-                continue;
-            }
-            //  pos_type max_bl =
-            //  std::min(r.endB(),params->trace_controller.max_col(al));
-            //  //tomark: trace_controller
-            //  pos_type min_bl =
-            //  std::max(r.startB(),params->trace_controller.min_col(al));
+        //  pos_type max_bl =
+        //  std::min(r.endB(),params->trace_controller.max_col(al));
+        //  //tomark: trace_controller
+        //  pos_type min_bl =
+        //  std::max(r.startB(),params->trace_controller.min_col(al));
 
-            pos_type max_bl = r.endB();
-            pos_type min_bl = r.startB();
+        pos_type max_bl = r.endB();
+        pos_type min_bl = r.startB();
 
-            // for bl in max_bl .. min_bl
-            for (pos_type bl = max_bl + 1; bl > min_bl;) {
-                bl--;
+        if (params->threads_ <= 1) {
+            // for al in r.endA() .. r.startA
 
-                const BasePairs::LeftAdjList &adjlB = bpsB.left_adjlist_s(bl);
+            for (pos_type al = r.endA() + 1; al > r.startA();) {
+                al--;
+                if (trace_debugging_output)
+                    std::cout << "align_D al: " << al << std::endl;
 
-                if (adjlB.size()==1) {
+                if (bpsA.left_adjlist_s(al).size() == 1) {
                     if (trace_debugging_output)
-                        std::cout << "empty left_adjlist(bl=)" << bl
+                        std::cout << "empty left_adjlist(al=)" << al
                                   << std::endl;
                     continue;
                 }
 
-                // ------------------------------------------------------------
-                // from aligner.cc: find maximum arc ends
-                pos_type max_ar = al;
-                pos_type max_br = bl;
-
-                // get the maximal right ends of any arc match with left ends
-                // (al,bl)
-                // in noLP mode, we don't consider cases without immediately
-                // enclosing arc match
-                arc_matches.get_max_right_ends(al, bl, &max_ar, &max_br,
-                                               params->no_lonely_pairs_);
-
-                // check whether there is an arc match at all
-                if (al == max_ar || bl == max_br)
-                    continue;
+                // for bl in max_bl .. min_bl
+                for (pos_type bl = max_bl + 1; bl > min_bl;) {
+                    bl--;
 
-                // compute matrix M
-                //          stopwatch.start("compM");
-                fill_M_entries(al, max_ar, bl, max_br);
-                //          stopwatch.stop("compM");
+                    if (bpsB.left_adjlist_s(bl).size() == 1) {
+                        if (trace_debugging_output)
+                            std::cout << "empty left_adjlist(bl=)" << bl
+                                      << std::endl;
+                        continue;
+                    }
 
-                // compute IA
-                //          stopwatch.start("compIA");
-                for (auto arcB = adjlB.begin(); arcB->right() <= r.endB(); ++arcB) {
-                    fill_IA_entries(al, *arcB, max_ar);
+                    fill_left_ends(al, bl, mef_);
                 }
-                //          stopwatch.stop("compIA");
-
-                // comput IB
-                //          stopwatch.start("compIB");
-                for (auto arcA = adjlA.begin(); arcA->right() <= r.endA(); ++arcA) {
-                    fill_IB_entries(*arcA, bl, max_br);
+            }
+        } else {
+            // left ends with arcs
+            std::vector<pos_type> left_endsA;
+            for (pos_type al = r.endA() + 1; al > r.startA();) {
+                al--;
+                if (bpsA.left_adjlist_s(al).size() > 1) {
+                    left_endsA.push_back(al);
                 }
-                //          stopwatch.stop("compIB");
+            }
+            std::vector<bool> is_left_endB(max_bl + 1, false);
+            for (pos_type bl = min_bl; bl <= max_bl; bl++) {
+                is_left_endB[bl] = bpsB.left_adjlist_s(bl).size() > 1;
+            }
 
-                // ------------------------------------------------------------
-                // now fill matrix D entries
-                //
-                fill_D_entries(al, bl);
+            // the anti-diagonals al+bl are processed in decreasing order
+            const pos_type max_diag = r.endA() + max_bl;
+            const size_t num_diags = max_diag - (r.startA() + min_bl) + 1;
+
+            // pairs of left ends with arcs on the anti-diagonal of index k
+            auto diag_cells = [&](size_t k) {
+                pos_type d = max_diag - k;
+                std::vector<std::pair<pos_type, pos_type>> cells;
+                for (auto al : left_endsA) {
+                    if (al <= d && d - al >= min_bl && d - al <= max_bl &&
+                        is_left_endB[d - al]) {
+                        cells.emplace_back(al, d - al);
+                    }
+                }
+                return cells;
+            };
+
+            // fill the pairs of the current anti-diagonal in parallel;
+            // the next anti-diagonal is started when all pairs of the
+            // current one are filled. Each thread uses its own
+            // matrices M, E and F; thread 0 uses mef_.
+            size_t num_threads = params->threads_;
+            std::vector<MEFMatrices> mefs(num_threads - 1);
+            for (auto &mef : mefs) {
+                mef.resize(mapperA.get_max_info_vec_size() + 1,
+                           mapperB.get_max_info_vec_size() + 1);
             }
+
+            std::vector<std::pair<pos_type, pos_type>> cells;
+            parallel_levels(num_diags, num_threads,
+                            [&](size_t diag) {
+                                cells = diag_cells(diag);
+                                return cells.size();
+                            },
+                            [&](size_t, size_t item, size_t thread) {
+                                fill_left_ends(cells[item].first,
+                                               cells[item].second,
+                                               thread == 0 ? mef_
+                                                           : mefs[thread - 1]);
+                            });
         }
+
         if (trace_debugging_output)
-            std::cout << "M matrix:" << std::endl << M << std::endl;
+            std::cout << "M matrix:" << std::endl << mef_.M << std::endl;
         if (trace_debugging_output)
             std::cout << "D matrix:" << std::endl << Dmat << std::endl;
 
@@ -903,16 +1200,16 @@ namespace LocARNA {
             }
 
             // stopwatch.start("align top level");
-            fill_M_entries(ps_al, last_index_A, ps_bl, last_index_B);
+            fill_M_entries(ps_al, last_index_A, ps_bl, last_index_B, mef_);
             // tocheck: always use get_startA-1 (not zero) in
             // sparsification_mapper and other parts
             // stopwatch.stop("align top level");
 
             if (trace_debugging_output)
-                std::cout << "M matrix:" << std::endl << M << std::endl;
+                std::cout << "M matrix:" << std::endl << mef_.M << std::endl;
             if (trace_debugging_output) {
                 std::cout << "M(" << last_index_A << "," << last_index_B
-                          << ")=" << M(last_index_A, last_index_B)
+                          << ")=" << mef_.M(last_index_A, last_index_B)
                           << " getGapCostBetween are:"
                           << getGapCostBetween<true>(last_valid_seq_pos_A,
                                                      ps_ar)
@@ -922,7 +1219,7 @@ namespace LocARNA {
                 // << std::endl;
             }
 
-            return M(last_index_A, last_index_B)
+            return mef_.M(last_index_A, last_index_B)
                 // toask: where should we care about non_default scoring views
                 + getGapCostBetween<true>(last_valid_seq_pos_A, ps_ar) +
                 getGapCostBetween<false>(last_valid_seq_pos_B,
@@ -1139,6 +1436,9 @@ namespace LocARNA {
     void
     AlignerN::trace_D(const Arc &arcA, const Arc &arcB, ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef_.M;
+        const ScoreMatrix &Emat = mef_.E;
+        const ScoreMatrix &Fmat = mef_.F;
 
         assert(!params->no_lonely_pairs_); // take special care of noLP in this
                                            // method
@@ -1202,7 +1502,7 @@ namespace LocARNA {
         }
 
         // first recompute M
-        fill_M_entries(al, ar_seq_pos, bl, br_seq_pos);
+        fill_M_entries(al, ar_seq_pos, bl, br_seq_pos, mef_);
 
         //-----three cases for gap extension/initiation ---
 
@@ -1271,6 +1571,8 @@ namespace LocARNA {
                       bool top_level,
                       ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef_.M;
+        const ScoreMatrix &Emat = mef_.E;
 
         seq_pos_t i_seq_pos = mapperA.get_pos_in_seq_new(al, i_index);
         if (trace_debugging_output)
@@ -1320,6 +1622,8 @@ namespace LocARNA {
                       bool top_level,
                       ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef_.M;
+        const ScoreMatrix &Fmat = mef_.F;
 
         seq_pos_t j_seq_pos = mapperB.get_pos_in_seq_new(bl, j_index);
 
@@ -1370,6 +1674,9 @@ namespace LocARNA {
                            bool top_level,
                            ScoringView sv) {
         const Scoring *scoring = sv.scoring();
+        const M_matrix_t &M = mef_.M;
+        const ScoreMatrix &Emat = mef_.E;
+        const ScoreMatrix &Fmat = mef_.F;
 
         seq_pos_t i_seq_pos = mapperA.get_pos_in_seq_new(al, i_index);
         seq_pos_t j_seq_pos = mapperB.get_pos_in_seq_new(bl, j_index);
@@ -1680,8 +1987,8 @@ namespace LocARNA {
         if (trace_debugging_output)
             std::cout << "******trace_M***** "
                       << " al:" << al << " i:" << i_seq_pos << " bl:" << bl
-                      << " j:" << j_seq_pos << " :: " << M(i_index, j_index)
-                      << std::endl;
+                      << " j:" << j_seq_pos
+                      << " :: " << mef_.M(i_index, j_index) << std::endl;
 
         //    if ( i_seq_pos <= al ) {
         //      for (int k = bl+1; k <= j_seq_pos; k++) { //TODO: end gaps cost
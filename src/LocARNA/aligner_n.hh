@@ -88,18 +88,91 @@ namespace LocARNA {
         //! the arc indices of RNA A
         ScoreMatrix IBDmat;
 
-        //! matrix for the affine gap cost model base deletion
-        ScoreMatrix Emat;
-        //! matrix for the affine gap cost model base insertion
-        ScoreMatrix Fmat;
+        /**
+         * @brief Arc right-adjacent to a sparsified position, with the
+         * data of its arc matches that depends only on the arc
+         */
+        struct GatheredArc {
+            const Arc *arc; //!< the arc
+            //! index of the first valid position before the left end
+            matidx_t left_index_before;
+            //! gap cost between that position and the left end
+            infty_score_t gap;
+            //! opening cost of the implicit gap before the left end
+            score_t opening;
+        };
 
         /**
-         * @brief M matrix
+         * @brief Matrices M, E and F of the alignment below one pair of
+         * left ends
          *
-         * use only one M matrix (unlike in Aligner), since we don't handle
-         * structure locality
+         * The matrices are indexed by the sparsified positions of the
+         * current left ends. In the parallel computation of D, each
+         * thread owns such a workspace.
          */
-        M_matrix_t M;
+        struct MEFMatrices {
+            /**
+             * @brief M matrix
+             *
+             * use only one M matrix (unlike in Aligner), since we don't
+             * handle structure locality
+             */
+            M_matrix_t M;
+            //! matrix for the affine gap cost model base deletion
+            ScoreMatrix E;
+            //! matrix for the affine gap cost model base insertion
+            ScoreMatrix F;
+
+            /**
+             * @name Gathered columns of fill_M_rows()
+             *
+             * Data of the sparsified positions j of B below the
+             * current left end bl, which are needed in every row of M
+             * and are therefore gathered once into contiguous arrays
+             */
+            //! @{
+            //! sequence position of j
+            std::vector<seq_pos_t> posB;
+            //! gap cost between the previous position and j
+            std::vector<infty_score_t> gapB;
+            //! cost of inserting j (including gapB)
+            std::vector<infty_score_t> insB;
+            //! opening cost of the implicit insertion before j
+            std::vector<score_t> openingB;
+            //! whether j can be matched as unpaired base
+            std::vector<char> unpairedB;
+            //! begin of the arcs right-adjacent to j in arcsB
+            std::vector<size_t> arcsB_begin;
+            //! arcs right-adjacent to the positions j
+            std::vector<GatheredArc> arcsB;
+            //! @}
+
+            //! arcs right-adjacent to the current row of fill_M_rows()
+            std::vector<GatheredArc> arcsA;
+
+            //! base match scores of the entries of the current row of
+            //! fill_M_rows()
+            std::vector<score_t> basematchB;
+
+            //! maximum of the base match, arc match and E candidates
+            //! of the entries of the current row of fill_M_rows()
+            std::vector<infty_score_t> matchM;
+
+            /**
+             * @brief Resize all matrices
+             * @param rows number of rows
+             * @param cols number of columns
+             */
+            void
+            resize(size_t rows, size_t cols) {
+                M.resize(rows, cols);
+                E.resize(rows, cols);
+                F.resize(rows, cols);
+            }
+        };
+
+        //! matrices M, E and F of the main thread (used in traceback)
+        MEFMatrices mef_;
 
         //! matrix to store cost of deleting/inserting a subsequence
         //! of sequence A, indexed by neighboring positions of the
@@ -301,6 +374,7 @@ namespace LocARNA {
          * @param ar right end of arc a
          * @param bl left end of arc b
          * @param br right end of arc b
+         * @param mef matrices M, E and F
          * @param sv Scoring view
          *
          */
@@ -310,6 +384,7 @@ namespace LocARNA {
                    pos_type ar,
                    pos_type bl,
                    pos_type br,
+                   MEFMatrices &mef,
                    ScoringView sv);
 
         /**
@@ -384,6 +459,7 @@ namespace LocARNA {
         * @param i_seq_pos position in sequence A, for which score is computed
         * @param i_prev_seq_pos position in sequence A, first valid seq position
         * before i_index
+        * @param mef matrices M, E and F
         * @param sv the scoring view to be used
         * @returns score of E(i,j)
         */
@@ -394,6 +470,7 @@ namespace LocARNA {
                         matidx_t j_index,
                         seq_pos_t i_seq_pos,
                         seq_pos_t i_prev_seq_pos,
+                        const MEFMatrices &mef,
                         ScoringView sv);
 
         /**
@@ -405,6 +482,7 @@ namespace LocARNA {
         * @param j_seq_pos position in sequence B, for which score is computed
         * @param j_prev_seq_pos position in sequence B, first valid seq position
         * before i_index
+        * @param mef matrices M, E and F
         * @param sv the scoring view to be used
         * @returns score of E(i,j)
         */
@@ -415,6 +493,7 @@ namespace LocARNA {
                         matidx_t j_index,
                         seq_pos_t i_seq_pos,
                         seq_pos_t i_prev_seq_pos,
+                        const MEFMatrices &mef,
                         ScoringView sv);
         /**
          * \brief compute M value of single matrix element
@@ -425,6 +504,8 @@ namespace LocARNA {
          * computed
          * @param index_j index position in sequence B, for which score is
          * computed
+         * @param mef matrices M, E and F; the entries E(i,j) and
+         * F(i,j) are written
          * @param sv the scoring view to be used
          * @returns score of M(i,j) for the arcs left ended by al, bl
          *
@@ -435,6 +516,7 @@ namespace LocARNA {
                         index_t bl,
                         matidx_t index_i,
                         matidx_t index_j,
+                        MEFMatrices &mef,
                         ScoringView sv);
         //---------------------------------------------------------------------------------
 
@@ -446,14 +528,42 @@ namespace LocARNA {
          * @param ar right end of arc a
          * @param bl left end of arc b
          * @param br right end of arc b
-         * @param allow_exclusion whether to allow exclusions, not supported by
-         * sparse
+         * @param mef matrices M, E and F to be filled
          *
          * @pre arc-match (al,ar)~(bl,br) valid due to constraints and
          * heuristics
          */
         void
-        fill_M_entries(pos_type al, pos_type ar, pos_type bl, pos_type br);
+        fill_M_entries(pos_type al,
+                       pos_type ar,
+                       pos_type bl,
+                       pos_type br,
+                       MEFMatrices &mef);
+
+        /**
+         * \brief fill the entries of M, E and F row by row
+         *
+         * Computes the same entries as compute_M_entry() for all
+         * entries of the matrices. The data of the columns is gathered
+         * once into the contiguous arrays of mef and the base match
+         * scores of a row are gathered before the row is filled, such
+         * that the entries of E and the base match candidates of a row
+         * are computed by branch-free loops over contiguous arrays.
+         * GCC vectorizes these two loops at -O3 if the target supports
+         * compares of 64-bit integers (e.g. -msse4.2 or -mavx2), but not
+         * for plain x86-64. The entries of F and M, which depend on
+         * their left neighbors, are computed by a sequential scan over
+         * the row.
+         *
+         * @param al position in sequence A: left end of current arc match
+         * @param bl position in sequence B: left end of current arc match
+         * @param mef matrices M, E and F to be filled; first row and
+         * column are initialized
+         * @param sv the scoring view to be used
+         */
+        template <class ScoringView>
+        void
+        fill_M_rows(index_t al, index_t bl, MEFMatrices &mef, ScoringView sv);
 
         /**
          * \brief trace back base deletion within a match of arcs
@@ -576,17 +686,39 @@ namespace LocARNA {
         /**
            create the entries in the D matrix
            This function is called by align() (unless D_created)
+
+           The entries of a pair of left ends (al,bl) depend only on
+           pairs (al',bl') with al'>=al and bl'>=bl. Using several
+           threads, the pairs of each anti-diagonal al+bl are therefore
+           filled in parallel, where each thread uses its own matrices
+           M, E and F. Otherwise, the pairs are filled one by one.
         */
         void
         align_D();
 
+        /**
+         * fill the entries of IA, IB and D (and their IAD and IBD
+         * entries) for the left ends al,bl
+         *
+         * @param al position in sequence A: left end of arc matches
+         * @param bl position in sequence B: left end of arc matches
+         * @param mef matrices M, E and F
+         *
+         * @note writes only entries of IA, IB, IAD, IBD, D that belong
+         * to arcs with left end al or bl, such that different pairs of
+         * one anti-diagonal can be filled concurrently.
+         */
+        void
+        fill_left_ends(pos_type al, pos_type bl, MEFMatrices &mef);
+
         /**
          * fill in D the entries with left ends al,bl
          * @param al position in sequence A: left end of current arc match
          * @param bl position in sequence A: left end of current arc match
+         * @param mef matrices M, E and F filled for al,bl
          */
         void
-        fill_D_entries(pos_type al, pos_type bl);
+        fill_D_entries(pos_type al, pos_type bl, const MEFMatrices &mef);
 
         /**
          * Read/Write access to D matrix
@@ -0,0 +1,462 @@
+#ifndef LOCARNA_ALIGNER_NP_HH
+#define LOCARNA_ALIGNER_NP_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <memory>
+#include <vector>
+
+#include "aligner_p.hh"
+#include "sparsification_mapper.hh"
+
+namespace LocARNA {
+
+    /**
+       \brief Computes partition function of alignment, arc match and base
+       match probabilities over the sparsified alignments of SPARSE
+
+       Sparsified variant of AlignerP: like AlignerN, the alignment
+       of the loops of each pair of left ends (al,bl) is computed only
+       for the positions that are valid due to the sparsification
+       mappers, i.e. positions that are unpaired in the loop or right
+       ends of base pairs in the loop with sufficient probability.
+       The positions between two valid positions are always deleted
+       (or inserted), which is scored like a gap by AlignerN. The
+       partition function thus sums over a subset of the alignments
+       of AlignerP, where the scoring is the same as for AlignerP
+       (base matches, arc matches and affine gap costs). If all
+       positions are valid, AlignerNP computes the same partition
+       function and probabilities as AlignerP.
+
+       For each pair of left ends, the matrices E, F and R distinguish
+       the alignments of the prefixes of the loops that end with a
+       deletion, an insertion or a match; they are needed, since
+       implicit gaps due to sparsification can continue a previous
+       gap (as in AlignerN::compute_M_entry()).
+
+       The outside algorithm computes the derivatives of the partition
+       function by the inside entries (i.e. back propagation through
+       the inside algorithm), which recomputes the inside matrices of
+       each pair of left ends once. The derivative by D(a,b) is the
+       outside partition function of the arc match a~b.
+
+       @note The trace controller (max-diff heuristics) and anchor
+       constraints are ignored, as in AlignerN. Fragment match
+       probabilities are not supported.
+    */
+    template <typename T>
+    class AlignerNP {
+    public:
+        using pf_score_t = typename PFScoring<T>::pf_score_t;
+        using PFScoreMatrix = typename PFScoring<T>::PFScoreMatrix;
+
+        //! sparse matrix for storing partition functions
+        typedef SparseMatrix<pf_score_t> SparsePFScoreMatrix;
+
+        typedef size_t size_type; //!< size
+
+        typedef BasePairs__Arc Arc; //!< arc
+        typedef SparsificationMapper::ArcIdx ArcIdx; //!< arc index
+        typedef SparsificationMapper::matidx_t
+            matidx_t; //!< type for a matrix position
+        typedef SparsificationMapper::seq_pos_t
+            seq_pos_t; //!< type for a sequence position
+        typedef SparsificationMapper::index_t index_t; //!< type for an index
+
+    protected:
+        const std::unique_ptr<AlignerNPParams<T>>
+            params; //!< the parameter for the alignment
+
+        const PFScoring<T> *scoring; //!< the scores
+
+        const Sequence &seqA; //!< sequence A
+        const Sequence &seqB; //!< sequence B
+
+        const SparsificationMapper
+            &mapperA; //!< sparsification mapping for seq A
+        const SparsificationMapper
+            &mapperB; //!< sparsification mapping for seq B
+
+        const ArcMatches &arc_matches; //!< (potential) arc matches of A and B
+
+        const BasePairs &bpsA; //!< base pairs A
+        const BasePairs &bpsB; //!< base pairs B
+
+        /**
+         * scales the partition function.
+         * @see AlignerP::pf_scale
+         */
+        pf_score_t pf_scale;
+
+        pf_score_t partFunc; //!< the total partition function (only defined
+                             //!after call of align_inside())
+
+        /**
+           D(a,b) is the partition function of the subsequences
+           seqA(al..ar) and seqB(bl..br), where the arcs a and b match
+        */
+        PFScoreMatrix Dmat;
+
+        /**
+           D'(a,b) is the derivative of the partition function by
+           D(a,b), i.e. the partition function of the alignments
+           outside of the arc match a~b
+        */
+        PFScoreMatrix Dmatprime;
+
+        /**
+         * @brief Arc right-adjacent to a valid position, with the data
+         * of its matches that depends only on the arc
+         */
+        struct LoopArc {
+            const Arc *arc; //!< the arc
+            //! index of the first valid position before the left end
+            matidx_t left_index_before;
+            //! weight of the gap between that position and the left end
+            pf_score_t gap;
+            //! weight of opening the gap (1 if there is no gap)
+            pf_score_t opening;
+        };
+
+        /**
+         * @brief Valid positions of the loops of one left end
+         *
+         * Gathers the data of the valid positions of the loops with a
+         * common left end, indexed by the matrix index of the
+         * positions.
+         */
+        struct LoopPositions {
+            //! sequence position
+            std::vector<seq_pos_t> pos;
+            //! weight of the gap between the previous valid position
+            //! and the position
+            std::vector<pf_score_t> gap;
+            //! weight of deleting/inserting the position, including gap
+            std::vector<pf_score_t> indel;
+            //! weight of opening the gap before the position (1 if
+            //! there is no gap)
+            std::vector<pf_score_t> opening;
+            //! whether the position can be matched as unpaired base
+            std::vector<char> unpaired;
+            //! begin of the arcs right-adjacent to the position in arcs
+            std::vector<size_t> arcs_begin;
+            //! arcs right-adjacent to the positions
+            std::vector<LoopArc> arcs;
+        };
+
+        //! valid positions of the loops of all left ends in A
+        std::vector<LoopPositions> loopsA;
+        //! valid positions of the loops of all left ends in B
+        std::vector<LoopPositions> loopsB;
+
+        /**
+         * @brief Ends of the alignments of loops that are continued by
+         * a pair of (pseudo-)arc right ends
+         */
+        struct RightEnds {
+            matidx_t i; //!< matrix index in A of last valid position
+            matidx_t j; //!< matrix index in B of last valid position
+            //! weight of the gaps between the positions and the right ends
+            pf_score_t gap;
+            pf_score_t openingA; //!< weight of opening the gap in A
+            pf_score_t openingB; //!< weight of opening the gap in B
+        };
+
+        /**
+           For the current pair of left ends (al,bl), E(i,j), F(i,j)
+           and R(i,j) are the partition functions of the alignments
+           of the subsequences seqA(al+1..i) and seqB(bl+1..j) that
+           end with a deletion of i, an insertion of j and a (base or
+           arc) match, respectively; i and j are matrix indices of
+           valid positions.
+        */
+        PFScoreMatrix Emat;
+        PFScoreMatrix Fmat; //!< @see Emat
+        PFScoreMatrix Rmat; //!< @see Emat
+
+        //! derivatives of the partition function by the entries of Emat
+        PFScoreMatrix Ematprime;
+        //! derivatives of the partition function by the entries of Fmat
+        PFScoreMatrix Fmatprime;
+        //! derivatives of the partition function by the entries of Rmat
+        PFScoreMatrix Rmatprime;
+
+        //! weights of gapping the subsequences of A between two positions,
+        //! excluding the positions
+        PFScoreMatrix gapWeightMatA;
+        //! weights of gapping the subsequences of B between two positions,
+        //! excluding the positions
+        PFScoreMatrix gapWeightMatB;
+
+        //! probabilities of arc matchs, as computed by the algo
+        SparseProbMatrix am_prob;
+
+        /**
+         * probabilities of base matchs, as computed by the algo;
+         * accumulates the partition functions of the base matches
+         * before dividing by the total partition function
+         * @see AlignerP::bm_prob
+         */
+        SparsePFScoreMatrix bm_prob;
+
+        bool D_created;      //!< flag, is D already created?
+        bool Dprime_created; //!< flag, is Dprime already created?
+
+        //! compute the weights of gapping subsequences and gather the
+        //! valid positions of all loops
+        template <bool isA>
+        void
+        init_loops();
+
+        //! weight of gapping the subsequence between two positions,
+        //! excluding the positions
+        template <bool isA>
+        pf_score_t
+        gap_weight(seq_pos_t left_side, seq_pos_t right_side) const {
+            return isA ? gapWeightMatA(left_side, right_side)
+                       : gapWeightMatB(left_side, right_side);
+        }
+
+        /**
+         * @brief gather the valid positions of the loops with left end xl
+         *
+         * @param xl left end in A (isA) or B
+         * @param[out] loop the valid positions
+         *
+         * @pre gap weights are computed
+         */
+        template <bool isA>
+        void
+        gather_loop_positions(index_t xl, LoopPositions &loop) const;
+
+        /**
+         * @brief partition function of continuing the alignments of
+         * entry (i,j) with gaps
+         *
+         * @param i matrix index in A
+         * @param j matrix index in B
+         * @param openingA weight of opening the gap of A (1 if no gap)
+         * @param openingB weight of opening the gap of B (1 if no gap)
+         *
+         * The alignments that end with a deletion (insertion) continue
+         * the gap of A (B) without opening it, as in AlignerN.
+         */
+        pf_score_t
+        continued(matidx_t i,
+                  matidx_t j,
+                  pf_score_t openingA,
+                  pf_score_t openingB) const {
+            return Emat(i, j) * openingB + Fmat(i, j) * openingA +
+                Rmat(i, j) * openingA * openingB;
+        }
+
+        /**
+         * @brief add the derivative of continued() to the derivatives
+         * of the entries (i,j)
+         *
+         * @param i matrix index in A
+         * @param j matrix index in B
+         * @param openingA weight of opening the gap of A (1 if no gap)
+         * @param openingB weight of opening the gap of B (1 if no gap)
+         * @param prime derivative of the partition function by continued()
+         */
+        void
+        add_continued_prime(matidx_t i,
+                            matidx_t j,
+                            pf_score_t openingA,
+                            pf_score_t openingB,
+                            pf_score_t prime) {
+            Ematprime(i, j) += prime * openingB;
+            Fmatprime(i, j) += prime * openingA;
+            Rmatprime(i, j) += prime * openingA * openingB;
+        }
+
+        //! compute one entry in R (inside recursion cases)
+        pf_score_t
+        comp_R_entry(const LoopPositions &loopA,
+                     const LoopPositions &loopB,
+                     matidx_t i,
+                     matidx_t j) const;
+
+        /**
+         * @brief the alignments of loops that are continued by a pair
+         * of right ends
+         *
+         * @param al left end in seqA
+         * @param ar right end in seqA
+         * @param bl left end in seqB
+         * @param br right end in seqB
+         *
+         * @return the last valid positions before ar and br and the
+         * weights of the gaps between them and the right ends
+         */
+        RightEnds
+        right_ends(index_t al, seq_pos_t ar, index_t bl, seq_pos_t br) const;
+
+        /**
+         * @brief size of the matrices for the arc matches with left
+         * ends al and bl
+         *
+         * @param al left end in seqA
+         * @param bl left end in seqB
+         *
+         * @return number of rows and columns that cover the valid
+         * positions before the right ends of all arc matches
+         */
+        std::pair<matidx_t, matidx_t>
+        loop_extent(index_t al, index_t bl) const;
+
+        /**
+         * align the loops with left ends al and bl
+         *
+         * @param al left end in seqA
+         * @param bl left end in seqB
+         * @param rows number of rows to fill
+         * @param cols number of columns to fill
+         *
+         * Fills the matrices E, F and R for the valid positions of the
+         * loops.
+         */
+        void
+        align_inside_arcmatch(index_t al,
+                              index_t bl,
+                              matidx_t rows,
+                              matidx_t cols);
+
+        /**
+         * back propagate the derivatives of the partition function
+         * through the matrices of the left ends al and bl
+         *
+         * @param al left end in seqA
+         * @param bl left end in seqB
+         * @param rows number of filled rows
+         * @param cols number of filled columns
+         *
+         * @pre align_inside_arcmatch(al,bl,rows,cols) and the
+         * derivatives of the entries are initialized by the
+         * derivatives of the entries of D with these left ends (or of
+         * the total partition function)
+         *
+         * Adds the derivatives of the inner arc matches to Dmatprime
+         * and the partition functions of base matches to bm_prob.
+         */
+        void
+        align_outside_arcmatch(index_t al,
+                               index_t bl,
+                               matidx_t rows,
+                               matidx_t cols);
+
+        /**
+         * fill in D the entries with left ends al,bl
+         * @pre align_inside_arcmatch(al,bl,...)
+         */
+        void
+        fill_D(index_t al, index_t bl);
+
+        /**
+         * create the entries in the D matrix.
+         * This function is called by align_inside() (unless D_created)
+         */
+        void
+        align_D();
+
+        //! returns lvalue of matrix D
+        pf_score_t &
+        D(const Arc &arcA, const Arc &arcB) {
+            return Dmat(arcA.idx(), arcB.idx());
+        }
+
+        //! returns lvalue of matrix D'
+        pf_score_t &
+        Dprime(const Arc &arcA, const Arc &arcB) {
+            return Dmatprime(arcA.idx(), arcB.idx());
+        }
+
+    public:
+        /**
+         * @brief Construct from parameters
+         * @param ap parameter for aligner
+         * @note ap is copied to allow reference to a temporary
+         * @note allow implicit conversion for named parameter idiom
+         */
+        AlignerNP(const AlignerNPParams<T> &ap);
+
+        /**
+         * compute the partition function by the inside algorithm
+         * and fill the D matrix
+         * @returns partition function
+         */
+        pf_score_t
+        align_inside();
+
+        /**
+         * perform the outside algorithm,
+         * fill the Dprime matrix and accumulate the partition
+         * functions of the base matches;
+         * assumes that D matrix is computed already
+         */
+        void
+        align_outside();
+
+        //! computes the probabilitites of all arc matches and stores them
+        //! internally (in a sparse matrix), no probability filtering
+        void
+        compute_arcmatch_probabilities();
+
+        //! computes the probabilitites of all base matches and stores them
+        //! internally (in a sparse matrix), no probability filtering
+        //! @pre compute_arcmatch_probabilities() if
+        //! basematch_probs_include_arcmatch
+        void
+        compute_basematch_probabilities(bool basematch_probs_include_arcmatch);
+
+        /**
+         * \brief write the arc match probabilities to a stream
+         *
+         * probabilities are filtered by threshold params->min_am_prob
+         * @param out output stream
+         */
+        void
+        write_arcmatch_probabilities(std::ostream &out);
+
+        /**
+         * \brief write the base match probabilities to a stream
+         *
+         * probabilities are filtered by threshold params->min_bm_prob
+         * @param out output stream
+         */
+        void
+        write_basematch_probabilities(std::ostream &out);
+
+        /**
+         * @brief arc match probability
+         * @param arcA arc in A
+         * @param arcB arc in B
+         * @return probability of matching arcA and arcB
+         * @pre compute_arcmatch_probabilities()
+         */
+        double
+        arcmatch_prob(const Arc &arcA, const Arc &arcB) const {
+            return am_prob(arcA.idx(), arcB.idx());
+        }
+
+        /**
+         * @brief base match probability
+         * @param i position in A
+         * @param j position in B
+         * @return probability of matching i and j
+         * @pre compute_basematch_probabilities()
+         */
+        double
+        basematch_prob(size_type i, size_type j) const {
+            return (double)bm_prob(i, j);
+        }
+    };
+
+} // end namespace LocARNA
+
+#include "aligner_np.icc"
+
+#endif // LOCARNA_ALIGNER_NP_HH
@@ -145,8 +145,15 @@ namespace LocARNA {
                            >::value,
                            "Invalid type in named arguments pack." );
 
-            auto args = std::make_tuple(argpack...);
+            construct(std::make_tuple(argpack...));
+        }
+
+    protected:
+        AlignerPParams() {}
 
+        template <class ArgTuple>
+        void
+        construct(const ArgTuple &args) {
             AlignerParams::construct(args);
 
             min_am_prob_ = get_named_arg_opt<min_am_prob>(args);
@@ -155,6 +162,40 @@ namespace LocARNA {
         }
     };
 
+    /**
+     * @brief parameters for AlignerNP
+     */
+    template <typename T>
+    class AlignerNPParams : public AlignerPParams<T> {
+    public:
+        DEFINE_NAMED_ARG_FEATURE(sparsification_mapperA, const SparsificationMapper *);
+        DEFINE_NAMED_ARG_FEATURE(sparsification_mapperB, const SparsificationMapper *);
+
+        using valid_args = tuple_cat_type_t<
+            typename AlignerPParams<T>::valid_args,
+            std::tuple<sparsification_mapperA,
+                       sparsification_mapperB>>;
+
+        /**
+         * Construct with named arguments
+         */
+        template <class... Args>
+        AlignerNPParams(Args... argpack)
+            : AlignerPParams<T>() {
+            static_assert( type_subset_of<
+                           std::tuple<Args...> ,
+                           tuple_cat_type_t<valid_args, AlignerParams::valid_args>
+                           >::value,
+                           "Invalid type in named arguments pack." );
+
+            auto args = std::make_tuple(argpack...);
+
+            AlignerPParams<T>::construct(args);
+            sparsification_mapperA_ = get_named_arg<sparsification_mapperA>(args);
+            sparsification_mapperB_ = get_named_arg<sparsification_mapperB>(args);
+        }
+    };
+
     /**
      * @brief parameters for AlignerN
      */
@@ -162,11 +203,18 @@ namespace LocARNA {
     public:
         DEFINE_NAMED_ARG_FEATURE(sparsification_mapperA, const SparsificationMapper *);
         DEFINE_NAMED_ARG_FEATURE(sparsification_mapperB, const SparsificationMapper *);
+        //! number of threads for computing the matrix D
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(threads, int, 1);
+        //! fill the matrices M row by row with gathered columns
+        //! (otherwise entry by entry)
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(row_kernel, bool, true);
 
         using valid_args = tuple_cat_type_t<
             AlignerParams::valid_args,
             std::tuple<AlignerNParams::sparsification_mapperA,
-                       AlignerNParams::sparsification_mapperB>>;
+                       AlignerNParams::sparsification_mapperB,
+                       AlignerNParams::threads,
+                       AlignerNParams::row_kernel>>;
 
         /**
          * Construct with named arguments
@@ -185,6 +233,8 @@ namespace LocARNA {
             AlignerParams::construct(args);
             sparsification_mapperA_ = get_named_arg<sparsification_mapperA>(args);
             sparsification_mapperB_ = get_named_arg<sparsification_mapperB>(args);
+            threads_ = get_named_arg_opt<threads>(args);
+            row_kernel_ = get_named_arg_opt<row_kernel>(args);
         }
     };
 } // end namespace LocARNA
@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cmath>
+
+#include "alignment_comparison.hh"
+#include "multiple_alignment.hh"
+#include "parallel.hh"
+
+namespace LocARNA {
+
+    namespace {
+        /**
+         * @brief Sparse table for range minimum and maximum queries
+         */
+        class RangeMinMax {
+        public:
+            explicit RangeMinMax(const std::vector<long> &values)
+                : min_(1, values), max_(1, values) {
+                for (size_t w = 1; 2 * w <= values.size(); w *= 2) {
+                    const auto &min = min_.back();
+                    const auto &max = max_.back();
+                    std::vector<long> next_min(values.size() - 2 * w + 1);
+                    std::vector<long> next_max(next_min.size());
+                    for (size_t i = 0; i < next_min.size(); i++) {
+                        next_min[i] = std::min(min[i], min[i + w]);
+                        next_max[i] = std::max(max[i], max[i + w]);
+                    }
+                    min_.push_back(std::move(next_min));
+                    max_.push_back(std::move(next_max));
+                }
+            }
+
+            //! minimum and maximum in the range [from, to]
+            std::pair<long, long>
+            query(size_t from, size_t to) const {
+                size_t level = 0;
+                while ((size_t(2) << level) <= to - from + 1) {
+                    level++;
+                }
+                size_t to_ = to + 1 - (size_t(1) << level);
+                return {std::min(min_[level][from], min_[level][to_]),
+                        std::max(max_[level][from], max_[level][to_])};
+            }
+
+        private:
+            std::vector<std::vector<long>> min_;
+            std::vector<std::vector<long>> max_;
+        };
+    }
+
+    AlignmentComparison::AlignmentComparison(
+        const MultipleAlignment &reference, size_t threads)
+        : ref_index_(), reference_(), threads_(std::max<size_t>(1, threads)) {
+        for (size_t r = 0; r < reference.num_of_rows(); r++) {
+            ref_index_[reference.seqentry(r).name()] = r;
+            reference_.push_back(make_row(reference.seqentry(r).seq()));
+        }
+    }
+
+    AlignmentComparison::row_t
+    AlignmentComparison::make_row(const string1 &seq) {
+        row_t row;
+        row.columns.push_back(0);
+        row.prefix.reserve(seq.length() + 1);
+        row.prefix.push_back(0);
+        for (size_t col = 1; col <= seq.length(); col++) {
+            if (!is_gap_symbol(seq[col])) {
+                row.columns.push_back(col);
+            }
+            row.prefix.push_back(row.columns.size() - 1);
+        }
+        return row;
+    }
+
+    void
+    AlignmentComparison::prepare(const MultipleAlignment &ma,
+                                 rows_t &rows,
+                                 std::vector<size_t> &ref_rows) const {
+        rows.clear();
+        ref_rows.clear();
+        for (size_t r = 0; r < ma.num_of_rows(); r++) {
+            const auto &entry = ma.seqentry(r);
+            auto it = ref_index_.find(entry.name());
+            if (it == ref_index_.end()) {
+                throw failure("Sequence " + entry.name() +
+                              " does not occur in the reference alignment.");
+            }
+            rows.push_back(make_row(entry.seq()));
+            if (rows.back().columns.size() !=
+                reference_[it->second].columns.size()) {
+                throw failure("Sequence " + entry.name() +
+                              " differs from the reference alignment.");
+            }
+            ref_rows.push_back(it->second);
+        }
+    }
+
+    size_t
+    AlignmentComparison::deviation(const row_t &x,
+                                   const row_t &y,
+                                   const row_t &ref_x,
+                                   const row_t &ref_y) {
+        // The cuts of the reference form a monotone path of points
+        // (i,j), where each column increases i and/or j by at most
+        // one. For a cut (i1,j1) of the alignment, the distance
+        // |i-i1|+|j-j1| decreases along the path until i>=i1 or
+        // j>=j1 and increases after i>i1 and j>j1. In between, the
+        // distance is |d-d1| for the diagonal d=i-j, which changes by
+        // at most one per column; thus, the minimum distance is the
+        // distance of d1 to the range of diagonals in this part.
+
+        const size_t ref_length = ref_x.prefix.size() - 1;
+        const size_t len_x = ref_x.columns.size() - 1;
+        const size_t len_y = ref_y.columns.size() - 1;
+
+        std::vector<long> diagonal(ref_length + 1);
+        std::vector<size_t> first_x(len_x + 1, ref_length + 1);
+        std::vector<size_t> last_x(len_x + 1, 0);
+        std::vector<size_t> first_y(len_y + 1, ref_length + 1);
+        std::vector<size_t> last_y(len_y + 1, 0);
+        for (size_t c = 0; c <= ref_length; c++) {
+            size_t i = ref_x.prefix[c];
+            size_t j = ref_y.prefix[c];
+            diagonal[c] = (long)i - (long)j;
+            first_x[i] = std::min(first_x[i], c);
+            last_x[i] = c;
+            first_y[j] = std::min(first_y[j], c);
+            last_y[j] = c;
+        }
+
+        RangeMinMax diagonals(diagonal);
+
+        size_t d = 0;
+        for (size_t c = 0; c < x.prefix.size(); c++) {
+            size_t i1 = x.prefix[c];
+            size_t j1 = y.prefix[c];
+            long d1 = (long)i1 - (long)j1;
+
+            auto range = diagonals.query(std::min(first_x[i1], first_y[j1]),
+                                         std::max(last_x[i1], last_y[j1]));
+
+            long dist = d1 < range.first
+                ? range.first - d1
+                : (d1 > range.second ? d1 - range.second : 0);
+
+            d = std::max(d, (size_t)dist);
+        }
+        return d;
+    }
+
+    AlignmentComparison::pair_scores_t
+    AlignmentComparison::compare_pair(const row_t &x,
+                                      const row_t &y,
+                                      const row_t &ref_x,
+                                      const row_t &ref_y) {
+        // counts for the positions of one sequence s matched to the
+        // other sequence t
+        struct direction_t {
+            size_t common = 0;         // same match or both to gaps
+            size_t matches = 0;        // matches in the alignment
+            size_t ref_matches = 0;    // matches in the reference
+            size_t common_matches = 0; // same match in both
+            double shift = 0.0;        // sum of position differences
+        };
+
+        auto direction = [](const row_t &s,
+                            const row_t &t,
+                            const row_t &ref_s,
+                            const row_t &ref_t) {
+            direction_t dir;
+            long last = -1;
+            long ref_last = -1;
+            for (size_t i = 1; i < s.columns.size(); i++) {
+                size_t c = s.columns[i];
+                size_t ref_c = ref_s.columns[i];
+
+                // matching position in t (as in match_vector) or -1
+                long m = t.prefix[c] != t.prefix[c - 1] ? t.prefix[c] : -1;
+                long ref_m = ref_t.prefix[ref_c] != ref_t.prefix[ref_c - 1]
+                    ? ref_t.prefix[ref_c]
+                    : -1;
+
+                dir.common += (m == ref_m);
+                dir.matches += (m != -1);
+                dir.ref_matches += (ref_m != -1);
+                dir.common_matches += (m != -1 && m == ref_m);
+
+                // position in t or the one before the gap (as in
+                // match_vector2)
+                long m2 = t.prefix[c];
+                long ref_m2 = ref_t.prefix[ref_c];
+                double j = m2 + ((m2 == last) ? 0.5 : 0);
+                double ref_j = ref_m2 + ((ref_m2 == ref_last) ? 0.5 : 0);
+                dir.shift += std::abs(j - ref_j);
+                last = m2;
+                ref_last = ref_m2;
+            }
+            return dir;
+        };
+
+        direction_t xy = direction(x, y, ref_x, ref_y);
+        direction_t yx = direction(y, x, ref_y, ref_x);
+
+        const size_t len_x = x.columns.size() - 1;
+        const size_t len_y = y.columns.size() - 1;
+
+        pair_scores_t scores;
+        scores.deviation = deviation(x, y, ref_x, ref_y);
+        scores.matches = xy.matches;
+        scores.exclusive = xy.matches - xy.common_matches;
+        scores.match_sps =
+            xy.common_matches * 2.0 / (xy.matches + xy.ref_matches);
+        scores.compalign_sps =
+            (double)(xy.common + yx.common) / (len_x + len_y);
+        scores.deviation_sps = (xy.shift + yx.shift) / (len_x + len_y);
+        return scores;
+    }
+
+    AlignmentComparison::scores_t
+    AlignmentComparison::compare(const MultipleAlignment &ma) const {
+        return compare(std::vector<MultipleAlignment>{ma}).front();
+    }
+
+    std::vector<AlignmentComparison::scores_t>
+    AlignmentComparison::compare(
+        const std::vector<MultipleAlignment> &alignments) const {
+        const size_t n = alignments.size();
+
+        std::vector<rows_t> rows(n);
+        std::vector<std::vector<size_t>> ref_rows(n);
+
+        // row pairs of all alignments as (alignment, x, y)
+        struct task_t {
+            size_t a;
+            size_t x;
+            size_t y;
+        };
+        std::vector<task_t> tasks;
+        std::vector<size_t> first_task(n + 1, 0);
+        for (size_t a = 0; a < n; a++) {
+            prepare(alignments[a], rows[a], ref_rows[a]);
+            first_task[a] = tasks.size();
+            for (size_t x = 0; x < rows[a].size(); x++) {
+                for (size_t y = x + 1; y < rows[a].size(); y++) {
+                    tasks.push_back({a, x, y});
+                }
+            }
+        }
+        first_task[n] = tasks.size();
+
+        std::vector<pair_scores_t> pair_scores(tasks.size());
+
+        parallel_for(tasks.size(), threads_,
+                     [&](size_t k, size_t) {
+                         const task_t &t = tasks[k];
+                         const rows_t &r = rows[t.a];
+                         pair_scores[k] = compare_pair(
+                             r[t.x], r[t.y], reference_[ref_rows[t.a][t.x]],
+                             reference_[ref_rows[t.a][t.y]]);
+                     },
+                     16);
+
+        // sum up in the order of the pairs
+        std::vector<scores_t> results(n);
+        for (size_t a = 0; a < n; a++) {
+            size_t deviation = 0;
+            size_t matches = 0;
+            size_t exclusive = 0;
+            double match_sps = 0.0;
+            double compalign_sps = 0.0;
+            double deviation_sps = 0.0;
+            for (size_t k = first_task[a]; k < first_task[a + 1]; k++) {
+                const pair_scores_t &s = pair_scores[k];
+                deviation = std::max(deviation, s.deviation);
+                matches += s.matches;
+                exclusive += s.exclusive;
+                match_sps += s.match_sps;
+                compalign_sps += s.compalign_sps;
+                deviation_sps += s.deviation_sps;
+            }
+
+            size_t K = rows[a].size();
+
+            results[a].deviation = deviation;
+            results[a].realignment_score = exclusive / (double)matches;
+            results[a].match_sps = match_sps * 2.0 / K / (K - 1);
+            results[a].compalign_sps = compalign_sps * 2.0 / K / (K - 1);
+            results[a].deviation_sps = deviation_sps * 2.0 / K / (K - 1);
+        }
+
+        return results;
+    }
+
+} // end namespace LocARNA
@@ -0,0 +1,175 @@
+#ifndef LOCARNA_ALIGNMENT_COMPARISON_HH
+#define LOCARNA_ALIGNMENT_COMPARISON_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "aux.hh"
+
+namespace LocARNA {
+
+    class MultipleAlignment;
+    class string1;
+
+    /**
+     * @brief Comparison of alignments to a reference alignment
+     *
+     * Computes the scores of MultipleAlignment::deviation(),
+     * cmfinder_realignment_score(), sps() and avg_deviation_score()
+     * in one pass over all pairs of rows. The rows are represented
+     * by integer arrays (column of each position and number of
+     * sequence positions up to each column), which are precomputed
+     * once for the reference. The deviation uses range min/max
+     * queries on the reference instead of comparing all pairs of
+     * cuts; thus, each pair of rows costs O(L log L) instead of
+     * O(L^2).
+     *
+     * Pairs of rows are compared in parallel. Contributions of the
+     * pairs are summed in fixed order, such that the results do not
+     * depend on the number of threads.
+     */
+    class AlignmentComparison {
+    public:
+        /**
+         * @brief Scores of an alignment compared to the reference
+         */
+        struct scores_t {
+            //! deviation, see MultipleAlignment::deviation()
+            size_t deviation;
+            //! see MultipleAlignment::cmfinder_realignment_score()
+            double realignment_score;
+            //! sum-of-pairs score of matches (sps with compalign=false)
+            double match_sps;
+            //! compalign score (sps with compalign=true)
+            double compalign_sps;
+            //! see MultipleAlignment::avg_deviation_score()
+            double deviation_sps;
+        };
+
+        /**
+         * @brief Construct with reference alignment
+         *
+         * @param reference reference alignment
+         * @param threads number of threads
+         */
+        explicit AlignmentComparison(const MultipleAlignment &reference,
+                                     size_t threads = 1);
+
+        /**
+         * @brief Compare alignment to the reference
+         *
+         * @param ma alignment
+         * @return scores of ma
+         *
+         * throws failure if the sequences of ma do not occur in the
+         * reference
+         */
+        scores_t
+        compare(const MultipleAlignment &ma) const;
+
+        /**
+         * @brief Compare several alignments to the reference
+         *
+         * @param alignments alignments
+         * @return scores of the alignments
+         *
+         * The row pairs of all alignments are compared in parallel.
+         */
+        std::vector<scores_t>
+        compare(const std::vector<MultipleAlignment> &alignments) const;
+
+    private:
+        /**
+         * @brief Alignment row as integer arrays
+         */
+        struct row_t {
+            //! column of each sequence position (1-based, [0]=0)
+            std::vector<size_t> columns;
+            //! number of sequence positions up to each column ([0]=0)
+            std::vector<size_t> prefix;
+        };
+
+        //! rows of an alignment
+        using rows_t = std::vector<row_t>;
+
+        //! indices of the reference rows by name
+        std::map<std::string, size_t> ref_index_;
+
+        //! rows of the reference
+        rows_t reference_;
+
+        //! number of threads
+        size_t threads_;
+
+        /**
+         * @brief Compute integer representation of a row
+         * @param seq alignment string
+         * @return row
+         */
+        static row_t
+        make_row(const string1 &seq);
+
+        /**
+         * @brief Map the rows of an alignment to the reference
+         * @param ma alignment
+         * @param[out] rows rows of ma
+         * @param[out] ref_rows index of the reference row for each row
+         */
+        void
+        prepare(const MultipleAlignment &ma,
+                rows_t &rows,
+                std::vector<size_t> &ref_rows) const;
+
+        /**
+         * @brief Scores of one pair of rows
+         */
+        struct pair_scores_t {
+            size_t deviation;     //!< deviation
+            size_t matches;       //!< matches in the alignment
+            size_t exclusive;     //!< matches not in the reference
+            double match_sps;     //!< contribution to the match sps
+            double compalign_sps; //!< contribution to the compalign sps
+            double deviation_sps; //!< contribution to the deviation sps
+        };
+
+        /**
+         * @brief Compare pairwise alignment to the reference
+         *
+         * @param x row x of the alignment
+         * @param y row y of the alignment
+         * @param ref_x row of x in the reference
+         * @param ref_y row of y in the reference
+         *
+         * @return scores
+         */
+        static pair_scores_t
+        compare_pair(const row_t &x,
+                     const row_t &y,
+                     const row_t &ref_x,
+                     const row_t &ref_y);
+
+        /**
+         * @brief Deviation of a pairwise alignment
+         *
+         * @param x row x of the alignment
+         * @param y row y of the alignment
+         * @param ref_x row of x in the reference
+         * @param ref_y row of y in the reference
+         *
+         * @return deviation, see MultipleAlignment::deviation2()
+         */
+        static size_t
+        deviation(const row_t &x,
+                  const row_t &y,
+                  const row_t &ref_x,
+                  const row_t &ref_y);
+    };
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_ALIGNMENT_COMPARISON_HH
@@ -11,10 +11,7 @@
 
 namespace LocARNA {
 
-    ArcMatches::~ArcMatches() {
-        delete bpsA;
-        delete bpsB;
-    }
+    ArcMatches::~ArcMatches() {}
 
     bool
     ArcMatches::is_valid_arcmatch(const Arc &arcA, const Arc &arcB) const {
@@ -134,10 +131,23 @@ namespace LocARNA {
                            size_type max_diff_at_am_,
                            const MatchController &match_controller_,
                            const AnchorConstraints &constraints_)
-        : lenA(rna_dataA.length()),
-          lenB(rna_dataB.length()),
-          bpsA(new BasePairs(&rna_dataA, min_prob)),
-          bpsB(new BasePairs(&rna_dataB, min_prob)),
+        : ArcMatches(std::make_shared<const BasePairs>(&rna_dataA, min_prob),
+                     std::make_shared<const BasePairs>(&rna_dataB, min_prob),
+                     max_length_diff_,
+                     max_diff_at_am_,
+                     match_controller_,
+                     constraints_) {}
+
+    ArcMatches::ArcMatches(std::shared_ptr<const BasePairs> bpsA_,
+                           std::shared_ptr<const BasePairs> bpsB_,
+                           size_type max_length_diff_,
+                           size_type max_diff_at_am_,
+                           const MatchController &match_controller_,
+                           const AnchorConstraints &constraints_)
+        : lenA(bpsA_->seqlen()),
+          lenB(bpsB_->seqlen()),
+          bpsA(std::move(bpsA_)),
+          bpsB(std::move(bpsB_)),
           max_length_diff(max_length_diff_),
           max_diff_at_am(max_diff_at_am_),
           match_controller(match_controller_),
@@ -243,8 +253,8 @@ namespace LocARNA {
             arcsB.insert(BasePairs::bpair_t(k, l));
         }
 
-        bpsA = new BasePairs(lenA, arcsA);
-        bpsB = new BasePairs(lenB, arcsB);
+        bpsA = std::make_shared<const BasePairs>(lenA, arcsA);
+        bpsB = std::make_shared<const BasePairs>(lenB, arcsB);
 
         // ----------------------------------------
         // construct the vectors of arc matches and scores
@@ -6,6 +6,7 @@
 #endif
 
 #include <algorithm>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 
@@ -121,8 +122,10 @@ namespace LocARNA {
         size_type lenA; //!< length of sequence A
         size_type lenB; //!< length of sequence B
 
-        BasePairs *bpsA; //!< base pairs of RNA A
-        BasePairs *bpsB; //!< base pairs of RNA B
+        //! base pairs of RNA A (possibly shared with a SparseSequenceIndex)
+        std::shared_ptr<const BasePairs> bpsA;
+        //! base pairs of RNA B (possibly shared with a SparseSequenceIndex)
+        std::shared_ptr<const BasePairs> bpsB;
 
         /* Constraints and Heuristics */
 
@@ -312,7 +315,29 @@ namespace LocARNA {
                    const MatchController &trace_controller,
                    const AnchorConstraints &constraints);
 
-        //! clean up base pair objects
+        /**
+         *  \brief construct from given base pairs
+         *
+         * Like the construction from base pair probabilities, but the
+         * base pairs are given, e.g. by a SparseSequenceIndex that is
+         * reused for several pairs of RNAs, and shared.
+         *
+         * @param bpsA base pairs of RNA A
+         * @param bpsB base pairs of RNA B
+         * @param max_length_diff consider arc matches only up to maximal length
+         difference
+         * @param max_diff_at_am consider arc matches only up to maximal
+         * difference at their ends
+         * @param trace_controller arc matches only due to trace controller
+         * @param constraints arc matches only due to constraints
+         */
+        ArcMatches(std::shared_ptr<const BasePairs> bpsA,
+                   std::shared_ptr<const BasePairs> bpsB,
+                   size_type max_length_diff,
+                   size_type max_diff_at_am,
+                   const MatchController &trace_controller,
+                   const AnchorConstraints &constraints);
+
         ~ArcMatches();
 
         // for the mea probabilistic consistency transformation, support to read
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <memory>
+
+#include "epm_anchors.hh"
+
+#include "anchor_constraints.hh"
+#include "arc_matches.hh"
+#include "exact_matcher.hh"
+#include "ext_rna_data.hh"
+#include "multiple_alignment.hh"
+#include "sequence.hh"
+#include "sparse_sequence_index.hh"
+#include "sparsification_mapper.hh"
+#include "trace_controller.hh"
+
+namespace LocARNA {
+
+    std::pair<SequenceAnnotation, SequenceAnnotation>
+    epm_anchor_annotation(const ExtRnaData &rna_dataA,
+                          const ExtRnaData &rna_dataB,
+                          const EPMAnchorParams &params) {
+        SparseSequenceIndex indexA(rna_dataA, params.min_prob_,
+                                   params.prob_unpaired_in_loop_threshold_,
+                                   params.prob_basepair_in_loop_threshold_,
+                                   false);
+        SparseSequenceIndex indexB(rna_dataB, params.min_prob_,
+                                   params.prob_unpaired_in_loop_threshold_,
+                                   params.prob_basepair_in_loop_threshold_,
+                                   false);
+        return epm_anchor_annotation(indexA, indexB, params);
+    }
+
+    std::pair<SequenceAnnotation, SequenceAnnotation>
+    epm_anchor_annotation(const SparseSequenceIndex &indexA,
+                          const SparseSequenceIndex &indexB,
+                          const EPMAnchorParams &params) {
+        if (indexA.index_left_ends() || indexB.index_left_ends()) {
+            throw failure("EPM anchors require sequence indices that are "
+                          "indexed by arcs.");
+        }
+
+        const ExtRnaData &rna_dataA = indexA.rna_data();
+        const ExtRnaData &rna_dataB = indexB.rna_data();
+        const Sequence &seqA = rna_dataA.sequence();
+        const Sequence &seqB = rna_dataB.sequence();
+        size_type lenA = seqA.length();
+        size_type lenB = seqB.length();
+
+        TraceController trace_controller(seqA, seqB, nullptr,
+                                         params.max_diff_);
+
+        AnchorConstraints seq_constraints(
+            lenA, seqA.has_annotation(MultipleAlignment::AnnoType::anchors)
+                ? seqA.annotation(MultipleAlignment::AnnoType::anchors)
+                      .single_string()
+                : "",
+            lenB, seqB.has_annotation(MultipleAlignment::AnnoType::anchors)
+                ? seqB.annotation(MultipleAlignment::AnnoType::anchors)
+                      .single_string()
+                : "",
+            !params.relaxed_anchors_);
+
+        ArcMatches arc_matches(indexA.base_pairs(), indexB.base_pairs(),
+                               params.max_diff_am_ != -1
+                                   ? (size_type)params.max_diff_am_
+                                   : std::max(lenA, lenB),
+                               params.max_diff_at_am_ != -1
+                                   ? (size_type)params.max_diff_at_am_
+                                   : std::max(lenA, lenB),
+                               trace_controller, seq_constraints);
+
+        SparseTraceController sparse_trace_controller(
+            indexA.mapper(), indexB.mapper(), trace_controller);
+
+        PatternPairMap EPMs;
+        {
+            // filtering is only meaningful for inexact matches
+            ExactMatcher em(seqA, seqB, rna_dataA, rna_dataB, arc_matches,
+                            sparse_trace_controller, EPMs, params.alpha_1_,
+                            params.alpha_2_, params.alpha_3_,
+                            params.difference_to_opt_score_,
+                            params.min_score_, params.number_of_EPMs_,
+                            params.inexact_struct_match_,
+                            params.struct_mismatch_score_,
+                            params.inexact_struct_match_ && params.add_filter_,
+                            false, std::max(1, params.threads_));
+            em.compute_arcmatch_score();
+            em.trace_EPMs(params.subopt_);
+        }
+
+        PatternPairMap chainedEPMs;
+        LCSEPM chaining(seqA, seqB, EPMs, chainedEPMs);
+        chaining.calculateLCSEPM(params.quiet_);
+
+        return chaining.anchor_annotation();
+    }
+
+} // end namespace LocARNA
@@ -0,0 +1,185 @@
+#ifndef LOCARNA_EPM_ANCHORS_HH
+#define LOCARNA_EPM_ANCHORS_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <utility>
+
+#include "aux.hh"
+#include "named_arguments.hh"
+#include "sequence_annotation.hh"
+
+namespace LocARNA {
+
+    class ExtRnaData;
+    class SparseSequenceIndex;
+
+    /**
+       \brief Parameter for anchoring by chains of exact pattern matches
+
+       The parameters correspond to the respective options of
+       exparna_p; the defaults are the defaults of exparna_p.
+
+       @see epm_anchor_annotation()
+    */
+    class EPMAnchorParams {
+    public:
+        //! cutoff probability of arcs in arc matches
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(min_prob, double, 0.01);
+        //! threshold for the probabilities of unpaired bases in loops
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(prob_unpaired_in_loop_threshold,
+                                         double,
+                                         0.01);
+        //! threshold for the probabilities of base pairs in loops
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(prob_basepair_in_loop_threshold,
+                                         double,
+                                         0.01);
+        //! maximal ratio of unpaired bases in loops to the sequence
+        //! length (0: no restriction)
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_uil_length_ratio, double, 0.0);
+        //! maximal ratio of base pairs in loops to the loop length (0:
+        //! no restriction)
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_bpil_length_ratio, double, 0.0);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff, int, -1);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff_am, int, 30);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff_at_am, int, -1);
+        //! multiplier for the sequential score
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(alpha_1, int, 1);
+        //! multiplier for the structural score
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(alpha_2, int, 5);
+        //! multiplier for the stacking score (requires stacking
+        //! probabilities unless 0)
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(alpha_3, int, 5);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(struct_mismatch_score, int, -10);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(inexact_struct_match, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(add_filter, bool, false);
+        //! use the suboptimal traceback
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(subopt, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(difference_to_opt_score, int, -1);
+        //! minimal score of a traced EPM
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(min_score, int, 90);
+        //! maximal number of EPMs for the suboptimal traceback
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(number_of_EPMs, long int, 100);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(relaxed_anchors, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(quiet, bool, true);
+        //! number of threads for computing and tracing the EPMs
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(threads, int, 1);
+
+        using valid_args = std::tuple<min_prob,
+                                      prob_unpaired_in_loop_threshold,
+                                      prob_basepair_in_loop_threshold,
+                                      max_uil_length_ratio,
+                                      max_bpil_length_ratio,
+                                      max_diff,
+                                      max_diff_am,
+                                      max_diff_at_am,
+                                      alpha_1,
+                                      alpha_2,
+                                      alpha_3,
+                                      struct_mismatch_score,
+                                      inexact_struct_match,
+                                      add_filter,
+                                      subopt,
+                                      difference_to_opt_score,
+                                      min_score,
+                                      number_of_EPMs,
+                                      relaxed_anchors,
+                                      quiet,
+                                      threads>;
+
+        /**
+         * Construct with named arguments
+         */
+        template <class... Args>
+        EPMAnchorParams(Args... argpack) {
+            static_assert( type_subset_of<
+                           std::tuple<Args...>,
+                           valid_args>::value,
+                           "Invalid type in named arguments pack." );
+            auto args = std::make_tuple(argpack...);
+
+            min_prob_ = get_named_arg_opt<min_prob>(args);
+            prob_unpaired_in_loop_threshold_ =
+                get_named_arg_opt<prob_unpaired_in_loop_threshold>(args);
+            prob_basepair_in_loop_threshold_ =
+                get_named_arg_opt<prob_basepair_in_loop_threshold>(args);
+            max_uil_length_ratio_ =
+                get_named_arg_opt<max_uil_length_ratio>(args);
+            max_bpil_length_ratio_ =
+                get_named_arg_opt<max_bpil_length_ratio>(args);
+            max_diff_ = get_named_arg_opt<max_diff>(args);
+            max_diff_am_ = get_named_arg_opt<max_diff_am>(args);
+            max_diff_at_am_ = get_named_arg_opt<max_diff_at_am>(args);
+            alpha_1_ = get_named_arg_opt<alpha_1>(args);
+            alpha_2_ = get_named_arg_opt<alpha_2>(args);
+            alpha_3_ = get_named_arg_opt<alpha_3>(args);
+            struct_mismatch_score_ =
+                get_named_arg_opt<struct_mismatch_score>(args);
+            inexact_struct_match_ =
+                get_named_arg_opt<inexact_struct_match>(args);
+            add_filter_ = get_named_arg_opt<add_filter>(args);
+            subopt_ = get_named_arg_opt<subopt>(args);
+            difference_to_opt_score_ =
+                get_named_arg_opt<difference_to_opt_score>(args);
+            min_score_ = get_named_arg_opt<min_score>(args);
+            number_of_EPMs_ = get_named_arg_opt<number_of_EPMs>(args);
+            relaxed_anchors_ = get_named_arg_opt<relaxed_anchors>(args);
+            quiet_ = get_named_arg_opt<quiet>(args);
+            threads_ = get_named_arg_opt<threads>(args);
+        }
+    };
+
+    /**
+     * @brief Anchors from the best chain of exact pattern matches
+     *
+     * Computes the EPMs of two RNAs by ExactMatcher and their best
+     * chain by LCSEPM, like exparna_p, and returns the matched
+     * positions of the chain as anchor annotations; these can be set
+     * as anchors of the RNAs (RnaData::set_anchors()) to restrict
+     * their alignment by AnchorConstraints, which replaces the
+     * ExpLoc-P pipeline (exparna_p --output-anchor-pp followed by
+     * locarna) without writing and reading files. Anchors of the
+     * input restrict the EPMs.
+     *
+     * @param rna_dataA first RNA
+     * @param rna_dataB second RNA
+     * @param params parameters
+     *
+     * @return pair of the anchor annotations of A and B
+     */
+    std::pair<SequenceAnnotation, SequenceAnnotation>
+    epm_anchor_annotation(const ExtRnaData &rna_dataA,
+                          const ExtRnaData &rna_dataB,
+                          const EPMAnchorParams &params = EPMAnchorParams());
+
+    /**
+     * @brief Anchors from the best chain of exact pattern matches,
+     * reusing the sparsification data of the RNAs
+     *
+     * Like epm_anchor_annotation(const ExtRnaData &, const ExtRnaData &,
+     * const EPMAnchorParams &), but the base pairs and sparsification
+     * mappers are given by sequence indices, which can be reused for
+     * all pairs of a set of RNAs. The thresholds min_prob,
+     * prob_unpaired_in_loop_threshold and
+     * prob_basepair_in_loop_threshold of params are therefore
+     * replaced by the ones of the indices.
+     *
+     * @param indexA sparsification data of the first RNA
+     * @param indexB sparsification data of the second RNA
+     * @param params parameters
+     *
+     * @return pair of the anchor annotations of A and B
+     *
+     * @note the indices must be indexed by arcs
+     * (index_left_ends=false)
+     */
+    std::pair<SequenceAnnotation, SequenceAnnotation>
+    epm_anchor_annotation(const SparseSequenceIndex &indexA,
+                          const SparseSequenceIndex &indexB,
+                          const EPMAnchorParams &params = EPMAnchorParams());
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_EPM_ANCHORS_HH
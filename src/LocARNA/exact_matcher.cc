@@ -3,9 +3,110 @@
 #include "exact_matcher.hh"
 #include <iostream>
 #include <fstream>
+#include <tuple>
+
+#include <numeric>
+
+#include "parallel.hh"
 
 namespace LocARNA {
 
+    namespace {
+        /**
+         * @brief Nesting heights of the arcs of a set of base pairs
+         *
+         * The height of an arc is 0 if no arc is nested strictly
+         * inside of it and otherwise one more than the maximal height
+         * of the arcs inside of it.
+         *
+         * @param bps base pairs
+         * @return vector of the heights, indexed by arc index
+         */
+        std::vector<size_t>
+        nesting_heights(const BasePairs &bps) {
+            std::vector<size_t> order(bps.num_bps());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+                return bps.arc(x).right() < bps.arc(y).right();
+            });
+
+            // Fenwick tree over the reversed left ends, which stores
+            // one more than the heights of the processed arcs, such that
+            // the prefix maximum up to the reversed position of l+1 is
+            // the maximum of the arcs with left end greater than l
+            size_t n = bps.seqlen() + 1;
+            std::vector<size_t> tree(n + 1, 0);
+            auto query = [&](size_t l) {
+                size_t best = 0;
+                for (size_t k = n - l; k > 0; k -= k & (~k + 1)) {
+                    best = std::max(best, tree[k]);
+                }
+                return best;
+            };
+            auto update = [&](size_t l, size_t value) {
+                for (size_t k = n - l; k <= n; k += k & (~k + 1)) {
+                    tree[k] = std::max(tree[k], value);
+                }
+            };
+
+            std::vector<size_t> heights(bps.num_bps(), 0);
+            // arcs are inserted only after all arcs with the same right
+            // end are processed, such that the queried arcs have smaller
+            // right ends
+            for (size_t first = 0; first < order.size();) {
+                size_t last = first;
+                while (last < order.size() &&
+                       bps.arc(order[last]).right() ==
+                           bps.arc(order[first]).right()) {
+                    const auto &arc = bps.arc(order[last]);
+                    size_t inner = query(arc.left() + 1);
+                    heights[arc.idx()] = inner;
+                    last++;
+                }
+                for (; first < last; first++) {
+                    const auto &arc = bps.arc(order[first]);
+                    update(arc.left(), heights[arc.idx()] + 1);
+                }
+            }
+            return heights;
+        }
+
+        /**
+         * @brief Process items level by level using several threads
+         *
+         * Runs parallel_levels() over the given levels; each thread
+         * uses its own workspace.
+         *
+         * @param levels items by level
+         * @param workspace workspace of the calling thread
+         * @param num_threads number of threads
+         * @param rows number of rows of the workspaces
+         * @param cols number of columns of the workspaces
+         * @param fn function called as fn(item, workspace)
+         */
+        template <class Workspace, class Fn>
+        void
+        process_levels(const std::vector<std::vector<size_t>> &levels,
+                       Workspace &workspace,
+                       size_t num_threads,
+                       size_t rows,
+                       size_t cols,
+                       Fn fn) {
+            num_threads = std::max<size_t>(1, num_threads);
+            std::vector<Workspace> workspaces(num_threads - 1);
+            for (auto &w : workspaces) {
+                w.resize(rows, cols);
+            }
+            parallel_levels(
+                levels.size(), num_threads,
+                [&](size_t level) { return levels[level].size(); },
+                [&](size_t level, size_t k, size_t thread) {
+                    fn(levels[level][k],
+                       thread == 0 ? workspace : workspaces[thread - 1]);
+                });
+        }
+    }
+
     // Constructor
     ExactMatcher::ExactMatcher(
         const Sequence &seqA_,
@@ -24,7 +125,8 @@ namespace LocARNA {
         bool inexact_struct_match_,
         score_t struct_mismatch_score_,
         bool add_filter_,
-        bool verbose_)
+        bool verbose_,
+        size_t threads_)
         : seqA(seqA_),
           seqB(seqB_),
           rna_dataA(rna_dataA_),
@@ -36,6 +138,7 @@ namespace LocARNA {
           sparse_mapperA(sparse_trace_controller.get_sparse_mapperA()),
           sparse_mapperB(sparse_trace_controller.get_sparse_mapperB()),
           foundEPMs(foundEPMs_),
+          epm_writer(nullptr),
           alpha_1(alpha_1_),
           alpha_2(alpha_2_),
           alpha_3(alpha_3_),
@@ -47,6 +150,7 @@ namespace LocARNA {
           struct_mismatch_score(struct_mismatch_score_),
           add_filter(add_filter_),
           verbose(verbose_),
+          threads(std::max((size_t)1, threads_)),
           pseudo_arcA(bpsA.num_bps(), 0, seqA.length()),
           pseudo_arcB(bpsB.num_bps(), 0, seqB.length()) {
         if (difference_to_opt_score < 0)
@@ -61,20 +165,8 @@ namespace LocARNA {
         if (verbose)
             std::cout << std::endl;
 
-        L.resize(sparse_mapperA.get_max_info_vec_size(),
-                 sparse_mapperB.get_max_info_vec_size());
-        L.fill(infty_score_t::neg_infty);
-        L.set(0, 0, infty_score_t(0));
-
-        G_A.resize(sparse_mapperA.get_max_info_vec_size(),
-                   sparse_mapperB.get_max_info_vec_size());
-        G_AB.resize(sparse_mapperA.get_max_info_vec_size(),
-                    sparse_mapperB.get_max_info_vec_size());
-
-        LR.resize(sparse_mapperA.get_max_info_vec_size(),
-                  sparse_mapperB.get_max_info_vec_size());
-        LR.fill(infty_score_t::neg_infty);
-        LR.set(0, 0, infty_score_t(0));
+        lglr_.resize(sparse_mapperA.get_max_info_vec_size(),
+                     sparse_mapperB.get_max_info_vec_size());
 
         F.resize(seqA.length() + 1, seqB.length() + 1);
         F.fill(infty_score_t(0));
@@ -92,6 +184,9 @@ namespace LocARNA {
     // compute_LGLR heuristic)
     void
     ExactMatcher::initialize_gap_matrices() {
+        ScoreMatrix &G_A = lglr_.G_A;
+        ScoreMatrix &G_AB = lglr_.G_AB;
+
         // initialize first row of G_A with -inf and G_AB with 0
         for (pos_type j = 1; j < G_A.sizes().second; ++j) {
             G_A.set(0, j, infty_score_t::neg_infty);
@@ -225,30 +320,34 @@ namespace LocARNA {
     // store arcmatch_score with stacking and probs of outermost arcmatch
     void
     ExactMatcher::compute_arcmatch_score() {
-        matpos_t last_filled_pos; // the last position that was filled in the
-                                  // matrices
-
-        // for all arc matches from inside to outside
-        for (const auto& x : arc_matches) {
-            pos_type al = x.arcA().left();
-            pos_type ar = x.arcA().right();
-            pos_type bl = x.arcB().left();
-            pos_type br = x.arcB().right();
-
-            // compute the arc match score only for matching arc matches
-            if ((nucleotide_match(al, bl) && nucleotide_match(ar, br)) ||
-                inexact_struct_match) {
-                last_filled_pos = compute_LGLR(x.arcA(), x.arcB(), false);
-
-                matidx_t last_i = last_filled_pos.first;
-                matidx_t last_j = last_filled_pos.second;
-
-                // the arc match score is the maximum of the last matrix entry
-                // in
-                // matrices LR, L or G_A (as we used the heuristic computation)
-                D(x) = max3(LR(last_i, last_j), L(last_i, last_j),
-                            G_A(last_i, last_j));
+        if (threads <= 1) {
+            // for all arc matches from inside to outside
+            for (const auto &x : arc_matches) {
+                compute_arcmatch_score(lglr_, x);
+            }
+        } else {
+            // group the arc matches by nesting depth; the depth of each
+            // inner arc match is smaller than the depth of the arc match
+            std::vector<size_t> heightsA = nesting_heights(bpsA);
+            std::vector<size_t> heightsB = nesting_heights(bpsB);
+
+            std::vector<std::vector<size_t>> levels;
+            for (const auto &x : arc_matches) {
+                size_t depth = std::min(heightsA[x.arcA().idx()],
+                                        heightsB[x.arcB().idx()]);
+                if (depth >= levels.size()) {
+                    levels.resize(depth + 1);
+                }
+                levels[depth].push_back(x.idx());
             }
+
+            process_levels(levels, lglr_, threads,
+                           sparse_mapperA.get_max_info_vec_size(),
+                           sparse_mapperB.get_max_info_vec_size(),
+                           [&](size_t idx, LGLRMatrices &mats) {
+                               compute_arcmatch_score(
+                                   mats, arc_matches.arcmatch(idx));
+                           });
         }
 
         // compute the best combination of arc matches and unpaired parts in
@@ -256,9 +355,40 @@ namespace LocARNA {
         compute_F();
     }
 
+    void
+    ExactMatcher::compute_arcmatch_score(LGLRMatrices &mats,
+                                         const ArcMatch &am) {
+        pos_type al = am.arcA().left();
+        pos_type ar = am.arcA().right();
+        pos_type bl = am.arcB().left();
+        pos_type br = am.arcB().right();
+
+        // compute the arc match score only for matching arc matches
+        if ((nucleotide_match(al, bl) && nucleotide_match(ar, br)) ||
+            inexact_struct_match) {
+            // the last position that was filled in the matrices
+            matpos_t last_filled_pos =
+                compute_LGLR(mats, am.arcA(), am.arcB(), false);
+
+            matidx_t last_i = last_filled_pos.first;
+            matidx_t last_j = last_filled_pos.second;
+
+            // the arc match score is the maximum of the last matrix entry
+            // in
+            // matrices LR, L or G_A (as we used the heuristic computation)
+            D(am) = max3(mats.LR(last_i, last_j), mats.L(last_i, last_j),
+                         mats.G_A(last_i, last_j));
+        }
+    }
+
     // for debugging
     void
     ExactMatcher::test_arcmatch_score() {
+        const ScoreMatrix &L = lglr_.L;
+        const ScoreMatrix &G_A = lglr_.G_A;
+        const ScoreMatrix &G_AB = lglr_.G_AB;
+        const ScoreMatrix &LR = lglr_.LR;
+
         matpos_t last_filled_pos;
 
         // for all arc matches from inside to outside
@@ -272,7 +402,8 @@ namespace LocARNA {
             if ((nucleotide_match(al, bl) && nucleotide_match(ar, br)) ||
                 inexact_struct_match) {
                 // heuristic
-                last_filled_pos = compute_LGLR(x.arcA(), x.arcB(), false);
+                last_filled_pos =
+                    compute_LGLR(lglr_, x.arcA(), x.arcB(), false);
 
                 matidx_t last_i = last_filled_pos.first;
                 matidx_t last_j = last_filled_pos.second;
@@ -285,7 +416,8 @@ namespace LocARNA {
 
                 // suboptimal
                 initialize_gap_matrices();
-                last_filled_pos = compute_LGLR(x.arcA(), x.arcB(), true);
+                last_filled_pos =
+                    compute_LGLR(lglr_, x.arcA(), x.arcB(), true);
 
 #ifndef NDEBUG
                 last_i = last_filled_pos.first;
@@ -308,7 +440,15 @@ namespace LocARNA {
     // last matched positions and the right ends of the arcs exists
     // compute L, G_A (G matrix) and LR matrix
     ExactMatcher::matpos_t
-    ExactMatcher::compute_LGLR(const Arc &a, const Arc &b, bool suboptimal) {
+    ExactMatcher::compute_LGLR(LGLRMatrices &mats,
+                               const Arc &a,
+                               const Arc &b,
+                               bool suboptimal) {
+        ScoreMatrix &L = mats.L;
+        ScoreMatrix &G_A = mats.G_A;
+        ScoreMatrix &G_AB = mats.G_AB;
+        ScoreMatrix &LR = mats.LR;
+
         // initialize matrices for using the sparse trace controller
         init_mat(L, a, b, infty_score_t(0), infty_score_t::neg_infty,
                  infty_score_t::neg_infty);
@@ -368,11 +508,11 @@ namespace LocARNA {
                     // compute entry only if idx pos is valid for the suboptimal
                     // case
                     L(idx_i, idx_j) =
-                        compute_matrix_entry(a, b, mat_pos, idx_pos_diag, false,
-                                             suboptimal);
+                        compute_matrix_entry(mats, a, b, mat_pos, idx_pos_diag,
+                                             false, suboptimal);
                     LR(idx_i, idx_j) =
-                        compute_matrix_entry(a, b, mat_pos, idx_pos_diag, true,
-                                             suboptimal);
+                        compute_matrix_entry(mats, a, b, mat_pos, idx_pos_diag,
+                                             true, suboptimal);
 
                     // update last filled position
                     last_pos_filled.first = idx_i;
@@ -436,7 +576,8 @@ namespace LocARNA {
     // already taking into account the trace controller (not yet implemented for
     // the suboptimal case!)
     infty_score_t
-    ExactMatcher::compute_matrix_entry(const Arc &a,
+    ExactMatcher::compute_matrix_entry(const LGLRMatrices &mats,
+                                       const Arc &a,
                                        const Arc &b,
                                        matpos_t mat_pos,
                                        matpos_t mat_pos_diag,
@@ -461,7 +602,7 @@ namespace LocARNA {
         // match
         if (seq_matching(idxA, idxB, mat_pos, seq_pos)) {
             score_seq =
-                seq_str_matching(a, b, mat_pos_diag, seq_pos,
+                seq_str_matching(mats, a, b, mat_pos_diag, seq_pos,
                                  score_for_seq_match(), matrixLR, suboptimal);
         }
         // structural matching
@@ -489,7 +630,7 @@ namespace LocARNA {
                 score_t score_am_stacking = score_for_inner_am.finite_value() +
                     score_for_stacking(a, b, inner_a, inner_b);
 
-                score_str = max(seq_str_matching(a, b, mat_pos_diag_str,
+                score_str = max(seq_str_matching(mats, a, b, mat_pos_diag_str,
                                                  last_seq_pos_to_be_matched,
                                                  score_am_stacking, matrixLR,
                                                  suboptimal),
@@ -505,7 +646,8 @@ namespace LocARNA {
     // matrix LR, we can continue
     // the traceback in L or G_A (the gap matrix)
     infty_score_t
-    ExactMatcher::seq_str_matching(const Arc &a,
+    ExactMatcher::seq_str_matching(const LGLRMatrices &mats,
+                                   const Arc &a,
                                    const Arc &b,
                                    matpos_t mat_pos_diag,
                                    pair_seqpos_t seq_pos_to_be_matched,
@@ -520,7 +662,10 @@ namespace LocARNA {
         matidx_t idx_i_diag = mat_pos_diag.first;
         matidx_t idx_j_diag = mat_pos_diag.second;
 
-        ScoreMatrix &mat = matrixLR ? LR : L;
+        const ScoreMatrix &L = mats.L;
+        const ScoreMatrix &G_A = mats.G_A;
+        const ScoreMatrix &G_AB = mats.G_AB;
+        const ScoreMatrix &mat = matrixLR ? mats.LR : L;
 
         // if matching without a gap is possible we simply add add_score
         if (sparse_trace_controller.matching_wo_gap(idxA, idxB, mat_pos_diag,
@@ -715,6 +860,37 @@ namespace LocARNA {
         if (verbose)
             std::cout << "score for traceback " << min_score_tb << ": ";
 
+        // start positions of the heuristic traceback, if it is done in
+        // parallel
+        std::vector<pair_seqpos_t> start_positions;
+
+        // trace the EPMs of the collected start positions in parallel and
+        // store them in the order of the start positions
+        auto trace_start_positions = [&]() {
+            std::vector<EPM> epms(start_positions.size());
+            std::vector<std::vector<size_t>> levels(
+                1, std::vector<size_t>(start_positions.size()));
+            std::iota(levels[0].begin(), levels[0].end(), 0);
+
+            process_levels(levels, lglr_, threads,
+                           sparse_mapperA.get_max_info_vec_size(),
+                           sparse_mapperB.get_max_info_vec_size(),
+                           [&](size_t k, LGLRMatrices &mats) {
+                               trace_F_heuristic(mats,
+                                                 start_positions[k].first,
+                                                 start_positions[k].second,
+                                                 epms[k]);
+                           });
+
+            for (auto &epm : epms) {
+                add_foundEPM(epm, false, false);
+            }
+            start_positions.clear();
+        };
+        // the start positions are traced in batches, which bounds the
+        // number of EPMs that are kept at once
+        const size_t batch_size = 1024 * threads;
+
         // compute traceback in F matrix
         for (size_type i = 1; i < F.sizes().first; ++i) {
             size_t min_col =
@@ -751,20 +927,29 @@ namespace LocARNA {
                                               << std::endl;
                                 return;
                             }
-                        } else {
+                        } else if (threads <= 1) {
                             EPM cur_epm;
-                            trace_F_heuristic(i, j, cur_epm); // compute
-                                                              // traceback from
-                                                              // position (i,j)
-                            add_foundEPM(cur_epm, false); // store the traced
-                                                          // epm in the
-                                                          // corresponding
-                                                          // datastructure
+                            trace_F_heuristic(lglr_, i, j,
+                                              cur_epm); // compute
+                                                        // traceback from
+                                                        // position (i,j)
+                            // store the traced epm in the corresponding
+                            // datastructure
+                            add_foundEPM(cur_epm, false, false);
+                        } else {
+                            start_positions.emplace_back(i, j);
+                            if (start_positions.size() == batch_size) {
+                                trace_start_positions();
+                            }
                         }
                     }
                 }
             }
         }
+
+        if (!start_positions.empty()) {
+            trace_start_positions();
+        }
         if (verbose && check_PPM() && count_EPMs)
             std::cout << cur_number_of_EPMs << " EPMs " << std::endl;
     }
@@ -830,7 +1015,9 @@ namespace LocARNA {
     // adds a found EPM to the patternPairMap (datastructure used for chaining
     // algorithm)
     void
-    ExactMatcher::add_foundEPM(EPM &cur_epm, bool count_EPMs) {
+    ExactMatcher::add_foundEPM(EPM &cur_epm,
+                               bool count_EPMs,
+                               bool suboptimal) {
         ++cur_number_of_EPMs;
 
         if (count_EPMs)
@@ -846,10 +1033,6 @@ namespace LocARNA {
         // make sure that the current epm is valid
         assert(validate_epm(cur_epm));
 
-        std::stringstream ss;
-        ss << "pat_" << cur_number_of_EPMs;
-        std::string patId = ss.str();
-
         // rewrite information for use in the chaining algorithm
         intVec pat1Vec;
         intVec pat2Vec;
@@ -861,6 +1044,18 @@ namespace LocARNA {
             structure.push_back(x.third);
         }
 
+        if (epm_writer != nullptr) {
+            // the heuristic traceback traces each EPM once, only the
+            // suboptimal traceback can trace duplicates
+            epm_writer->write(cur_epm.get_score(), structure, pat1Vec, pat2Vec,
+                              suboptimal);
+            return;
+        }
+
+        std::stringstream ss;
+        ss << "pat_" << cur_number_of_EPMs;
+        std::string patId = ss.str();
+
         SinglePattern pattern1 = SinglePattern(patId, seq1_id, pat1Vec);
         SinglePattern pattern2 = SinglePattern(patId, seq2_id, pat2Vec);
         foundEPMs.add(patId, pattern1, pattern2, structure,
@@ -873,7 +1068,10 @@ namespace LocARNA {
     // traces through the F matrix from position (i,j) to find the best EPM that
     // ends in (i,j)
     void
-    ExactMatcher::trace_F_heuristic(pos_type i, pos_type j, EPM &cur_epm) {
+    ExactMatcher::trace_F_heuristic(LGLRMatrices &mats,
+                                    pos_type i,
+                                    pos_type j,
+                                    EPM &cur_epm) {
         assert(F(i, j).is_finite());
         cur_epm.set_score(F(i, j).finite_value());
 
@@ -898,7 +1096,8 @@ namespace LocARNA {
                         assert(score_for_am(a, b).is_finite());
 
                         cur_epm.add_am(am.arcA(), am.arcB());
-                        trace_LGLR_heuristic(am.arcA(), am.arcB(), cur_epm);
+                        trace_LGLR_heuristic(mats, am.arcA(), am.arcB(),
+                                             cur_epm);
 
                         i = am.arcA().left() - 1;
                         j = am.arcB().left() - 1;
@@ -912,12 +1111,17 @@ namespace LocARNA {
     // traces through the L, G_A and LR matrices for the arcmatch of a and b
     // and stores the result in epm_to_store
     void
-    ExactMatcher::trace_LGLR_heuristic(const Arc &a,
+    ExactMatcher::trace_LGLR_heuristic(LGLRMatrices &mats,
+                                       const Arc &a,
                                        const Arc &b,
                                        EPM &cur_epm) {
         assert(D(a, b).is_finite());
 
-        matpos_t cur_pos = compute_LGLR(a, b, false);
+        const ScoreMatrix &L = mats.L;
+        const ScoreMatrix &G_A = mats.G_A;
+        const ScoreMatrix &LR = mats.LR;
+
+        matpos_t cur_pos = compute_LGLR(mats, a, b, false);
 
         matidx_t idx_i = cur_pos.first;
         matidx_t idx_j = cur_pos.second;
@@ -965,8 +1169,8 @@ namespace LocARNA {
                     // check for sequential matching
                     if (seq_matching(idxA, idxB, cur_pos, cur_seq_pos)) {
                         seq_matching_poss = trace_seq_str_matching_heuristic(
-                            a, b, state, cur_pos, mat_pos_diag, cur_seq_pos,
-                            score_for_seq_match());
+                            mats, a, b, state, cur_pos, mat_pos_diag,
+                            cur_seq_pos, score_for_seq_match());
                         if (seq_matching_poss) {
                             cur_epm.add(i, j, '.');
                             break;
@@ -1002,7 +1206,7 @@ namespace LocARNA {
 
                             str_matching_poss =
                                 trace_seq_str_matching_heuristic(
-                                    a, b, state, cur_pos, idx_pos_before,
+                                    mats, a, b, state, cur_pos, idx_pos_before,
                                     last_seq_pos_to_be_matched,
                                     score_am_stacking);
 
@@ -1060,7 +1264,7 @@ namespace LocARNA {
             const Arc &inner_arcB = bpsB.arc(arc_idx_pair.second);
 
             // trace recursively
-            trace_LGLR_heuristic(inner_arcA, inner_arcB, cur_epm);
+            trace_LGLR_heuristic(mats, inner_arcA, inner_arcB, cur_epm);
         }
     }
 
@@ -1071,6 +1275,7 @@ namespace LocARNA {
     // the traceback in L or G_A (the gap matrix)
     bool
     ExactMatcher::trace_seq_str_matching_heuristic(
+        const LGLRMatrices &mats,
         const Arc &a,
         const Arc &b,
         int &state,
@@ -1080,7 +1285,9 @@ namespace LocARNA {
         score_t add_score) {
         bool matching = false;
         bool matrixLR = (state == in_LR);
-        const ScoreMatrix &mat = matrixLR ? LR : L;
+        const ScoreMatrix &L = mats.L;
+        const ScoreMatrix &G_A = mats.G_A;
+        const ScoreMatrix &mat = matrixLR ? mats.LR : L;
 
         matidx_t idx_i = cur_mat_pos.first;
         matidx_t idx_j = cur_mat_pos.second;
@@ -1146,7 +1353,7 @@ namespace LocARNA {
         found_epms.back().set_max_tol_left(max_tol);
 
         // pos_type pos_cur_epm = 0;
-        epm_it_t cur_epm = found_epms.begin();
+        epm_idx_t cur_epm = 0;
 
         pair_seqpos_t cur_pos = pair_seqpos_t(i, j);
         map_am_to_do_t am_to_do_for_F;
@@ -1168,7 +1375,7 @@ namespace LocARNA {
                 pos_type j = cur_pos.second;
                 assert(i >= 1 && j >= 1);
 
-                cur_max_tol = (infty_score_t)cur_epm->get_max_tol_left() -
+                cur_max_tol = (infty_score_t)found_epms[cur_epm].get_max_tol_left() -
                     F(i, j) + F(i - 1, j - 1) + score_for_seq_match();
 
                 // sequential matching
@@ -1186,7 +1393,7 @@ namespace LocARNA {
                     const Arc &b = am.arcB();
                     const PairArcIdx pair_arcs(a.idx(), b.idx());
 
-                    cur_max_tol = (infty_score_t)cur_epm->get_max_tol_left() -
+                    cur_max_tol = (infty_score_t)found_epms[cur_epm].get_max_tol_left() -
                         F(i, j) +
                         F(am.arcA().left() - 1, am.arcB().left() - 1) +
                         score_for_am(a, b);
@@ -1208,7 +1415,7 @@ namespace LocARNA {
                                cur_epm, found_epms, am_to_do_for_F, count_EPMs);
 
                 // update current position
-                pair_seqpos_t last_matched_pos = cur_epm->last_matched_pos();
+                pair_seqpos_t last_matched_pos = found_epms[cur_epm].last_matched_pos();
                 cur_pos = pair_seqpos_t(last_matched_pos.first - 1,
                                         last_matched_pos.second - 1);
             }
@@ -1217,8 +1424,8 @@ namespace LocARNA {
 
             // search for next epm to process (epm that is not traced
             // completely)
-            for (; cur_epm != found_epms.end(); ++cur_epm) {
-                pair_seqpos_t last_matched_pos = cur_epm->last_matched_pos();
+            for (; cur_epm < found_epms.size(); ++cur_epm) {
+                pair_seqpos_t last_matched_pos = found_epms[cur_epm].last_matched_pos();
                 if (!(F(last_matched_pos.first - 1,
                         last_matched_pos.second - 1) == infty_score_t(0))) {
                     finished = false;
@@ -1257,8 +1464,8 @@ namespace LocARNA {
         }
 
         // check for EPMs that are included in other EPMs
-        for (epm_it_t epm1 = found_epms.begin(); epm1 != found_epms.end();) {
-            epm_it_t epm2 = epm1;
+        for (auto epm1 = found_epms.begin(); epm1 != found_epms.end(); ++epm1) {
+            auto epm2 = epm1;
             ++epm2; // compare to all other epms after cur_epm
 
             for (; epm2 != found_epms.end(); ++epm2) {
@@ -1283,13 +1490,16 @@ namespace LocARNA {
                     // compare with next epm
                 }
             }
-            // erase epm if it is invalid
-            if (epm1->is_invalid()) {
-                found_epms.erase(epm1++);
-            } else {
-                ++epm1;
-            }
         }
+
+        // erase the invalid epms in one pass; an epm is compared to all
+        // epms after it before it can be erased, such that deferring the
+        // erasure does not change the result
+        found_epms.erase(std::remove_if(found_epms.begin(), found_epms.end(),
+                                        [](const EPM &epm) {
+                                            return epm.is_invalid();
+                                        }),
+                         found_epms.end());
     }
 
     // computes the suboptimal traceback through the L, G_A, G_AB and LR
@@ -1302,8 +1512,13 @@ namespace LocARNA {
                                         epm_cont_t &found_epms,
                                         bool recurse,
                                         bool count_EPMs) {
-        matpos_t cur_mat_pos =
-            compute_LGLR(a, b, true); // recompute matrices L, G_A, G_AB and LR
+        const ScoreMatrix &L = lglr_.L;
+        const ScoreMatrix &G_A = lglr_.G_A;
+        const ScoreMatrix &G_AB = lglr_.G_AB;
+        const ScoreMatrix &LR = lglr_.LR;
+
+        matpos_t cur_mat_pos = compute_LGLR(
+            lglr_, a, b, true); // recompute matrices L, G_A, G_AB and LR
 
         matidx_t idx_i = cur_mat_pos.first;
         matidx_t idx_j = cur_mat_pos.second;
@@ -1316,7 +1531,7 @@ namespace LocARNA {
         const PairArcIdx no_am(bpsA.num_bps(), bpsB.num_bps());
 
         found_epms.push_back(EPM());
-        epm_it_t cur_epm = found_epms.begin();
+        epm_idx_t cur_epm = 0;
 
         pair_seqpos_t seq_pos_to_be_matched(a.right(), b.right());
         poss_L_LR poss(-1, (infty_score_t)0, matpos_t(0, 0), no_am,
@@ -1370,15 +1585,15 @@ namespace LocARNA {
 
         while (!finished) {
             // continue traceback until we end up at pos (0,0) in matrix L or LR
-            while (cur_epm->get_cur_pos() != matpos_t(0, 0) ||
-                   (cur_epm->get_state() != in_L &&
-                    cur_epm->get_state() != in_LR)) {
-                matpos_t cur_mat_pos = cur_epm->get_cur_pos();
+            while (found_epms[cur_epm].get_cur_pos() != matpos_t(0, 0) ||
+                   (found_epms[cur_epm].get_state() != in_L &&
+                    found_epms[cur_epm].get_state() != in_LR)) {
+                matpos_t cur_mat_pos = found_epms[cur_epm].get_cur_pos();
 
                 pos_type idx_i = cur_mat_pos.first;
                 pos_type idx_j = cur_mat_pos.second;
 
-                bool matrixLR = cur_epm->get_state() == in_LR;
+                bool matrixLR = found_epms[cur_epm].get_state() == in_LR;
                 const ScoreMatrix &mat = matrixLR ? LR : L;
 
                 assert(mat(idx_i, idx_j).is_finite());
@@ -1394,7 +1609,7 @@ namespace LocARNA {
                     mat_pos_diag = sparse_trace_controller.diag_pos_bef(
                         idxA, idxB, seq_pos_to_be_matched, a.left(), b.left());
 
-                    score_t score_contr = cur_epm->get_max_tol_left() +
+                    score_t score_contr = found_epms[cur_epm].get_max_tol_left() +
                         score_for_seq_match() -
                         mat(idx_i, idx_j).finite_value();
 
@@ -1433,7 +1648,7 @@ namespace LocARNA {
                         score_t score_contr =
                             score_for_am(inner_a, inner_b).finite_value() +
                             score_for_stacking(a, b, inner_a, inner_b) +
-                            cur_epm->get_max_tol_left() -
+                            found_epms[cur_epm].get_max_tol_left() -
                             mat(idx_i, idx_j).finite_value();
 
                         trace_seq_str_matching_subopt(a, b, score_contr,
@@ -1452,15 +1667,15 @@ namespace LocARNA {
                                map_am_to_do, count_EPMs);
             }
 
-            assert(cur_epm->get_cur_pos() == matpos_t(0, 0) &&
-                   (cur_epm->get_state() == in_L ||
-                    cur_epm->get_state() == in_LR));
+            assert(found_epms[cur_epm].get_cur_pos() == matpos_t(0, 0) &&
+                   (found_epms[cur_epm].get_state() == in_L ||
+                    found_epms[cur_epm].get_state() == in_LR));
 
             finished = true;
 
             // search for next epm to process (epm that is not at pos(0,0))
-            for (; cur_epm != found_epms.end(); ++cur_epm) {
-                if (cur_epm->get_cur_pos() != matpos_t(0, 0)) {
+            for (; cur_epm < found_epms.size(); ++cur_epm) {
+                if (found_epms[cur_epm].get_cur_pos() != matpos_t(0, 0)) {
                     finished = false;
                     break;
                 }
@@ -1480,7 +1695,7 @@ namespace LocARNA {
         }
 
         // sort the epms according to the tolerance left in ascending order
-        found_epms.sort();
+        std::stable_sort(found_epms.begin(), found_epms.end());
     }
 
     // traces a sequential or structural match for the suboptimal traceback
@@ -1493,13 +1708,16 @@ namespace LocARNA {
         pair_seqpos_t seq_pos_to_be_matched,
         const PairArcIdx &am,
         poss_L_LR &poss,
-        epm_it_t cur_epm,
+        epm_idx_t cur_epm,
         epm_cont_t &found_epms,
         map_am_to_do_t &map_am_to_do,
         bool count_EPMs) {
-        bool matrixLR = cur_epm->get_state() == in_LR;
+        bool matrixLR = found_epms[cur_epm].get_state() == in_LR;
 
-        const ScoreMatrix &mat = matrixLR ? LR : L;
+        const ScoreMatrix &L = lglr_.L;
+        const ScoreMatrix &G_A = lglr_.G_A;
+        const ScoreMatrix &G_AB = lglr_.G_AB;
+        const ScoreMatrix &mat = matrixLR ? lglr_.LR : L;
 
         matidx_t idx_i_diag = mat_pos_diag.first;
         matidx_t idx_j_diag = mat_pos_diag.second;
@@ -1507,7 +1725,7 @@ namespace LocARNA {
         bool matching_in_cur_mat =
             false; // whether a matching in the current matrix is possible
 
-        poss_L_LR pot_new_poss(cur_epm->get_state(),
+        poss_L_LR pot_new_poss(found_epms[cur_epm].get_state(),
                                mat(idx_i_diag, idx_j_diag) + score_contr,
                                mat_pos_diag, am, seq_pos_to_be_matched);
 
@@ -1553,7 +1771,7 @@ namespace LocARNA {
                              const Arc &b,
                              const poss_L_LR &pot_new_poss,
                              poss_L_LR &poss,
-                             epm_it_t cur_epm,
+                             epm_idx_t cur_epm,
                              epm_cont_t &found_epms,
                              map_am_to_do_t &map_am_to_do,
                              bool count_EPMs) {
@@ -1582,7 +1800,7 @@ namespace LocARNA {
                                  bool last_poss,
                                  const poss_L_LR &new_poss,
                                  poss_L_LR &poss,
-                                 epm_it_t cur_epm,
+                                 epm_idx_t cur_epm,
                                  epm_cont_t &found_epms,
                                  map_am_to_do_t &map_am_to_do,
                                  bool count_EPMs) {
@@ -1601,12 +1819,10 @@ namespace LocARNA {
             const score_t &max_tol = new_poss.second.finite_value();
 
             // if it is not the last possibility, copy the current epm and add
-            // the subsequent extension to the copied epm and reset pointer
+            // the subsequent extension to the copied epm and reset index
             if (!last_poss) {
-                found_epms.push_back(*cur_epm);
-                cur_epm = found_epms.end();
-                assert(!found_epms.empty());
-                --cur_epm;
+                found_epms.push_back(found_epms[cur_epm]);
+                cur_epm = found_epms.size() - 1;
             }
 
             // sequential match
@@ -1616,7 +1832,7 @@ namespace LocARNA {
                 if (new_poss.first == in_F ||
                     cur_pos_seq != pair_seqpos_t(a.right(), b.right())) {
                     // store the sequence positions of the match
-                    cur_epm->add(cur_pos_seq.first, cur_pos_seq.second, '.');
+                    found_epms[cur_epm].add(cur_pos_seq.first, cur_pos_seq.second, '.');
                 }
             }
 
@@ -1628,9 +1844,9 @@ namespace LocARNA {
                 const Arc &inner_a = bpsA.arc(pair_arc_idx.first);
                 const Arc &inner_b = bpsB.arc(pair_arc_idx.second);
 
-                cur_epm->add_am(inner_a, inner_b);
+                found_epms[cur_epm].add_am(inner_a, inner_b);
 
-                cur_epm->store_am(
+                found_epms[cur_epm].store_am(
                     inner_a,
                     inner_b); // store arcmatch for subsequent traceback
                 // construct map that stores the result of each used
@@ -1659,9 +1875,9 @@ namespace LocARNA {
 
             // update information of the current epm
 
-            cur_epm->set_cur_pos(new_poss.third);
-            cur_epm->set_state(new_poss.first);
-            cur_epm->set_max_tol_left(max_tol);
+            found_epms[cur_epm].set_cur_pos(new_poss.third);
+            found_epms[cur_epm].set_state(new_poss.first);
+            found_epms[cur_epm].set_max_tol_left(max_tol);
 
             // reset poss for the next iteration if last_poss is true
             if (last_poss) {
@@ -1676,10 +1892,14 @@ namespace LocARNA {
                                      const Arc &b,
                                      const poss_L_LR &pot_new_poss,
                                      poss_L_LR &poss,
-                                     epm_it_t cur_epm,
+                                     epm_idx_t cur_epm,
                                      epm_cont_t &found_epms,
                                      map_am_to_do_t &map_am_to_do,
                                      bool count_EPMs) {
+        const ScoreMatrix &L = lglr_.L;
+        const ScoreMatrix &G_A = lglr_.G_A;
+        const ScoreMatrix &G_AB = lglr_.G_AB;
+
         ArcIdx idxA = a.idx();
         ArcIdx idxB = b.idx();
 
@@ -1964,7 +2184,7 @@ namespace LocARNA {
     // epm
     void
     ExactMatcher::preproc_fill_epm(map_am_to_do_t &map_am_to_do,
-                                   epm_it_t cur_epm,
+                                   epm_idx_t cur_epm,
                                    epm_cont_t &found_epms,
                                    bool count_EPMs,
                                    score_t min_allowed_score) {
@@ -1989,20 +2209,19 @@ namespace LocARNA {
         // last_el_to_process is the last
         // element that is processed
         assert(found_epms.size() > 0);
-        epm_it_t last_el_to_process = --found_epms.end();
+        epm_idx_t last_el_to_process = found_epms.size() - 1;
 
-        for (epm_it_t cur_epm = found_epms.begin(); cur_epm != found_epms.end();
-             ++cur_epm) {
-            if (!(cur_epm->number_of_am() == 0)) {
+        for (epm_idx_t cur_epm = 0; cur_epm < found_epms.size(); ++cur_epm) {
+            if (!(found_epms[cur_epm].number_of_am() == 0)) {
                 if (!check_PPM()) {
                     return;
                 }
 
                 std::vector<const EPM *> epms_to_insert;
 
-                assert(cur_epm->number_of_am() > 0);
+                assert(found_epms[cur_epm].number_of_am() > 0);
 
-                size_type number_of_am = cur_epm->number_of_am();
+                size_type number_of_am = found_epms[cur_epm].number_of_am();
                 epms_to_insert.resize(number_of_am);
 
                 // max_tol_left_up_to_pos(vec_idx) gives the maximal tolerance
@@ -2012,7 +2231,7 @@ namespace LocARNA {
 
                 // initialize the first entry in max_tol_left_up_to_pos with the
                 // tolerance left for the current epm
-                max_tol_left_up_to_pos[0] = cur_epm->get_max_tol_left();
+                max_tol_left_up_to_pos[0] = found_epms[cur_epm].get_max_tol_left();
 
                 size_type vec_idx = 0;
 
@@ -2024,8 +2243,8 @@ namespace LocARNA {
                     // insert the missing parts of the first possibility, not
                     // needed if just counting the EPMs
                     for (PairArcIdxVec::const_iterator arc_pairs =
-                             cur_epm->am_begin();
-                         arc_pairs != cur_epm->am_end(); ++arc_pairs) {
+                             found_epms[cur_epm].am_begin();
+                         arc_pairs != found_epms[cur_epm].am_end(); ++arc_pairs) {
                         const epm_cont_t &cur_epm_list =
                             map_am_to_do.find(*arc_pairs)->second.second;
 
@@ -2033,20 +2252,20 @@ namespace LocARNA {
                         assert(map_am_to_do.find(*arc_pairs)->second.first ==
                                cur_epm_list.begin()->get_max_tol_left());
 
-                        cur_epm->insert_epm(*cur_epm_list.begin());
+                        found_epms[cur_epm].insert_epm(*cur_epm_list.begin());
                     }
                 }
 
-                cur_epm->clear_am_to_do();
+                found_epms[cur_epm].clear_am_to_do();
                 // the tolerance stays the same as we inserted only optimal
                 // solutions
             }
             // add the EPM at the current position pos_cur_epm to the
             // PatternPairMap if we came from the F matrix
             if (check_PPM() && min_allowed_score != -1) {
-                cur_epm->set_score(min_allowed_score +
-                                   cur_epm->get_max_tol_left());
-                add_foundEPM(*cur_epm, count_EPMs);
+                found_epms[cur_epm].set_score(min_allowed_score +
+                                   found_epms[cur_epm].get_max_tol_left());
+                add_foundEPM(found_epms[cur_epm], count_EPMs, true);
             }
 
             // the last element that needs to be processed is reached ->
@@ -2064,14 +2283,14 @@ namespace LocARNA {
                            std::vector<score_t> &max_tol_left_up_to_pos,
                            std::vector<const EPM *> &epms_to_insert,
                            score_t min_score,
-                           epm_it_t cur_epm,
+                           epm_idx_t cur_epm,
                            epm_cont_t &found_epms,
                            bool count_EPMs) {
-        assert(cur_epm->number_of_am() > 0);
-        assert(vec_idx < cur_epm->number_of_am());
+        assert(found_epms[cur_epm].number_of_am() > 0);
+        assert(vec_idx < found_epms[cur_epm].number_of_am());
 
         // arc match that is filled in the current epm
-        const PairArcIdx &cur_arcs_idx = cur_epm->get_am(vec_idx);
+        const PairArcIdx &cur_arcs_idx = found_epms[cur_epm].get_am(vec_idx);
 
         map_am_to_do_t::const_iterator res = map_am_to_do.find(cur_arcs_idx);
         assert(res != map_am_to_do.end());
@@ -2117,23 +2336,23 @@ namespace LocARNA {
 
             // if we haven't filled all arc matches, we go to the next arc match
             // indexed by vec_idx+1 in the current epm
-            if (vec_idx + 1 < cur_epm->number_of_am()) {
+            if (vec_idx + 1 < found_epms[cur_epm].number_of_am()) {
                 size_type next_vec_idx = vec_idx + 1;
                 fill_epm(map_am_to_do, next_vec_idx, max_tol_left_up_to_pos,
                          epms_to_insert, min_score, cur_epm, found_epms,
                          count_EPMs);
             } else { // if all arc matches are filled
 
-                if (cur_epm->get_first_insertion()) {
+                if (found_epms[cur_epm].get_first_insertion()) {
                     // first insertion, we skip this possibility and insert it
                     // later
-                    cur_epm->set_first_insertion(false);
+                    found_epms[cur_epm].set_first_insertion(false);
                 }
 
                 // if this is not the first insertion for the current epm
                 else {
                     // copy the current epm
-                    found_epms.push_back(*cur_epm);
+                    found_epms.push_back(found_epms[cur_epm]);
 
                     if (!count_EPMs) {
                         // insert the parts for the missing arc matches, not
@@ -2157,8 +2376,8 @@ namespace LocARNA {
                             min_score +
                             max_tol_left); // set the final score of the epm
                         add_foundEPM(
-                            found_epms.back(),
-                            count_EPMs); // store epm also in the patternPairMap
+                            found_epms.back(), count_EPMs,
+                            true); // store epm also in the patternPairMap
                     }
                 }
             }
@@ -2176,6 +2395,11 @@ namespace LocARNA {
                                  size_type offsetB,
                                  bool suboptimal,
                                  bool add_info) {
+        const ScoreMatrix &L = lglr_.L;
+        const ScoreMatrix &G_A = lglr_.G_A;
+        const ScoreMatrix &G_AB = lglr_.G_AB;
+        const ScoreMatrix &LR = lglr_.LR;
+
         size_type num_posA = sparse_mapperA.number_of_valid_mat_pos(a.idx());
         size_type num_posB = sparse_mapperB.number_of_valid_mat_pos(b.idx());
         if (offsetA > num_posA) {
@@ -2461,9 +2685,6 @@ namespace LocARNA {
     //    SinglePatterns
     //--------------------------------------------------------------------------
     PatternPairMap::PatternPairMap() {
-        idMap.clear();
-        patternList.clear();
-        patternOrderedMap.clear();
         minPatternSize = 100000;
     }
 
@@ -2476,9 +2697,9 @@ namespace LocARNA {
                         const SinglePattern &second,
                         const std::string &structure,
                         int score) {
-        patternList.push_back(std::make_unique<PatternPair>(id, first, second, structure, score));
-        auto p = patternList.back().get();
-        idMap.insert(make_pair(id, p));
+        patternStore.emplace_back(id, first, second, structure, score);
+        auto p = &patternStore.back();
+        patternList.push_back(p);
         if (p->getSize() < minPatternSize) {
             minPatternSize = p->getSize();
         }
@@ -2486,9 +2707,9 @@ namespace LocARNA {
 
     void
     PatternPairMap::add(const SelfValuePTR value) {
-        patternList.push_back(std::make_unique<PatternPair>(*value));
-        auto p = patternList.back().get();
-        idMap.insert(make_pair(value->getId(), p));
+        patternStore.push_back(*value);
+        auto p = &patternStore.back();
+        patternList.push_back(p);
         if (p->getSize() < minPatternSize) {
             minPatternSize = p->getSize();
         }
@@ -2496,18 +2717,16 @@ namespace LocARNA {
 
     void
     PatternPairMap::makeOrderedMap() {
-        patternOrderedMap.clear();
-        for ( const auto &x: patternList ) {
-            patternOrderedMap.insert(std::make_pair(x->getSize(), x.get()));
-        }
+        patternOrderedMap = patternList;
+        std::stable_sort(patternOrderedMap.begin(), patternOrderedMap.end(),
+                         [](SelfValuePTR x, SelfValuePTR y) {
+                             return x->getSize() > y->getSize();
+                         });
     }
 
     // void
     // PatternPairMap::updateFromMap() {
     //     if (!patternOrderedMap.empty()) {
-    //         idMap.clear();
-
-    //         @todo this would crash, since patternList holds unique ptrs !
     //         patternList.clear();
     //         for (orderedMapITER i = patternOrderedMap.begin();
     //              i != patternOrderedMap.end(); ++i) {
@@ -2517,13 +2736,13 @@ namespace LocARNA {
     // }
 
     const PatternPair &
-    PatternPairMap::getPatternPair(const std::string &id) const {
-        return *(idMap.find(id)->second);
+    PatternPairMap::getPatternPair(size_type idx) const {
+        return *patternList.at(idx);
     }
 
     const PatternPairMap::SelfValuePTR
-    PatternPairMap::getPatternPairPTR(const std::string &id) const {
-        return (idMap.find(id)->second);
+    PatternPairMap::getPatternPairPTR(size_type idx) const {
+        return patternList.at(idx);
     }
 
     const PatternPairMap::patListTYPE &
@@ -2542,7 +2761,7 @@ namespace LocARNA {
 
     const int
     PatternPairMap::size() const {
-        return idMap.size();
+        return patternList.size();
     }
 
     int
@@ -2563,17 +2782,22 @@ namespace LocARNA {
         return EPMscore;
     }
 
-    std::ostream &
-    operator<<(std::ostream &out,
-               const PatternPairMap::patListTYPE &pat_pair_list) {
-        size_type i = 0;
-        out << "epm_id\t score\t structure\t positions" << std::endl;
-        for (const auto &x : pat_pair_list) {
-            const PatternPair &pat_pair = *x;
-            out << i << "\t" << pat_pair.getScore() << "\t"
-                << pat_pair.get_struct() << "\t";
-            const intVec &pat1 = pat_pair.getFirstPat().getPat();
-            const intVec &pat2 = pat_pair.getSecPat().getPat();
+    namespace {
+        //! write the header of an EPM list
+        void
+        write_epm_list_header(std::ostream &out) {
+            out << "epm_id\t score\t structure\t positions" << std::endl;
+        }
+
+        //! write one EPM of an EPM list
+        void
+        write_epm_list_entry(std::ostream &out,
+                             size_type i,
+                             int score,
+                             const std::string &structure,
+                             const intVec &pat1,
+                             const intVec &pat2) {
+            out << i << "\t" << score << "\t" << structure << "\t";
 
             assert(pat1.size() == pat2.size());
             intVec::const_iterator it_pat1 = pat1.begin();
@@ -2583,16 +2807,69 @@ namespace LocARNA {
                 out << *it_pat1 << ":" << *it_pat2 << " ";
             }
             out << std::endl;
+        }
+    }
+
+    std::ostream &
+    operator<<(std::ostream &out,
+               const PatternPairMap::patListTYPE &pat_pair_list) {
+        size_type i = 0;
+        write_epm_list_header(out);
+        for (const auto &x : pat_pair_list) {
+            const PatternPair &pat_pair = *x;
+            write_epm_list_entry(out, i, pat_pair.getScore(),
+                                 pat_pair.get_struct(),
+                                 pat_pair.getFirstPat().getPat(),
+                                 pat_pair.getSecPat().getPat());
             ++i;
         }
         return out;
     }
 
+    EPMListWriter::EPMListWriter(std::ostream &out_)
+        : out(out_), written(0), skipped(0) {
+        write_epm_list_header(out);
+    }
+
+    bool
+    EPMListWriter::write(int score,
+                         const std::string &structure,
+                         const intVec &pat1,
+                         const intVec &pat2,
+                         bool skip_duplicates) {
+        if (skip_duplicates) {
+            // FNV-1a hash of score, structure and positions
+            uint64_t fingerprint = 14695981039346656037ULL;
+            auto add = [&fingerprint](uint64_t value) {
+                for (size_t k = 0; k < sizeof(value); k++) {
+                    fingerprint ^= (value >> (8 * k)) & 0xff;
+                    fingerprint *= 1099511628211ULL;
+                }
+            };
+            add((uint32_t)score);
+            for (char c : structure) {
+                add((unsigned char)c);
+            }
+            for (size_t k = 0; k < pat1.size(); k++) {
+                add(((uint64_t)pat1[k] << 32) | pat2[k]);
+            }
+
+            if (!fingerprints.insert(fingerprint).second) {
+                ++skipped;
+                return false;
+            }
+        }
+
+        write_epm_list_entry(out, written, score, structure, pat1, pat2);
+        ++written;
+        return true;
+    }
+
     LCSEPM::~LCSEPM() {
         // std::cout << std::endl << " execute destructor..." << std::endl;
 
-        EPM_Table2.clear();
-        holeOrdering2.clear();
+        EPMsByStart.clear();
+        holeOrdering.clear();
     }
 
     void
@@ -2606,23 +2883,21 @@ namespace LocARNA {
         preProcessing();
         if (!quiet) {
             std::cout << " LCSEPM calculate holes..." << std::endl;
-            std::cout << "   holes to calculate = " << holeOrdering2.size()
+            std::cout << "   holes to calculate = " << holeOrdering.size()
                       << std::endl;
         }
-        calculateHoles3(quiet);
+        calculateHoles(quiet);
         if (!quiet) {
-            std::cout << " LCSEPM calculate outmost D_rec..." << std::endl;
+            std::cout << " LCSEPM chain outmost EPMs..." << std::endl;
         }
         int i = 1;
         int k = 1;
-        std::vector<std::vector<int> > last_vec;
-        int LCSEPMscore =
-            D_rec2(i, seqA.length(), k, seqB.length(), last_vec, false);
+        int LCSEPMscore = chain(i, seqA.length(), k, seqB.length(), nullptr);
         if (!quiet) {
             std::cout << "    Score LCS-EPM: " << LCSEPMscore << std::endl;
             std::cout << " LCSEPM calculate traceback..." << std::endl;
         }
-        calculateTraceback2(i, seqA.length(), k, seqB.length(), last_vec);
+        calculateTraceback(i, seqA.length(), k, seqB.length());
         int LCSEPMsize = matchedEPMs.getMapBases();
         if (!quiet) {
             std::cout << "    #EPMs: " << matchedEPMs.size()
@@ -2661,160 +2936,244 @@ namespace LocARNA {
 
     void
     LCSEPM::preProcessing() {
-        // set EPM_Table size
-        EPM_Table2.resize(seqA.length() + 1);
-        for (unsigned int i = 0; i < EPM_Table2.size(); ++i)
-            EPM_Table2[i].resize(seqB.length() + 1);
-
-        for ( const auto &myPair: patterns.getList() ) {
-            calculatePatternBoundaries(myPair.get());
+        const PatternPairMap::patListTYPE &epms = patterns.getList();
 
-            // add EPM to EPM_table
-            EPM_Table2[myPair->getOutsideBounds().first.second]
-                      [myPair->getOutsideBounds().second.second]
-                          .push_back(myPair.get());
+        EPMsByStart.resize(epms.size());
+        for (size_type x = 0; x < epms.size(); ++x) {
+            PatternPairMap::SelfValuePTR myPair = epms[x];
+            calculatePatternBoundaries(myPair);
+            EPMsByStart[x] = x;
 
-            // add all inside Holes from current EPM to holeOrdering multimap,
-            // sorted by holes size and exact position
-            for (const auto & h : myPair->getInsideBounds()) {
-                // insert hole in multimap
-                holeOrdering2.insert(std::make_pair(&h, myPair.get()));
+            // collect all inside holes of the current EPM
+            for (const auto &h : myPair->getInsideBounds()) {
+                holeOrdering.push_back(std::make_pair(&h, myPair));
             }
         }
+
+        std::stable_sort(EPMsByStart.begin(), EPMsByStart.end(),
+                         [&epms](size_type x, size_type y) {
+                             return epms[x]->getOutsideBounds().first.first <
+                                 epms[y]->getOutsideBounds().first.first;
+                         });
+
+        // sort holes by their size in A, such that holes are computed
+        // after all holes that they can contain; identical holes become
+        // neighbors
+        std::stable_sort(holeOrdering.begin(), holeOrdering.end(),
+                         [](const hole_t &h1, const hole_t &h2) {
+                             const intPPair &x = *h1.first;
+                             const intPPair &y = *h2.first;
+                             int size1 = x.first.second - x.first.first;
+                             int size2 = y.first.second - y.first.first;
+                             return std::tie(size1, x) < std::tie(size2, y);
+                         });
     }
 
-    int
-    LCSEPM::D_rec2(const int &i,
-                   const int &j,
-                   const int &k,
-                   const int &l,
-                   std::vector<std::vector<int> > &D_h,
-                   const bool debug) {
-        // initialize D_h matrix with 0
-        D_h.clear();
-        D_h.resize(j - i + 2);
-        for (unsigned int a = 0; a < D_h.size(); ++a)
-            D_h[a].resize(l - k + 2, 0);
-
-        // assert(i<=j);
-        // assert(k<=l);
-
-        for (unsigned int j_1 = 1; j_1 < size_t(j - i + 2); ++j_1)
-            for (unsigned int l_2 = 1; l_2 < size_t(l - k + 2); ++l_2) {
-                if (debug == true) {
-                    //      std::cout << "debug " << j_1 << "," << l_2 <<
-                    //      std::endl;
+    namespace {
+        //! candidate EPM of a chain
+        struct chain_candidate_t {
+            PatternPairMap::SelfValuePTR epm; //!< the EPM
+            size_type rank; //!< index in the list of EPMs
+            int best;       //!< score of the best chain ending in the EPM
+            int pred;       //!< predecessor in this chain (-1 if none)
+
+            //! first position in A
+            int
+            startA() const {
+                return epm->getOutsideBounds().first.first;
+            }
+            //! last position in A
+            int
+            endA() const {
+                return epm->getOutsideBounds().first.second;
+            }
+            //! first position in B
+            int
+            startB() const {
+                return epm->getOutsideBounds().second.first;
+            }
+            //! last position in B
+            int
+            endB() const {
+                return epm->getOutsideBounds().second.second;
+            }
+
+            //! whether this candidate is preferred as last EPM of a chain
+            bool
+            better(const chain_candidate_t &y) const {
+                if (best != y.best) {
+                    return best > y.best;
                 }
-                // check if EPMs ending at current position
-                if (EPM_Table2[i + j_1 - 1][k + l_2 - 1].size() == 0) {
-                    D_h[j_1][l_2] = (D_h[j_1 - 1][l_2] > D_h[j_1][l_2 - 1])
-                        ? D_h[j_1 - 1][l_2]
-                        : D_h[j_1][l_2 - 1];
-                    // bug in old version? this is new: - No!
-                    // D_h[j_1][l_2] =
-                    // max3(D_h[j_1-1][l_2],D_h[j_1][l_2-1],D_h[j_1-1][l_2-1]) ;
-                } else {
-                    // get list of all EPMS ending at current pos
-                    std::vector<PatternPairMap::SelfValuePTR> EPM_list =
-                        EPM_Table2[i + j_1 - 1][k + l_2 - 1];
-                    int maxScore = 0;
-
-                    // iterate over all EPMS to get best score
-                    for (const auto &myX : EPM_list) {
-                        // std::cout << i+j_1-1 << "," << k+l_2-1 << " patid: "
-                        // <<  myX->getId() << std::endl;
-
-                        int pos_before_EPM_Str1 =
-                            myX->getOutsideBounds().first.first - i;
-                        int pos_before_EPM_Str2 =
-                            myX->getOutsideBounds().second.first - k;
-
-                        int score_EPM = 0;
-
-                        // check if EPM fits into cuurent hole
-                        if ((pos_before_EPM_Str1 >= 0) &&
-                            (pos_before_EPM_Str2 >= 0)) {
-                            score_EPM =
-                                D_h[pos_before_EPM_Str1][pos_before_EPM_Str2] +
-                                myX->getScore();
-                            // std::cout << myX->getId() << " FITS - EPM
-                            // max score "<< score_EPM << " before " <<
-                            // pos_before_EPM_Str1+i <<","<<
-                            // pos_before_EPM_Str2+k << " " <<
-                            // D_h[pos_before_EPM_Str1][pos_before_EPM_Str2] <<
-                            // std::endl;
-                        }
+                if (endB() != y.endB()) {
+                    return endB() < y.endB();
+                }
+                if (endA() != y.endA()) {
+                    return endA() < y.endA();
+                }
+                return rank < y.rank;
+            }
+        };
+
+        /**
+         * @brief Fenwick tree for prefix maxima of chain candidates
+         *
+         * Maps positions 1..n to candidates (by index); the maximum
+         * refers to chain_candidate_t::better().
+         */
+        class ChainFenwickTree {
+        public:
+            ChainFenwickTree(const std::vector<chain_candidate_t> &candidates,
+                             size_t n)
+                : candidates_(candidates), tree_(n + 1, -1) {}
+
+            //! set candidate x at position pos
+            void
+            update(size_t pos, int x) {
+                for (; pos < tree_.size(); pos += pos & (~pos + 1)) {
+                    if (tree_[pos] < 0 ||
+                        candidates_[x].better(candidates_[tree_[pos]])) {
+                        tree_[pos] = x;
+                    }
+                }
+            }
 
-                        if (score_EPM > maxScore) {
-                            maxScore = score_EPM;
-                        }
-                        // std::cout << myX->getId() << " EPM max score
-                        // "<< score_EPM << " before " << pos_before_EPM_Str1+i
-                        // <<","<< pos_before_EPM_Str2+k <<  std::endl;
+            //! best candidate in positions 1..pos (-1 if none)
+            int
+            query(size_t pos) const {
+                int x = -1;
+                for (; pos > 0; pos -= pos & (~pos + 1)) {
+                    if (tree_[pos] >= 0 &&
+                        (x < 0 ||
+                         candidates_[tree_[pos]].better(candidates_[x]))) {
+                        x = tree_[pos];
                     }
-                    // std::cout << "score hole max "<< maxScore << std::endl;
-                    D_h[j_1][l_2] =
-                        max3(maxScore, D_h[j_1 - 1][l_2], D_h[j_1][l_2 - 1]);
                 }
+                return x;
+            }
+
+        private:
+            const std::vector<chain_candidate_t> &candidates_;
+            std::vector<int> tree_;
+        };
+    }
+
+    int
+    LCSEPM::chain(int i,
+                  int j,
+                  int k,
+                  int l,
+                  std::vector<PatternPairMap::SelfValuePTR> *trace) const {
+        const PatternPairMap::patListTYPE &epms = patterns.getList();
+
+        // EPMs that start in [i..j] in A, in the order of their start
+        auto first = std::lower_bound(
+            EPMsByStart.begin(), EPMsByStart.end(), i,
+            [&epms](size_type x, int pos) {
+                return int(epms[x]->getOutsideBounds().first.first) < pos;
+            });
+        auto last = std::upper_bound(
+            first, EPMsByStart.end(), j, [&epms](int pos, size_type x) {
+                return pos < int(epms[x]->getOutsideBounds().first.first);
+            });
+
+        std::vector<chain_candidate_t> candidates;
+        for (auto it = first; it != last; ++it) {
+            chain_candidate_t x = {epms[*it], *it, 0, -1};
+            if (x.endA() <= j && x.startB() >= k && x.endB() <= l) {
+                candidates.push_back(x);
             }
-        return (D_h[j - i + 1][l - k + 1]);
+        }
+        if (candidates.empty()) {
+            return 0;
+        }
+
+        // compress the end positions in B
+        std::vector<int> endsB;
+        endsB.reserve(candidates.size());
+        for (const auto &x : candidates) {
+            endsB.push_back(x.endB());
+        }
+        std::sort(endsB.begin(), endsB.end());
+        endsB.erase(std::unique(endsB.begin(), endsB.end()), endsB.end());
+
+        // candidates in the order of their end in A
+        std::vector<int> byEndA(candidates.size());
+        for (size_t x = 0; x < candidates.size(); ++x) {
+            byEndA[x] = x;
+        }
+        std::sort(byEndA.begin(), byEndA.end(), [&candidates](int x, int y) {
+            return candidates[x].endA() < candidates[y].endA();
+        });
+
+        // sweep over the starts in A; the tree holds the candidates that
+        // end before the current start in A
+        ChainFenwickTree tree(candidates, endsB.size());
+        size_t ended = 0;
+        for (auto &x : candidates) {
+            for (; ended < byEndA.size() &&
+                 candidates[byEndA[ended]].endA() < x.startA();
+                 ++ended) {
+                int y = byEndA[ended];
+                size_t pos = std::lower_bound(endsB.begin(), endsB.end(),
+                                              candidates[y].endB()) -
+                    endsB.begin() + 1;
+                tree.update(pos, y);
+            }
+            size_t pos =
+                std::lower_bound(endsB.begin(), endsB.end(), x.startB()) -
+                endsB.begin();
+            int y = tree.query(pos);
+            x.best = x.epm->getScore();
+            if (y >= 0 && candidates[y].best > 0) {
+                x.best += candidates[y].best;
+                x.pred = y;
+            }
+        }
+
+        int best = 0;
+        for (size_t x = 0; x < candidates.size(); ++x) {
+            if (candidates[x].best > 0 &&
+                (best == 0 || candidates[x].better(candidates[best - 1]))) {
+                best = x + 1;
+            }
+        }
+        if (best == 0) {
+            return 0;
+        }
+
+        if (trace != nullptr) {
+            trace->clear();
+            for (int x = best - 1; x >= 0; x = candidates[x].pred) {
+                trace->push_back(candidates[x].epm);
+            }
+        }
+        return candidates[best - 1].best;
     }
 
     void
-    LCSEPM::calculateHoles3(bool quiet) {
+    LCSEPM::calculateHoles(bool quiet) {
         intPPairPTR lastHole = NULL;
-        // PatternPairMap::SelfValuePTR lastEPM  = NULL;
         int lastHoleScore = 0;
         int skippedHoles = 0;
-        for (HoleMapCITER2 t = holeOrdering2.begin(); t != holeOrdering2.end();
-             ++t) {
-            // check if current hole is exactly teh same as last hole
+        for (const auto &t : holeOrdering) {
+            // check if current hole is exactly the same as last hole
             // then we do not need to calculate again the same hole
             // ordering of "holeOrdering" ensures that similar holes are next to
             // each other
-            if ((lastHole == NULL) ||
-                (lastHole->first.first != (*t).first->first.first) ||
-                (lastHole->first.second != (*t).first->first.second) ||
-                (lastHole->second.first != (*t).first->second.first) ||
-                (lastHole->second.second != (*t).first->second.second)) {
-                // std::cout << std::endl << (*t).second->getId() << std::endl
-                // <<  " new current hole " << (*t).first->first.first << "," <<
-                // (*t).first->first.second;
-                // std::cout << " - " << (*t).first->second.first << "," <<
-                // (*t).first->second.second << std::endl;
-                // std::cout << "score old " << (*t).second->getScore() << " "
-                // << (*t).second->get_struct() << std::endl;
-
+            if ((lastHole == NULL) || (*lastHole != *t.first)) {
                 // calculate best score of hole
-                bool deb = false;
-                std::vector<std::vector<int> > vec;
-                int holeScore = D_rec2((*t).first->first.first + 1,
-                                       (*t).first->first.second - 1,
-                                       (*t).first->second.first + 1,
-                                       (*t).first->second.second - 1, vec, deb);
-                (*t).second->setEPMScore((*t).second->getScore() + holeScore);
-
-                // std::cout << "score new " << (*t).second->getScore() <<
-                // std::endl;
-
-                lastHole = (*t).first;
-                // lastEPM = (*t).second;
+                int holeScore =
+                    chain(t.first->first.first + 1, t.first->first.second - 1,
+                          t.first->second.first + 1, t.first->second.second - 1,
+                          nullptr);
+                t.second->setEPMScore(t.second->getScore() + holeScore);
+
+                lastHole = t.first;
                 lastHoleScore = holeScore;
             } else {
                 // add score of last hole to current EPM
-                (*t).second->setEPMScore((*t).second->getScore() +
-                                         lastHoleScore);
+                t.second->setEPMScore(t.second->getScore() + lastHoleScore);
                 skippedHoles++;
-                // std::cout << std::endl << (*t).second->getId() << std::endl
-                // <<  " new current hole " << (*t).first->first.first << "," <<
-                // (*t).first->first.second;
-                // std::cout << " - " << (*t).first->second.first << "," <<
-                // (*t).first->second.second <<  " " <<
-                // (*t).second->get_struct() << std::endl;
-                // std::cout << "score:"<< lastHoleScore << "-"<<
-                // (*t).second->getEPMScore() << "-" << (*t).second->getScore()
-                // << " - current hole is same as last hole. skip!" <<
-                // std::endl;
             }
         }
         if (!quiet) {
@@ -2823,94 +3182,18 @@ namespace LocARNA {
     }
 
     void
-    LCSEPM::calculateTraceback2(const int i,
-                                const int j,
-                                const int k,
-                                const int l,
-                                std::vector<std::vector<int> > holeVec) {
-        int j_1 = holeVec.size() - 1;
-        int l_2 = holeVec[0].size() - 1;
-
-        while ((j_1 >= 1) && (l_2 >= 1) && (holeVec[j_1][l_2] > 0)) {
-            // std::cout << "traceback " << i+j_1-1 <<","<< k+l_2-1 << " score:
-            // "<<holeVec[j_1][l_2] << std::endl;
-            if (holeVec[j_1][l_2 - 1] == holeVec[j_1][l_2])
-                --l_2;
-            else if (holeVec[j_1 - 1][l_2] == holeVec[j_1][l_2])
-                --j_1;
-            else {
-                // get all EPMs which end at (i + j_1-1,k + l_2-1)
-                std::vector<PatternPairMap::SelfValuePTR> EPM_list =
-                    EPM_Table2[i + j_1 - 1][k + l_2 - 1];
-
-                // over all EPMs which end at (i+j_1-1,k+l_2-1)
-                for (const auto &myX : EPM_list) {
-                    // std::cout << "here " << myX->getId() << std::endl;
-
-                    // check if current EPM fits inside current hole
-                    int x1 = myX->getOutsideBounds().first.first - i;
-                    int x2 = myX->getOutsideBounds().second.first - k;
-                    if ((x1 >= 0) && (x2 >= 0)) {
-                        // check score
-
-                        // std::cout << "(j_1,l_2)=(" << j_1<< "," << l_2 <<")
-                        // "<< i <<","<< j << "-" << k << "," << l << "
-                        // outsidebounds first " <<
-                        // myX->getOutsideBounds().first.first << "," <<
-                        // myX->getOutsideBounds().second.first <<
-                        // std::endl;
-                        // std::cout << "score (j1,l2)="<< holeVec[j_1][l_2] <<
-                        // " score=" << myX->getScore() << "  EPM_score="
-                        // << myX->getEPMScore() << "
-                        // before="<<holeVec[myX->getOutsideBounds().first.first-1][myX->getOutsideBounds().second.first-1];
-                        // std::cout << " " <<
-                        // myX->getOutsideBounds().first.first-1 << "," <<
-                        // myX->getOutsideBounds().second.first-1<<
-                        // std::endl;
-                        int check = myX->getScore() + holeVec[x1][x2];
-                        if (holeVec[j_1][l_2] == check) {
-                            // add current EPM to traceback
-                            // std::cout << "added traceback EPM "<<
-                            // myX->getId() << std::endl;
-                            matchedEPMs.add(myX);
-
-                            // recurse with traceback into all holes of best EPM
-                            for (const auto &h : myX->getInsideBounds()) {
-                                std::vector<std::vector<int> > tmpHoleVec;
-                                tmpHoleVec.clear();
-                                // std::cout << myX->getId() << " D_rec2
-                                // hole " << h.first.first+1 << "," <<
-                                // h.first.second-1 << "-" <<
-                                // h.second.first+1 << "," <<
-                                // h.second.second-1 << std::endl;
-                                int sc = D_rec2(h.first.first + 1,
-                                                h.first.second - 1,
-                                                h.second.first + 1,
-                                                h.second.second - 1,
-                                                tmpHoleVec, true);
-                                // call traceback only if there is an EPM within
-                                // hole
-                                // std::cout << myX->getId() << "score "<<
-                                // sc << " " << h.first.first+1 << "," <<
-                                // h.first.second-1 << "-" <<
-                                // h.second.first+1 << "," <<
-                                // h.second.second-1 << " hole traceback..."
-                                // << std::endl;
-                                if (sc > 0) {
-                                    calculateTraceback2(h.first.first + 1,
-                                                        h.first.second - 1,
-                                                        h.second.first + 1,
-                                                        h.second.second - 1,
-                                                        tmpHoleVec);
-                                }
-                            }
-                            // jump with traceback to position before EPM
-                            j_1 = (myX->getOutsideBounds().first.first) - i;
-                            l_2 = (myX->getOutsideBounds().second.first) - k;
-                            break;
-                        }
-                    } // if EPM fits hole
-                }     // for
+    LCSEPM::calculateTraceback(int i, int j, int k, int l) {
+        std::vector<PatternPairMap::SelfValuePTR> trace;
+        chain(i, j, k, l, &trace);
+
+        for (const auto &myX : trace) {
+            // add current EPM to traceback
+            matchedEPMs.add(myX);
+
+            // recurse with traceback into all holes of the EPM
+            for (const auto &h : myX->getInsideBounds()) {
+                calculateTraceback(h.first.first + 1, h.first.second - 1,
+                                   h.second.first + 1, h.second.second - 1);
             }
         }
     }
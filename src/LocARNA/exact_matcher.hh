@@ -6,12 +6,14 @@
 #endif
 
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #include <iterator>
 #include <list>
 #include <limits>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "aux.hh"
 #include "ext_rna_data.hh"
@@ -254,25 +256,28 @@ namespace LocARNA {
 
     /**
      * \brief manage a set of EPMs (PatternPair)
+     *
+     * The PatternPairs are stored in chunks that are never moved, such
+     * that pointers to them stay valid while EPMs are added. The list
+     * of PatternPairs is a flat vector of pointers in the order of
+     * addition; the position in this list serves as id.
      */
     class PatternPairMap {
     public:
         typedef PatternPair selfValueTYPE; //!< PatternPair
         typedef PatternPair *SelfValuePTR; //!< pointer to PatternPair
 
-        typedef std::multimap<int, SelfValuePTR, std::greater<int> >
-            orderedMapTYPE; //!< ordered map type
+        typedef std::vector<SelfValuePTR>
+            orderedMapTYPE; //!< PatternPairs ordered by decreasing size
         typedef orderedMapTYPE::const_iterator
-            orderedMapCITER; //!< const iterator for the map
+            orderedMapCITER; //!< const iterator for the ordered map
         typedef orderedMapTYPE::iterator
-            orderedMapITER;                          //!< iterator for the map
-        typedef std::vector<std::unique_ptr<selfValueTYPE>> patListTYPE; //!< list of patternPairs
+            orderedMapITER;  //!< iterator for the ordered map
+        typedef std::vector<SelfValuePTR> patListTYPE; //!< list of patternPairs
         typedef patListTYPE::iterator
             patListITER; //!< iterator for the list of PatternPairs
         typedef patListTYPE::const_iterator
             patListCITER; //!< const iterator for the list of PatternPairs
-        typedef std::unordered_map<std::string, SelfValuePTR>
-            PatternIdMapTYPE; //!< map type patternId -> pointer to PatternPair
 
         //! Contructor
         PatternPairMap();
@@ -313,7 +318,8 @@ namespace LocARNA {
         void
         add(const SelfValuePTR value);
 
-        //! creates the ordered Map
+        //! creates the ordered Map by sorting once (stable, such that
+        //! PatternPairs of equal size stay in the order of addition)
         void
         makeOrderedMap();
 
@@ -322,20 +328,20 @@ namespace LocARNA {
         // updateFromMap();
 
         /**
-         * \brief gets the PatternPair with the Id id
-         * @param id Id of PatternPair
-         * @return PatternPair with Id id
+         * \brief gets the PatternPair with index idx
+         * @param idx index of the PatternPair in the list
+         * @return PatternPair at index idx
          */
         const PatternPair &
-        getPatternPair(const std::string &id) const;
+        getPatternPair(size_type idx) const;
 
         /**
-         * \brief gets the pointer to the PatternPair with the Id id
-         * @param id Id of PatternPair
-         * @return pointer to the PatternPair with Id id
+         * \brief gets the pointer to the PatternPair with index idx
+         * @param idx index of the PatternPair in the list
+         * @return pointer to the PatternPair at index idx
          */
         const SelfValuePTR
-        getPatternPairPTR(const std::string &id) const;
+        getPatternPairPTR(size_type idx) const;
 
         /**
          * read access
@@ -360,7 +366,7 @@ namespace LocARNA {
 
         /**
          * read access
-         * @return size of the idMap
+         * @return number of PatternPairs
          */
         const int
         size() const;
@@ -389,10 +395,10 @@ namespace LocARNA {
         };
 
     private:
+        std::deque<PatternPair> patternStore; //!< storage of the PatternPairs
         patListTYPE patternList;          //!< list of PatternPairs
         orderedMapTYPE patternOrderedMap; //!< ordered Map with respect to the
                                           //!size of the PatternPairs
-        PatternIdMapTYPE idMap; //!< map: patternId -> pointer to PatternPair
         int minPatternSize;     //!< minimum size of a Pattern
     };
 
@@ -406,8 +412,78 @@ namespace LocARNA {
     operator<<(std::ostream &out,
                const PatternPairMap::patListTYPE &pat_pair_map);
 
+    /**
+     * \brief writes EPMs to a stream as soon as they are traced
+     *
+     * Writes the same list as the output operator of the pattern list
+     * of a PatternPairMap, but without storing the EPMs. In order to
+     * skip EPMs that were already written, the writer can keep a 64 bit
+     * fingerprint of the score, structure and positions of each
+     * written EPM; then, its memory grows linearly with the number of
+     * written EPMs.
+     *
+     * @see ExactMatcher::set_epm_writer()
+     */
+    class EPMListWriter {
+    public:
+        /**
+         * \brief Constructor, writes the header of the list
+         * @param out output stream
+         */
+        explicit EPMListWriter(std::ostream &out);
+
+        /**
+         * \brief write an EPM
+         * @param score score of the EPM
+         * @param structure structure of the EPM
+         * @param pat1 positions in the first sequence
+         * @param pat2 positions in the second sequence
+         * @param skip_duplicates whether to skip the EPM if it was
+         * already written; this keeps its fingerprint
+         * @return whether the EPM was written
+         * @note EPMs of equal fingerprints are considered equal; a
+         * hash collision drops a distinct EPM
+         */
+        bool
+        write(int score,
+              const std::string &structure,
+              const intVec &pat1,
+              const intVec &pat2,
+              bool skip_duplicates);
+
+        //! number of written EPMs
+        size_type
+        size() const {
+            return written;
+        }
+
+        //! number of skipped duplicate EPMs
+        size_type
+        duplicates() const {
+            return skipped;
+        }
+
+    private:
+        std::ostream &out;                       //!< output stream
+        std::unordered_set<uint64_t> fingerprints; //!< fingerprints of the
+                                                   //!EPMs written with
+                                                   //!skip_duplicates
+        size_type written; //!< number of written EPMs
+        size_type skipped; //!< number of skipped duplicates
+    };
+
     /**
      * \brief computes the best chain of EPMs, the LCS-EPM
+     *
+     * EPMs are chained by a sparse dynamic program over their end
+     * points (see chain()). The holes of the EPMs, i.e. the gaps
+     * between consecutive positions that are large enough to contain
+     * another EPM, are chained first in the order of their size; the
+     * score of the best chain in each hole is added to the score of its
+     * EPM. Only the EPMs starting within a hole in A are visited when
+     * chaining it, found by binary search in the EPMs sorted by their
+     * start; EPMs of nested holes are visited again for each
+     * enclosing hole.
      */
     class LCSEPM {
     public:
@@ -465,60 +541,50 @@ namespace LocARNA {
         output_clustal(const std::string &outfile_name);
 
     private:
-        struct HoleCompare2 {
-            bool
-            operator()(const intPPairPTR &h1, const intPPairPTR &h2) const {
-                // first compare size of holes
-                if (h1->first.second - h1->first.first - 1 <
-                    h2->first.second - h2->first.first - 1) {
-                    return true;
-                }
-                // compare if holes are identical in both structures
-                if (h1->first.second - h1->first.first - 1 ==
-                    h2->first.second - h2->first.first - 1) {
-                    if ((h1->first.first == h2->first.first) &&
-                        (h1->first.second == h2->first.second) &&
-                        (h1->second.first == h2->second.first) &&
-                        (h1->second.second == h2->second.second)) {
-                        return true;
-                    }
-                }
-
-                return false;
-            }
-        };
-
-        typedef std::multimap<intPPairPTR,
-                              PatternPairMap::SelfValuePTR,
-                              HoleCompare2>
-            HoleOrderingMapTYPE2;
-        typedef HoleOrderingMapTYPE2::const_iterator HoleMapCITER2;
+        //! hole of an EPM together with the EPM
+        typedef std::pair<intPPairPTR, PatternPairMap::SelfValuePTR> hole_t;
 
         void
         preProcessing();
         void
-        calculateHoles3(bool quiet);
+        calculateHoles(bool quiet);
         void
         calculatePatternBoundaries(PatternPair *myPair);
-        void
-        calculateTraceback2(const int i,
-                            const int j,
-                            const int k,
-                            const int l,
-                            std::vector<std::vector<int> > holeVec);
-        int
-        D_rec2(const int &i,
-               const int &j,
-               const int &k,
-               const int &l,
-               std::vector<std::vector<int> > &D_h,
-               const bool debug);
 
+        /**
+         * @brief Best chain of the EPMs in a range
+         *
+         * @param i first position of the range in A
+         * @param j last position of the range in A
+         * @param k first position of the range in B
+         * @param l last position of the range in B
+         * @param[out] trace if not null, the EPMs of a best chain from
+         * last to first
+         * @return score of the best chain of EPMs within the range
+         *
+         * Sparse dynamic program over the EPMs of the range, ordered by
+         * their start in A. The best chains ending in the EPMs that end
+         * before the current start in A are kept in a Fenwick tree for
+         * prefix maxima over the (compressed) end positions in B. All
+         * EPMs that start in [i..j] are scanned to select the EPMs
+         * within the range; for s scanned and r selected of n EPMs, the
+         * chaining takes O(log n + s + r log r) time. s can be much
+         * larger than r if many EPMs lie outside of [k..l] in B.
+         * Ties are broken like the traceback through the full
+         * chaining matrix: prefer the chain whose last EPM ends first
+         * in B, then in A, then comes first in the list of EPMs.
+         */
         int
-        max3(int a, int b, int c) {
-            int tmp = a > b ? a : b;
-            return (tmp > c ? tmp : c);
-        };
+        chain(int i,
+              int j,
+              int k,
+              int l,
+              std::vector<PatternPairMap::SelfValuePTR> *trace) const;
+
+        //! adds a best chain of the range and, recursively, the best
+        //! chains in the holes of its EPMs to matchedEPMs
+        void
+        calculateTraceback(int i, int j, int k, int l);
 
         //!@brief returns the structure of the given sequence
         char *
@@ -545,9 +611,11 @@ namespace LocARNA {
             return s;
         }
 
-        std::vector<std::vector<std::vector<PatternPairMap::SelfValuePTR> > >
-            EPM_Table2;
-        HoleOrderingMapTYPE2 holeOrdering2;
+        //! indices of the EPMs in the list of EPMs, sorted by their
+        //! first position in A
+        std::vector<size_type> EPMsByStart;
+        //! holes of all EPMs, ordered by their size in A
+        std::vector<hole_t> holeOrdering;
         const Sequence &seqA;
         const Sequence &seqB;
         PatternPairMap &matchedEPMs;
@@ -1332,9 +1400,11 @@ namespace LocARNA {
         typedef EPM::PairArcIdxVec
             PairArcIdxVec; //!< type for vector of pairs of arc indices
 
-        typedef std::list<EPM>
-            epm_cont_t; //!< the container used for temporarily storing the EPMs
-        typedef epm_cont_t::iterator epm_it_t; //!< iterator for epm_cont_t
+        //! the container used for temporarily storing the EPMs; EPMs are
+        //! appended while tracing and addressed by their index, which stays
+        //! valid when the container grows
+        typedef std::vector<EPM> epm_cont_t;
+        typedef epm_cont_t::size_type epm_idx_t; //!< index in epm_cont_t
         typedef std::pair<score_t, epm_cont_t> el_map_am_to_do_t; //!< type for
                                                                   //!storing for
                                                                   //!a given
@@ -1389,16 +1459,54 @@ namespace LocARNA {
         PatternPairMap &foundEPMs; //!< stores all traced EPMs in the
                                    //!datastructure PatternPairMap (needed for
                                    //!the chaining)
+        EPMListWriter *epm_writer; //!< if set, traced EPMs are written by
+                                   //!the writer instead of stored in
+                                   //!foundEPMs
+
+        /**
+         * @brief Matrices L, G_A, G_AB and LR of one arc match
+         *
+         * The matrices are indexed by the sparsified positions of the
+         * current arc match. In the parallel computation of D and in
+         * the parallel heuristic traceback, each thread owns such a
+         * workspace.
+         */
+        struct LGLRMatrices {
+            ScoreMatrix L; //!< matrix that stores the best matching from the
+                           //!left
+            ScoreMatrix G_A; //!< gap matrix after inserting gaps in A
+                             //!(suboptimal traceback)
+            //!< single gap matrix G that inserts gaps in A and B (heuristic
+            //!traceback)
+            ScoreMatrix G_AB; //!< gap matrix after inserting first gaps in A
+                              //!and then in B (for suboptimal traceback)
+            ScoreMatrix
+                LR; //!< matrix that combines matching from the left and right
+
+            /**
+             * @brief Resize and initialize all matrices
+             * @param rows number of rows
+             * @param cols number of columns
+             */
+            void
+            resize(size_t rows, size_t cols) {
+                L.resize(rows, cols);
+                L.fill(infty_score_t::neg_infty);
+                L.set(0, 0, infty_score_t(0));
+
+                G_A.resize(rows, cols);
+                G_AB.resize(rows, cols);
+
+                LR.resize(rows, cols);
+                LR.fill(infty_score_t::neg_infty);
+                LR.set(0, 0, infty_score_t(0));
+            }
+        };
+
+        //! matrices L, G_A, G_AB and LR of the main thread (used in the
+        //! suboptimal traceback)
+        LGLRMatrices lglr_;
 
-        ScoreMatrix L;   //!< matrix that stores the best matching from the left
-        ScoreMatrix G_A; //!< gap matrix after inserting gaps in A (suboptimal
-                         //!traceback)
-        //!< single gap matrix G that inserts gaps in A and B (heuristic
-        //!traceback)
-        ScoreMatrix G_AB; //!< gap matrix after inserting first gaps in A and
-                          //!then in B (for suboptimal traceback)
-        ScoreMatrix
-            LR; //!< matrix that combines matching from the left and right
         ScoreMatrix F;    //!< final matrix
         ScoreMatrix Dmat; //!< score matrix which stores for each arcmatch the
                           //!score under the arcmatch
@@ -1426,6 +1534,9 @@ namespace LocARNA {
 
         bool verbose; //!< whether to output additional information
 
+        size_t threads; //!< number of threads for filling D and for the
+                        //!heuristic traceback
+
         pair_seqpos_t pos_of_max; //!< the position of the maximum in matrix F
 
         enum {
@@ -1547,6 +1658,7 @@ namespace LocARNA {
         /**
          * \brief computes matrices L, G (G_A,G_AB in suboptimal case) and LR
          *
+         * @param mats matrices L, G_A, G_AB and LR that are filled
          * @param a arc in first sequence
          * @param b arc in second sequence
          * @param suboptimal whether to compute the matrix entry for the
@@ -1556,11 +1668,15 @@ namespace LocARNA {
          *                 matrices for arcs a and b
          */
         pair_seqpos_t
-        compute_LGLR(const Arc &a, const Arc &b, bool suboptimal);
+        compute_LGLR(LGLRMatrices &mats,
+                     const Arc &a,
+                     const Arc &b,
+                     bool suboptimal);
 
         /**
          * \brief computes one entry of the matrix L or LR
          *
+         * @param mats matrices L, G_A, G_AB and LR
          * @param a arc in first sequence
          * @param b arc in second sequence
          * @param mat_pos current matrix position
@@ -1573,7 +1689,8 @@ namespace LocARNA {
          * @return the best score for matrix entry mat_pos
          */
         infty_score_t
-        compute_matrix_entry(const Arc &a,
+        compute_matrix_entry(const LGLRMatrices &mats,
+                             const Arc &a,
                              const Arc &b,
                              matpos_t mat_pos,
                              matpos_t mat_pos_diag,
@@ -1583,6 +1700,7 @@ namespace LocARNA {
         /**
          * \brief computes a sequential match or structural match
          *
+         * @param mats matrices L, G_A, G_AB and LR
          * @param a arc in first sequence
          * @param b arc in second sequence
          * @param mat_pos_diag next diagonal matrix position
@@ -1599,7 +1717,8 @@ namespace LocARNA {
          * respectively
          */
         infty_score_t
-        seq_str_matching(const Arc &a,
+        seq_str_matching(const LGLRMatrices &mats,
+                         const Arc &a,
                          const Arc &b,
                          matpos_t mat_pos_diag,
                          pair_seqpos_t seq_pos_to_be_matched,
@@ -1607,6 +1726,18 @@ namespace LocARNA {
                          bool matrixLR,
                          bool suboptimal);
 
+        /**
+         * \brief computes the arc match score of one arc match
+         *
+         * Fills the matrices L, G_A and LR for the arc match and
+         * stores the score in D; writes only the D entry of am.
+         *
+         * @param mats matrices L, G_A, G_AB and LR
+         * @param am arc match
+         */
+        void
+        compute_arcmatch_score(LGLRMatrices &mats, const ArcMatch &am);
+
         //! computes matrix F
         void
         compute_F();
@@ -1653,13 +1784,16 @@ namespace LocARNA {
 
         /**
          * \brief add current epm to list of all EPMs (PatternPairMap)
+         * or write it by the EPM writer
          *
          * @param cur_epm EPM that is added to the list of all EPMs
          * @param count_EPMs whether the EPMs are just counted or also
          * stored in the PatternPairMap
+         * @param suboptimal whether the EPM is traced by the suboptimal
+         * traceback; only there, the EPM writer skips duplicates
          */
         void
-        add_foundEPM(EPM &cur_epm, bool count_EPMs);
+        add_foundEPM(EPM &cur_epm, bool count_EPMs, bool suboptimal);
 
         bool
         check_PPM() {
@@ -1704,28 +1838,37 @@ namespace LocARNA {
          * \brief traces through the F matrix from position (i,j)
          *        to find the best EPM that ends in (i,j)
          *
+         * @param mats matrices L, G_A, G_AB and LR
          * @param i position in sequence A
          * @param j position in sequence B
          * @param cur_epm EPM that is filled
          */
         void
-        trace_F_heuristic(pos_type i, pos_type j, EPM &cur_epm);
+        trace_F_heuristic(LGLRMatrices &mats,
+                          pos_type i,
+                          pos_type j,
+                          EPM &cur_epm);
 
         /**
          * \brief traces through the L, G and LR matrix and finds
          *                the optimal solution
          *
+         * @param mats matrices L, G_A, G_AB and LR
          * @param a arc in sequence A
          * @param b arc in sequence B
          * @param cur_epm EPM that is filled
          */
         void
-        trace_LGLR_heuristic(const Arc &a, const Arc &b, EPM &cur_epm);
+        trace_LGLR_heuristic(LGLRMatrices &mats,
+                             const Arc &a,
+                             const Arc &b,
+                             EPM &cur_epm);
 
         /**
          * \brief traces a sequence or structural match for the heuristic
          * traceback
          *
+         * @param mats matrices L, G_A, G_AB and LR
          * @param a arc in sequence A
          * @param b arc in sequence B
          * @param state the matrix state before and after the match
@@ -1741,7 +1884,8 @@ namespace LocARNA {
          * @return whether the sequential/structural match is possible
          */
         bool
-        trace_seq_str_matching_heuristic(const Arc &a,
+        trace_seq_str_matching_heuristic(const LGLRMatrices &mats,
+                                         const Arc &a,
                                          const Arc &b,
                                          int &state,
                                          matpos_t &cur_mat_pos,
@@ -1814,7 +1958,7 @@ namespace LocARNA {
          * @param seq_pos_to_be_matched the sequence position that will be
          * matched
          *        (in case of an arc match the left ends of the arc match)
-         * @param cur_epm an iterator to the current EPM in found_epms (the list
+         * @param cur_epm the index of the current EPM in found_epms (the list
          * of EPMs)
          * @param am the arc match that is currently traced (pseudo arc for
          * sequential match)
@@ -1835,7 +1979,7 @@ namespace LocARNA {
                                       pair_seqpos_t seq_pos_to_be_matched,
                                       const PairArcIdx &am,
                                       poss_L_LR &poss,
-                                      epm_it_t cur_epm,
+                                      epm_idx_t cur_epm,
                                       epm_cont_t &found_epms,
                                       map_am_to_do_t &map_am_to_do,
                                       bool count_EPMs);
@@ -1848,7 +1992,7 @@ namespace LocARNA {
          * @param pot_new_poss the potential new possibility for the traceback
          * @param poss stores the first possiblity that was encountered for each
          * position
-         * @param cur_epm an iterator to the current EPM in found_epms (the list
+         * @param cur_epm the index of the current EPM in found_epms (the list
          * of EPMs)
          * @param found_epms the list of all traced EPMs
          * @param map_am_to_do stores for each arc match that was traced the
@@ -1864,7 +2008,7 @@ namespace LocARNA {
                    const Arc &b,
                    const poss_L_LR &pot_new_poss,
                    poss_L_LR &poss,
-                   epm_it_t cur_epm,
+                   epm_idx_t cur_epm,
                    epm_cont_t &found_epms,
                    map_am_to_do_t &am_to_do_for_cur_am,
                    bool count_EPMs);
@@ -1880,7 +2024,7 @@ namespace LocARNA {
          * @param new_poss the new possibility for the traceback that is stored
          * @param poss stores the first possiblity that was encountered for each
          * position
-         * @param cur_epm an iterator to the current EPM in found_epms (the list
+         * @param cur_epm the index of the current EPM in found_epms (the list
          * of EPMs)
          * @param found_epms the list of all traced EPMs
          * @param map_am_to_do stores for each arc match that was traced the
@@ -1895,7 +2039,7 @@ namespace LocARNA {
                        bool last_poss,
                        const poss_L_LR &new_poss,
                        poss_L_LR &poss,
-                       epm_it_t cur_epm,
+                       epm_idx_t cur_epm,
                        epm_cont_t &found_epms,
                        map_am_to_do_t &am_to_do_for_cur_am,
                        bool count_EPMs);
@@ -1909,7 +2053,7 @@ namespace LocARNA {
          * @param pot_new_poss the potential new possibility for the traceback
          * @param poss stores the first possiblity that was encountered for each
          * position
-         * @param cur_epm an iterator to the current EPM in found_epms (the list
+         * @param cur_epm the index of the current EPM in found_epms (the list
          * of EPMs)
          * @param found_epms the list of all traced EPMs
          * @param map_am_to_do stores for each arc match that was traced the
@@ -1923,7 +2067,7 @@ namespace LocARNA {
                            const Arc &b,
                            const poss_L_LR &pot_new_poss,
                            poss_L_LR &poss,
-                           epm_it_t cur_epm,
+                           epm_idx_t cur_epm,
                            epm_cont_t &found_epms,
                            map_am_to_do_t &map_am_to_do,
                            bool count_EPMs);
@@ -1952,7 +2096,7 @@ namespace LocARNA {
          corresponding
          *                     list of EPMs for the current arc match
 
-         * @param cur_epm an iterator to the current EPM in found_epms (the list
+         * @param cur_epm the index of the current EPM in found_epms (the list
          of EPMs)
          * @param found_epms the list of all traced EPMs
          * @param count_EPMs whether the EPMs are just counted or also
@@ -1965,7 +2109,7 @@ namespace LocARNA {
          */
         void
         preproc_fill_epm(map_am_to_do_t &am_to_do,
-                         epm_it_t cur_epm,
+                         epm_idx_t cur_epm,
                          epm_cont_t &found_epms,
                          bool count_EPMs,
                          score_t min_allowed_score = -1);
@@ -1990,7 +2134,7 @@ namespace LocARNA {
          *                  for assigning the correct score after the filling of
          * the EPM!)
          *                  from L/LR Matrix: dummy value -1
-         * @param cur_epm an iterator to the current EPM in found_epms (the list
+         * @param cur_epm the index of the current EPM in found_epms (the list
          * of EPMs)
          * @param found_epms the list of all traced EPMs
          * @param count_EPMs whether the EPMs are just counted or also
@@ -2003,7 +2147,7 @@ namespace LocARNA {
                  std::vector<score_t> &max_tol_left_up_to_pos,
                  std::vector<const EPM *> &epms_to_insert,
                  score_t min_score,
-                 epm_it_t cur_epm,
+                 epm_idx_t cur_epm,
                  epm_cont_t &found_epms,
                  bool count_EPMs);
 
@@ -2058,6 +2202,8 @@ namespace LocARNA {
          * @param apply_filter_ whether to apply an additional filter when
          * allowing inexact structure matches
          * @param verbose_ whether to write additional information
+         * @param threads_ number of threads for filling D and for the
+         * heuristic traceback
          */
         ExactMatcher(const Sequence &seqA_,
                      const Sequence &seqB_,
@@ -2075,12 +2221,23 @@ namespace LocARNA {
                      bool inexact_struct_match_,
                      score_t struct_mismatch_score_,
                      bool apply_filter_,
-                     bool verbose_);
+                     bool verbose_,
+                     size_t threads_ = 1);
 
         ~ExactMatcher();
 
-        //! fills matrix D (i.e. computes all arc match scores) by filling
-        //! matrices L, G_A and LR
+        /**
+           fills matrix D (i.e. computes all arc match scores) by filling
+           matrices L, G_A and LR
+
+           The score of an arc match depends only on the scores of its
+           inner arc matches. The arc matches are therefore grouped by
+           nesting depth, i.e. the minimum of the heights of their arcs
+           in the nesting forests of A and B; using several threads, the
+           arc matches of one depth are filled in parallel, where each
+           thread uses its own matrices L, G_A and LR. Otherwise, the
+           arc matches are filled one by one from inside to outside.
+        */
         void
         compute_arcmatch_score();
 
@@ -2088,9 +2245,32 @@ namespace LocARNA {
         void
         test_arcmatch_score();
 
+        /**
+         * \brief write the traced EPMs instead of storing them
+         *
+         * If the EPMs are not chained, the writer streams them, such
+         * that the heuristic traceback needs only constant memory; the
+         * pattern pair map stays empty. The suboptimal traceback skips
+         * EPMs that were already written, thus the writer keeps a
+         * fingerprint of each EPM there, which grows linearly with the
+         * number of EPMs.
+         *
+         * @param writer EPM writer, nullptr stores the EPMs again
+         */
+        void
+        set_epm_writer(EPMListWriter *writer) {
+            epm_writer = writer;
+        }
+
         /**
          * \brief computes the traceback and traces all EPMs
          *
+         * Using several threads, the heuristic traceback traces the
+         * EPMs of all start positions in parallel and stores them in
+         * the order of the start positions, such that the result does
+         * not depend on the number of threads. The suboptimal
+         * traceback is sequential.
+         *
          * @param suboptimal whether to compute the suboptimal or
          *        heuristic traceback
          */
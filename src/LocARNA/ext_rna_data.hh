@@ -58,6 +58,35 @@ namespace LocARNA {
                    double max_bpil_length_ratio,
                    const PFoldParams &pfoldparams);
 
+        /**
+         * @brief Construct from shared RnaEnsemble with lazy
+         * computation of stacking and in loop probabilities
+         *
+         * @param rna_ensemble RNA ensemble data
+         * @param p_bpcut cutoff probability for base pairs
+         * @param p_bpilcut cutoff probability for base pairs in loops
+         * @param p_uilcut cutoff probability for unpaired bases in loops
+         * @param pfoldparams parameters for partition folding
+         *
+         * The in loop probabilities of a loop are computed from the
+         * kept ensemble, when the loop is accessed first.
+         *
+         * @note requires that rnaensemble has in loop probabilities
+         * @note the filters max_uil_length_ratio and
+         * max_bpil_length_ratio need all in loop probabilities; if
+         * they are active, all probabilities are computed immediately
+         *
+         * @see RnaData(std::shared_ptr<const RnaEnsemble>,double,double,const PFoldParams &)
+         */
+        ExtRnaData(std::shared_ptr<const RnaEnsemble> rna_ensemble,
+                   double p_bpcut,
+                   double p_bpilcut,
+                   double p_uilcut,
+                   double max_bps_length_ratio,
+                   double max_uil_length_ratio,
+                   double max_bpil_length_ratio,
+                   const PFoldParams &pfoldparams);
+
         /**
          * @brief Construct from input file
          *
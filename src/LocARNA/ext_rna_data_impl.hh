@@ -5,7 +5,11 @@
 #include <config.h>
 #endif
 
+#include <atomic>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "ext_rna_data.hh"
 #include "rna_data_impl.hh"
@@ -50,15 +54,38 @@ namespace LocARNA {
         double p_uilcut_;
 
         //! in loop probabilities of base pairs
-        arc_prob_matrix_matrix_t arc_in_loop_probs_;
+        //! (mutable for memoization in lazy mode)
+        mutable arc_prob_matrix_matrix_t arc_in_loop_probs_;
 
         //! in loop probabilities of unpaired bases
-        arc_prob_vector_matrix_t unpaired_in_loop_probs_;
+        //! (mutable for memoization in lazy mode)
+        mutable arc_prob_vector_matrix_t unpaired_in_loop_probs_;
 
         //! used in initialization, to check whether in loop probs
         //! still have to be computed
         bool has_in_loop_probs_;
 
+        /**
+         * RNA ensemble for computing in loop probabilities of a loop
+         * on its first access (lazy mode); empty, if the in loop
+         * probabilities are complete
+         */
+        std::shared_ptr<const RnaEnsemble> lazy_ensemble_;
+
+        //! in lazy mode, loops (i,j) with already computed in loop
+        //! probabilities; the external loop is (0,len+1)
+        mutable SparseMatrix<bool> in_loop_probs_known_;
+
+        //! in lazy mode, whether all loops are known; then, look ups
+        //! don't lock
+        mutable std::atomic<bool> in_loop_probs_complete_;
+
+        //! right ends of all arcs by their left ends (sorted)
+        std::vector<std::vector<size_t>> right_ends_;
+
+        //! guards the memoization in lazy mode
+        mutable std::mutex lazy_mutex_;
+
         // ----------------------------------------
         // CONSTRUCTORS
 
@@ -120,6 +147,79 @@ namespace LocARNA {
         void
         init_from_ext_rna_ensemble(const RnaEnsemble &rna_ensemble);
 
+        /**
+         * @brief In loop base pair probabilities of a loop
+         *
+         * @param p left end of loop closing base pair or 0
+         * @param q right end of loop closing base pair or len+1
+         *
+         * @return matrix of base pair in loop probabilities; the
+         * external loop is (0,len+1)
+         *
+         * @note in lazy mode, the probabilities of the loop are
+         * computed on first access
+         */
+        const arc_prob_matrix_t &
+        arc_in_loop_probs(size_t p, size_t q) const;
+
+        /**
+         * @brief In loop unpaired probabilities of a loop
+         *
+         * @param p left end of loop closing base pair or 0
+         * @param q right end of loop closing base pair or len+1
+         *
+         * @return vector of unpaired in loop probabilities
+         *
+         * @see arc_in_loop_probs()
+         */
+        const arc_prob_vector_t &
+        unpaired_in_loop_probs(size_t p, size_t q) const;
+
+        /**
+         * @brief Compute the in loop probabilities of all loops that
+         * are not known yet
+         *
+         * @note no effect unless in lazy mode; required before
+         * iterating over arc_in_loop_probs_ or unpaired_in_loop_probs_
+         */
+        void
+        complete_lazy_probs() const;
+
+    private:
+        /**
+         * @brief Collect right ends of arcs by their left ends
+         */
+        void
+        init_right_ends();
+
+        /**
+         * @brief Compute in loop probabilities of one loop
+         *
+         * @param rna_ensemble rna ensemble with in loop probabilities
+         * @param p left end of loop closing base pair or 0
+         * @param q right end of loop closing base pair or len+1
+         *
+         * Sets the entries (p,q) of arc_in_loop_probs_ and
+         * unpaired_in_loop_probs_ (unless empty)
+         */
+        void
+        compute_in_loop_probs(const RnaEnsemble &rna_ensemble,
+                              size_t p,
+                              size_t q) const;
+
+        /**
+         * @brief Make sure the in loop probabilities of a loop are known
+         *
+         * @param p left end of loop closing base pair or 0
+         * @param q right end of loop closing base pair or len+1
+         *
+         * @note requires lazy mode; caller must hold lazy_mutex_
+         */
+        void
+        require_in_loop_probs(size_t p, size_t q) const;
+
+    public:
+
         /**
          * @brief read in loop probability section of pp-format
          *
@@ -0,0 +1,49 @@
+#include <cstdlib> // import free()
+
+#include "folding_context.hh"
+
+extern "C" {
+#include <ViennaRNA/params.h>
+}
+
+namespace LocARNA {
+
+    FoldingContext::FoldingContext(const PFoldParams &params)
+        : params_(params), exp_params_(nullptr), exp_params_comparative_() {}
+
+    FoldingContext::~FoldingContext() {
+        free(exp_params_);
+        for (auto &x : exp_params_comparative_) {
+            free(x.second);
+        }
+    }
+
+    vrna_md_t
+    FoldingContext::model_details() const {
+        vrna_md_t md;
+        vrna_md_copy(&md, &params_.model_details());
+        return md;
+    }
+
+    vrna_exp_param_t *
+    FoldingContext::exp_params() {
+        if (exp_params_ == nullptr) {
+            auto md = model_details();
+            exp_params_ = vrna_exp_params(&md);
+        }
+        return exp_params_;
+    }
+
+    vrna_exp_param_t *
+    FoldingContext::exp_params_comparative(size_t n_seq) {
+        auto it = exp_params_comparative_.find(n_seq);
+        if (it != exp_params_comparative_.end()) {
+            return it->second;
+        }
+        auto md = model_details();
+        auto params = vrna_exp_params_comparative(n_seq, &md);
+        exp_params_comparative_[n_seq] = params;
+        return params;
+    }
+
+} // end namespace LocARNA
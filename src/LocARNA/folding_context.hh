@@ -0,0 +1,105 @@
+#ifndef LOCARNA_FOLDING_CONTEXT_HH
+#define LOCARNA_FOLDING_CONTEXT_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <map>
+
+#include "pfold_params.hh"
+
+extern "C" {
+#include <ViennaRNA/data_structures.h>
+}
+
+namespace LocARNA {
+
+    /**
+     * @brief Reusable setup for partition folding many RNAs
+     *
+     * Holds a copy of the folding parameters and caches the ViennaRNA
+     * Boltzmann factor tables (vrna_exp_param_t), which are otherwise
+     * recomputed for every fold compound. RnaEnsemble objects that are
+     * constructed with a context substitute (copies of) the cached
+     * tables, which saves a noticeable fixed cost per folding for
+     * short sequences.
+     *
+     * The tables do not depend on the sequence, but on the model
+     * details and, for alignments, the number of rows; they are
+     * computed on first use.
+     *
+     * @note A context is not thread-safe; use one context per thread.
+     */
+    class FoldingContext {
+    public:
+        /**
+         * @brief Construct
+         *
+         * @param params folding parameters; the context holds a copy
+         */
+        explicit FoldingContext(const PFoldParams &params);
+
+        /**
+         * @brief Destructor
+         *
+         * Frees the cached parameter tables
+         */
+        ~FoldingContext();
+
+        /**
+         * @brief Folding parameters
+         * @return parameters of the context
+         */
+        const PFoldParams &
+        params() const {
+            return params_;
+        }
+
+        /**
+         * @brief Boltzmann factors for single sequence folding
+         *
+         * @return cached table; owned by the context
+         */
+        vrna_exp_param_t *
+        exp_params();
+
+        /**
+         * @brief Boltzmann factors for alignment folding
+         *
+         * @param n_seq number of rows of the alignment
+         *
+         * @return cached table; owned by the context
+         */
+        vrna_exp_param_t *
+        exp_params_comparative(size_t n_seq);
+
+    private:
+        //! folding parameters
+        PFoldParams params_;
+
+        //! Boltzmann factors for single sequences
+        vrna_exp_param_t *exp_params_;
+
+        //! Boltzmann factors for alignments by number of rows
+        std::map<size_t, vrna_exp_param_t *> exp_params_comparative_;
+
+        //! model details as passed to ViennaRNA
+        vrna_md_t
+        model_details() const;
+
+        /**
+         * @brief no copy construction
+         */
+        FoldingContext(const FoldingContext &);
+
+        /**
+         * @brief no assignment
+         */
+        FoldingContext &
+        operator=(const FoldingContext &);
+    }; // end class FoldingContext
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_FOLDING_CONTEXT_HH
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+#include "aux.hh"
+#include "guide_tree.hh"
+
+namespace LocARNA {
+
+    GuideTree::GuideTree(size_t num_leaves,
+                         merges_t merges,
+                         std::vector<double> branch_lengths)
+        : num_leaves_(num_leaves),
+          merges_(std::move(merges)),
+          branch_lengths_(std::move(branch_lengths)) {
+        if (num_leaves_ == 0 || merges_.size() + 1 != num_leaves_) {
+            throw failure("Guide tree does not match the number of leaves.");
+        }
+        if (!branch_lengths_.empty() &&
+            branch_lengths_.size() != 2 * num_leaves_ - 1) {
+            throw failure("Guide tree requires one branch length per node.");
+        }
+    }
+
+    GuideTree
+    GuideTree::upgma(matrix_t similarities) {
+        const size_t n = similarities.dim();
+        if (n == 0) {
+            throw failure("Cannot construct guide tree without leaves.");
+        }
+
+        // the matrix slots of the clusters are reused for merged
+        // clusters; for each slot, track the tree node and cluster size
+        std::vector<size_t> node(n);
+        std::iota(node.begin(), node.end(), 0);
+        std::vector<size_t> cluster_size(n, 1);
+
+        // slots of active clusters
+        std::vector<size_t> active(node);
+
+        merges_t merges;
+        merges.reserve(n - 1);
+
+        // merge the clusters in slots a and b into slot a
+        auto merge = [&](size_t a, size_t b) {
+            merges.emplace_back(std::min(node[a], node[b]),
+                                std::max(node[a], node[b]));
+            for (size_t c : active) {
+                if (c == a || c == b) {
+                    continue;
+                }
+                similarities(a, c) =
+                    (cluster_size[a] * similarities(a, c) +
+                     cluster_size[b] * similarities(b, c)) /
+                    (cluster_size[a] + cluster_size[b]);
+            }
+            node[a] = n + merges.size() - 1;
+            cluster_size[a] += cluster_size[b];
+            active.erase(std::find(active.begin(), active.end(), b));
+        };
+
+        // nearest neighbor chain: follow the most similar clusters
+        // until two clusters are mutually most similar; since average
+        // linkage is reducible, merging them keeps the chain valid
+        std::vector<size_t> chain;
+        while (active.size() > 1) {
+            if (chain.empty()) {
+                chain.push_back(active.front());
+            }
+            size_t a = chain.back();
+            // previous chain element; preferred on ties to guarantee
+            // termination
+            size_t prev = chain.size() >= 2 ? chain[chain.size() - 2] : n;
+
+            size_t best = prev;
+            float best_similarity = (prev < n)
+                ? similarities(a, prev)
+                : std::numeric_limits<float>::lowest();
+            for (size_t c : active) {
+                if (c != a &&
+                    (best == n || similarities(a, c) > best_similarity)) {
+                    best = c;
+                    best_similarity = similarities(a, c);
+                }
+            }
+
+            if (best == prev) {
+                chain.pop_back();
+                chain.pop_back();
+                merge(std::min(a, prev), std::max(a, prev));
+            } else {
+                chain.push_back(best);
+            }
+        }
+
+        return GuideTree(n, std::move(merges));
+    }
+
+    GuideTree
+    GuideTree::neighbor_joining(matrix_t distances) {
+        const size_t n = distances.dim();
+        if (n == 0) {
+            throw failure("Cannot construct guide tree without leaves.");
+        }
+
+        std::vector<size_t> node(n);
+        std::iota(node.begin(), node.end(), 0);
+        std::vector<size_t> active(node);
+
+        std::vector<double> branch_lengths(2 * n - 1, 0.0);
+        merges_t merges;
+        merges.reserve(n - 1);
+
+        // distance sums of the active clusters
+        std::vector<double> sums(n, 0.0);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < i; j++) {
+                sums[i] += distances(i, j);
+                sums[j] += distances(i, j);
+            }
+        }
+
+        // join the clusters in slots i and j into slot i
+        auto join = [&](size_t i, size_t j,
+                        double length_i, double length_j) {
+            branch_lengths[node[i]] = std::max(0.0, length_i);
+            branch_lengths[node[j]] = std::max(0.0, length_j);
+            merges.emplace_back(std::min(node[i], node[j]),
+                                std::max(node[i], node[j]));
+            node[i] = n + merges.size() - 1;
+            active.erase(std::find(active.begin(), active.end(), j));
+        };
+
+        while (active.size() > 2) {
+            const double m = active.size();
+
+            // find the pair minimizing the Q criterion
+            size_t best_i = n;
+            size_t best_j = n;
+            double best_q = std::numeric_limits<double>::max();
+            for (size_t x = 0; x < active.size(); x++) {
+                size_t i = active[x];
+                for (size_t y = 0; y < x; y++) {
+                    size_t j = active[y];
+                    double q =
+                        (m - 2) * distances(i, j) - sums[i] - sums[j];
+                    if (best_i == n || q < best_q) {
+                        best_q = q;
+                        best_i = i;
+                        best_j = j;
+                    }
+                }
+            }
+
+            const size_t i = std::min(best_i, best_j);
+            const size_t j = std::max(best_i, best_j);
+            const double dij = distances(i, j);
+            const double length_i =
+                dij / 2 + (sums[i] - sums[j]) / (2 * (m - 2));
+
+            // distances to the new cluster (in slot i)
+            sums[i] = 0.0;
+            for (size_t k : active) {
+                if (k == i || k == j) {
+                    continue;
+                }
+                double dk = (distances(i, k) + distances(j, k) - dij) / 2;
+                sums[k] += dk - distances(i, k) - distances(j, k);
+                sums[i] += dk;
+                distances(i, k) = dk;
+            }
+
+            join(i, j, length_i, dij - length_i);
+        }
+
+        if (active.size() == 2) {
+            const double d = distances(active[0], active[1]);
+            join(active[0], active[1], d / 2, d / 2);
+        }
+
+        return GuideTree(n, std::move(merges), std::move(branch_lengths));
+    }
+
+    std::ostream &
+    GuideTree::write_newick(std::ostream &out,
+                            const std::vector<std::string> &names) const {
+        if (names.size() != num_leaves_) {
+            throw failure("Number of names does not match the guide tree.");
+        }
+
+        const size_t root = 2 * num_leaves_ - 2;
+
+        // the root has no branch length
+        auto write_length = [&](size_t v) {
+            if (!branch_lengths_.empty() && v != root) {
+                out << ":" << branch_lengths_[v];
+            }
+        };
+
+        // iterative depth first traversal (the tree depth can be
+        // linear in the number of leaves); the state counts the
+        // visited children of a node
+        std::vector<std::pair<size_t, int>> stack;
+        stack.emplace_back(root, 0);
+
+        while (!stack.empty()) {
+            size_t v = stack.back().first;
+            int state = stack.back().second;
+
+            if (v < num_leaves_) {
+                out << names[v];
+                write_length(v);
+                stack.pop_back();
+                continue;
+            }
+
+            const merge_t &children = merges_[v - num_leaves_];
+            switch (state) {
+            case 0:
+                out << "(";
+                stack.back().second = 1;
+                stack.emplace_back(children.first, 0);
+                break;
+            case 1:
+                out << ",";
+                stack.back().second = 2;
+                stack.emplace_back(children.second, 0);
+                break;
+            default:
+                out << ")";
+                write_length(v);
+                stack.pop_back();
+            }
+        }
+
+        return out << ";";
+    }
+
+} // end namespace LocARNA
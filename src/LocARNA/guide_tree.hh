@@ -0,0 +1,130 @@
+#ifndef LOCARNA_GUIDE_TREE_HH
+#define LOCARNA_GUIDE_TREE_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "matrices.hh"
+
+namespace LocARNA {
+
+    /**
+     * @brief Binary guide tree for progressive alignment
+     *
+     * The tree is represented by its merge steps (like a linkage
+     * matrix): the nodes 0..N-1 are the leaves; merge step k joins
+     * two nodes and creates node N+k. The last step yields the
+     * root. This is the tree representation of ProgressiveAligner.
+     *
+     * Trees are constructed from pairwise similarities by UPGMA or
+     * from pairwise distances by neighbor-joining; both work on
+     * packed triangular matrices.
+     */
+    class GuideTree {
+    public:
+        //! merge step, pair of joined nodes
+        using merge_t = std::pair<size_t, size_t>;
+
+        //! sequence of merge steps
+        using merges_t = std::vector<merge_t>;
+
+        //! matrix type of pairwise similarities and distances
+        using matrix_t = TriangularMatrix<float>;
+
+        /**
+         * @brief Construct from merge steps
+         *
+         * @param num_leaves number of leaves
+         * @param merges merge steps
+         * @param branch_lengths length of the edge to the parent for
+         * each node; empty, if the tree has no branch lengths
+         */
+        GuideTree(size_t num_leaves,
+                  merges_t merges,
+                  std::vector<double> branch_lengths = {});
+
+        /**
+         * @brief Construct tree by UPGMA
+         *
+         * @param similarities pairwise similarities (e.g. alignment
+         * scores); the matrix is used as working space
+         *
+         * @return UPGMA tree (average linkage, maximizing similarity)
+         *
+         * Uses the nearest neighbor chain algorithm, which requires
+         * time O(N^2) and no memory beyond the matrix.
+         */
+        static GuideTree
+        upgma(matrix_t similarities);
+
+        /**
+         * @brief Construct tree by neighbor-joining
+         *
+         * @param distances pairwise distances; the matrix is used as
+         * working space
+         *
+         * @return neighbor-joining tree with branch lengths, rooted at
+         * the last join. Negative branch lengths are set to 0.
+         *
+         * Requires time O(N^3).
+         */
+        static GuideTree
+        neighbor_joining(matrix_t distances);
+
+        /**
+         * @brief Number of leaves
+         * @return number of leaves
+         */
+        size_t
+        num_leaves() const {
+            return num_leaves_;
+        }
+
+        /**
+         * @brief Merge steps
+         * @return merge steps in the order of construction
+         */
+        const merges_t &
+        merges() const {
+            return merges_;
+        }
+
+        /**
+         * @brief Branch lengths
+         * @return length of the edge to the parent for each node;
+         * empty if the tree has no branch lengths
+         */
+        const std::vector<double> &
+        branch_lengths() const {
+            return branch_lengths_;
+        }
+
+        /**
+         * @brief Write tree in NEWICK format
+         *
+         * @param out output stream
+         * @param names names of the leaves
+         *
+         * @return stream
+         *
+         * Writes branch lengths if available.
+         */
+        std::ostream &
+        write_newick(std::ostream &out,
+                     const std::vector<std::string> &names) const;
+
+    private:
+        size_t num_leaves_;                  //!< number of leaves
+        merges_t merges_;                    //!< merge steps
+        std::vector<double> branch_lengths_; //!< branch lengths
+    };
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_GUIDE_TREE_HH
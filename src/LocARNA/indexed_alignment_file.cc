@@ -0,0 +1,292 @@
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "aux.hh"
+#include "indexed_alignment_file.hh"
+
+namespace LocARNA {
+
+    const std::string IndexedAlignmentFile::index_suffix = ".lidx";
+
+    namespace {
+        //! header tag of the sidecar index files
+        const std::string index_header = "#LOCARNA_INDEX";
+
+        //! version of the sidecar format
+        const int index_version = 1;
+
+        /**
+         * @brief Read-only stream buffer on a memory range
+         *
+         * Allows parsing a mapped byte range by the istream readers
+         * of MultipleAlignment without copying.
+         */
+        class MemoryBuffer : public std::streambuf {
+        public:
+            MemoryBuffer(const char *begin, size_t length) {
+                char *b = const_cast<char *>(begin);
+                setg(b, b, b + length);
+            }
+        };
+
+        std::string
+        format_name(MultipleAlignment::FormatType format) {
+            return format == MultipleAlignment::FormatType::FASTA
+                ? "FASTA"
+                : "STOCKHOLM";
+        }
+
+        /**
+         * @brief Value of a Stockholm #=GF line
+         *
+         * @param line the line
+         * @param feature feature tag, e.g. "ID"
+         * @param[out] value first word of the value
+         *
+         * @return whether line is a #=GF line of the feature
+         */
+        bool
+        gf_value(const std::string &line,
+                 const std::string &feature,
+                 std::string &value) {
+            std::istringstream in(line);
+            std::string tag, f;
+            in >> tag >> f >> value;
+            return tag == "#=GF" && f == feature && !in.fail();
+        }
+    }
+
+    IndexedAlignmentFile::IndexedAlignmentFile(const std::string &filename,
+                                               FormatType format)
+        : filename_(filename),
+          format_(format),
+          data_(nullptr),
+          size_(0),
+          mtime_(0),
+          entries_(),
+          name2idx_(),
+          index_loaded_(false) {
+        if (format != FormatType::FASTA && format != FormatType::STOCKHOLM) {
+            throw failure("Indexed access supports only FASTA and "
+                          "Stockholm files.");
+        }
+
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw failure("Cannot open file " + filename + " for reading.");
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw failure("Cannot access file " + filename + ".");
+        }
+        size_ = st.st_size;
+        mtime_ = st.st_mtime;
+
+        if (size_ > 0) {
+            void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                close(fd);
+                throw failure("Cannot map file " + filename + ".");
+            }
+            // entries are accessed randomly
+            madvise(addr, size_, MADV_RANDOM);
+            data_ = static_cast<const char *>(addr);
+        }
+        // the mapping stays valid after closing
+        close(fd);
+
+        index_loaded_ = read_index();
+        if (!index_loaded_) {
+            build_index();
+            write_index();
+        }
+    }
+
+    IndexedAlignmentFile::~IndexedAlignmentFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    void
+    IndexedAlignmentFile::add_entry(entry_t entry) {
+        size_t idx = entries_.size();
+        if (entry.names_.empty()) {
+            entry.names_.push_back(std::to_string(idx + 1));
+        }
+        for (const auto &name : entry.names_) {
+            // on duplicate names, the first entry wins
+            name2idx_.insert(std::make_pair(name, idx));
+        }
+        entries_.push_back(std::move(entry));
+    }
+
+    void
+    IndexedAlignmentFile::build_index() {
+        entries_.clear();
+        name2idx_.clear();
+
+        // the entry under construction
+        bool in_entry = false;
+        entry_t entry;
+
+        auto close_entry = [&](size_t end) {
+            if (in_entry) {
+                entry.length_ = end - entry.offset_;
+                add_entry(entry);
+                in_entry = false;
+            }
+        };
+
+        size_t pos = 0;
+        while (pos < size_) {
+            const char *eol = static_cast<const char *>(
+                memchr(data_ + pos, '\n', size_ - pos));
+            size_t next = (eol == nullptr) ? size_ : (eol - data_) + 1;
+
+            // only header, annotation and end lines are relevant;
+            // skip sequence lines without copying them
+            char c = data_[pos];
+            if (!(c == '>' || c == '#' || c == '/')) {
+                pos = next;
+                continue;
+            }
+
+            std::string line(data_ + pos, next - pos);
+            // strip line end (including carriage returns)
+            while (!line.empty() &&
+                   (line.back() == '\n' || line.back() == '\r')) {
+                line.pop_back();
+            }
+
+            if (format_ == FormatType::FASTA) {
+                if (has_prefix(line, ">")) {
+                    close_entry(pos);
+                    in_entry = true;
+                    entry = entry_t{pos, 0, {}};
+                    std::istringstream in(line.substr(1));
+                    std::string name;
+                    if (in >> name) {
+                        entry.names_.push_back(name);
+                    }
+                }
+            } else {
+                if (has_prefix(line, "# STOCKHOLM")) {
+                    close_entry(pos);
+                    in_entry = true;
+                    entry = entry_t{pos, 0, {}};
+                } else if (in_entry) {
+                    std::string value;
+                    if (line == "//") {
+                        close_entry(next);
+                    } else if (gf_value(line, "ID", value)) {
+                        entry.names_.insert(entry.names_.begin(), value);
+                    } else if (gf_value(line, "AC", value)) {
+                        entry.names_.push_back(value);
+                    }
+                }
+            }
+
+            pos = next;
+        }
+        close_entry(size_);
+    }
+
+    bool
+    IndexedAlignmentFile::read_index() {
+        std::ifstream in((filename_ + index_suffix).c_str());
+        if (!in.is_open()) {
+            return false;
+        }
+
+        std::string line;
+        if (!getline(in, line)) {
+            return false;
+        }
+
+        // the index must be made for this version of the file
+        std::istringstream header(line);
+        std::string tag, format;
+        int version;
+        size_t size;
+        long mtime;
+        header >> tag >> version >> format >> size >> mtime;
+        if (header.fail() || tag != index_header || version != index_version ||
+            format != format_name(format_) || size != size_ ||
+            mtime != mtime_) {
+            return false;
+        }
+
+        entries_.clear();
+        name2idx_.clear();
+
+        while (getline(in, line)) {
+            std::istringstream lin(line);
+            entry_t entry;
+            lin >> entry.offset_ >> entry.length_;
+            if (lin.fail() || entry.offset_ + entry.length_ > size_) {
+                // corrupt index; rebuild
+                entries_.clear();
+                name2idx_.clear();
+                return false;
+            }
+            std::string name;
+            while (lin >> name) {
+                entry.names_.push_back(name);
+            }
+            add_entry(entry);
+        }
+
+        return true;
+    }
+
+    bool
+    IndexedAlignmentFile::write_index() const {
+        std::ofstream out((filename_ + index_suffix).c_str());
+        if (!out.is_open()) {
+            return false;
+        }
+
+        out << index_header << " " << index_version << " "
+            << format_name(format_) << " " << size_ << " " << mtime_
+            << std::endl;
+        for (const auto &entry : entries_) {
+            out << entry.offset_ << " " << entry.length_;
+            for (const auto &name : entry.names_) {
+                out << " " << name;
+            }
+            out << "\n";
+        }
+
+        return out.good();
+    }
+
+    MultipleAlignment
+    IndexedAlignmentFile::alignment(const std::string &name) const {
+        auto it = name2idx_.find(name);
+        if (it == name2idx_.end()) {
+            throw failure("No entry " + name + " in file " + filename_ + ".");
+        }
+        return alignment(it->second);
+    }
+
+    MultipleAlignment
+    IndexedAlignmentFile::alignment(size_t idx) const {
+        assert(idx < entries_.size());
+        const auto &entry = entries_[idx];
+
+        MemoryBuffer buffer(data_ + entry.offset_, entry.length_);
+        std::istream in(&buffer);
+        return MultipleAlignment(in, format_);
+    }
+
+} // end namespace LocARNA
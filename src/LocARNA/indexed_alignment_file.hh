@@ -0,0 +1,182 @@
+#ifndef LOCARNA_INDEXED_ALIGNMENT_FILE_HH
+#define LOCARNA_INDEXED_ALIGNMENT_FILE_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "multiple_alignment.hh"
+
+namespace LocARNA {
+
+    /**
+     * @brief Random access to the entries of a large multi-entry file
+     *
+     * Provides access by name to the entries of a multi-FASTA file
+     * (one entry per sequence) or a Stockholm database (one entry per
+     * alignment, e.g. an Rfam family) without reading the entire file.
+     *
+     * On first use, the file is scanned once and an index of the byte
+     * ranges of all entries is written to a sidecar file (file name
+     * plus suffix ".lidx"). Subsequently, the index is loaded from the
+     * sidecar, unless the file was modified in the meantime. The file
+     * is memory mapped; constructing an entry parses only its byte
+     * range.
+     *
+     * Entries of FASTA files are named by the sequence name (first
+     * word of the header line). Stockholm entries are named by their
+     * identifier (#=GF ID) and, if present, by their accession (#=GF
+     * AC); entries without either are named by their index.
+     *
+     * @note if the sidecar cannot be written (e.g. read-only
+     * directory), the index is kept in memory only
+     */
+    class IndexedAlignmentFile {
+    public:
+        //! type of the entry formats
+        using FormatType = MultipleAlignment::FormatType;
+
+        //! suffix of the sidecar index file
+        static const std::string index_suffix;
+
+        /**
+         * @brief Construct from file
+         *
+         * @param filename input file name
+         * @param format file format, either FASTA or STOCKHOLM
+         *
+         * Maps the file and loads or builds the index.
+         */
+        IndexedAlignmentFile(const std::string &filename, FormatType format);
+
+        /**
+         * @brief Destructor
+         *
+         * Unmaps the file
+         */
+        ~IndexedAlignmentFile();
+
+        /**
+         * @brief Number of entries
+         * @return number of entries
+         */
+        size_t
+        size() const {
+            return entries_.size();
+        }
+
+        /**
+         * @brief Check existence of an entry
+         * @param name entry name
+         * @return whether the file contains an entry of this name
+         */
+        bool
+        contains(const std::string &name) const {
+            return name2idx_.find(name) != name2idx_.end();
+        }
+
+        /**
+         * @brief Name of an entry
+         * @param idx entry index (0-based, in file order)
+         * @return (first) name of the entry
+         */
+        const std::string &
+        name(size_t idx) const {
+            return entries_[idx].names_.front();
+        }
+
+        /**
+         * @brief Construct an entry by name
+         *
+         * @param name entry name
+         * @return entry as multiple alignment
+         *
+         * throws failure if the name is unknown
+         */
+        MultipleAlignment
+        alignment(const std::string &name) const;
+
+        /**
+         * @brief Construct an entry by index
+         *
+         * @param idx entry index (0-based, in file order)
+         * @return entry as multiple alignment
+         */
+        MultipleAlignment
+        alignment(size_t idx) const;
+
+        /**
+         * @brief Whether the index was loaded from the sidecar
+         * @return true, if the index was loaded; false, if it was built
+         */
+        bool
+        index_loaded() const {
+            return index_loaded_;
+        }
+
+    private:
+        //! byte range of an entry
+        struct entry_t {
+            size_t offset_; //!< offset of first byte
+            size_t length_; //!< length in bytes
+            std::vector<std::string> names_; //!< name and aliases
+        };
+
+        std::string filename_; //!< name of the input file
+        FormatType format_;    //!< format of the input file
+
+        const char *data_; //!< mapped file content
+        size_t size_;      //!< file size
+        long mtime_;       //!< modification time of the file
+
+        std::vector<entry_t> entries_;            //!< entries in file order
+        std::map<std::string, size_t> name2idx_;  //!< names and aliases
+        bool index_loaded_; //!< whether the index was loaded from sidecar
+
+        /**
+         * @brief Scan the mapped file and build the index
+         */
+        void
+        build_index();
+
+        /**
+         * @brief Read the index from the sidecar file
+         * @return whether a valid index for the current file was read
+         */
+        bool
+        read_index();
+
+        /**
+         * @brief Write the index to the sidecar file
+         * @return whether writing succeeded
+         */
+        bool
+        write_index() const;
+
+        /**
+         * @brief Add an entry and register its names
+         * @param entry the entry; if it has no names, it is named by
+         * its index
+         */
+        void
+        add_entry(entry_t entry);
+
+        /**
+         * @brief no copy construction
+         */
+        IndexedAlignmentFile(const IndexedAlignmentFile &);
+
+        /**
+         * @brief no assignment
+         */
+        IndexedAlignmentFile &
+        operator=(const IndexedAlignmentFile &);
+    }; // end class IndexedAlignmentFile
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_INDEXED_ALIGNMENT_FILE_HH
@@ -4,23 +4,18 @@
 
 namespace LocARNA {
 
-    const TaintedInftyInt::base_type TaintedInftyInt::min_finity =
-        std::numeric_limits<TaintedInftyInt::base_type>::min() / 5;
-
-    const TaintedInftyInt::base_type TaintedInftyInt::max_finity =
-        -(std::numeric_limits<TaintedInftyInt::base_type>::min() / 5) - 1;
-
-    const TaintedInftyInt::base_type TaintedInftyInt::min_normal_neg_infty =
-        std::numeric_limits<TaintedInftyInt::base_type>::min() / 5 * 3;
-
-    const TaintedInftyInt::base_type TaintedInftyInt::max_normal_pos_infty =
-        -(std::numeric_limits<TaintedInftyInt::base_type>::min() / 5 * 3) - 1;
-
-    const InftyInt InftyInt::neg_infty = InftyInt(
-        std::numeric_limits<TaintedInftyInt::base_type>::min() / 5 * 2);
-
-    const InftyInt InftyInt::pos_infty = InftyInt(
-        -(std::numeric_limits<TaintedInftyInt::base_type>::min() / 5 * 2));
+    constexpr TaintedInftyInt::base_type TaintedInftyInt::min_finity;
+    constexpr TaintedInftyInt::base_type TaintedInftyInt::max_finity;
+    constexpr TaintedInftyInt::base_type TaintedInftyInt::min_normal_neg_infty;
+    constexpr TaintedInftyInt::base_type TaintedInftyInt::max_normal_pos_infty;
+    constexpr TaintedInftyInt::base_type TaintedInftyInt::normalized_neg_infty;
+    constexpr TaintedInftyInt::base_type TaintedInftyInt::normalized_pos_infty;
+
+    const InftyInt InftyInt::neg_infty =
+        InftyInt(TaintedInftyInt::normalized_neg_infty);
+
+    const InftyInt InftyInt::pos_infty =
+        InftyInt(TaintedInftyInt::normalized_pos_infty);
 
     /**
      * Output operator for writing object of TaintedInftyInt to output stream
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <iosfwd>
+#include <limits>
 #include <assert.h>
 
 namespace LocARNA {
@@ -61,17 +62,32 @@ namespace LocARNA {
     protected:
         base_type val; //!< value
 
+        // the bounds are compile time constants, such that normalizing
+        // compiles to selects in loops over scores
+
         //! minimum finite value
-        static const base_type min_finity;
+        static constexpr base_type min_finity =
+            std::numeric_limits<base_type>::min() / 5;
 
         //! maximum finite value
-        static const base_type max_finity;
+        static constexpr base_type max_finity =
+            -(std::numeric_limits<base_type>::min() / 5) - 1;
 
         //! minimum normal infinite value
-        static const base_type min_normal_neg_infty;
+        static constexpr base_type min_normal_neg_infty =
+            std::numeric_limits<base_type>::min() / 5 * 3;
 
         //! maximum normal infinite value
-        static const base_type max_normal_pos_infty;
+        static constexpr base_type max_normal_pos_infty =
+            -(std::numeric_limits<base_type>::min() / 5 * 3) - 1;
+
+        //! value of normalized negative infinity
+        static constexpr base_type normalized_neg_infty =
+            std::numeric_limits<base_type>::min() / 5 * 2;
+
+        //! value of normalized positive infinity
+        static constexpr base_type normalized_pos_infty =
+            -(std::numeric_limits<base_type>::min() / 5 * 2);
 
     public:
         /**
@@ -334,9 +350,9 @@ namespace LocARNA {
         normalize() {
             // std::cout << "NORMALIZE" <<std::endl;
             if (is_neg_infty()) {
-                val = neg_infty.val;
+                val = normalized_neg_infty;
             } else if (is_pos_infty()) {
-                val = pos_infty.val;
+                val = normalized_pos_infty;
             }
         }
 
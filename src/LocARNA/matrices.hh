@@ -7,7 +7,7 @@
 
 /* @file Define various generic matrix classes (with templated element
    type): simple matrix, matrix with range restriction, matrix with
-   offset, rotatable matrix.
+   offset, rotatable matrix, packed symmetric matrix.
  */
 
 #include <iostream>
@@ -430,6 +430,88 @@ namespace LocARNA {
         }
     };
 
+    // ----------------------------------------
+    //! @brief Symmetric matrix in packed triangular storage
+    //!
+    //! Stores only the entries (i,j) with i>j, i.e. n*(n-1)/2
+    //! entries for an n x n matrix; the diagonal is not
+    //! stored. Access is symmetric: (i,j) and (j,i) denote the same
+    //! entry. Used for pairwise distances or similarities.
+    //!
+    template <class elem_t>
+    class TriangularMatrix {
+    protected:
+        std::vector<elem_t> mat_; //!< vector storing the matrix entries
+        size_t dim_;              //!< dimension
+
+        /**
+         * Computes address/index in 1D vector from 2D matrix indices
+         *
+         * @param i first index
+         * @param j second index
+         *
+         * @return index in vector
+         * @pre i!=j
+         */
+        size_t
+        addr(size_t i, size_t j) const {
+            assert(i != j);
+            assert(i < dim_ && j < dim_);
+            if (i < j) {
+                std::swap(i, j);
+            }
+            return i * (i - 1) / 2 + j;
+        }
+
+    public:
+        /**
+         * Construct with dimension
+         *
+         * @param dim dimension
+         * @param x initial value of entries
+         */
+        explicit TriangularMatrix(size_t dim = 0, const elem_t &x = elem_t())
+            : mat_(dim * (dim > 0 ? dim - 1 : 0) / 2, x), dim_(dim) {}
+
+        /**
+         * Access dimension
+         *
+         * @return dimension of matrix
+         */
+        size_t
+        dim() const {
+            return dim_;
+        }
+
+        /**
+         * Read access to matrix element
+         *
+         * @param i
+         * @param j
+         *
+         * @return entry (i,j)
+         * @pre i!=j
+         */
+        const elem_t &
+        operator()(size_t i, size_t j) const {
+            return mat_[addr(i, j)];
+        }
+
+        /**
+         * Read/write access to matrix element
+         *
+         * @param i
+         * @param j
+         *
+         * @return reference to entry (i,j)
+         * @pre i!=j
+         */
+        elem_t &
+        operator()(size_t i, size_t j) {
+            return mat_[addr(i, j)];
+        }
+    };
+
 } // end namespace LocARNA
 
 #endif // LOCARNA_MATRICES_HH
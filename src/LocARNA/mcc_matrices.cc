@@ -31,7 +31,9 @@ namespace LocARNA {
 
     // ----------------------------------------
 
-    McC_matrices_t::McC_matrices_t(const MultipleAlignment &sequence, const PFoldParams &params)
+    McC_matrices_t::McC_matrices_t(const MultipleAlignment &sequence,
+                                   const PFoldParams &params,
+                                   bool exp_params)
         : McC_matrices_base(){
 
         // use MultipleAlignment to get pointer to c-string of the
@@ -43,7 +45,8 @@ namespace LocARNA {
         if (sequence.length()>0) {
             vc_ = vrna_fold_compound(seqstring.c_str(),
                                      &md,
-                                     VRNA_OPTION_PF);
+                                     exp_params ? VRNA_OPTION_PF
+                                                : VRNA_OPTION_MFE);
         } else {
             vc_ = nullptr;
         }
@@ -52,7 +55,8 @@ namespace LocARNA {
 
     // ----------------------------------------
     McC_ali_matrices_t::McC_ali_matrices_t(const MultipleAlignment &sequence,
-                                           const PFoldParams &params)
+                                           const PFoldParams &params,
+                                           bool exp_params)
         : McC_matrices_base() {
 
         size_t n_seq = sequence.num_of_rows();
@@ -72,7 +76,8 @@ namespace LocARNA {
 
         vc_ = vrna_fold_compound_comparative(sequences.get(),
                                              &md,
-                                             VRNA_OPTION_PF);
+                                             exp_params ? VRNA_OPTION_PF
+                                                        : VRNA_OPTION_MFE);
     }
     McC_ali_matrices_t::~McC_ali_matrices_t() {}
 
@@ -206,8 +206,13 @@ namespace LocARNA {
          *
          * @param sequence the sequence
          * @param params locarna partition fold parameters
+         * @param exp_params whether to compute the Boltzmann factors;
+         * if false, they have to be substituted before partition
+         * folding (vrna_exp_params_subst())
          */
-        McC_matrices_t(const MultipleAlignment &sequence, const PFoldParams &params);
+        McC_matrices_t(const MultipleAlignment &sequence,
+                       const PFoldParams &params,
+                       bool exp_params = true);
 
         /**
          * @brief destruct, optionally free local copy
@@ -267,8 +272,12 @@ namespace LocARNA {
          *
          * @param ma the multiple alignment
          * @param params locarna partition fold parameters
+         * @param exp_params whether to compute the Boltzmann factors
+         * @see McC_matrices_t::McC_matrices_t()
          */
-        McC_ali_matrices_t(const MultipleAlignment &ma, const PFoldParams &params);
+        McC_ali_matrices_t(const MultipleAlignment &ma,
+                           const PFoldParams &params,
+                           bool exp_params = true);
 
         /**
          * @brief destruct
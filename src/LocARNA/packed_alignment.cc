@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <array>
+
+#include "packed_alignment.hh"
+#include "multiple_alignment.hh"
+
+namespace LocARNA {
+
+    constexpr PackedAlignment::code_t PackedAlignment::escape_code;
+
+    const char PackedAlignment::symbols_[PackedAlignment::escape_code] = {
+        '-', 'A', 'C', 'G', 'U', 'N', 'R', 'Y',
+        'S', 'W', 'K', 'M', 'B', 'D', 'H'};
+
+    PackedAlignment::code_t
+    PackedAlignment::encode(char c) {
+        static const std::array<code_t, 256> codes = [] {
+            std::array<code_t, 256> codes;
+            codes.fill(escape_code);
+            for (code_t x = 0; x < escape_code; x++) {
+                codes[(unsigned char)symbols_[x]] = x;
+            }
+            return codes;
+        }();
+        return codes[(unsigned char)c];
+    }
+
+    PackedAlignment::PackedAlignment(const MultipleAlignment &ma)
+        : rows_(ma.num_of_rows()),
+          length_(ma.length()),
+          stride_((rows_ + 1) / 2),
+          data_(length_ * stride_, 0),
+          escapes_() {
+        // fill row by row; escapes are sorted afterwards
+        for (size_type row = 0; row < rows_; row++) {
+            const string1 &seq = ma.seqentry(row).seq();
+            const size_type shift = (row & 1) ? 4 : 0;
+            for (size_type col = 1; col <= length_; col++) {
+                code_t c = encode(seq[col]);
+                data_[(col - 1) * stride_ + row / 2] |= c << shift;
+                if (c == escape_code) {
+                    escapes_.emplace_back((col - 1) * rows_ + row, seq[col]);
+                }
+            }
+        }
+        std::sort(escapes_.begin(), escapes_.end());
+    }
+
+    const char &
+    PackedAlignment::escaped_symbol(size_type col, size_type row) const {
+        size_type idx = (col - 1) * rows_ + row;
+        auto it = std::lower_bound(
+            escapes_.begin(), escapes_.end(), idx,
+            [](const std::pair<size_type, char> &x, size_type idx) {
+                return x.first < idx;
+            });
+        assert(it != escapes_.end() && it->first == idx);
+        return it->second;
+    }
+
+} // end namespace LocARNA
@@ -0,0 +1,259 @@
+#ifndef LOCARNA_PACKED_ALIGNMENT_HH
+#define LOCARNA_PACKED_ALIGNMENT_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "aux.hh"
+
+namespace LocARNA {
+
+    class MultipleAlignment;
+
+    /**
+     * @brief Packed column-major copy of a multiple alignment
+     *
+     * MultipleAlignment stores one string per row; thus, traversing
+     * a column touches a different cache line for each row. This
+     * class stores the symbols of each column consecutively with 4
+     * bits per symbol (two rows per byte), such that column oriented
+     * algorithms (like the column similarities in Scoring) stay in
+     * cache even for alignments of hundreds of rows.
+     *
+     * The gap, the nucleotides ACGU, N and the most common IUPAC
+     * codes have their own codes. All other symbols are escaped and
+     * looked up in a (sorted) side table.
+     *
+     * @note the object is a snapshot of the alignment; it is not
+     * updated when the alignment changes
+     */
+    class PackedAlignment {
+    public:
+        //! size type
+        using size_type = size_t;
+
+        //! type of symbol codes
+        using code_t = unsigned char;
+
+        //! code of escaped symbols
+        static constexpr code_t escape_code = 15;
+
+        /**
+         * @brief Construct from multiple alignment
+         * @param ma multiple alignment
+         */
+        explicit PackedAlignment(const MultipleAlignment &ma);
+
+        /**
+         * @brief Number of rows
+         * @return number of rows
+         */
+        size_type
+        num_of_rows() const {
+            return rows_;
+        }
+
+        /**
+         * @brief Length
+         * @return number of columns
+         */
+        size_type
+        length() const {
+            return length_;
+        }
+
+        /**
+         * @brief Code of a symbol
+         *
+         * @param col column index (1-based)
+         * @param row row index (0-based)
+         *
+         * @return code of the symbol in row and column
+         */
+        code_t
+        code(size_type col, size_type row) const {
+            assert(1 <= col && col <= length_);
+            assert(row < rows_);
+            return unpack(&data_[(col - 1) * stride_], row);
+        }
+
+        /**
+         * @brief Symbol access
+         *
+         * @param col column index (1-based)
+         * @param row row index (0-based)
+         *
+         * @return symbol in row and column
+         */
+        const char &
+        symbol(size_type col, size_type row) const {
+            code_t c = code(col, row);
+            return c != escape_code ? symbols_[c] : escaped_symbol(col, row);
+        }
+
+        /**
+         * @brief Read only proxy of a column
+         *
+         * Provides the same interface as MultipleAlignment::AliColumn.
+         */
+        class Column {
+        public:
+            //! value type
+            using value_type = char;
+
+            /**
+             * @brief const iterator over the rows
+             */
+            class const_iterator {
+            public:
+                //! @brief pre-increment
+                const_iterator &
+                operator++() {
+                    ++row_;
+                    return *this;
+                }
+
+                //! @brief dereference
+                const char &operator*() const {
+                    code_t c = unpack(data_, row_);
+                    return c != escape_code
+                        ? symbols_[c]
+                        : pa_->escaped_symbol(col_, row_);
+                }
+
+                //! @brief test inequality
+                bool
+                operator!=(const const_iterator &it) const {
+                    return row_ != it.row_ || data_ != it.data_;
+                }
+
+                //! @brief test equality
+                bool
+                operator==(const const_iterator &it) const {
+                    return !(*this != it);
+                }
+
+            private:
+                friend class Column;
+
+                const_iterator(const PackedAlignment *pa,
+                               size_type col,
+                               size_type row)
+                    : pa_(pa),
+                      data_(&pa->data_[(col - 1) * pa->stride_]),
+                      col_(col),
+                      row_(row) {}
+
+                const PackedAlignment *pa_;
+                const code_t *data_;
+                size_type col_;
+                size_type row_;
+            };
+
+            //! iterator (always const)
+            using iterator = const_iterator;
+
+            /**
+             * @brief element access
+             * @param row row index (0-based)
+             * @return symbol in row
+             */
+            const char &operator[](size_type row) const {
+                return pa_->symbol(col_, row);
+            }
+
+            /**
+             * @brief Size / Number of rows
+             * @return number of rows
+             */
+            size_type
+            size() const {
+                return pa_->num_of_rows();
+            }
+
+            //! @brief begin iterator
+            const_iterator
+            begin() const {
+                return const_iterator(pa_, col_, 0);
+            }
+
+            //! @brief end iterator
+            const_iterator
+            end() const {
+                return const_iterator(pa_, col_, size());
+            }
+
+        private:
+            friend class PackedAlignment;
+
+            Column(const PackedAlignment *pa, size_type col)
+                : pa_(pa), col_(col) {
+                assert(1 <= col && col <= pa->length());
+            }
+
+            const PackedAlignment *pa_;
+            size_type col_;
+        };
+
+        /**
+         * @brief Access column
+         * @param col column index (1-based)
+         * @return column proxy
+         */
+        Column
+        column(size_type col) const {
+            return Column(this, col);
+        }
+
+    private:
+        //! symbols by their code (except escape)
+        static const char symbols_[escape_code];
+
+        size_type rows_;   //!< number of rows
+        size_type length_; //!< number of columns
+        size_type stride_; //!< bytes per column
+
+        //! packed codes, column after column
+        std::vector<code_t> data_;
+
+        //! escaped symbols by linear index (col-1)*rows+row; sorted
+        std::vector<std::pair<size_type, char>> escapes_;
+
+        /**
+         * @brief Encode symbol
+         * @param c symbol
+         * @return code of c; escape_code if c has no code
+         */
+        static code_t
+        encode(char c);
+
+        /**
+         * @brief Code of a row in a packed column
+         * @param data packed column
+         * @param row row index
+         * @return code
+         */
+        static code_t
+        unpack(const code_t *data, size_type row) {
+            code_t byte = data[row / 2];
+            return (row & 1) ? (byte >> 4) : (byte & 0xF);
+        }
+
+        /**
+         * @brief Look up escaped symbol
+         * @param col column index (1-based)
+         * @param row row index (0-based)
+         * @return symbol
+         */
+        const char &
+        escaped_symbol(size_type col, size_type row) const;
+    };
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_PACKED_ALIGNMENT_HH
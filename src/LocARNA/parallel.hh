@@ -0,0 +1,164 @@
+#ifndef LOCARNA_PARALLEL_HH
+#define LOCARNA_PARALLEL_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LocARNA {
+
+    /**
+     * @brief Process items level by level using several threads
+     *
+     * The items of one level are dealt out to the threads in order
+     * of their indices; a level is started when all items of the
+     * previous level are processed. The calling thread takes part
+     * as thread 0, such that no thread is started for a single
+     * thread.
+     *
+     * When a level is started, start_level(level) is called by one
+     * thread (under the lock, while no item is processed); it
+     * returns the number of items of the level and may prepare data
+     * that fn reads. Each item is processed by fn(level, item,
+     * thread), where thread in [0, num_threads) identifies the
+     * calling thread, e.g. to select a per-thread workspace.
+     *
+     * An exception thrown by fn (or start_level) stops dealing out
+     * items; after all threads finished, the first exception is
+     * rethrown.
+     *
+     * @param num_levels number of levels
+     * @param num_threads number of threads
+     * @param start_level function called as start_level(level)
+     * @param fn function called as fn(level, item, thread)
+     */
+    template <class StartLevel, class Fn>
+    void
+    parallel_levels(size_t num_levels,
+                    size_t num_threads,
+                    StartLevel start_level,
+                    Fn fn) {
+        num_threads = std::max<size_t>(1, num_threads);
+
+        std::mutex mutex;
+        std::condition_variable level_done;
+        size_t level = 0;
+        size_t level_size = 0;
+        size_t next = 0;
+        size_t running = 0;
+        std::exception_ptr error;
+
+        // start the first non-empty level from level on; requires the
+        // lock, while threads are running
+        auto start_levels = [&]() {
+            for (; level < num_levels; level++) {
+                try {
+                    level_size = start_level(level);
+                } catch (...) {
+                    error = std::current_exception();
+                    level = num_levels;
+                    return;
+                }
+                next = 0;
+                if (level_size > 0) {
+                    return;
+                }
+            }
+        };
+
+        auto worker = [&](size_t thread) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (level < num_levels) {
+                if (error || next == level_size) {
+                    if (running == 0) {
+                        if (error) {
+                            level = num_levels;
+                        } else {
+                            level++;
+                            start_levels();
+                        }
+                        level_done.notify_all();
+                    } else {
+                        level_done.wait(lock);
+                    }
+                    continue;
+                }
+
+                size_t item = next++;
+                size_t item_level = level;
+                running++;
+                lock.unlock();
+
+                std::exception_ptr item_error;
+                try {
+                    fn(item_level, item, thread);
+                } catch (...) {
+                    item_error = std::current_exception();
+                }
+
+                lock.lock();
+                if (item_error && !error) {
+                    error = item_error;
+                }
+                running--;
+                if (running == 0) {
+                    level_done.notify_all();
+                }
+            }
+        };
+
+        start_levels();
+        // (read before starting threads, which modify level)
+        const bool has_items = level < num_levels;
+
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < num_threads && has_items; t++) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);
+        for (auto &t : threads) {
+            t.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief Process items using several threads
+     *
+     * Calls fn(item, thread) for all items in [0, n); see
+     * parallel_levels() for the order, the thread index and the
+     * handling of exceptions. Items are dealt out in chunks, which
+     * saves synchronization for many small items.
+     *
+     * @param n number of items
+     * @param num_threads number of threads
+     * @param fn function called as fn(item, thread)
+     * @param chunk number of items dealt out at once
+     */
+    template <class Fn>
+    void
+    parallel_for(size_t n, size_t num_threads, Fn fn, size_t chunk = 1) {
+        chunk = std::max<size_t>(1, chunk);
+        const size_t num_chunks = (n + chunk - 1) / chunk;
+        parallel_levels(1,
+                        std::min(num_threads, num_chunks),
+                        [&](size_t) { return num_chunks; },
+                        [&](size_t, size_t c, size_t thread) {
+                            const size_t to = std::min(n, (c + 1) * chunk);
+                            for (size_t item = c * chunk; item < to; item++) {
+                                fn(item, thread);
+                            }
+                        });
+    }
+} // end namespace LocARNA
+
+#endif // LOCARNA_PARALLEL_HH
@@ -36,6 +36,7 @@ namespace LocARNA {
             DEFINE_NAMED_ARG_DEFAULT(stacking, bool, false);
             DEFINE_NAMED_ARG_DEFAULT(dangling, int, 2);
             DEFINE_NAMED_ARG_DEFAULT(max_bp_span, int, -1);
+            DEFINE_NAMED_ARG_DEFAULT(window_size, int, -1);
             DEFINE_NAMED_ARG_DEFAULT(ribo, bool, true);
             DEFINE_NAMED_ARG_DEFAULT(cv_fact, double, 0.6);
             DEFINE_NAMED_ARG_DEFAULT(nc_fact, double, 0.5);
@@ -44,6 +45,7 @@ namespace LocARNA {
                                           stacking,
                                           dangling,
                                           max_bp_span,
+                                          window_size,
                                           ribo,
                                           cv_fact,
                                           nc_fact>;
@@ -55,7 +57,13 @@ namespace LocARNA {
          * @param noLP forbid lonely base pairs
          * @param stacking calculate stacking probabilities
          * @param max_bp_span maximum base pair span
+         * @param window_size window size for local (plfold-style)
+         * folding; -1 selects global folding
          * @param dangling ViennaRNA dangling end type
+         *
+         * @note in local folding, the maximum base pair span is
+         * limited by the window size; if no span is given, it
+         * defaults to the window size.
          */
         template <typename... Args>
         PFoldParams(Args... argpack) : md_() {
@@ -72,6 +80,16 @@ namespace LocARNA {
 
             md_.max_bp_span = get_named_arg_opt<args::max_bp_span>(args);
 
+            md_.window_size = get_named_arg_opt<args::window_size>(args);
+            if (md_.window_size > 0) {
+                if (md_.max_bp_span < 0 ||
+                    md_.max_bp_span > md_.window_size) {
+                    md_.max_bp_span = md_.window_size;
+                }
+            } else {
+                md_.window_size = -1;
+            }
+
             md_.dangles = get_named_arg_opt<args::dangling>(args);
             assert(md_.dangles >= 0);
             assert(md_.dangles <= 3);
@@ -147,6 +165,26 @@ namespace LocARNA {
                                         : std::numeric_limits<size_t>::max();
         }
 
+        /**
+         * @brief Check for local folding
+         *
+         * @return whether local (windowed) folding is selected
+         */
+        bool
+        local_folding() const {
+            return md_.window_size > 0;
+        }
+
+        /**
+         * @brief Get window size of local folding
+         *
+         * @return window size (-1 for global folding)
+         */
+        int
+        window_size() const {
+            return md_.window_size;
+        }
+
         /**
          * @brief Get dangling value
          *
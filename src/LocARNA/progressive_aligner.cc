@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+
+#include "progressive_aligner.hh"
+
+#include "aligner.hh"
+#include "alignment.hh"
+#include "anchor_constraints.hh"
+#include "arc_matches.hh"
+#include "multiple_alignment.hh"
+#include "parallel.hh"
+#include "rna_data.hh"
+#include "rna_ensemble.hh"
+#include "sequence.hh"
+#include "trace_controller.hh"
+
+namespace LocARNA {
+
+    ProgressiveAligner::ProgressiveAligner(
+        const ScoringParams &scoring_params,
+        const ProgressiveAlignerParams &params)
+        : scoring_params_(scoring_params), params_(params), scores_() {
+        if (scoring_params_.mea_scoring_) {
+            throw failure("Progressive alignment does not support "
+                          "MEA scoring.");
+        }
+        if (params_.alifold_consensus_ && !params_.pfoldparams_) {
+            throw failure("Alifold consensus requires folding "
+                          "parameters.");
+        }
+    }
+
+    std::vector<size_t>
+    ProgressiveAligner::parent_steps(size_t num_leaves, const tree_t &tree) {
+        if (num_leaves == 0) {
+            throw failure("Progressive alignment requires at least one "
+                          "leaf.");
+        }
+        if (tree.size() + 1 != num_leaves) {
+            throw failure("Guide tree does not match the number of "
+                          "leaves.");
+        }
+
+        // parent step of each node; the root has no parent
+        const size_t no_parent = tree.size();
+        std::vector<size_t> parent(num_leaves + tree.size(), no_parent);
+
+        for (size_t k = 0; k < tree.size(); k++) {
+            for (size_t node : {tree[k].first, tree[k].second}) {
+                // children are leaves or results of earlier steps
+                if (node >= num_leaves + k || parent[node] != no_parent) {
+                    throw failure("Invalid guide tree: bad node in merge "
+                                  "step " + std::to_string(k) + ".");
+                }
+                parent[node] = k;
+            }
+            if (tree[k].first == tree[k].second) {
+                throw failure("Invalid guide tree: node merged with "
+                              "itself.");
+            }
+        }
+
+        return parent;
+    }
+
+    ProgressiveAligner::profile_t
+    ProgressiveAligner::merge(const RnaData &rna_dataA,
+                              const RnaData &rna_dataB,
+                              infty_score_t &score) const {
+        const Sequence &seqA = rna_dataA.sequence();
+        const Sequence &seqB = rna_dataB.sequence();
+
+        size_type lenA = seqA.length();
+        size_type lenB = seqB.length();
+
+        AnchorConstraints seq_constraints(
+            lenA,
+            seqA.annotation(MultipleAlignment::AnnoType::anchors)
+                .single_string(),
+            lenB,
+            seqB.annotation(MultipleAlignment::AnnoType::anchors)
+                .single_string(),
+            !params_.relaxed_anchors_);
+
+        TraceController trace_controller(seqA, seqB, nullptr,
+                                         params_.max_diff_,
+                                         params_.max_diff_relax_);
+        trace_controller.restrict_by_anchors(seq_constraints);
+
+        ArcMatches arc_matches(rna_dataA, rna_dataB, params_.min_prob_,
+                               params_.max_diff_am_ != -1
+                                   ? (size_type)params_.max_diff_am_
+                                   : std::max(lenA, lenB),
+                               params_.max_diff_at_am_ != -1
+                                   ? (size_type)params_.max_diff_at_am_
+                                   : std::max(lenA, lenB),
+                               trace_controller, seq_constraints);
+
+        // the background probabilities depend on the profile lengths
+        ScoringParams scoring_params = scoring_params_;
+        scoring_params.exp_probA_ =
+            params_.exp_prob_ >= 0 ? params_.exp_prob_ : prob_exp_f(lenA);
+        scoring_params.exp_probB_ =
+            params_.exp_prob_ >= 0 ? params_.exp_prob_ : prob_exp_f(lenB);
+
+        Scoring scoring(seqA, seqB, rna_dataA, rna_dataB, arc_matches,
+                        nullptr, scoring_params);
+
+        Aligner aligner(
+            AlignerParams(AlignerParams::seqA(&seqA),
+                          AlignerParams::seqB(&seqB),
+                          AlignerParams::scoring(&scoring),
+                          AlignerParams::no_lonely_pairs(
+                              params_.no_lonely_pairs_),
+                          AlignerParams::struct_local(params_.struct_local_),
+                          AlignerParams::sequ_local(params_.sequ_local_),
+                          AlignerParams::free_endgaps(params_.free_endgaps_),
+                          AlignerParams::max_diff_am(params_.max_diff_am_),
+                          AlignerParams::max_diff_at_am(
+                              params_.max_diff_at_am_),
+                          AlignerParams::trace_controller(&trace_controller),
+                          AlignerParams::stacking(params_.stacking_),
+                          AlignerParams::constraints(&seq_constraints)));
+
+        score = aligner.align();
+        aligner.trace();
+
+        if (params_.alifold_consensus_) {
+            // fold the merged alignment in memory; the cutoff is
+            // chosen as in locarna --alifold-consensus-dp
+            MultipleAlignment ma(aligner.get_alignment());
+            double min_prob = std::sqrt(rna_dataA.arc_cutoff_prob() *
+                                   rna_dataB.arc_cutoff_prob());
+            RnaEnsemble rna_ensemble(ma, *params_.pfoldparams_, false, true);
+            return std::make_shared<RnaData>(rna_ensemble, min_prob, 0,
+                                             *params_.pfoldparams_);
+        }
+
+        return std::make_shared<RnaData>(rna_dataA, rna_dataB,
+                                         aligner.get_alignment(),
+                                         scoring_params.exp_probA_,
+                                         scoring_params.exp_probB_);
+    }
+
+    ProgressiveAligner::profile_t
+    ProgressiveAligner::align(const std::vector<profile_t> &leaves,
+                              const tree_t &tree) {
+        // validates the tree
+        parent_steps(leaves.size(), tree);
+        const size_t num_leaves = leaves.size();
+        const size_t num_steps = tree.size();
+
+        scores_.assign(num_steps, infty_score_t::neg_infty);
+
+        // profiles of all nodes; released as soon as they are merged
+        std::vector<profile_t> profiles(leaves);
+        profiles.resize(num_leaves + num_steps);
+
+        // group the steps by their height in the tree; since children
+        // are results of earlier steps, the steps of one height
+        // belong to independent subtrees
+        std::vector<size_t> height(num_leaves + num_steps, 0);
+        std::vector<std::vector<size_t>> levels;
+        for (size_t k = 0; k < num_steps; k++) {
+            size_t h = std::max(height[tree[k].first], height[tree[k].second]);
+            height[num_leaves + k] = h + 1;
+            if (levels.size() <= h) {
+                levels.resize(h + 1);
+            }
+            levels[h].push_back(k);
+        }
+
+        // merge the steps of each height in parallel
+        parallel_levels(
+            levels.size(), std::max(1, params_.threads_),
+            [&](size_t level) { return levels[level].size(); },
+            [&](size_t level, size_t item, size_t) {
+                size_t k = levels[level][item];
+                profile_t profileA = std::move(profiles[tree[k].first]);
+                profile_t profileB = std::move(profiles[tree[k].second]);
+                profiles[num_leaves + k] =
+                    merge(*profileA, *profileB, scores_[k]);
+            });
+
+        return profiles.back();
+    }
+
+    ProgressiveAligner::profile_t
+    ProgressiveAligner::project(const MultipleAlignment &ma,
+                                const std::vector<const RnaData *> &rows_data,
+                                const std::vector<bool> &selected) const {
+        std::vector<const RnaData *> selected_data;
+        std::vector<size_t> rows;
+        for (size_t r = 0; r < ma.num_of_rows(); r++) {
+            if (selected[r]) {
+                selected_data.push_back(rows_data[r]);
+                rows.push_back(r);
+            }
+        }
+
+        // columns with at least one non-gap in the selected rows
+        std::vector<size_t> columns;
+        for (size_t c = 1; c <= ma.length(); c++) {
+            for (size_t r : rows) {
+                if (!is_gap_symbol(ma.seqentry(r).seq()[c])) {
+                    columns.push_back(c);
+                    break;
+                }
+            }
+        }
+
+        MultipleAlignment projection;
+        for (size_t r : rows) {
+            const MultipleAlignment::SeqEntry &entry = ma.seqentry(r);
+            std::string seq;
+            seq.reserve(columns.size());
+            for (size_t c : columns) {
+                seq += entry.seq()[c];
+            }
+            projection.append(MultipleAlignment::SeqEntry(
+                entry.name(), entry.description(), seq));
+        }
+
+        double p_exp = params_.exp_prob_ >= 0
+            ? params_.exp_prob_
+            : prob_exp_f(projection.length());
+
+        return std::make_shared<RnaData>(selected_data, projection, p_exp);
+    }
+
+    ProgressiveAligner::profile_t
+    ProgressiveAligner::refine(const std::vector<profile_t> &leaves,
+                               const tree_t &tree,
+                               profile_t profile,
+                               const PFoldParams &pfoldparams,
+                               size_t rounds) {
+        parent_steps(leaves.size(), tree);
+        const size_t num_leaves = leaves.size();
+        const size_t num_nodes = num_leaves + tree.size();
+
+        // identify the leaves by their names
+        std::map<std::string, size_t> leaf_index;
+        for (size_t i = 0; i < num_leaves; i++) {
+            const MultipleAlignment &ma = leaves[i]->multiple_alignment();
+            if (ma.num_of_rows() != 1) {
+                throw failure("Refinement requires single RNAs as leaves.");
+            }
+            leaf_index[ma.seqentry(0).name()] = i;
+        }
+        if (leaf_index.size() != num_leaves ||
+            profile->multiple_alignment().num_of_rows() != num_leaves) {
+            throw failure("Leaves do not match the rows of the alignment.");
+        }
+
+        // leaves below each node
+        std::vector<std::vector<size_t>> below(num_nodes);
+        for (size_t i = 0; i < num_leaves; i++) {
+            below[i].push_back(i);
+        }
+        for (size_t k = 0; k < tree.size(); k++) {
+            auto &v = below[num_leaves + k];
+            v = below[tree[k].first];
+            v.insert(v.end(), below[tree[k].second].begin(),
+                     below[tree[k].second].end());
+        }
+
+        // one split per edge of the (unrooted) tree; the two edges
+        // at the root yield the same split
+        std::vector<size_t> splits;
+        for (size_t v = 0; num_leaves > 2 && v + 1 < num_nodes; v++) {
+            if (v != tree.back().second) {
+                splits.push_back(v);
+            }
+        }
+
+        double objective =
+            -alifold_mfe(profile->multiple_alignment(), pfoldparams);
+
+        // result of realigning along one split
+        struct candidate_t {
+            profile_t profile;
+            double objective;
+        };
+
+        // realign the current alignment along a split
+        auto realign = [&](const profile_t &current, size_t split) {
+            const MultipleAlignment &ma = current->multiple_alignment();
+            std::vector<const RnaData *> rows_data(ma.num_of_rows());
+            for (size_t r = 0; r < ma.num_of_rows(); r++) {
+                auto it = leaf_index.find(ma.seqentry(r).name());
+                if (it == leaf_index.end()) {
+                    throw failure("Leaves do not match the rows of the "
+                                  "alignment.");
+                }
+                rows_data[r] = leaves[it->second].get();
+            }
+
+            std::vector<bool> in_split(num_leaves, false);
+            for (size_t i : below[split]) {
+                in_split[i] = true;
+            }
+            std::vector<bool> selected(ma.num_of_rows());
+            for (size_t r = 0; r < ma.num_of_rows(); r++) {
+                selected[r] =
+                    in_split[leaf_index.find(ma.seqentry(r).name())->second];
+            }
+
+            profile_t profileA = project(ma, rows_data, selected);
+            selected.flip();
+            profile_t profileB = project(ma, rows_data, selected);
+
+            infty_score_t score = infty_score_t::neg_infty;
+            candidate_t candidate;
+            candidate.profile = merge(*profileA, *profileB, score);
+            candidate.objective =
+                -alifold_mfe(candidate.profile->multiple_alignment(),
+                             pfoldparams);
+            return candidate;
+        };
+
+        const size_t num_threads =
+            std::max<size_t>(1, std::max(1, params_.threads_));
+
+        for (size_t round = 0; round < rounds; round++) {
+            bool improved = false;
+
+            size_t pos = 0;
+            while (pos < splits.size()) {
+                // speculatively realign the next splits in parallel,
+                // all of them against the current alignment
+                const size_t batch_size =
+                    std::min(num_threads, splits.size() - pos);
+                std::vector<candidate_t> candidates(batch_size);
+
+                parallel_for(batch_size, batch_size,
+                             [&](size_t b, size_t) {
+                                 candidates[b] =
+                                     realign(profile, splits[pos + b]);
+                             });
+
+                // accept the first improvement; later candidates were
+                // computed from the previous alignment and are dropped
+                size_t b = 0;
+                while (b < batch_size &&
+                       !(candidates[b].objective > objective)) {
+                    b++;
+                }
+                if (b < batch_size) {
+                    profile = std::move(candidates[b].profile);
+                    objective = candidates[b].objective;
+                    improved = true;
+                    pos += b + 1;
+                } else {
+                    pos += batch_size;
+                }
+            }
+
+            if (!improved) {
+                break;
+            }
+        }
+
+        return profile;
+    }
+
+} // end namespace LocARNA
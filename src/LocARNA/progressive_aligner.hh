@@ -0,0 +1,264 @@
+#ifndef LOCARNA_PROGRESSIVE_ALIGNER_HH
+#define LOCARNA_PROGRESSIVE_ALIGNER_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "aux.hh"
+#include "named_arguments.hh"
+#include "free_endgaps.hh"
+#include "scoring.hh"
+
+namespace LocARNA {
+
+    class RnaData;
+    class MultipleAlignment;
+    class PFoldParams;
+
+    /**
+       \brief Parameter for progressive alignment by ProgressiveAligner
+
+       Collects the parameters of the pairwise alignments of the
+       progressive steps; they correspond to the respective options of
+       locarna. The scoring parameters are passed separately.
+
+       @see ProgressiveAligner
+    */
+    class ProgressiveAlignerParams {
+    public:
+        //! cutoff probability of arcs in arc matches
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(min_prob, double, 0.0005);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(no_lonely_pairs, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(struct_local, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(sequ_local, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(free_endgaps, FreeEndgaps, FreeEndgaps("----"));
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff, int, -1);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff_relax, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff_am, int, -1);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(max_diff_at_am, int, -1);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(relaxed_anchors, bool, false);
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(stacking, bool, false);
+        //! background probability; if negative, derive from the length
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(exp_prob, double, -1.0);
+        //! number of threads for merging independent subtrees
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(threads, int, 1);
+        //! compute consensus dot plots by alifold (otherwise averaged)
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(alifold_consensus, bool, false);
+        //! folding parameters for the alifold consensus
+        DEFINE_NAMED_ARG_DEFAULT_FEATURE(pfoldparams,
+                                         const PFoldParams *,
+                                         nullptr);
+
+        using valid_args = std::tuple<min_prob,
+                                      no_lonely_pairs,
+                                      struct_local,
+                                      sequ_local,
+                                      free_endgaps,
+                                      max_diff,
+                                      max_diff_relax,
+                                      max_diff_am,
+                                      max_diff_at_am,
+                                      relaxed_anchors,
+                                      stacking,
+                                      exp_prob,
+                                      threads,
+                                      alifold_consensus,
+                                      pfoldparams>;
+
+        /**
+         * Construct with named arguments
+         */
+        template <class... Args>
+        ProgressiveAlignerParams(Args... argpack) {
+            static_assert( type_subset_of<
+                           std::tuple<Args...>,
+                           valid_args>::value,
+                           "Invalid type in named arguments pack." );
+            auto args = std::make_tuple(argpack...);
+
+            min_prob_ = get_named_arg_opt<min_prob>(args);
+            no_lonely_pairs_ = get_named_arg_opt<no_lonely_pairs>(args);
+            struct_local_ = get_named_arg_opt<struct_local>(args);
+            sequ_local_ = get_named_arg_opt<sequ_local>(args);
+            free_endgaps_ = get_named_arg_opt<free_endgaps>(args);
+            max_diff_ = get_named_arg_opt<max_diff>(args);
+            max_diff_relax_ = get_named_arg_opt<max_diff_relax>(args);
+            max_diff_am_ = get_named_arg_opt<max_diff_am>(args);
+            max_diff_at_am_ = get_named_arg_opt<max_diff_at_am>(args);
+            relaxed_anchors_ = get_named_arg_opt<relaxed_anchors>(args);
+            stacking_ = get_named_arg_opt<stacking>(args);
+            exp_prob_ = get_named_arg_opt<exp_prob>(args);
+            threads_ = get_named_arg_opt<threads>(args);
+            alifold_consensus_ = get_named_arg_opt<alifold_consensus>(args);
+            pfoldparams_ = get_named_arg_opt<pfoldparams>(args);
+        }
+    };
+
+    /**
+     * @brief Progressive multiple alignment of RNAs along a guide tree
+     *
+     * Aligns the profiles of the two children of each inner node of
+     * the guide tree by Aligner and represents the result as
+     * consensus RnaData, which is kept in memory as input to the
+     * parent node. Merges of the same height in the tree, which
+     * belong to independent subtrees, are performed in parallel;
+     * thus, balanced trees are aligned in about log(N) rounds.
+     *
+     * The guide tree is given by its merge steps (like a linkage
+     * matrix): the nodes 0..N-1 are the leaves; merge step k joins
+     * two nodes and creates node N+k. The last step yields the root.
+     *
+     * With ProgressiveAlignerParams::alifold_consensus, the
+     * consensus base pair probabilities of each merged profile are
+     * computed by alifold on its alignment (like locarna
+     * --alifold-consensus-dp); otherwise, they are averaged from the
+     * profiles of the children.
+     *
+     * @note MEA scoring is not supported, since it requires match
+     * probabilities for each merge.
+     */
+    class ProgressiveAligner {
+    public:
+        //! merge step, pair of joined nodes
+        using merge_t = std::pair<size_t, size_t>;
+
+        //! guide tree as sequence of merge steps
+        using tree_t = std::vector<merge_t>;
+
+        //! profile of a node
+        using profile_t = std::shared_ptr<const RnaData>;
+
+        /**
+         * @brief Construct with parameters
+         *
+         * @param scoring_params scoring parameters; the background
+         * probabilities are set for each merge (unless
+         * ProgressiveAlignerParams::exp_prob is given)
+         * @param params alignment parameters
+         *
+         * @note the scoring parameters are copied; objects passed by
+         * pointer (ribosum, ribofit, pfoldparams) must be kept alive
+         * by the caller
+         *
+         * throws failure if alifold consensus is requested without
+         * folding parameters
+         */
+        ProgressiveAligner(const ScoringParams &scoring_params,
+                           const ProgressiveAlignerParams &params);
+
+        /**
+         * @brief Align the leaves along the guide tree
+         *
+         * @param leaves profiles of the leaves
+         * @param tree guide tree
+         *
+         * @return consensus profile of the root; its sequence is the
+         * multiple alignment of all leaves
+         *
+         * throws failure if the tree is not a binary tree over the
+         * leaves
+         */
+        profile_t
+        align(const std::vector<profile_t> &leaves, const tree_t &tree);
+
+        /**
+         * @brief Iterative refinement along the guide tree
+         *
+         * @param leaves profiles of the leaves (single RNAs)
+         * @param tree guide tree
+         * @param profile profile of an alignment of all leaves,
+         * e.g. the result of align()
+         * @param pfoldparams folding parameters of the objective
+         * @param rounds maximum number of refinement rounds
+         *
+         * @return profile of the refined alignment
+         *
+         * Each edge of the guide tree splits the alignment into two
+         * parts; the parts are realigned and the result is accepted
+         * if it improves the objective, which is the negated
+         * alifold mfe (like mlocarna --iterate). Rounds over all
+         * splits are repeated until no split improves.
+         *
+         * The profiles of the parts are projected from the leaf
+         * profiles, such that no RNA is folded again. Splits are
+         * realigned speculatively in parallel (using the configured
+         * number of threads) against the current alignment;
+         * improvements are accepted greedily in the order of the
+         * splits, such that the result equals the one of serial
+         * refinement.
+         *
+         * throws failure if the leaves do not match the rows of the
+         * alignment
+         */
+        profile_t
+        refine(const std::vector<profile_t> &leaves,
+               const tree_t &tree,
+               profile_t profile,
+               const PFoldParams &pfoldparams,
+               size_t rounds);
+
+        /**
+         * @brief Scores of the merge steps of the last alignment
+         * @return vector of the scores by merge step
+         */
+        const std::vector<infty_score_t> &
+        scores() const {
+            return scores_;
+        }
+
+    private:
+        ScoringParams scoring_params_;     //!< scoring parameters
+        ProgressiveAlignerParams params_;  //!< alignment parameters
+        std::vector<infty_score_t> scores_; //!< scores of the merge steps
+
+        /**
+         * @brief Check the guide tree
+         * @param num_leaves number of leaves
+         * @param tree guide tree
+         * @return for each node, the merge step of its parent
+         *
+         * throws failure if the tree is invalid
+         */
+        static std::vector<size_t>
+        parent_steps(size_t num_leaves, const tree_t &tree);
+
+        /**
+         * @brief Align two profiles
+         *
+         * @param rna_dataA profile A
+         * @param rna_dataB profile B
+         * @param[out] score alignment score
+         *
+         * @return consensus profile of the alignment; the base pair
+         * probabilities are averaged or, for alifold consensus,
+         * computed by alifold on the alignment
+         */
+        profile_t
+        merge(const RnaData &rna_dataA,
+              const RnaData &rna_dataB,
+              infty_score_t &score) const;
+
+        /**
+         * @brief Profile of a subset of the rows of an alignment
+         *
+         * @param ma multiple alignment
+         * @param rows_data data of the RNAs in the rows of ma
+         * @param selected whether each row belongs to the subset
+         *
+         * @return profile of the selected rows, without columns
+         * consisting only of gaps
+         */
+        profile_t
+        project(const MultipleAlignment &ma,
+                const std::vector<const RnaData *> &rows_data,
+                const std::vector<bool> &selected) const;
+    }; // end class ProgressiveAligner
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_PROGRESSIVE_ALIGNER_HH
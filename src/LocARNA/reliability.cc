@@ -0,0 +1,497 @@
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "reliability.hh"
+#include "multiple_alignment.hh"
+
+namespace LocARNA {
+
+    namespace {
+        /**
+         * @brief Read the files of all pairs of sequences
+         *
+         * @param dir directory
+         * @param names file names of the sequences
+         * @param read_line function that parses one line for a pair
+         */
+        template <class ReadLine>
+        void
+        read_pair_files(const std::string &dir,
+                        const std::vector<std::string> &names,
+                        ReadLine read_line) {
+            for (size_t a = 0; a < names.size(); a++) {
+                for (size_t b = 0; b < names.size(); b++) {
+                    if (a == b) {
+                        continue;
+                    }
+                    std::string filename =
+                        dir + "/" + names[a] + "-" + names[b];
+                    std::ifstream in(filename.c_str());
+                    if (!in.is_open()) {
+                        continue;
+                    }
+                    std::string line;
+                    while (getline(in, line)) {
+                        if (line.find_first_not_of(" \t") ==
+                            std::string::npos) {
+                            continue;
+                        }
+                        std::istringstream lin(line);
+                        if (!read_line(lin, a, b)) {
+                            throw failure("Cannot parse line '" + line +
+                                          "' in " + filename + ".");
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Columns of the sequence positions of all rows
+         * @param ma multiple alignment
+         * @return for each row, vector of the column of each
+         * position (1-based, [0]=0)
+         */
+        std::vector<std::vector<pos_type>>
+        position_columns(const MultipleAlignment &ma) {
+            std::vector<std::vector<pos_type>> cols(ma.num_of_rows());
+            for (size_t r = 0; r < ma.num_of_rows(); r++) {
+                const string1 &seq = ma.seqentry(r).seq();
+                cols[r].push_back(0);
+                for (pos_type c = 1; c <= ma.length(); c++) {
+                    if (std::isalpha((unsigned char)seq[c])) {
+                        cols[r].push_back(c);
+                    }
+                }
+            }
+            return cols;
+        }
+
+        /**
+         * @brief Column of a position
+         * @param cols columns of the positions of a row
+         * @param i position
+         * @return column of i or 0 if i is out of range
+         */
+        pos_type
+        column(const std::vector<pos_type> &cols, pos_type i) {
+            return i < cols.size() ? cols[i] : 0;
+        }
+    }
+
+    MatchProbSets::MatchProbSets(size_t num_seqs)
+        : num_seqs_(num_seqs),
+          base_matches_(num_seqs * num_seqs),
+          arc_matches_(num_seqs * num_seqs) {}
+
+    void
+    MatchProbSets::read_base_match_probs(
+        const std::string &dir, const std::vector<std::string> &names) {
+        assert(names.size() == num_seqs_);
+        read_pair_files(dir, names,
+                        [this](std::istream &in, size_t a, size_t b) {
+                            base_match_t bm;
+                            if (!(in >> bm.i >> bm.j >> bm.prob)) {
+                                return false;
+                            }
+                            base_matches(a, b).push_back(bm);
+                            return true;
+                        });
+    }
+
+    void
+    MatchProbSets::read_arc_match_probs(
+        const std::string &dir, const std::vector<std::string> &names) {
+        assert(names.size() == num_seqs_);
+        read_pair_files(dir, names,
+                        [this](std::istream &in, size_t a, size_t b) {
+                            arc_match_t am;
+                            if (!(in >> am.i >> am.j >> am.k >> am.l >>
+                                  am.prob)) {
+                                return false;
+                            }
+                            arc_matches(a, b).push_back(am);
+                            return true;
+                        });
+    }
+
+    ReliabilityProfile::ReliabilityProfile(const MultipleAlignment &ma,
+                                           const MatchProbSets &probs)
+        : seq_(ma.length() + 1, 0.0),
+          str_(ma.length() + 1, 0.0),
+          arcs_() {
+        const size_t K = ma.num_of_rows();
+        if (K < 2 || probs.num_seqs() != K) {
+            throw failure("Reliabilities require match probabilities of "
+                          "at least two rows.");
+        }
+
+        auto cols = position_columns(ma);
+
+        // each unordered pair contributes once; like mlocarna, use the
+        // probabilities with the lexicographically larger name first
+        for (size_t x = 0; x < K; x++) {
+            for (size_t y = x + 1; y < K; y++) {
+                if (ma.seqentry(x).name() > ma.seqentry(y).name()) {
+                    add_pair(probs, x, y, cols);
+                } else {
+                    add_pair(probs, y, x, cols);
+                }
+            }
+        }
+
+        double pairs = K * (K - 1) / 2.0;
+        normalize(pairs, pairs);
+    }
+
+    ReliabilityProfile::ReliabilityProfile(
+        const MultipleAlignment &ma,
+        const MatchProbSets &probs,
+        size_t row,
+        const arc_reliabilities_t &pair_probs)
+        : seq_(ma.length() + 1, 0.0),
+          str_(ma.length() + 1, 0.0),
+          arcs_() {
+        const size_t K = ma.num_of_rows();
+        if (K < 2 || probs.num_seqs() != K || row >= K) {
+            throw failure("Reliabilities require match probabilities of "
+                          "at least two rows.");
+        }
+
+        auto cols = position_columns(ma);
+
+        for (size_t b = 0; b < K; b++) {
+            if (b != row) {
+                add_pair(probs, row, b, cols);
+            }
+        }
+
+        // the base pair probabilities of the sequence count as one
+        // more contribution to the arc reliabilities
+        for (const auto &pp : pair_probs) {
+            pos_type c1 = column(cols[row], pp.first.first);
+            pos_type c2 = column(cols[row], pp.first.second);
+            if (c1 == 0 || c2 == 0) {
+                throw failure("Base pair out of range of the sequence " +
+                              ma.seqentry(row).name() + ".");
+            }
+            arcs_[{c1, c2}] += pp.second;
+        }
+
+        normalize(K - 1, K);
+    }
+
+    void
+    ReliabilityProfile::add_pair(
+        const MatchProbSets &probs,
+        size_t a,
+        size_t b,
+        const std::vector<std::vector<pos_type>> &cols) {
+        const auto &cols_a = cols[a];
+        const auto &cols_b = cols[b];
+
+        // matches contribute if they are matches of the alignment
+        for (const auto &bm : probs.base_matches(a, b)) {
+            pos_type c = column(cols_a, bm.i);
+            if (c != 0 && c == column(cols_b, bm.j)) {
+                seq_[c] += bm.prob;
+            }
+        }
+
+        for (const auto &am : probs.arc_matches(a, b)) {
+            pos_type c1 = column(cols_a, am.i);
+            pos_type c2 = column(cols_a, am.j);
+            if (c1 == 0 || c2 < c1 || c1 != column(cols_b, am.k) ||
+                c2 != column(cols_b, am.l)) {
+                continue;
+            }
+            str_[c1] += am.prob;
+            str_[c2] += am.prob;
+            arcs_[{c1, c2}] += am.prob;
+        }
+    }
+
+    void
+    ReliabilityProfile::normalize(double seq_pairs, double arc_pairs) {
+        for (size_t c = 1; c < seq_.size(); c++) {
+            seq_[c] /= seq_pairs;
+            str_[c] /= seq_pairs;
+        }
+        for (auto &arc : arcs_) {
+            arc.second /= arc_pairs;
+        }
+    }
+
+    std::pair<double, std::string>
+    ReliabilityProfile::max_weight_structure(double struct_weight,
+                                             double threshold) const {
+        const pos_type len = length();
+        const pos_type d_min = 4; // minimal difference j-i of arcs (i,j)
+
+        // arcs by left end, sorted by right end
+        std::vector<std::vector<std::pair<pos_type, double>>> arcs(len + 2);
+        for (const auto &arc : arcs_) {
+            arcs[arc.first.first].emplace_back(arc.first.second,
+                                               arc.second * struct_weight);
+        }
+
+        // triangular matrices; row i holds the entries j=i-1..len
+        std::vector<std::vector<double>> N(len + 2);
+        std::vector<std::vector<pos_type>> T(len + 2);
+        for (pos_type i = 1; i <= len + 1; i++) {
+            N[i].resize(len - i + 2, 0.0);
+            T[i].resize(len - i + 2, 0);
+        }
+        auto n = [&](pos_type i, pos_type j) -> double & {
+            return N[i][j + 1 - i];
+        };
+        auto t = [&](pos_type i, pos_type j) -> pos_type & {
+            return T[i][j + 1 - i];
+        };
+
+        // T is 0 for "i unpaired" or k for the arc (i,k)
+        for (pos_type i = len; i >= 1; i--) {
+            // candidates for right ends k of arcs (i,k) with weight;
+            // following Ziv-Ukelson et al., only arcs that are optimal
+            // for n(i,k) are candidates
+            std::vector<std::pair<pos_type, double>> candidates;
+            auto arc = std::lower_bound(
+                arcs[i].begin(), arcs[i].end(),
+                std::make_pair(i + d_min,
+                               std::numeric_limits<double>::lowest()));
+
+            for (pos_type j = i + d_min; j <= len; j++) {
+                double best = n(i + 1, j);
+                pos_type best_k = 0;
+
+                for (const auto &cand : candidates) {
+                    pos_type k = cand.first;
+                    double score =
+                        n(i + 1, k - 1) + n(k + 1, j) + cand.second;
+                    if (score > best) {
+                        best = score;
+                        best_k = k;
+                    }
+                }
+
+                if (arc != arcs[i].end() && arc->first == j) {
+                    double score = n(i + 1, j - 1) + arc->second;
+                    if (score > best) {
+                        best = score;
+                        best_k = j;
+                        candidates.push_back(*arc);
+                    }
+                    ++arc;
+                }
+
+                n(i, j) = best;
+                t(i, j) = best_k;
+            }
+        }
+
+        double score = len > 0 ? n(1, len) : 0.0;
+
+        std::string structure(len, '.');
+        std::vector<std::pair<pos_type, pos_type>> stack;
+        if (len > 0) {
+            stack.emplace_back(1, len);
+        }
+        while (!stack.empty()) {
+            pos_type i = stack.back().first;
+            pos_type j = stack.back().second;
+            stack.pop_back();
+
+            if (i + d_min > j) {
+                continue;
+            }
+
+            pos_type k = t(i, j);
+            if (k == 0) {
+                stack.emplace_back(i + 1, j);
+                continue;
+            }
+
+            double rel = arcs_.find({i, k})->second;
+            const char *brackets =
+                rel >= threshold ? "()" : (rel >= threshold / 2 ? "{}" : "`'");
+            structure[i - 1] = brackets[0];
+            structure[k - 1] = brackets[1];
+
+            stack.emplace_back(i + 1, k - 1);
+            stack.emplace_back(k + 1, j);
+        }
+
+        return {score, structure};
+    }
+
+    std::ostream &
+    ReliabilityProfile::write_bm_reliabilities(std::ostream &out) const {
+        for (pos_type c = 1; c <= length(); c++) {
+            out << c << " " << seq_[c] << " " << str_[c] << "\n";
+        }
+        return out;
+    }
+
+    std::ostream &
+    ReliabilityProfile::write_am_reliabilities(std::ostream &out) const {
+        for (const auto &arc : arcs_) {
+            out << arc.first.first << " " << arc.first.second << " "
+                << arc.second << "\n";
+        }
+        return out;
+    }
+
+    std::ostream &
+    ReliabilityProfile::write_bars(std::ostream &out) const {
+        const size_t reso = 10;
+        for (size_t level = 0; level < reso; level++) {
+            out << "-" << std::setw(3) << 100 * (level + 1) / reso << "%"
+                << std::string(14, ' ');
+            double x = (double)level / reso;
+            for (pos_type c = 1; c <= length(); c++) {
+                out << (str_[c] > x ? '#'
+                                    : (str_[c] + seq_[c] > x ? '*' : ' '));
+            }
+            out << "\n";
+        }
+        return out;
+    }
+
+    std::ostream &
+    ReliabilityProfile::write_dotplot(std::ostream &out,
+                                      const std::string &sequence) const {
+        // postscript code adapted from RNAfold -p output
+        out << "%!PS-Adobe-3.0 EPSF-3.0\n"
+               "%%Title: RNA Dot Plot\n"
+               "%%Creator: MLocARNA\n"
+               "%%BoundingBox: 66 211 518 662\n"
+               "%%DocumentFonts: Helvetica\n"
+               "%%Pages: 1\n"
+               "%%EndComments\n"
+               "\n"
+               "%Options:\n"
+               "%\n"
+               "%This file contains the square roots of the base pair "
+               "probabilities in the form\n"
+               "% i  j  sqrt(p(i,j)) ubox\n"
+               "\n"
+               "%%BeginProlog\n"
+               "/DPdict 100 dict def\n"
+               "DPdict begin\n"
+               "/logscale false def\n"
+               "/lpmin 1e-05 log def\n"
+               "\n"
+               "/box { %size x y box - draws box centered on x,y\n"
+               "   2 index 0.5 mul sub            % x -= 0.5\n"
+               "   exch 2 index 0.5 mul sub exch  % y -= 0.5\n"
+               "   3 -1 roll dup rectfill\n"
+               "} bind def\n"
+               "\n"
+               "/ubox {\n"
+               "   logscale {\n"
+               "      log dup add lpmin div 1 exch sub dup 0 lt { pop 0 } "
+               "if\n"
+               "   } if\n"
+               "   3 1 roll\n"
+               "   exch len exch sub 1 add box\n"
+               "} bind def\n"
+               "\n"
+               "/lbox {\n"
+               "   3 1 roll\n"
+               "   len exch sub 1 add box\n"
+               "} bind def\n"
+               "\n"
+               "/drawseq {\n"
+               "% print sequence along all 4 sides\n"
+               "[ [0.7 -0.3 0 ]\n"
+               "  [0.7 0.7 len add 0]\n"
+               "  [-0.3 len sub -0.4 -90]\n"
+               "  [-0.3 len sub 0.7 len add -90]\n"
+               "] {\n"
+               "   gsave\n"
+               "    aload pop rotate translate\n"
+               "    0 1 len 1 sub {\n"
+               "     dup 0 moveto\n"
+               "     sequence exch 1 getinterval\n"
+               "     show\n"
+               "    } for\n"
+               "   grestore\n"
+               "  } forall\n"
+               "} bind def\n"
+               "\n"
+               "/drawgrid{\n"
+               "  0.01 setlinewidth\n"
+               "  len log 0.9 sub cvi 10 exch exp  % grid spacing\n"
+               "  dup 1 gt {\n"
+               "     dup dup 20 div dup 2 array astore exch 40 div setdash\n"
+               "  } { [0.3 0.7] 0.1 setdash } ifelse\n"
+               "  0 exch len {\n"
+               "     dup dup\n"
+               "     0 moveto\n"
+               "     len lineto\n"
+               "     dup\n"
+               "     len exch sub 0 exch moveto\n"
+               "     len exch len exch sub lineto\n"
+               "     stroke\n"
+               "  } for\n"
+               "  [] 0 setdash\n"
+               "  0.04 setlinewidth\n"
+               "  currentdict /cutpoint known {\n"
+               "    cutpoint 1 sub\n"
+               "    dup dup -1 moveto len 1 add lineto\n"
+               "    len exch sub dup\n"
+               "    -1 exch moveto len 1 add exch lineto\n"
+               "    stroke\n"
+               "  } if\n"
+               "  0.5 neg dup translate\n"
+               "} bind def\n"
+               "\n"
+               "end\n"
+               "%%EndProlog\n"
+               "DPdict begin\n"
+               "%delete next line to get rid of title\n"
+               "270 665 moveto /Helvetica findfont 14 scalefont setfont "
+               "(dot.ps) show\n"
+               "\n"
+               "/sequence { (\\\n"
+            << sequence << "\\\n"
+            << ") } def\n"
+               "/len { sequence length } bind def\n"
+               "\n"
+               "72 216 translate\n"
+               "72 6 mul len 1 add div dup scale\n"
+               "/Helvetica findfont 0.95 scalefont setfont\n"
+               "\n"
+               "drawseq\n"
+               "0.5 dup translate\n"
+               "% draw diagonal\n"
+               "0.04 setlinewidth\n"
+               "0 len moveto len 0 lineto stroke\n"
+               "\n"
+               "drawgrid\n"
+               "\n"
+               "%data starts here\n";
+
+        for (const auto &arc : arcs_) {
+            if (arc.second != 0) {
+                out << "0 0 0 setrgbcolor " << arc.first.first << " "
+                    << arc.first.second << " " << std::sqrt(arc.second)
+                    << " ubox\n";
+            }
+        }
+
+        out << "\n"
+               "showpage\n"
+               "end\n"
+               "%%EOF\n";
+        return out;
+    }
+
+} // end namespace LocARNA
@@ -0,0 +1,312 @@
+#ifndef LOCARNA_RELIABILITY_HH
+#define LOCARNA_RELIABILITY_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aux.hh"
+
+namespace LocARNA {
+
+    class MultipleAlignment;
+
+    /**
+     * @brief Base and arc match probabilities of pairs of sequences
+     *
+     * Holds the match probabilities of the ordered pairs of a set of
+     * sequences as flat lists; the lists of the pair (a,b) contain
+     * positions of a first. This corresponds to the probability
+     * directories written by mlocarna (options --write-bm-probs and
+     * --write-am-probs), which contain one file nameA-nameB per
+     * ordered pair.
+     */
+    class MatchProbSets {
+    public:
+        //! base match (i,j) with probability
+        struct base_match_t {
+            pos_type i; //!< position in first sequence
+            pos_type j; //!< position in second sequence
+            double prob; //!< match probability
+        };
+
+        //! arc match of (i,j) and (k,l) with probability
+        struct arc_match_t {
+            pos_type i; //!< left end in first sequence
+            pos_type j; //!< right end in first sequence
+            pos_type k; //!< left end in second sequence
+            pos_type l; //!< right end in second sequence
+            double prob; //!< match probability
+        };
+
+        //! list of base matches
+        using base_matches_t = std::vector<base_match_t>;
+
+        //! list of arc matches
+        using arc_matches_t = std::vector<arc_match_t>;
+
+        /**
+         * @brief Construct without probabilities
+         * @param num_seqs number of sequences
+         */
+        explicit MatchProbSets(size_t num_seqs);
+
+        /**
+         * @brief Number of sequences
+         * @return number of sequences
+         */
+        size_t
+        num_seqs() const {
+            return num_seqs_;
+        }
+
+        /**
+         * @brief Base matches of a pair of sequences
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @return base matches of a and b
+         */
+        base_matches_t &
+        base_matches(size_t a, size_t b) {
+            return base_matches_[a * num_seqs_ + b];
+        }
+
+        //! @copydoc base_matches(size_t,size_t)
+        const base_matches_t &
+        base_matches(size_t a, size_t b) const {
+            return base_matches_[a * num_seqs_ + b];
+        }
+
+        /**
+         * @brief Arc matches of a pair of sequences
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @return arc matches of a and b
+         */
+        arc_matches_t &
+        arc_matches(size_t a, size_t b) {
+            return arc_matches_[a * num_seqs_ + b];
+        }
+
+        //! @copydoc arc_matches(size_t,size_t)
+        const arc_matches_t &
+        arc_matches(size_t a, size_t b) const {
+            return arc_matches_[a * num_seqs_ + b];
+        }
+
+        /**
+         * @brief Read base match probabilities
+         *
+         * @param dir directory with one file nameA-nameB per pair;
+         * lines "i j p"
+         * @param names file names of the sequences
+         *
+         * Missing files are treated as pairs without probabilities.
+         * throws failure on lines that cannot be parsed
+         */
+        void
+        read_base_match_probs(const std::string &dir,
+                              const std::vector<std::string> &names);
+
+        /**
+         * @brief Read arc match probabilities
+         *
+         * @param dir directory with one file nameA-nameB per pair;
+         * lines "i j k l p"
+         * @param names file names of the sequences
+         *
+         * Missing files are treated as pairs without probabilities.
+         * throws failure on lines that cannot be parsed
+         */
+        void
+        read_arc_match_probs(const std::string &dir,
+                             const std::vector<std::string> &names);
+
+    private:
+        size_t num_seqs_;                         //!< number of sequences
+        std::vector<base_matches_t> base_matches_; //!< by pair
+        std::vector<arc_matches_t> arc_matches_;   //!< by pair
+    };
+
+    /**
+     * @brief Reliability profile of a multiple alignment
+     *
+     * Reliabilities of the columns of a multiple alignment, as
+     * computed by mlocarna --probabilistic: the base match
+     * reliability of a column is the average of the match
+     * probabilities of the row pairs in this column, split into
+     * contributions of base matches (sequence) and of arc matches
+     * (structure). The arc match reliability of two columns is the
+     * average probability that the row pairs match arcs between
+     * these columns.
+     *
+     * The profile is computed by one pass over the match
+     * probability lists of each pair of rows; the alignment is only
+     * used to map sequence positions to columns. All indices of the
+     * profile are columns (1-based).
+     */
+    class ReliabilityProfile {
+    public:
+        //! arc reliabilities (or pair probabilities) by column pairs
+        using arc_reliabilities_t =
+            std::map<std::pair<pos_type, pos_type>, double>;
+
+        /**
+         * @brief Construct consensus profile
+         *
+         * @param ma multiple alignment
+         * @param probs match probabilities of the rows of ma
+         */
+        ReliabilityProfile(const MultipleAlignment &ma,
+                           const MatchProbSets &probs);
+
+        /**
+         * @brief Construct profile of a single sequence
+         *
+         * @param ma multiple alignment
+         * @param probs match probabilities of the rows of ma
+         * @param row row of the sequence
+         * @param pair_probs base pair probabilities of the sequence
+         * (by sequence positions)
+         *
+         * Averages over the pairs of row with all other rows; the
+         * arc reliabilities include the base pair probabilities of
+         * the sequence as one more contribution.
+         */
+        ReliabilityProfile(const MultipleAlignment &ma,
+                           const MatchProbSets &probs,
+                           size_t row,
+                           const arc_reliabilities_t &pair_probs);
+
+        /**
+         * @brief Length
+         * @return number of columns
+         */
+        size_type
+        length() const {
+            return seq_.size() - 1;
+        }
+
+        /**
+         * @brief Base match reliabilities from base matches
+         * @return vector of reliabilities by column (index 0 unused)
+         */
+        const std::vector<double> &
+        sequence_reliabilities() const {
+            return seq_;
+        }
+
+        /**
+         * @brief Base match reliabilities from arc matches
+         * @return vector of reliabilities by column (index 0 unused)
+         */
+        const std::vector<double> &
+        structure_reliabilities() const {
+            return str_;
+        }
+
+        /**
+         * @brief Arc match reliabilities
+         * @return reliabilities by pairs of columns
+         */
+        const arc_reliabilities_t &
+        arc_reliabilities() const {
+            return arcs_;
+        }
+
+        /**
+         * @brief Maximum reliability structure
+         *
+         * @param struct_weight factor of the arc reliabilities
+         * @param threshold minimum reliability of pairs written
+         * as '()'; pairs above threshold/2 are written as '{}', all
+         * others as '`\''
+         *
+         * @return pair of score and structure
+         *
+         * Nussinov-like maximization of the sum of arc
+         * reliabilities (with minimum loop length 3), which uses
+         * candidate lists for sparsity.
+         */
+        std::pair<double, std::string>
+        max_weight_structure(double struct_weight, double threshold) const;
+
+        /**
+         * @brief Write base match reliabilities
+         * @param out output stream
+         * @return stream
+         *
+         * lines "i seq str" for all columns i
+         */
+        std::ostream &
+        write_bm_reliabilities(std::ostream &out) const;
+
+        /**
+         * @brief Write arc match reliabilities
+         * @param out output stream
+         * @return stream
+         *
+         * lines "i j rel"
+         */
+        std::ostream &
+        write_am_reliabilities(std::ostream &out) const;
+
+        /**
+         * @brief Write reliability bars
+         * @param out output stream
+         * @return stream
+         *
+         * Draws the reliabilities of the columns in 10 rows; '#'
+         * marks structure, '*' sequence reliability.
+         */
+        std::ostream &
+        write_bars(std::ostream &out) const;
+
+        /**
+         * @brief Write dot plot of the arc reliabilities
+         * @param out output stream
+         * @param sequence sequence (or consensus) string
+         * @return stream
+         *
+         * Writes postscript in the style of RNAfold -p.
+         */
+        std::ostream &
+        write_dotplot(std::ostream &out, const std::string &sequence) const;
+
+    private:
+        std::vector<double> seq_;  //!< sequence reliabilities
+        std::vector<double> str_;  //!< structure reliabilities
+        arc_reliabilities_t arcs_; //!< arc reliabilities
+
+        /**
+         * @brief Add contributions of one pair of rows
+         *
+         * @param probs match probabilities
+         * @param a first row
+         * @param b second row
+         * @param cols column of each position by row
+         */
+        void
+        add_pair(const MatchProbSets &probs,
+                 size_t a,
+                 size_t b,
+                 const std::vector<std::vector<pos_type>> &cols);
+
+        /**
+         * @brief Divide all reliabilities
+         * @param seq_pairs number of pairs in the base match reliabilities
+         * @param arc_pairs number of pairs in the arc reliabilities
+         */
+        void
+        normalize(double seq_pairs, double arc_pairs);
+    };
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_RELIABILITY_HH
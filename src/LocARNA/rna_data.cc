@@ -42,6 +42,25 @@ namespace LocARNA {
         }
     }
 
+    RnaData::RnaData(std::shared_ptr<const RnaEnsemble> rna_ensemble,
+                     double p_bpcut,
+                     double max_bps_length_ratio,
+                     const PFoldParams &pfoldparams)
+        : pimpl_(std::make_unique<RnaDataImpl>(this,
+                                               p_bpcut,
+                                               pfoldparams.max_bp_span())) {
+        // the ensemble is only needed for stacking probabilities
+        if (pfoldparams.stacking()) {
+            pimpl_->lazy_ensemble_ = rna_ensemble;
+        }
+        init_from_rna_ensemble(*rna_ensemble, pfoldparams);
+
+        if (max_bps_length_ratio > 0.0) {
+            pimpl_->drop_worst_bps(max_bps_length_ratio *
+                                   pimpl_->sequence_.length());
+        }
+    }
+
     RnaData::RnaData(const std::string &filename,
                      double p_bpcut,
                      double max_bps_length_ratio,
@@ -52,13 +71,18 @@ namespace LocARNA {
         bool complete = read_autodetect(filename, pfoldparams);
 
         if (!complete) {
-            // recompute all probabilities
-            RnaEnsemble rna_ensemble(
+            // recompute all probabilities; keep the ensemble for
+            // computing stacking probabilities on demand (otherwise,
+            // it is freed after initialization)
+            auto rna_ensemble = std::make_shared<const RnaEnsemble>(
                 pimpl_->sequence_, pfoldparams, false,
                 pimpl_->sequence_.num_of_rows()>1); // use given parameters, no in loop, use alifold unless single seq
+            if (pfoldparams.stacking()) {
+                pimpl_->lazy_ensemble_ = rna_ensemble;
+            }
 
             // initialize from RnaEnsemble; note: method is virtual
-            init_from_rna_ensemble(rna_ensemble, pfoldparams);
+            init_from_rna_ensemble(*rna_ensemble, pfoldparams);
         }
 
         if (max_bps_length_ratio > 0.0) {
@@ -67,6 +91,80 @@ namespace LocARNA {
         }
     }
 
+    // "row consensus" constructor
+    RnaDataImpl::RnaDataImpl(RnaData *self,
+                             const std::vector<const RnaData *> &rows_data,
+                             const MultipleAlignment &ma,
+                             double p_exp)
+        : self_(self),
+          sequence_(ma),
+          p_bpcut_(),
+          max_bp_span_(),
+          arc_probs_(0.0),
+          arc_2_probs_(0.0),
+          has_stacking_(false),
+          arc_2_probs_complete_(false) {
+        const size_t rows = rows_data.size();
+        if (rows == 0 || rows != ma.num_of_rows()) {
+            throw failure("Number of RNAs does not match the alignment.");
+        }
+
+        double
+            p_penalty_factor = 0.1; // as in the pairwise consensus
+
+        // geometric mean of the cutoffs
+        double log_p_min_sum = 0.0;
+        for (const RnaData *rna_data : rows_data) {
+            log_p_min_sum += log(rna_data->arc_cutoff_prob());
+        }
+        p_bpcut_ = exp(log_p_min_sum / rows);
+        const double log_p_floor =
+            log(std::min(p_exp, p_bpcut_ * p_penalty_factor));
+
+        // for each column pair, sum the log probabilities over the
+        // rows having the pair; all other rows contribute the floor
+        SparseMatrix<double> log_sums(0.0);
+        SparseMatrix<size_t> counts(0);
+
+        std::vector<size_t> col;
+        for (size_t r = 0; r < rows; r++) {
+            const RnaData &rna_data = *rows_data[r];
+            if (rna_data.sequence().num_of_rows() != 1) {
+                throw failure("Consensus of alignment rows requires "
+                              "single RNAs.");
+            }
+
+            // map sequence positions to alignment columns
+            const string1 &seq = ma.seqentry(r).seq();
+            col.assign(1, 0);
+            for (size_t c = 1; c <= seq.length(); c++) {
+                if (!is_gap_symbol(seq[c])) {
+                    col.push_back(c);
+                }
+            }
+            if (col.size() != rna_data.length() + 1) {
+                throw failure("Alignment row " + ma.seqentry(r).name() +
+                              " does not match its RNA.");
+            }
+
+            for (const auto &x : rna_data.pimpl_->arc_probs_) {
+                const size_t i = col[x.first.first];
+                const size_t j = col[x.first.second];
+                log_sums.ref(i, j) += std::max(log(x.second), log_p_floor);
+                counts.ref(i, j) += 1;
+            }
+        }
+
+        for (const auto &x : log_sums) {
+            const size_t count = counts(x.first.first, x.first.second);
+            double p =
+                exp((x.second + (rows - count) * log_p_floor) / rows);
+            if (p > p_bpcut_) {
+                arc_probs_(x.first.first, x.first.second) = p;
+            }
+        }
+    }
+
     // do almost nothing
     RnaData::RnaData(double p_bpcut, size_t max_bp_span)
         : pimpl_(std::make_unique<RnaDataImpl>(this, p_bpcut, max_bp_span)) {}
@@ -86,6 +184,11 @@ namespace LocARNA {
                                                p_expA,
                                                p_expB)) {}
 
+    RnaData::RnaData(const std::vector<const RnaData *> &rows_data,
+                     const MultipleAlignment &ma,
+                     double p_exp)
+        : pimpl_(std::make_unique<RnaDataImpl>(this, rows_data, ma, p_exp)) {}
+
     RnaData::~RnaData() {
     }
 
@@ -114,7 +217,8 @@ namespace LocARNA {
           max_bp_span_(),
           arc_probs_(0.0),
           arc_2_probs_(0.0),
-          has_stacking_(false) {
+          has_stacking_(false),
+          arc_2_probs_complete_(false) {
 
         double
             p_penalty_factor = 0.1; //!<@todo this constant should be configurable
@@ -133,7 +237,8 @@ namespace LocARNA {
           max_bp_span_(max_bp_span),
           arc_probs_(0.0),
           arc_2_probs_(0.0),
-          has_stacking_(false) {}
+          has_stacking_(false),
+          arc_2_probs_complete_(false) {}
 
     ExtRnaData::ExtRnaData(const std::string &filename,
                            double p_bpcut,
@@ -149,13 +254,18 @@ namespace LocARNA {
         bool complete = read_autodetect(filename, pfoldparams);
 
         if (!complete) {
-            // recompute all probabilities
-            RnaEnsemble rna_ensemble(
+            // recompute all probabilities; keep the ensemble for
+            // computing stacking and in loop probabilities on demand
+            auto rna_ensemble = std::make_shared<const RnaEnsemble>(
                 sequence(), pfoldparams, true,
                 pimpl_->sequence_.num_of_rows()>1); // use given parameters, in-loop, use alifold unless single seq
+            if (pfoldparams.stacking()) {
+                pimpl_->lazy_ensemble_ = rna_ensemble;
+            }
+            ext_pimpl_->lazy_ensemble_ = rna_ensemble;
 
             // initialize
-            init_from_rna_ensemble(rna_ensemble, pfoldparams);
+            init_from_rna_ensemble(*rna_ensemble, pfoldparams);
         }
 
         if (max_bps_length_ratio > 0.0) {
@@ -190,6 +300,30 @@ namespace LocARNA {
         }
     }
 
+    ExtRnaData::ExtRnaData(std::shared_ptr<const RnaEnsemble> rna_ensemble,
+                           double p_bpcut,
+                           double p_bpilcut,
+                           double p_uilcut,
+                           double max_bps_length_ratio,
+                           double max_uil_length_ratio,
+                           double max_bpil_length_ratio,
+                           const PFoldParams &pfoldparams)
+        : RnaData(rna_ensemble, p_bpcut, max_bps_length_ratio, pfoldparams),
+          ext_pimpl_(
+              std::make_unique<ExtRnaDataImpl>(this, p_bpilcut, p_uilcut)) {
+        ext_pimpl_->lazy_ensemble_ = rna_ensemble;
+        // base pair and stacking probabilities are already
+        // initialized (and filtered) by RnaData
+        ext_pimpl_->init_from_ext_rna_ensemble(*rna_ensemble);
+
+        if (max_uil_length_ratio > 0.0) {
+            ext_pimpl_->drop_worst_uil(max_uil_length_ratio * length());
+        }
+        if (max_bpil_length_ratio > 0.0) {
+            ext_pimpl_->drop_worst_bpil(max_bpil_length_ratio * length());
+        }
+    }
+
     ExtRnaData::~ExtRnaData() {
     }
 
@@ -201,7 +335,9 @@ namespace LocARNA {
           p_uilcut_(p_uilcut),
           arc_in_loop_probs_(arc_prob_matrix_t(0.0)),
           unpaired_in_loop_probs_(arc_prob_vector_t(0.0)),
-          has_in_loop_probs_(false) {}
+          has_in_loop_probs_(false),
+          in_loop_probs_known_(false),
+          in_loop_probs_complete_(false) {}
 
     bool
     RnaData::read_autodetect(const std::string &filename,
@@ -517,9 +653,16 @@ namespace LocARNA {
 
         // ----------------------------------------
         // init base pair probabilities
+        //
+        // base pairs exceeding the span of the ensemble have
+        // probability 0; not enumerating them keeps this loop in
+        // O(len*span), which matters for long, locally folded
+        // sequences
+        size_t span = rna_ensemble.max_bp_span();
         arc_probs_.clear();
         for (size_t i = 1; i <= len; i++) {
-            for (size_t j = i + TURN + 1; j <= len; j++) {
+            for (size_t j = i + TURN + 1;
+                 j <= len && bp_span(i, j) <= span; j++) {
                 double p = rna_ensemble.arc_prob(i, j);
 
                 if (p > p_bpcut_) { // apply filter
@@ -531,10 +674,13 @@ namespace LocARNA {
         // ----------------------------------------
         // init stacking probabilities
         arc_2_probs_.clear();
+        arc_2_probs_complete_ = false;
         has_stacking_ = pfoldparams.stacking();
-        if (has_stacking_) {
+        // in lazy mode, stacking probabilities are computed on demand
+        if (has_stacking_ && !lazy_ensemble_) {
             for (size_t i = 1; i <= len; i++) {
-                for (size_t j = i + TURN + 3; j <= len; j++) {
+                for (size_t j = i + TURN + 3;
+                     j <= len && bp_span(i, j) <= span; j++) {
                     double p2 = rna_ensemble.arc_2_prob(i, j);
                     if (p2 > p_bpcut_) { // apply filter to joint probability !
                         arc_2_probs_(i, j) = p2;
@@ -553,114 +699,188 @@ namespace LocARNA {
         // (usually, this is called after RnaDataImpl::init_from_rna_ensemble)
         assert(rna_ensemble.has_in_loop_probs());
 
-        size_t len = self_->length();
-
-        // ----------------------------------------
-        // init base pair probabilities
         arc_in_loop_probs_.clear();
+        unpaired_in_loop_probs_.clear();
+        in_loop_probs_known_.clear();
+        in_loop_probs_complete_ = false;
+
+        init_right_ends();
+
+        // in lazy mode, the loops are computed on demand
+        if (!lazy_ensemble_) {
+            // in loop
+            for (const auto &x : self_->arc_probs()) {
+                compute_in_loop_probs(rna_ensemble, x.first.first,
+                                      x.first.second);
+            }
+            // external
+            compute_in_loop_probs(rna_ensemble, 0, self_->length() + 1);
+        }
+
+        // set flag
+        has_in_loop_probs_ = true;
+
+        // all set
+        return;
+    } // end method init_from_ext_rna_ensemble
 
-        // ------------------------------
-        // construct helper data structure for efficiency:
+    void
+    ExtRnaDataImpl::init_right_ends() {
+        // helper data structure for efficiency:
         // map left ends to right ends of all arcs in arc_probs_
-        std::vector<std::vector<size_t> > right_ends;
-        right_ends.resize(len + 1);
+        right_ends_.clear();
+        right_ends_.resize(self_->length() + 1);
         for (const auto &x : self_->arc_probs()) {
-            pos_type i = x.first.first;
-            pos_type j = x.first.second;
-            right_ends[i].push_back(j);
+            right_ends_[x.first.first].push_back(x.first.second);
         }
-        for (auto &x : right_ends) {
+        for (auto &x : right_ends_) {
             sort(x.begin(), x.end());
         }
-        // end constructing helper data structure
-
-        // in loop
-        for (const auto &x : self_->arc_probs()) {
-            pos_type i = x.first.first;
-            pos_type j = x.first.second;
-            arc_prob_matrix_t m_ij(0.0);
-
-            for (size_t ip = i + 1; ip < j; ip++) {
-                // for( size_t jp=ip+TURN+1; jp < j; jp++ ) {
-                for (const auto &jp : right_ends[ip]) {
-                    if (jp >= j) break;
-
-                    auto p = rna_ensemble.arc_in_loop_prob(ip, jp, i, j);
+    }
 
-                    if (p > p_bpilcut_) {
-                        m_ij(ip, jp) = p;
-                    }
+    void
+    ExtRnaDataImpl::compute_in_loop_probs(const RnaEnsemble &rna_ensemble,
+                                          size_t p,
+                                          size_t q) const {
+        // the external loop is represented by (0,len+1)
+        bool external = (p == 0);
+
+        // base pairs in loop
+        arc_prob_matrix_t m_pq(0.0);
+        for (size_t ip = p + 1; ip < q; ip++) {
+            for (const auto &jp : right_ends_[ip]) {
+                if (jp >= q) break;
+
+                auto prob = external
+                    ? rna_ensemble.arc_external_prob(ip, jp)
+                    : rna_ensemble.arc_in_loop_prob(ip, jp, p, q);
+
+                if (prob > p_bpilcut_) {
+                    m_pq(ip, jp) = prob;
                 }
             }
-
-            // set only if not empty; use set instead of assignment,
-            // to avoid the comparison of complex SparseMatrix objects
-            if (!m_ij.empty()) {
-                arc_in_loop_probs_.set(i, j, m_ij);
-            }
         }
 
-        // external
-        arc_prob_matrix_t m_ext(0.0);
-        for (size_t ip = 1; ip < len; ip++) {
-            for (const auto &jp : right_ends[ip]) {
-                auto p = rna_ensemble.arc_external_prob(ip, jp);
+        // set only if not empty; use set instead of assignment,
+        // to avoid the comparison of complex SparseMatrix objects
+        if (!m_pq.empty()) {
+            arc_in_loop_probs_.set(p, q, m_pq);
+        }
 
-                if (p > p_bpilcut_) {
-                    m_ext(ip, jp) = p;
-                }
+        // unpaired bases in loop
+        arc_prob_vector_t v_pq(0.0);
+        for (size_t k = p + 1; k < q; k++) {
+            auto prob = external ? rna_ensemble.unpaired_external_prob(k)
+                                 : rna_ensemble.unpaired_in_loop_prob(k, p, q);
+            if (prob > p_uilcut_) {
+                v_pq[k] = prob;
             }
         }
 
         // set only if not empty; see above
-        if (!m_ext.empty()) {
-            arc_in_loop_probs_.set(0, self_->length() + 1, m_ext);
+        if (!v_pq.empty()) {
+            unpaired_in_loop_probs_.set(p, q, v_pq);
         }
+    }
 
-        // ----------------------------------------
-        // init unpaired probabilities
-        unpaired_in_loop_probs_.clear();
-
-        // in loop
-        for (const auto &x : self_->arc_probs()) {
-            pos_type i = x.first.first;
-            pos_type j = x.first.second;
-            arc_prob_vector_t v_ij(0.0);
-
-            for (size_t k = i + 1; k < j; k++) {
-                auto p = rna_ensemble.unpaired_in_loop_prob(k, i, j);
-                if (p > p_uilcut_) {
-                    v_ij[k] = p;
-                }
-            }
+    void
+    ExtRnaDataImpl::require_in_loop_probs(size_t p, size_t q) const {
+        const auto &known = in_loop_probs_known_;
+        if (known(p, q)) {
+            return;
+        }
+        // loops of dropped or filtered arcs stay empty
+        if (p == 0 || self_->arc_prob(p, q) > 0.0) {
+            compute_in_loop_probs(*lazy_ensemble_, p, q);
+        }
+        in_loop_probs_known_.set(p, q, true);
+    }
 
-            // set only if not empty; see above
-            if (!v_ij.empty()) {
-                unpaired_in_loop_probs_.set(i, j, v_ij);
-            }
+    const ExtRnaDataImpl::arc_prob_matrix_t &
+    ExtRnaDataImpl::arc_in_loop_probs(size_t p, size_t q) const {
+        const auto &probs = arc_in_loop_probs_;
+        if (!lazy_ensemble_ ||
+            in_loop_probs_complete_.load(std::memory_order_acquire)) {
+            return probs(p, q);
         }
+        // references to entries stay valid on insertion of other
+        // loops, such that only the look up needs protection
+        std::lock_guard<std::mutex> lock(lazy_mutex_);
+        require_in_loop_probs(p, q);
+        return probs(p, q);
+    }
 
-        // external
-        arc_prob_vector_t v_ext(0.0);
-        for (size_t k = 1; k <= len; k++) {
-            auto p = rna_ensemble.unpaired_external_prob(k);
+    const ExtRnaDataImpl::arc_prob_vector_t &
+    ExtRnaDataImpl::unpaired_in_loop_probs(size_t p, size_t q) const {
+        const auto &probs = unpaired_in_loop_probs_;
+        if (!lazy_ensemble_ ||
+            in_loop_probs_complete_.load(std::memory_order_acquire)) {
+            return probs(p, q);
+        }
+        std::lock_guard<std::mutex> lock(lazy_mutex_);
+        require_in_loop_probs(p, q);
+        return probs(p, q);
+    }
 
-            if (p > p_uilcut_) {
-                v_ext[k] = p;
-            }
+    void
+    ExtRnaDataImpl::complete_lazy_probs() const {
+        if (!lazy_ensemble_ ||
+            in_loop_probs_complete_.load(std::memory_order_acquire)) {
+            return;
         }
+        std::lock_guard<std::mutex> lock(lazy_mutex_);
+        for (const auto &x : self_->arc_probs()) {
+            require_in_loop_probs(x.first.first, x.first.second);
+        }
+        require_in_loop_probs(0, self_->length() + 1);
+        // from now on, look ups don't need the lock
+        in_loop_probs_complete_.store(true, std::memory_order_release);
+    }
 
-        // set only if not empty; see above
-        if (!v_ext.empty()) {
-            unpaired_in_loop_probs_.set(0, self_->length() + 1, v_ext);
+    double
+    RnaDataImpl::joint_arc_prob(size_t i, size_t j) const {
+        if (!lazy_ensemble_ ||
+            arc_2_probs_complete_.load(std::memory_order_acquire)) {
+            return arc_2_probs_(i, j);
         }
+        return compute_joint_arc_prob(i, j);
+    }
 
-        // set flag
-        has_in_loop_probs_ = true;
+    double
+    RnaDataImpl::compute_joint_arc_prob(size_t i, size_t j) const {
+        // as in init_from_rna_ensemble(); since the joint
+        // probability is bounded by arc_probs_(i,j), arcs below
+        // cutoff (or dropped) cannot pass the filter
+        const auto &arc_probs = arc_probs_;
+        if (has_stacking_ && arc_probs(i, j) > 0.0 &&
+            frag_len_geq(i, j, TURN + 4)) {
+            double p2 = lazy_ensemble_->arc_2_prob(i, j);
+            if (p2 > p_bpcut_) { // apply filter to joint probability !
+                return p2;
+            }
+        }
+        return 0.0;
+    }
 
-        // all set
-        return;
-    } // end method init_from_ext_rna_ensemble
+    void
+    RnaDataImpl::complete_lazy_probs() const {
+        if (!lazy_ensemble_ ||
+            arc_2_probs_complete_.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(lazy_mutex_);
+        if (arc_2_probs_complete_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for (const auto &x : arc_probs_) {
+            double p2 = compute_joint_arc_prob(x.first.first, x.first.second);
+            if (p2 > 0.0) {
+                arc_2_probs_.set(x.first.first, x.first.second, p2);
+            }
+        }
+        // from now on, look ups read arc_2_probs_
+        arc_2_probs_complete_.store(true, std::memory_order_release);
+    }
 
     bool
     ExtRnaData::inloopprobs_ok() const {
@@ -699,14 +919,14 @@ namespace LocARNA {
 
     double
     RnaData::joint_arc_prob(pos_type i, pos_type j) const {
-        return pimpl_->arc_2_probs_(i, j);
+        return pimpl_->joint_arc_prob(i, j);
     }
 
     double
     RnaData::stacked_arc_prob(pos_type i, pos_type j) const {
         assert(pimpl_->arc_probs_(i + 1, j - 1) != 0);
 
-        return pimpl_->arc_2_probs_(i, j) / pimpl_->arc_probs_(i + 1, j - 1);
+        return pimpl_->joint_arc_prob(i, j) / pimpl_->arc_probs_(i + 1, j - 1);
     }
 
     double
@@ -746,16 +966,12 @@ namespace LocARNA {
                                  pos_type j,
                                  pos_type p,
                                  pos_type q) const {
-        ExtRnaDataImpl::arc_prob_matrix_t m_pq =
-            ext_pimpl_->arc_in_loop_probs_(p, q);
-        return m_pq(i, j);
+        return ext_pimpl_->arc_in_loop_probs(p, q)(i, j);
     }
 
     double
     ExtRnaData::arc_external_prob(pos_type i, pos_type j) const {
-        ExtRnaDataImpl::arc_prob_matrix_t m_ext =
-            ext_pimpl_->arc_in_loop_probs_(0, length() + 1);
-        return m_ext(i, j);
+        return ext_pimpl_->arc_in_loop_probs(0, length() + 1)(i, j);
     }
 
     double
@@ -767,16 +983,12 @@ namespace LocARNA {
     ExtRnaData::unpaired_in_loop_prob(pos_type k,
                                       pos_type p,
                                       pos_type q) const {
-        ExtRnaDataImpl::arc_prob_vector_t v_pq =
-            ext_pimpl_->unpaired_in_loop_probs_(p, q);
-        return v_pq[k];
+        return ext_pimpl_->unpaired_in_loop_probs(p, q)[k];
     }
 
     double
     ExtRnaData::unpaired_external_prob(pos_type k) const {
-        ExtRnaDataImpl::arc_prob_vector_t v_ext =
-            ext_pimpl_->unpaired_in_loop_probs_(0, length() + 1);
-        return v_ext[k];
+        return ext_pimpl_->unpaired_in_loop_probs(0, length() + 1)[k];
     }
 
     void
@@ -1337,8 +1549,8 @@ namespace LocARNA {
             if (x.second > p_outbpcut) {
                 out << i << " " << j << " " << format_prob(x.second);
                 if (stacking && has_stacking_ &&
-                    arc_2_probs_(i, j) > p_bpcut_) {
-                    out << " " << format_prob(arc_2_probs_(i, j));
+                    joint_arc_prob(i, j) > p_bpcut_) {
+                    out << " " << format_prob(joint_arc_prob(i, j));
                 }
                 out << std::endl;
             }
@@ -1363,6 +1575,8 @@ namespace LocARNA {
             << std::endl
             << std::endl;
 
+        complete_lazy_probs();
+
         // write in-loop probabilities for all arcs with probability greater
         // than p_outbpcut
         for (const auto &x : self_->arc_probs()) {
@@ -1393,18 +1607,17 @@ namespace LocARNA {
         //     out << std::endl << "   ";
         // }
 
-        write_pp_basepair_in_loop_probabilities(out, arc_in_loop_probs_(i, j),
-                                                p_bpilcut);
+        const auto &bp_probs = arc_in_loop_probs(i, j);
+        const auto &u_probs = unpaired_in_loop_probs(i, j);
+
+        write_pp_basepair_in_loop_probabilities(out, bp_probs, p_bpilcut);
 
         out << " ;"; // separate base pair and unpaired probabilities
-        if (arc_in_loop_probs_(i, j).size() >= 4 &&
-            unpaired_in_loop_probs_(i, j).size() >= 4) {
+        if (bp_probs.size() >= 4 && u_probs.size() >= 4) {
             out << "\\" << std::endl << "   ";
         }
 
-        write_pp_unpaired_in_loop_probabilities(out,
-                                                unpaired_in_loop_probs_(i, j),
-                                                p_uilcut);
+        write_pp_unpaired_in_loop_probabilities(out, u_probs, p_uilcut);
         out << std::endl;
 
         return out;
@@ -1441,6 +1654,7 @@ namespace LocARNA {
     RnaData::write_size_info(std::ostream &out) const {
         out << "arcs: " << pimpl_->arc_probs_.size();
         if (pimpl_->has_stacking_) {
+            pimpl_->complete_lazy_probs();
             out << "  stackings: " << pimpl_->arc_2_probs_.size();
         }
         return out;
@@ -1453,16 +1667,17 @@ namespace LocARNA {
         // count unpaired bases in loop
         size_t num_unpaired_in_loop = 0;
 
-        size_t len = length();
-        for (size_t i = 1; i <= len; i++) {
-            for (size_t j = i + 1; j <= len; j++) {
-                num_arcs_in_loop +=
-                    arc_prob_matrix_t(ext_pimpl_->arc_in_loop_probs_(i, j))
-                        .size();
-                num_unpaired_in_loop +=
-                    ExtRnaDataImpl::arc_prob_vector_t(
-                        ext_pimpl_->unpaired_in_loop_probs_(i, j))
-                        .size();
+        ext_pimpl_->complete_lazy_probs();
+
+        // count entries of all loops except the external one
+        for (const auto &x : ext_pimpl_->arc_in_loop_probs_) {
+            if (x.first.first > 0) {
+                num_arcs_in_loop += x.second.size();
+            }
+        }
+        for (const auto &x : ext_pimpl_->unpaired_in_loop_probs_) {
+            if (x.first.first > 0) {
+                num_unpaired_in_loop += x.second.size();
             }
         }
 
@@ -1605,6 +1820,11 @@ namespace LocARNA {
         RnaDataImpl *rdimpl = static_cast<RnaData *>(self_)->pimpl_.get();
         rdimpl->drop_worst_bps(keep);
 
+        // loops are computed on demand from the remaining arcs
+        if (lazy_ensemble_) {
+            init_right_ends();
+        }
+
         // free unpaired in loop where arc prob is 0
         for (const auto &x : unpaired_in_loop_probs_) {
             auto &key = x.first;
@@ -1636,6 +1856,8 @@ namespace LocARNA {
 
     void
     ExtRnaDataImpl::drop_worst_uil(size_t keep) {
+        complete_lazy_probs();
+
         typedef std::pair<arc_prob_vector_matrix_t::key_type,
                           arc_prob_vector_t::key_type>
             key_type;
@@ -1667,6 +1889,8 @@ namespace LocARNA {
 
     void
     ExtRnaDataImpl::drop_worst_bpil(size_t keep) {
+        complete_lazy_probs();
+
         typedef std::pair<arc_prob_matrix_matrix_t::key_type,
                           arc_prob_matrix_t::key_type>
             key_type;
@@ -1698,6 +1922,8 @@ namespace LocARNA {
 
     void
     ExtRnaDataImpl::drop_worst_bpil_precise(double ratio) {
+        complete_lazy_probs();
+
         typedef std::pair<arc_prob_matrix_matrix_t::key_type,
                           arc_prob_matrix_t::key_type>
             key_type;
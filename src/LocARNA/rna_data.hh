@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <iosfwd>
+#include <vector>
 #include "aux.hh"
 #include "sparse_matrix.hh"
 
@@ -68,6 +69,27 @@ namespace LocARNA {
                 double max_bps_length_ratio,
                 const PFoldParams &pfoldparams);
 
+        /**
+         * @brief Construct from shared RnaEnsemble with lazy
+         * computation of stacking probabilities
+         *
+         * @param rna_ensemble RNA ensemble data
+         * @param p_bpcut cutoff probability
+         * @param max_bps_length_ratio max ratio of bps to length (0=no effect)
+         * @param pfoldparams folding parameters (controls stacking)
+         *
+         * @note Base pair probabilities are copied. The object keeps
+         * the ensemble (with its McCaskill matrices) alive and
+         * computes the stacking probability of an arc only when it
+         * is accessed first; the result is memoized. Thus, arcs that
+         * are never used (e.g. since they are filtered by
+         * ArcMatches) do not cost anything.
+         */
+        RnaData(std::shared_ptr<const RnaEnsemble> rna_ensemble,
+                double p_bpcut,
+                double max_bps_length_ratio,
+                const PFoldParams &pfoldparams);
+
         /**
          * @brief Construct from file
          *
@@ -80,7 +102,8 @@ namespace LocARNA {
          * filter off.
          *
          * @note autodetect format of input;
-         * for fa or aln input formats, predict base pair probabilities
+         * for fa or aln input formats, predict base pair probabilities;
+         * then, stacking probabilities are computed on demand
          *
          * @todo consider to allow reading from istream; use
          * istream::seekg(0) to reset stream to beginning (needed for
@@ -130,6 +153,26 @@ namespace LocARNA {
                 double p_expB,
                 bool only_local = false);
 
+        /**
+         * @brief Construct as consensus of the rows of a multiple alignment
+         *
+         * @param rows_data data of single RNAs; one object per row of ma
+         * @param ma multiple alignment of the RNAs; row r aligns
+         * the sequence of rows_data[r]
+         * @param p_exp background probability
+         *
+         * Generalizes the consensus of two aligned RNAs to any number
+         * of rows: the probability of a column pair is the geometric
+         * mean of the row probabilities, where missing probabilities
+         * are penalized as in the pairwise case. This allows to
+         * project profiles to subsets of the rows of an alignment
+         * without realignment. Stacking probabilities are not
+         * computed.
+         */
+        RnaData(const std::vector<const RnaData *> &rows_data,
+                const MultipleAlignment &ma,
+                double p_exp);
+
         /**
          * @brief destructor
          */
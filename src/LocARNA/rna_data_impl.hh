@@ -5,7 +5,11 @@
 #include <config.h>
 #endif
 
+#include <atomic>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "rna_data.hh"
 #include "sequence.hh"
 
@@ -45,12 +49,28 @@ namespace LocARNA {
          * simultaneously above threshold; analogous to arc_probs_
          *
          * @note arc_2_probs_ has entry (i,j) implies arc_probs_ has entry (i,j)
+         *
+         * @note in lazy mode, the entries are added by
+         * complete_lazy_probs() (therefore mutable)
          */
-        arc_prob_matrix_t arc_2_probs_;
+        mutable arc_prob_matrix_t arc_2_probs_;
 
         //! whether stacking probabilities are available
         bool has_stacking_;
 
+        /**
+         * RNA ensemble for computing stacking probabilities on
+         * demand (lazy mode); empty, if arc_2_probs_ is complete or
+         * there are no stacking probabilities
+         */
+        std::shared_ptr<const RnaEnsemble> lazy_ensemble_;
+
+        //! in lazy mode, whether arc_2_probs_ has been completed
+        mutable std::atomic<bool> arc_2_probs_complete_;
+
+        //! guards the completion in lazy mode
+        mutable std::mutex lazy_mutex_;
+
         /**
          * @brief Construct as consensus of two aligned RNAs
          *
@@ -68,6 +88,19 @@ namespace LocARNA {
                     double p_expA,
                     double p_expB);
 
+        /**
+         * @brief Construct as consensus of the rows of a multiple alignment
+         *
+         * @param self pointer to corresponding RnaData object
+         * @param rows_data data of single RNAs; one object per row of ma
+         * @param ma multiple alignment of the RNAs
+         * @param p_exp background probability
+         */
+        RnaDataImpl(RnaData *self,
+                    const std::vector<const RnaData *> &rows_data,
+                    const MultipleAlignment &ma,
+                    double p_exp);
+
         /**
          * @brief Almost empty constructor
          *
@@ -104,6 +137,43 @@ namespace LocARNA {
         init_from_rna_ensemble(const RnaEnsemble &rna_ensemble,
                                const PFoldParams &pfoldparams);
 
+        /**
+         * @brief Joint probability of base pairs (i,j) and (i+1,j-1)
+         *
+         * @param i left end
+         * @param j right end
+         *
+         * @return stacking probability if above cutoff; otherwise 0
+         *
+         * In lazy mode, the probability is computed from
+         * lazy_ensemble_, until arc_2_probs_ is completed. Look ups
+         * never lock, such that they can be performed concurrently.
+         */
+        double
+        joint_arc_prob(size_t i, size_t j) const;
+
+        /**
+         * @brief Compute joint probability from the lazy ensemble
+         *
+         * @param i left end
+         * @param j right end
+         *
+         * @return stacking probability if above cutoff; otherwise 0
+         *
+         * @note requires lazy mode
+         */
+        double
+        compute_joint_arc_prob(size_t i, size_t j) const;
+
+        /**
+         * @brief Compute all stacking probabilities into arc_2_probs_
+         *
+         * @note no effect unless in lazy mode; required before
+         * iterating over arc_2_probs_
+         */
+        void
+        complete_lazy_probs() const;
+
         /**
          * @brief read sequence section of pp-format
          *
@@ -10,6 +10,7 @@
 #include "multiple_alignment.hh"
 #include "global_stopwatch.hh"
 #include "pfold_params.hh"
+#include "folding_context.hh"
 
 extern "C" {
 #include <ViennaRNA/data_structures.h>
@@ -20,6 +21,7 @@ extern "C" {
 #include <ViennaRNA/loop_energies.h>
 #include <ViennaRNA/params.h>
 #include <ViennaRNA/alifold.h>
+#include <ViennaRNA/LPfold.h>
 }
 
 #include "mcc_matrices.hh"
@@ -39,6 +41,16 @@ namespace LocARNA {
                                                    inLoopProbs,
                                                    use_alifold)) {}
 
+    RnaEnsemble::RnaEnsemble(const MultipleAlignment &sequence,
+                             FoldingContext &context,
+                             bool inLoopProbs,
+                             bool use_alifold)
+        : pimpl_(std::make_unique<RnaEnsembleImpl>(sequence,
+                                                   context.params(),
+                                                   inLoopProbs,
+                                                   use_alifold,
+                                                   &context)) {}
+
     RnaEnsemble::~RnaEnsemble() {
     }
 
@@ -62,6 +74,16 @@ namespace LocARNA {
         return pimpl_->sequence_;
     }
 
+    size_type
+    RnaEnsemble::max_bp_span() const {
+        return pimpl_->max_bp_span_;
+    }
+
+    bool
+    RnaEnsemble::local_folding() const {
+        return pimpl_->used_local_folding_;
+    }
+
     double
     RnaEnsemble::min_free_energy() const {
         return pimpl_->min_free_energy_;
@@ -81,12 +103,17 @@ namespace LocARNA {
 
     double
     RnaEnsemble::arc_prob(size_type i, size_type j) const {
+        if (pimpl_->used_local_folding_) {
+            return pimpl_->local_arc_probs_(i, j);
+        }
         return pimpl_->McCmat_->bppm(i, j);
     }
 
     double
     RnaEnsemble::arc_2_prob(size_type i, size_type j) const {
-        if (pimpl_->used_alifold_) {
+        if (pimpl_->used_local_folding_) {
+            return pimpl_->local_arc_2_probs_(i, j);
+        } else if (pimpl_->used_alifold_) {
             return pimpl_->arc_2_prob_ali(i, j);
         } else {
             return pimpl_->arc_2_prob_noali(i, j);
@@ -97,7 +124,8 @@ namespace LocARNA {
         const MultipleAlignment &sequence,
         const PFoldParams &params,
         bool inLoopProbs,
-        bool use_alifold = true)
+        bool use_alifold,
+        FoldingContext *context)
         : // self_(self),
           sequence_(sequence),
           pair_probs_available_(false),
@@ -105,10 +133,14 @@ namespace LocARNA {
           in_loop_probs_available_(false),
           McCmat_(nullptr),
           used_alifold_(false),
+          used_local_folding_(false),
+          max_bp_span_(params.max_bp_span()),
+          local_arc_probs_(0.0),
+          local_arc_2_probs_(0.0),
           min_free_energy_(std::numeric_limits<double>::infinity()),
           min_free_energy_structure_("") {
         sequence_.normalize_rna_symbols();
-        compute_ensemble_probs(params, inLoopProbs, use_alifold);
+        compute_ensemble_probs(params, inLoopProbs, use_alifold, context);
     }
 
     RnaEnsembleImpl::~RnaEnsembleImpl() {
@@ -117,23 +149,38 @@ namespace LocARNA {
     void
     RnaEnsembleImpl::compute_ensemble_probs(const PFoldParams &params,
                                             bool inLoopProbs,
-                                            bool use_alifold) {
+                                            bool use_alifold,
+                                            FoldingContext *context) {
         stopwatch.start("bpp");
 
         assert(use_alifold || sequence_.num_of_rows() == 1);
 
         used_alifold_ = use_alifold;
+        used_local_folding_ = params.local_folding();
+
+        if (used_local_folding_) {
+            if (use_alifold) {
+                throw failure("RnaEnsemble: local folding is not supported "
+                              "for alignments.");
+            }
+            if (inLoopProbs) {
+                throw failure("RnaEnsemble: in loop probabilities are not "
+                              "available in local folding.");
+            }
+        }
 
         // run McCaskill and get access to results
         // in McCaskill_matrices
-        if (!use_alifold) {
-            compute_McCaskill_matrices(params, inLoopProbs);
+        if (used_local_folding_) {
+            compute_local_ensemble_probs(params);
+        } else if (!use_alifold) {
+            compute_McCaskill_matrices(params, inLoopProbs, context);
         } else {
-            compute_McCaskill_alifold_matrices(params, inLoopProbs);
+            compute_McCaskill_alifold_matrices(params, inLoopProbs, context);
         }
 
         pair_probs_available_ = true;
-        stacking_probs_available_ = true;
+        stacking_probs_available_ = !used_local_folding_ || params.stacking();
         in_loop_probs_available_ = inLoopProbs;
 
         stopwatch.stop("bpp");
@@ -141,7 +188,8 @@ namespace LocARNA {
 
     void
     RnaEnsembleImpl::compute_McCaskill_matrices(const PFoldParams &params,
-                                                bool inLoopProbs) {
+                                                bool inLoopProbs,
+                                                FoldingContext *context) {
         assert(sequence_.num_of_rows() == 1);
         size_t length = sequence_.length();
 
@@ -154,7 +202,9 @@ namespace LocARNA {
             return;
         }
 
-        McCmat_ = std::make_unique<McC_matrices_t>(sequence_, params);
+        // with context, the Boltzmann factors are substituted later
+        McCmat_ = std::make_unique<McC_matrices_t>(sequence_, params,
+                                                   context == nullptr);
 
         const std::string &structure_anno =
             sequence_.annotation(MultipleAlignment::AnnoType::structure)
@@ -185,7 +235,7 @@ namespace LocARNA {
         min_free_energy_ = vrna_mfe(McCmat_->vc(), c_structure.get());
         min_free_energy_structure_ = std::string(c_structure.get());
 
-        vrna_exp_params_rescale(McCmat_->vc(), &min_free_energy_);
+        prepare_exp_params(context);
 
         // ----------------------------------------
         // call pf_fold
@@ -200,10 +250,91 @@ namespace LocARNA {
         }
     }
 
+    /**
+     * @brief Collect probabilities streamed by vrna_probs_window()
+     *
+     * @param pr probabilities of pairs (i,j), i<j<=pr_size
+     * @param pr_size maximum right end
+     * @param i left end
+     * @param max maximum base pair span (unused)
+     * @param type type of probabilities
+     * @param data pointer to the RnaEnsembleImpl object
+     */
+    static void
+    collect_window_probs(FLT_OR_DBL *pr,
+                         int pr_size,
+                         int i,
+                         int max,
+                         unsigned int type,
+                         void *data) {
+        auto *self = static_cast<RnaEnsembleImpl *>(data);
+
+        RnaEnsembleImpl::arc_prob_matrix_t *probs = nullptr;
+        if (type & VRNA_PROBS_WINDOW_BPP) {
+            probs = &self->local_arc_probs_;
+        } else if (type & VRNA_PROBS_WINDOW_STACKP) {
+            probs = &self->local_arc_2_probs_;
+        } else {
+            return;
+        }
+
+        for (int j = i + 1; j <= pr_size; j++) {
+            if (pr[j] > RnaEnsembleImpl::local_prob_floor_) {
+                probs->set(i, j, pr[j]);
+            }
+        }
+    }
+
+    void
+    RnaEnsembleImpl::compute_local_ensemble_probs(const PFoldParams &params) {
+        assert(sequence_.num_of_rows() == 1);
+        size_t length = sequence_.length();
+
+        local_arc_probs_.clear();
+        local_arc_2_probs_.clear();
+
+        if (length == 0) {
+            return;
+        }
+
+        // window size and span cannot exceed the sequence length
+        vrna_md_t md = params.model_details();
+        md.window_size = std::min(md.window_size, (int)length);
+        md.max_bp_span = std::min(md.max_bp_span, md.window_size);
+
+        auto seqstring = sequence_.seqentry(0).seq().str();
+        vrna_fold_compound_t *vc =
+            vrna_fold_compound(seqstring.c_str(), &md,
+                               VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+
+        const std::string &structure_anno =
+            sequence_.annotation(MultipleAlignment::AnnoType::structure)
+                .single_string();
+        if (structure_anno.length() == length) {
+            unsigned int constraint_options = 0;
+            constraint_options |= VRNA_CONSTRAINT_DB | VRNA_CONSTRAINT_DB_PIPE |
+                VRNA_CONSTRAINT_DB_DOT | VRNA_CONSTRAINT_DB_X |
+                VRNA_CONSTRAINT_DB_ANG_BRACK | VRNA_CONSTRAINT_DB_RND_BRACK;
+
+            vrna_constraints_add(vc, structure_anno.c_str(),
+                                 constraint_options);
+        }
+
+        unsigned int options = VRNA_PROBS_WINDOW_BPP;
+        if (params.stacking()) {
+            options |= VRNA_PROBS_WINDOW_STACKP;
+        }
+
+        vrna_probs_window(vc, 0, options, &collect_window_probs, this);
+
+        vrna_fold_compound_free(vc);
+    }
+
     void
     RnaEnsembleImpl::compute_McCaskill_alifold_matrices(
         const PFoldParams &params,
-        bool inLoopProbs) {
+        bool inLoopProbs,
+        FoldingContext *context) {
 
         size_t length = sequence_.length();
 
@@ -216,7 +347,8 @@ namespace LocARNA {
             return;
         }
 
-        McCmat_ = std::make_unique<McC_ali_matrices_t>(sequence_, params);
+        McCmat_ = std::make_unique<McC_ali_matrices_t>(sequence_, params,
+                                                       context == nullptr);
 
         // reserve space for structure
         auto c_structure = std::make_unique<char []>(length + 1);
@@ -252,7 +384,7 @@ namespace LocARNA {
         min_free_energy_ = vrna_mfe(McCmat_->vc(), c_structure.get());
         min_free_energy_structure_ = std::string(c_structure.get());
 
-        vrna_exp_params_rescale(McCmat_->vc(), &min_free_energy_);
+        prepare_exp_params(context);
 
         // ----------------------------------------
         // call alifold partition function
@@ -267,6 +399,23 @@ namespace LocARNA {
         }
     }
 
+    void
+    RnaEnsembleImpl::prepare_exp_params(FoldingContext *context) {
+        if (context != nullptr) {
+            // the fold compound has no Boltzmann factors yet; use a
+            // copy of the context's tables instead of computing them
+            vrna_exp_param_t *exp_params =
+                used_alifold_
+                ? context->exp_params_comparative(sequence_.num_of_rows())
+                : context->exp_params();
+            vrna_exp_params_subst(McCmat_->vc(), exp_params);
+        }
+
+        // set the pf scale; this also adapts the model details of the
+        // Boltzmann factors to the fold compound (e.g. the span)
+        vrna_exp_params_rescale(McCmat_->vc(), &min_free_energy_);
+    }
+
     void
     RnaEnsembleImpl::compute_Qm2() {
         assert(!used_alifold_);
@@ -1059,4 +1208,17 @@ namespace LocARNA {
             pimpl_->McCmat_->qln(1);
     }
 
+    double
+    alifold_mfe(const MultipleAlignment &ma, const PFoldParams &params) {
+        size_t length = ma.length();
+        if (length == 0) {
+            return 0;
+        }
+
+        McC_ali_matrices_t mats(ma, params, false);
+
+        auto c_structure = std::make_unique<char []>(length + 1);
+        return vrna_mfe(mats.vc(), c_structure.get());
+    }
+
 } // end namespace LocARNA
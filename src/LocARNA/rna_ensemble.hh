@@ -18,6 +18,8 @@ namespace LocARNA {
 
     class PFoldParams;
 
+    class FoldingContext;
+
     /**
      * @brief Represents the raw structure ensemble data for an RNA
      *
@@ -37,6 +39,12 @@ namespace LocARNA {
      * @note the class guarantees that sequences are normalized
      * (uppercase, T->U) even when read in unnormalized form,
      * e.g. from file or stream or received from other objects
+     *
+     * @note if the folding parameters select local folding
+     * (PFoldParams::local_folding()), single sequences are folded
+     * in windows (like RNAplfold); then, only base pair and
+     * stacking probabilities are available and no dense
+     * McCaskill matrices are kept.
      */
     class RnaEnsemble {
     public:
@@ -54,12 +62,36 @@ namespace LocARNA {
          * @param use_alifold whether alifold should be used
          *
          * @pre unless use_alifold, sequence row number has to be 1
+         *
+         * @note in local folding mode, throws failure if use_alifold
+         * or inLoopProbs
          */
         RnaEnsemble(const MultipleAlignment &ma,
                     const PFoldParams &params,
                     bool inLoopProbs,
                     bool use_alifold = true);
 
+        /**
+         * @brief folding constructor reusing a folding context
+         *
+         * Like the constructor with folding parameters, but takes the
+         * parameters from the context and reuses its cached energy
+         * parameter tables. Results are identical.
+         *
+         * @param ma the RNA sequence or alignment as MultipleAlignment object; the object holds a copy of ma
+         * @param context folding context; used only during construction
+         * @param inLoopProbs whether in loop probabilities should be made
+         * available
+         * @param use_alifold whether alifold should be used
+         *
+         * @note when folding many (short) RNAs, use one context per
+         * thread for all of them
+         */
+        RnaEnsemble(const MultipleAlignment &ma,
+                    FoldingContext &context,
+                    bool inLoopProbs,
+                    bool use_alifold = true);
+
         /**
          * @brief copy constructor
          * @param rna_ensemble object to be copied
@@ -115,6 +147,22 @@ namespace LocARNA {
         size_type
         length() const;
 
+        /**
+         * \brief get maximum base pair span of the ensemble
+         *
+         * \return maximum span of base pairs with non-zero
+         * probability (maximum size_type value if unrestricted)
+         */
+        size_type
+        max_bp_span() const;
+
+        /**
+         * \brief check for local folding
+         * \return whether the ensemble was computed by local folding
+         */
+        bool
+        local_folding() const;
+
         /**
          * \brief get minimum free energy
          *
@@ -321,6 +369,21 @@ namespace LocARNA {
         //! pointer to corresponding RnaEnsembleImpl object
         std::unique_ptr<RnaEnsembleImpl> pimpl_;
     };
+
+    /**
+     * @brief Minimum free energy of an alignment by alifold
+     *
+     * @param ma multiple alignment
+     * @param params folding parameters
+     *
+     * @return consensus mfe (as reported by RNAalifold)
+     *
+     * Computes only the mfe, which is much cheaper than folding the
+     * alignment by RnaEnsemble; e.g. to score alignments during
+     * iterative refinement.
+     */
+    double
+    alifold_mfe(const MultipleAlignment &ma, const PFoldParams &params);
 }
 
 #endif // LOCARNA_RNA_ENSEMBLE_HH
@@ -13,11 +13,24 @@
 
 namespace LocARNA {
 
+    class FoldingContext;
+
     /**
      * @brief Implementation of RnaEnsemble
      */
     class RnaEnsembleImpl {
     public:
+        //! type of sparse probability matrices in local folding
+        typedef SparseMatrix<double> arc_prob_matrix_t;
+
+        /**
+         * @brief minimum probability stored in local folding
+         *
+         * Local folding streams pair probabilities window by window;
+         * only probabilities above this floor are kept.
+         */
+        static constexpr double local_prob_floor_ = 1e-6;
+
         //! the sequence; the object holds a copy of the input
         //! sequence/alignment
         MultipleAlignment sequence_;
@@ -43,6 +56,20 @@ namespace LocARNA {
         //! whether alifold was used to compute the McCaskill matrices
         bool used_alifold_;
 
+        //! whether local (windowed) folding was used; then, McCmat_
+        //! is not available and probabilities are taken from
+        //! local_arc_probs_ and local_arc_2_probs_
+        bool used_local_folding_;
+
+        //! maximum base pair span used in folding
+        size_type max_bp_span_;
+
+        //! base pair probabilities from local folding
+        arc_prob_matrix_t local_arc_probs_;
+
+        //! stacking probabilities from local folding
+        arc_prob_matrix_t local_arc_2_probs_;
+
         double min_free_energy_; //!< minimum free energy (if computed anyway)
         std::string min_free_energy_structure_; //!< minimum free energy
                                                 //!structure (if computed)
@@ -55,11 +82,14 @@ namespace LocARNA {
          * @param inLoopProbs whether to compute in loop probabilities
          * @param use_alifold whether to use alifold (required unless
          * sequence is a single sequence)
+         * @param context folding context for reusing energy parameter
+         * tables (optional)
          */
         RnaEnsembleImpl(const MultipleAlignment &sequence,
                         const PFoldParams &pfparams,
                         bool inLoopProbs,
-                        bool use_alifold);
+                        bool use_alifold,
+                        FoldingContext *context = nullptr);
 
         /**
          * @brief Destructor
@@ -90,13 +120,16 @@ namespace LocARNA {
          * @param inLoopProbs whether in loop probabilities should be made
          * available
          * @param use_alifold whether alifold should be used
+         * @param context folding context for reusing energy parameter
+         * tables (optional)
          *
          * @pre unless use_alifold, sequence row number has to be 1
          */
         void
         compute_ensemble_probs(const PFoldParams &params,
                                bool inLoopProbs,
-                               bool use_alifold);
+                               bool use_alifold,
+                               FoldingContext *context = nullptr);
 
         /**
          * \brief Get joint probability of stacked arcs
@@ -234,9 +267,27 @@ namespace LocARNA {
          * @param params parameters for partition folding
          * @param inLoopProbs whether to compute information for in loop
          * probablities
+         * @param context folding context (optional)
          */
         void
-        compute_McCaskill_matrices(const PFoldParams &params, bool inLoopProbs);
+        compute_McCaskill_matrices(const PFoldParams &params,
+                                   bool inLoopProbs,
+                                   FoldingContext *context);
+
+        /**
+         * \brief Computes local base pair probabilities
+         *
+         * Folds in windows of size params.window_size() using
+         * ViennaRNA's window API. The probabilities are streamed
+         * into sparse matrices; no dense matrices are kept.
+         *
+         * @pre sequence_ has exactly one row
+         *
+         * @param params parameters for partition folding; local
+         * folding selected
+         */
+        void
+        compute_local_ensemble_probs(const PFoldParams &params);
 
         /**
          * \brief Computes the McCaskill matrices and keeps them accessible
@@ -247,10 +298,26 @@ namespace LocARNA {
          * @param params parameters for partition folding
          * @param inLoopProbs whether to compute and keep information for in
          * loop probablities
+         * @param context folding context (optional)
          */
         void
         compute_McCaskill_alifold_matrices(const PFoldParams &params,
-                                           bool inLoopProbs);
+                                           bool inLoopProbs,
+                                           FoldingContext *context);
+
+        /**
+         * \brief Prepare the Boltzmann factors for partition folding
+         *
+         * Substitutes the cached factors of the context (if any) and
+         * rescales them by the minimum free energy.
+         *
+         * @param context folding context (optional)
+         *
+         * @pre McCmat_ is constructed and min_free_energy_ is computed;
+         * without context, McCmat_ has its own Boltzmann factors
+         */
+        void
+        prepare_exp_params(FoldingContext *context);
     };
 
 } // end namespace LocARNA
@@ -12,6 +12,7 @@
 
 #include <cmath>
 #include <fstream>
+#include <map>
 #include <memory>
 
 namespace LocARNA {
@@ -39,6 +40,8 @@ namespace LocARNA {
           rna_dataB(rna_dataB_),
           seqA(seqA_),
           seqB(seqB_),
+          packedA_(seqA_),
+          packedB_(seqB_),
           lambda_(0) {
 #ifndef NDEBUG
         if (params->ribofit_ != nullptr || params->ribosum_ != nullptr) {
@@ -138,6 +141,40 @@ namespace LocARNA {
             }
         }
 
+        if (!params->mea_scoring_ && params->ribofit_ == nullptr) {
+            // the similarity of two columns depends only on their
+            // symbol counts; thus, compute it once per pair of
+            // distinct profiles as profile-profile product
+            auto profilesA =
+                column_profiles(packedA_, profile_idxA_, profile_colA_);
+            auto profilesB =
+                column_profiles(packedB_, profile_idxB_, profile_colB_);
+
+            const int rows = seqA.num_of_rows() * seqB.num_of_rows();
+
+            Matrix<score_t> profile_sigma(profilesA.size(), profilesB.size());
+            for (size_type p = 0; p < profilesA.size(); ++p) {
+                for (size_type q = 0; q < profilesB.size(); ++q) {
+                    score_t score = 0;
+                    for (const auto &a : profilesA[p]) {
+                        for (const auto &b : profilesB[q]) {
+                            score += (score_t)(a.second * b.second) *
+                                symbol_similarity(a.first, b.first);
+                        }
+                    }
+                    profile_sigma(p, q) = round2score(score / rows);
+                }
+            }
+
+            for (size_type i = 1; i <= lenA; ++i) {
+                for (size_type j = 1; j <= lenB; ++j) {
+                    sigma_tab(i, j) =
+                        profile_sigma(profile_idxA_[i], profile_idxB_[j]);
+                }
+            }
+            return;
+        }
+
         for (size_type i = 1; i <= lenA; ++i) {
             for (size_type j = 1; j <= lenB; ++j) {
                 sigma_tab(i, j) = sigma_(i, j);
@@ -163,8 +200,8 @@ namespace LocARNA {
         } else {
             // compute average score for aligning the two alignment columns
 
-            const auto &colA = seqA[ia];
-            const auto &colB = seqB[ib];
+            const auto &colA = packedA_.column(ia);
+            const auto &colB = packedB_.column(ib);
 
             score_t score = 0;
 
@@ -187,19 +224,8 @@ namespace LocARNA {
                             100.0 *
                             params->ribofit_->basematch_score(cA.second, cB.second,
                                                              identity(cA.first, cB.first)));
-                    } else if (params->ribosum_ &&
-                               params->ribosum_->alphabet().in(cA.second) &&
-                               params->ribosum_->alphabet().in(cB.second)) {
-                        score += round2score(
-                            100.0 *
-                            params->ribosum_
-                                ->basematch_score_corrected(cA.second, cB.second));
                     } else {
-                        if (cA.second != 'N' && cB.second != 'N') {
-                            score += (cA.second == cB.second)
-                                ? params->match_
-                                : params->mismatch_;
-                        }
+                        score += symbol_similarity(cA.second, cB.second);
                     }
                 }
             }
@@ -208,6 +234,54 @@ namespace LocARNA {
         }
     }
 
+    score_t
+    Scoring::symbol_similarity(char a, char b) const {
+        if (params->ribosum_ && params->ribosum_->alphabet().in(a) &&
+            params->ribosum_->alphabet().in(b)) {
+            return round2score(
+                100.0 * params->ribosum_->basematch_score_corrected(a, b));
+        }
+        if (a != 'N' && b != 'N') {
+            return (a == b) ? params->match_ : params->mismatch_;
+        }
+        return 0;
+    }
+
+    std::vector<Scoring::profile_t>
+    Scoring::column_profiles(const PackedAlignment &packed,
+                             std::vector<size_t> &profile_idx,
+                             std::vector<size_type> &profile_col) {
+        std::vector<profile_t> profiles;
+        std::map<profile_t, size_t> index;
+
+        profile_idx.assign(packed.length() + 1, 0);
+        profile_col.clear();
+
+        std::vector<size_t> counts(256, 0);
+        for (size_type col = 1; col <= packed.length(); ++col) {
+            for (const auto &c : packed.column(col)) {
+                counts[(unsigned char)c]++;
+            }
+            profile_t profile;
+            for (size_t c = 0; c < counts.size(); ++c) {
+                if (counts[c] > 0) {
+                    profile.emplace_back((char)c, counts[c]);
+                    counts[c] = 0;
+                }
+            }
+
+            auto it = index.find(profile);
+            if (it == index.end()) {
+                it = index.emplace(profile, profiles.size()).first;
+                profiles.push_back(std::move(profile));
+                profile_col.push_back(col);
+            }
+            profile_idx[col] = it->second;
+        }
+
+        return profiles;
+    }
+
     void
     Scoring::precompute_weights(const RnaData &rna_data,
                                 const BasePairs &bps,
@@ -293,7 +367,7 @@ namespace LocARNA {
         // determine gap frequencies for each column in A and B
 
         for (size_type i = 1; i < lenA + 1; i++) {
-            const auto &colA = seqA[i];
+            const auto &colA = packedA_.column(i);
             for (const auto &x : colA) {
                 gapfreqA[i] += (x == '-') ? 1 : 0;
             }
@@ -301,7 +375,7 @@ namespace LocARNA {
         }
 
         for (size_type i = 1; i < lenB + 1; i++) {
-            const auto &colB = seqB[i];
+            const auto &colB = packedB_.column(i);
             for (const auto &x : colB) {
                 gapfreqB[i] += (x == '-') ? 1 : 0;
             }
@@ -335,6 +409,11 @@ namespace LocARNA {
         const size_type rowsA = seqA.num_of_rows();
         const size_type rowsB = seqB.num_of_rows();
 
+        const auto colAl = packedA_.column(arcA.left());
+        const auto colAr = packedA_.column(arcA.right());
+        const auto colBl = packedB_.column(arcB.left());
+        const auto colBr = packedB_.column(arcB.right());
+
         double score = 0;
         int gapless_combinations = 0;
 
@@ -347,25 +426,21 @@ namespace LocARNA {
                 // how to handle gaps?
                 // current solution: ignore gap entries
 
-                if (seqA[arcA.left()][i] != '-' &&
-                    seqA[arcA.right()][i] != '-' &&
-                    seqB[arcB.left()][j] != '-' &&
-                    seqB[arcB.right()][j] != '-') {
+                if (colAl[i] != '-' &&
+                    colAr[i] != '-' &&
+                    colBl[j] != '-' &&
+                    colBr[j] != '-') {
                     gapless_combinations++;
 
-                    if (alphabet.in(seqA[arcA.left()][i]) &&
-                        alphabet.in(seqA[arcA.right()][i]) &&
-                        alphabet.in(seqB[arcB.left()][j]) &&
-                        alphabet.in(seqB[arcB.right()][j])) {
+                    if (alphabet.in(colAl[i]) &&
+                        alphabet.in(colAr[i]) &&
+                        alphabet.in(colBl[j]) &&
+                        alphabet.in(colBr[j])) {
                         score += log(
-                            ribosum->arcmatch_prob(seqA[arcA.left()][i],
-                                                   seqA[arcA.right()][i],
-                                                   seqB[arcB.left()][j],
-                                                   seqB[arcB.right()][j]) /
-                            (ribosum->basematch_prob(seqA[arcA.left()][i],
-                                                     seqB[arcB.left()][j]) *
-                             ribosum->basematch_prob(seqA[arcA.right()][i],
-                                                     seqB[arcB.right()][j])));
+                            ribosum->arcmatch_prob(colAl[i], colAr[i],
+                                                   colBl[j], colBr[j]) /
+                            (ribosum->basematch_prob(colAl[i], colBl[j]) *
+                             ribosum->basematch_prob(colAr[i], colBr[j])));
                     } else {
                         // score += 0.0; // undetermined nucleotides
                     }
@@ -389,6 +464,11 @@ namespace LocARNA {
         const size_type rowsA = seqA.num_of_rows();
         const size_type rowsB = seqB.num_of_rows();
 
+        const auto colAl = packedA_.column(arcA.left());
+        const auto colAr = packedA_.column(arcA.right());
+        const auto colBl = packedB_.column(arcB.left());
+        const auto colBr = packedB_.column(arcB.right());
+
         double score = 0;
         int considered_combinations = 0;
 
@@ -400,39 +480,33 @@ namespace LocARNA {
                 // how to handle gaps?
                 // current solution: ignore gap entries
 
-                if (seqA[arcA.left()][i] != '-' &&
-                    seqA[arcA.right()][i] != '-' &&
-                    seqB[arcB.left()][j] != '-' &&
-                    seqB[arcB.right()][j] != '-') {
-                    if (alphabet.in(seqA[arcA.left()][i]) &&
-                        alphabet.in(seqA[arcA.right()][i]) &&
-                        alphabet.in(seqB[arcB.left()][j]) &&
-                        alphabet.in(seqB[arcB.right()][j])) {
+                if (colAl[i] != '-' &&
+                    colAr[i] != '-' &&
+                    colBl[j] != '-' &&
+                    colBr[j] != '-') {
+                    if (alphabet.in(colAl[i]) &&
+                        alphabet.in(colAr[i]) &&
+                        alphabet.in(colBl[j]) &&
+                        alphabet.in(colBr[j])) {
                         considered_combinations++;
 
                         if (ribofit) {
                             score +=
-                                ribofit->arcmatch_score(seqA[arcA.left()][i],
-                                                        seqA[arcA.right()][i],
-                                                        seqB[arcB.left()][j],
-                                                        seqB[arcB.right()][j],
+                                ribofit->arcmatch_score(colAl[i],
+                                                        colAr[i],
+                                                        colBl[j],
+                                                        colBr[j],
                                                         identity(i, j));
                         } else {
                             score +=
-                                log(ribosum->arcmatch_prob(seqA[arcA.left()][i],
-                                                           seqA[arcA.right()]
-                                                               [i],
-                                                           seqB[arcB.left()][j],
-                                                           seqB[arcB.right()]
-                                                               [j]) /
-                                    (ribosum->basepair_prob(seqA[arcA.left()]
-                                                                [i],
-                                                            seqA[arcA.right()]
-                                                                [i]) *
-                                     ribosum->basepair_prob(seqB[arcB.left()]
-                                                                [j],
-                                                            seqB[arcB.right()]
-                                                                [j]))) /
+                                log(ribosum->arcmatch_prob(colAl[i],
+                                                           colAr[i],
+                                                           colBl[j],
+                                                           colBr[j]) /
+                                    (ribosum->basepair_prob(colAl[i],
+                                                            colAr[i]) *
+                                     ribosum->basepair_prob(colBl[j],
+                                                            colBr[j]))) /
                                 log(2);
                         }
                     } else {
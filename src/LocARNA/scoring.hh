@@ -13,6 +13,7 @@
 #include "scoring_fwd.hh"
 #include "matrix.hh"
 #include "sequence.hh"
+#include "packed_alignment.hh"
 #include "arc_matches.hh"
 #include "named_arguments.hh"
 
@@ -284,6 +285,11 @@ namespace LocARNA {
         const Sequence &seqA;     //!< sequence A
         const Sequence &seqB;     //!< sequence B
 
+        //! sequence A in column-major form for column scores
+        PackedAlignment packedA_;
+        //! sequence B in column-major form for column scores
+        PackedAlignment packedB_;
+
         /**
          * parameter for modified scoring in normalized local
          * alignment
@@ -370,6 +376,20 @@ namespace LocARNA {
 
         Matrix<size_t> identity; //!< sequence identities in percent
 
+        /**
+         * profile index of each column of A (1-based); columns with
+         * the same profile (symbol counts) have the same base match
+         * similarities. Empty if the similarities do not only depend
+         * on the profiles (MEA or ribofit scoring).
+         */
+        std::vector<size_t> profile_idxA_;
+        //! profile index of each column of B, see profile_idxA_
+        std::vector<size_t> profile_idxB_;
+        //! first column of each profile of A
+        std::vector<size_type> profile_colA_;
+        //! first column of each profile of B
+        std::vector<size_type> profile_colB_;
+
         void
         precompute_sequence_identities();
 
@@ -398,6 +418,39 @@ namespace LocARNA {
         score_t
         sigma_(int i, int j) const;
 
+        /**
+         * \brief Similarity of two symbols
+         *
+         * @param a symbol in A
+         * @param b symbol in B
+         *
+         * @return ribosum similarity, if ribosum is used and a and b
+         * are in its alphabet; otherwise match/mismatch score, where
+         * N matches nothing
+         *
+         * @note ribofit similarities depend on the sequence identity
+         * and are not covered.
+         */
+        score_t
+        symbol_similarity(char a, char b) const;
+
+        //! profile of a column: counts of its symbols (sorted by symbol)
+        using profile_t = std::vector<std::pair<char, size_t>>;
+
+        /**
+         * \brief Compute the distinct column profiles
+         *
+         * @param packed alignment in column-major form
+         * @param[out] profile_idx profile index of each column (1-based)
+         * @param[out] profile_col first column of each profile
+         *
+         * @return distinct profiles
+         */
+        static std::vector<profile_t>
+        column_profiles(const PackedAlignment &packed,
+                        std::vector<size_t> &profile_idx,
+                        std::vector<size_type> &profile_col);
+
         /**
          * \brief Precompute all base similarities
          *
@@ -904,6 +957,26 @@ namespace LocARNA {
 
         exp_sigma_tab.resize(lenA + 1, lenB + 1);
 
+        if (!profile_idxA_.empty()) {
+            // columns with equal profiles have equal similarities;
+            // exponentiate once per pair of profiles
+            Matrix<pf_score_t> exp_profile_sigma(profile_colA_.size(),
+                                                 profile_colB_.size());
+            for (size_type p = 0; p < profile_colA_.size(); ++p) {
+                for (size_type q = 0; q < profile_colB_.size(); ++q) {
+                    exp_profile_sigma(p, q) = boltzmann_weight(
+                        sigma_tab(profile_colA_[p], profile_colB_[q]));
+                }
+            }
+            for (size_type i = 1; i <= lenA; ++i) {
+                for (size_type j = 1; j <= lenB; ++j) {
+                    exp_sigma_tab(i, j) = exp_profile_sigma(profile_idxA_[i],
+                                                            profile_idxB_[j]);
+                }
+            }
+            return;
+        }
+
         for (size_type i = 1; i <= lenA; ++i) {
             for (size_type j = 1; j <= lenB; ++j) {
                 exp_sigma_tab(i, j) = boltzmann_weight(sigma_tab(i, j));
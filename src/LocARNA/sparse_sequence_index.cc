@@ -0,0 +1,22 @@
+#include "sparse_sequence_index.hh"
+
+#include "ext_rna_data.hh"
+
+namespace LocARNA {
+
+    SparseSequenceIndex::SparseSequenceIndex(
+        const ExtRnaData &rna_data,
+        double min_prob,
+        double prob_unpaired_in_loop_threshold,
+        double prob_basepair_in_loop_threshold,
+        bool index_left_ends)
+        : rna_data_(rna_data),
+          index_left_ends_(index_left_ends),
+          bps_(std::make_shared<const BasePairs>(&rna_data, min_prob)),
+          mapper_(*bps_,
+                  rna_data,
+                  prob_unpaired_in_loop_threshold,
+                  prob_basepair_in_loop_threshold,
+                  index_left_ends) {}
+
+} // end namespace LocARNA
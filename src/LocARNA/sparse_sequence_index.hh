@@ -0,0 +1,86 @@
+#ifndef LOCARNA_SPARSE_SEQUENCE_INDEX_HH
+#define LOCARNA_SPARSE_SEQUENCE_INDEX_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <memory>
+
+#include "aux.hh"
+#include "basepairs.hh"
+#include "sparsification_mapper.hh"
+
+namespace LocARNA {
+
+    class ExtRnaData;
+
+    /**
+     * @brief Sparsification data of a single RNA
+     *
+     * Bundles the base pairs of an RNA and the sparsification mapper
+     * that filters them by the in-loop probabilities, as constructed
+     * by sparse, exparna_p and epm_anchor_annotation(). Both depend
+     * only on the RNA and the thresholds, such that an index could be
+     * reused for several pairs of RNAs: the base pairs are shared with
+     * the ArcMatches of a pair (see
+     * ArcMatches::ArcMatches(std::shared_ptr<const BasePairs>,
+     * std::shared_ptr<const BasePairs>, ...)), while the mapper is
+     * used directly by AlignerN or ExactMatcher.
+     *
+     * @note the RNA data must live as long as the index
+     */
+    class SparseSequenceIndex {
+    public:
+        /**
+         * @brief Construct from RNA data
+         *
+         * @param rna_data RNA data with in-loop probabilities
+         * @param min_prob minimal probability of the base pairs
+         * @param prob_unpaired_in_loop_threshold threshold for the
+         * probabilities of unpaired bases in loops
+         * @param prob_basepair_in_loop_threshold threshold for the
+         * probabilities of base pairs in loops
+         * @param index_left_ends whether the mapper is indexed by
+         * common left ends (true, SPARSE) or by arcs (false, ExpaRNA-P)
+         */
+        SparseSequenceIndex(const ExtRnaData &rna_data,
+                            double min_prob,
+                            double prob_unpaired_in_loop_threshold,
+                            double prob_basepair_in_loop_threshold,
+                            bool index_left_ends);
+
+        //! @return RNA data
+        const ExtRnaData &
+        rna_data() const {
+            return rna_data_;
+        }
+
+        //! @return base pairs
+        const std::shared_ptr<const BasePairs> &
+        base_pairs() const {
+            return bps_;
+        }
+
+        //! @return sparsification mapper
+        const SparsificationMapper &
+        mapper() const {
+            return mapper_;
+        }
+
+        //! @return whether the mapper is indexed by common left ends
+        bool
+        index_left_ends() const {
+            return index_left_ends_;
+        }
+
+    private:
+        const ExtRnaData &rna_data_;
+        bool index_left_ends_;
+        std::shared_ptr<const BasePairs> bps_;
+        SparsificationMapper mapper_;
+    };
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_SPARSE_SEQUENCE_INDEX_HH
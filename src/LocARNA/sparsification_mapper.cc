@@ -6,22 +6,37 @@ namespace LocARNA {
     void
     SparsificationMapper::compute_mapping_idx_arcs() {
         info_for_pos struct_pos;
-        left_adj_vec.resize(bps.num_bps());
-        info_valid_seq_pos_vecs.resize(bps.num_bps());
-        valid_mat_pos_vecs_before_eq.resize(bps.num_bps());
-        for (size_type k = 0; k < bps.num_bps(); k++) {
-            // pos_type max_size = 0;
-            struct_pos.reset();
+        size_type num_bps = bps.num_bps();
+
+        pos_starts.reserve(num_bps + 1);
+        before_eq_starts.reserve(num_bps + 1);
+        left_adj_starts.reserve(num_bps + 1);
+
+        // valid arcs with common left end of one arc, as pairs of
+        // offset of the left end and arc index; sorted stably into
+        // left_adj_pool by offset
+        std::vector<std::pair<size_type, ArcIdx> > left_adj;
+        std::vector<size_t> counts;
+
+        for (size_type k = 0; k < num_bps; k++) {
             const Arc &arc = bps.arc(k);
+            assert(arc.idx() == k);
+            pos_starts.push_back(pos_table.size());
+            before_eq_starts.push_back(valid_mat_pos_before_eq.size());
+            left_adj_starts.push_back(left_adj_offsets.size());
+            left_adj.clear();
+
             // add initialization
             struct_pos.unpaired = true;
             struct_pos.seq_pos = arc.left();
-            info_valid_seq_pos_vecs.at(k).push_back(struct_pos);
-            valid_mat_pos_vecs_before_eq.at(k).push_back(0);
-            left_adj_vec.at(k).resize(arc.right() - arc.left());
+            struct_pos.arcs_begin = arc_pool.size();
+            pos_table.push_back(struct_pos);
+            valid_mat_pos_before_eq.push_back(0);
             // compute mapping
             for (size_type j = arc.left() + 1; j < arc.right(); j++) {
-                struct_pos.reset();
+                struct_pos.seq_pos = 0;
+                struct_pos.unpaired = false;
+                struct_pos.arcs_begin = arc_pool.size();
                 if (is_valid_pos(arc, j)) {
                     struct_pos.seq_pos = j;
                     struct_pos.unpaired = true;
@@ -30,29 +45,52 @@ namespace LocARNA {
                      inner_arc->left() > arc.left(); ++inner_arc) {
                     if (!is_valid_arc(*inner_arc, arc))
                         continue;
-                    left_adj_vec.at(arc.idx())
-                        .at(inner_arc->left() - arc.left())
-                        .push_back(inner_arc->idx());
+                    left_adj.push_back(std::make_pair(
+                        inner_arc->left() - arc.left(), inner_arc->idx()));
                     struct_pos.seq_pos = j; //-arc.left();
-                    struct_pos.valid_arcs.push_back(inner_arc->idx());
+                    arc_pool.push_back(inner_arc->idx());
                 }
                 if (struct_pos.seq_pos == j) {
-                    info_valid_seq_pos_vecs.at(k).push_back(struct_pos);
-                    // max_size++;
+                    pos_table.push_back(struct_pos);
                 }
-                valid_mat_pos_vecs_before_eq.at(k).push_back(
-                    info_valid_seq_pos_vecs.at(k).size() - 1);
+                valid_mat_pos_before_eq.push_back(pos_table.size() -
+                                                  pos_starts.back() - 1);
+            }
+
+            // counting sort of the arcs with common left end by offset
+            size_type width = arc.right() - arc.left();
+            counts.assign(width + 1, 0);
+            for (const auto &x : left_adj) {
+                counts[x.first + 1]++;
             }
-            size_type max_size = info_valid_seq_pos_vecs.at(k).size();
+            size_t offset = left_adj_pool.size();
+            for (size_type i = 0; i <= width; i++) {
+                offset += counts[i];
+                left_adj_offsets.push_back(offset);
+                counts[i] = offset;
+            }
+            left_adj_pool.resize(offset);
+            for (const auto &x : left_adj) {
+                left_adj_pool[counts[x.first]++] = x.second;
+            }
+
+            size_type max_size = pos_table.size() - pos_starts.back();
             if (max_info_vec_size < max_size)
                 max_info_vec_size = max_size;
-            // if (max_info_vec_size > max_size )
-            //    max_info_vec_size = max_size;
         }
+        pos_starts.push_back(pos_table.size());
+        before_eq_starts.push_back(valid_mat_pos_before_eq.size());
+        left_adj_starts.push_back(left_adj_offsets.size());
+
+        // sentinel, delimits the arcs of the last entry
+        struct_pos.seq_pos = 0;
+        struct_pos.unpaired = false;
+        struct_pos.arcs_begin = arc_pool.size();
+        pos_table.push_back(struct_pos);
+
         if (max_info_vec_size == 0)
             max_info_vec_size++;
-        // cout << "valid positions for indices " << info_valid_seq_pos_vecs <<
-        // endl;
+        // cout << "valid positions for indices " << *this << endl;
     }
 
     void
@@ -61,19 +99,22 @@ namespace LocARNA {
         size_type seq_length = rnadata.length();
         //      std::cout << "compute_mapping_idx_left_ends: seq_length=" <<
         //      seq_length << std::endl;
-        info_valid_seq_pos_vecs.resize(seq_length + 1);
-        valid_mat_pos_vecs_before_eq.resize(seq_length + 1);
+        pos_starts.reserve(seq_length + 2);
+        before_eq_starts.reserve(seq_length + 2);
 
         // go over all left ends
         for (pos_type cur_left_end = 0; cur_left_end <= seq_length;
              cur_left_end++) {
             size_type max_size = 0;
-            struct_pos.reset();
+            pos_starts.push_back(pos_table.size());
+            before_eq_starts.push_back(valid_mat_pos_before_eq.size());
+
             // add initialization
             struct_pos.unpaired = true;
             struct_pos.seq_pos = cur_left_end;
-            info_valid_seq_pos_vecs.at(cur_left_end).push_back(struct_pos);
-            valid_mat_pos_vecs_before_eq.at(cur_left_end).push_back(0);
+            struct_pos.arcs_begin = arc_pool.size();
+            pos_table.push_back(struct_pos);
+            valid_mat_pos_before_eq.push_back(0);
 
             auto cur_ladjl = bps.left_adjlist_s(cur_left_end);
             pos_type max_right_end = cur_ladjl.size() >= 2 /*sentinel!*/
@@ -85,7 +126,9 @@ namespace LocARNA {
 
             for (pos_type cur_pos = cur_left_end + 1; cur_pos < max_right_end;
                  cur_pos++) {
-                struct_pos.reset();
+                struct_pos.seq_pos = 0;
+                struct_pos.unpaired = false;
+                struct_pos.arcs_begin = arc_pool.size();
                 if (cur_left_end == 0)
                     valid_pos_external(cur_pos, 0, struct_pos);
                 else
@@ -100,13 +143,11 @@ namespace LocARNA {
                                               &(*inner_arc), struct_pos);
                 }
                 if (struct_pos.seq_pos == cur_pos) {
-                    info_valid_seq_pos_vecs.at(cur_left_end)
-                        .push_back(struct_pos);
+                    pos_table.push_back(struct_pos);
                     max_size++;
                 }
-                valid_mat_pos_vecs_before_eq.at(cur_left_end)
-                    .push_back(info_valid_seq_pos_vecs.at(cur_left_end).size() -
-                               1);
+                valid_mat_pos_before_eq.push_back(pos_table.size() -
+                                                  pos_starts.back() - 1);
             }
             //              if (max_right_end != 0)
             //              valid_mat_pos_vecs_before_eq.at(cur_left_end).push_back(info_valid_seq_pos_vecs.at(cur_left_end).size()-1);
@@ -115,9 +156,17 @@ namespace LocARNA {
             if (max_info_vec_size < max_size)
                 max_info_vec_size = max_size;
         }
+        pos_starts.push_back(pos_table.size());
+        before_eq_starts.push_back(valid_mat_pos_before_eq.size());
+
+        // sentinel, delimits the arcs of the last entry
+        struct_pos.seq_pos = 0;
+        struct_pos.unpaired = false;
+        struct_pos.arcs_begin = arc_pool.size();
+        pos_table.push_back(struct_pos);
+
         //      cout << "max_info_vec_size " << max_info_vec_size << endl;
-        //      cout << "valid positions for indices " <<
-        //      info_valid_seq_pos_vecs << endl;
+        //      cout << "valid positions for indices " << *this << endl;
     }
 
     void
@@ -130,7 +179,7 @@ namespace LocARNA {
                 struct_pos.seq_pos = cur_pos;
             }
         } else if (is_valid_arc_external(*inner_arc)) {
-            struct_pos.valid_arcs.push_back(inner_arc->idx());
+            arc_pool.push_back(inner_arc->idx());
             struct_pos.seq_pos = cur_pos;
         }
     }
@@ -153,41 +202,30 @@ namespace LocARNA {
                 break;
             } else if (!is_valid_arc(*inner_arc, *arc))
                 continue;
-            struct_pos.valid_arcs.push_back(inner_arc->idx());
+            arc_pool.push_back(inner_arc->idx());
             struct_pos.seq_pos = cur_pos;
             break;
         }
     }
 
     std::ostream &
-    operator<<(
-        std::ostream &out,
-        const std::vector<SparsificationMapper::InfoForPosVec> &pos_vecs_) {
-        size_type idx = 0;
-        for (std::vector<SparsificationMapper::InfoForPosVec>::const_iterator
-                 it = pos_vecs_.begin();
-             it != pos_vecs_.end(); ++it) {
+    operator<<(std::ostream &out, const SparsificationMapper &mapper) {
+        for (size_type idx = 0; idx < mapper.number_of_indices(); idx++) {
             out << "Idx " << idx << std::endl;
-            out << (*it) << std::endl;
-            idx++;
-        }
-        return out;
-    }
-
-    std::ostream &
-    operator<<(std::ostream &out,
-               const SparsificationMapper::InfoForPosVec &pos_vec_) {
-        for (SparsificationMapper::InfoForPosVec::const_iterator it_bp =
-                 pos_vec_.begin();
-             it_bp != pos_vec_.end(); ++it_bp) {
-            out << "pos " << it_bp->seq_pos;
-            // int type = it_bp->type_of_pos;
-            bool unpaired = it_bp->unpaired;
-            if (unpaired)
-                out << " unpaired";
-            if (!it_bp->valid_arcs.empty())
-                out << " ArcIdxVec ";
-            out << it_bp->valid_arcs << std::endl;
+            for (size_type pos = 0; pos < mapper.number_of_valid_mat_pos(idx);
+                 pos++) {
+                out << "pos " << mapper.get_pos_in_seq_new(idx, pos);
+                if (mapper.pos_unpaired(idx, pos))
+                    out << " unpaired";
+                const auto arcs = mapper.valid_arcs_right_adj(idx, pos);
+                if (!arcs.empty())
+                    out << " ArcIdxVec ";
+                for (auto arc_idx : arcs) {
+                    out << arc_idx << " ";
+                }
+                out << std::endl;
+            }
+            out << std::endl;
         }
         return out;
     }
@@ -31,38 +31,80 @@ namespace LocARNA {
     public:
         typedef BasePairs__Arc Arc;            //!< type of arc
         typedef size_t ArcIdx;                 //!< type of arc index
-        typedef std::vector<ArcIdx> ArcIdxVec; //!< vector of arc indices
         typedef pos_type matidx_t;             //!< type for a matrix position
         typedef pos_type seq_pos_t;            //!< type for a sequence position
 
         typedef size_t index_t; //!< type for an index
 
-        //! a struct to represent all necessary information for all valid
-        //! sequence positions
+        /**
+         * @brief Read-only range of arc indices
+         *
+         * Refers to a slice of the arc index pool of the mapper;
+         * supports iteration like a const std::vector<ArcIdx>.
+         */
+        class ArcIdxVec {
+        public:
+            typedef const ArcIdx *const_iterator; //!< iterator type
+            typedef size_t size_type;             //!< size type
+
+            /**
+             * @brief Construct from pointer range
+             * @param begin begin of the range
+             * @param end end of the range
+             */
+            ArcIdxVec(const ArcIdx *begin, const ArcIdx *end)
+                : begin_(begin), end_(end) {}
+
+            //! @return begin of the range
+            const_iterator
+            begin() const {
+                return begin_;
+            }
+
+            //! @return end of the range
+            const_iterator
+            end() const {
+                return end_;
+            }
+
+            //! @return number of arc indices
+            size_type
+            size() const {
+                return end_ - begin_;
+            }
+
+            //! @return whether the range is empty
+            bool
+            empty() const {
+                return begin_ == end_;
+            }
+
+            /**
+             * @param i position in the range
+             * @return i-th arc index
+             */
+            ArcIdx
+            operator[](size_type i) const {
+                return begin_[i];
+            }
+
+        private:
+            const ArcIdx *begin_;
+            const ArcIdx *end_;
+        };
+
+    private:
+        //! entry of the position table: a valid sequence position with
+        //! additional information
         struct info_for_pos {
             seq_pos_t seq_pos; //!< the sequence position
             bool
                 unpaired; //!< if true, the sequence position can occur unpaired
-            ArcIdxVec valid_arcs; //!< a vector of arcs with common right end
-                                  //!from the sequence position
-
-            //! resets the content of the struct
-            void
-            reset() {
-                this->seq_pos = 0;
-                this->valid_arcs.clear();
-                this->unpaired = false;
-            }
+            size_t arcs_begin; //!< start of the arcs with common right end
+                               //! seq_pos in the arc pool; they end at the
+                               //! start of the next entry
         };
 
-        typedef std::vector<info_for_pos> InfoForPosVec; //!< vector of struct
-                                                         //!info_for_pos that is
-                                                         //!assigned to the
-                                                         //!index (either common
-                                                         //!left end or arc
-                                                         //!index)
-
-    private:
         const BasePairs &bps;                         //! BasePairs
         const ExtRnaData &rnadata;                    //! RnaData
         const double prob_unpaired_in_loop_threshold; //! threshold for a
@@ -71,20 +113,43 @@ namespace LocARNA {
         const double prob_basepair_in_loop_threshold; //! threshold for a
                                                       //! basepair under a loop
         size_type max_info_vec_size; //! the maximal size of the info vectors
-        //! for each index all valid sequence positions with additional
-        //! information is stored \n
-        //! index_t->matidx_t->info_for_pos
-        std::vector<InfoForPosVec> info_valid_seq_pos_vecs;
+
+        //! for all indices, all valid sequence positions with additional
+        //! information; the entries of index idx start at pos_starts[idx].
+        //! A sentinel entry at the end delimits the arcs of the last entry.
+        std::vector<info_for_pos> pos_table;
+
+        //! start of the entries of each index in pos_table (size: number
+        //! of indices + 1) \n
+        //! index_t->offset
+        std::vector<size_t> pos_starts;
+
+        //! pool of the arcs with common right end of all entries of
+        //! pos_table
+        std::vector<ArcIdx> arc_pool;
 
         //! for each index and each sequence position the first valid position
-        //! in the matrix before the sequence position is stored \n
-        //! index_t->seq_pos_t->matidx_t
-        std::vector<std::vector<matidx_t> > valid_mat_pos_vecs_before_eq;
+        //! in the matrix before the sequence position; the entries of index
+        //! idx start at before_eq_starts[idx] \n
+        //! (index_t,seq_pos_t)->matidx_t
+        std::vector<matidx_t> valid_mat_pos_before_eq;
+
+        //! start of the entries of each index in valid_mat_pos_before_eq
+        //! (size: number of indices + 1)
+        std::vector<size_t> before_eq_starts;
 
-        //! for each index and each sequence position all valid arcs that have
-        //! the sequence position as common left end are stored \n
-        //! index_t->seq_pos_t->ArcIdxVec
-        std::vector<std::vector<ArcIdxVec> > left_adj_vec;
+        //! for each arc index and each sequence position, the start of the
+        //! valid arcs with this position as common left end in
+        //! left_adj_pool; the entries of arc idx start at
+        //! left_adj_starts[idx] (only when indexing by arcs) \n
+        //! (index_t,seq_pos_t)->offset
+        std::vector<size_t> left_adj_offsets;
+
+        //! start of the entries of each arc index in left_adj_offsets
+        std::vector<size_t> left_adj_starts;
+
+        //! pool of the valid arcs with common left end
+        std::vector<ArcIdx> left_adj_pool;
 
         //! computes the datastructures for sparsification mapping based on
         //! indexing the arcs
@@ -99,7 +164,7 @@ namespace LocARNA {
         //! checks if the cur_pos is valid (inner_arc=0) under any arc with
         //! common left end
         //! checks if inner_arc is valid (inner_arc!=0) under any arc with
-        //! common left end
+        //! common left end; valid arcs are appended to the arc pool
         void
         iterate_left_adj_list(pos_type cur_left_end,
                               pos_type cur_pos,
@@ -111,6 +176,13 @@ namespace LocARNA {
                            const Arc *inner_arc,
                            info_for_pos &struct_pos);
 
+        //! entry of the position table for a matrix position at an index
+        const info_for_pos &
+        pos_info(index_t idx, matidx_t pos) const {
+            assert(pos < number_of_valid_mat_pos(idx));
+            return pos_table[pos_starts[idx] + pos];
+        }
+
     public:
         /**
          * Constructor
@@ -151,26 +223,17 @@ namespace LocARNA {
             return max_info_vec_size;
         }
 
-        /**
-         * gives all valid positions with additional information for an index
-         * @param idx index
-         * @return vector of all valid positions with additional information at
-         * index
-         */
-        const InfoForPosVec &
-        valid_seq_positions(index_t idx) const {
-            return info_valid_seq_pos_vecs.at(idx);
-        }
-
         /**
          * gives all valid arcs that end at a matrix position
          * @param idx index
          * @param pos matrix position
-         * @return vector of all valid arcs with the common right end pos
+         * @return range of all valid arcs with the common right end pos
          */
-        const ArcIdxVec &
+        ArcIdxVec
         valid_arcs_right_adj(index_t idx, matidx_t pos) const {
-            return info_valid_seq_pos_vecs.at(idx).at(pos).valid_arcs;
+            const info_for_pos *info = &pos_info(idx, pos);
+            return ArcIdxVec(arc_pool.data() + info->arcs_begin,
+                             arc_pool.data() + (info + 1)->arcs_begin);
         }
 
         /**
@@ -192,7 +255,10 @@ namespace LocARNA {
             if (left_end == std::numeric_limits<index_t>::max())
                 left_end = index;
             assert(pos >= left_end); // tocheck
-            return valid_mat_pos_vecs_before_eq.at(index).at(pos - left_end);
+            assert(before_eq_starts[index] + pos - left_end <
+                   before_eq_starts[index + 1]);
+            return valid_mat_pos_before_eq[before_eq_starts[index] + pos -
+                                           left_end];
         }
 
         /**
@@ -223,9 +289,7 @@ namespace LocARNA {
          */
         inline seq_pos_t
         get_pos_in_seq_new(index_t idx, matidx_t pos) const {
-            assert(pos < number_of_valid_mat_pos(idx));
-            return (
-                info_valid_seq_pos_vecs.at(idx).at(pos).seq_pos); //+arc.left();
+            return pos_info(idx, pos).seq_pos;
         }
 
         /**
@@ -235,7 +299,18 @@ namespace LocARNA {
          */
         size_type
         number_of_valid_mat_pos(index_t idx) const {
-            return info_valid_seq_pos_vecs.at(idx).size();
+            assert(idx + 1 < pos_starts.size());
+            return pos_starts[idx + 1] - pos_starts[idx];
+        }
+
+        /**
+         * gives the number of indices
+         * @return number of arcs or number of left ends (sequence
+         * length + 1), depending on the indexing
+         */
+        size_type
+        number_of_indices() const {
+            return pos_starts.size() - 1;
         }
 
         /**
@@ -247,7 +322,7 @@ namespace LocARNA {
          */
         bool
         pos_unpaired(index_t idx, matidx_t pos) const {
-            return info_valid_seq_pos_vecs.at(idx).at(pos).unpaired;
+            return pos_info(idx, pos).unpaired;
         }
 
         /**
@@ -273,12 +348,15 @@ namespace LocARNA {
          * gives all valid arcs with common left end from a sequence position
          * @param arc arc that is used as an index
          * @param pos sequence position
-         * @return vector of all valid arcs with common left end pos for the arc
+         * @return range of all valid arcs with common left end pos for the arc
          * index
          */
-        const ArcIdxVec &
+        ArcIdxVec
         valid_arcs_left_adj(const Arc &arc, seq_pos_t pos) const {
-            return left_adj_vec.at(arc.idx()).at(pos - arc.left());
+            assert(arc.left() <= pos && pos < arc.right());
+            size_t k = left_adj_starts[arc.idx()] + pos - arc.left();
+            return ArcIdxVec(left_adj_pool.data() + left_adj_offsets[k],
+                             left_adj_pool.data() + left_adj_offsets[k + 1]);
         }
 
         //! class destructor
@@ -465,24 +543,11 @@ namespace LocARNA {
      * prints all valid sequence positions with additional information for all
      * indices
      * @param out output stream object
-     * @param pos_vecs_ input vector
-     * @return output stream object
-     */
-    std::ostream &
-    operator<<(
-        std::ostream &out,
-        const std::vector<SparsificationMapper::InfoForPosVec> &pos_vecs_);
-
-    /**
-     * prints all valid sequence positions with additional information for one
-     * index
-     * @param out output stream object
-     * @param pos_vec_ input vector
+     * @param mapper sparsification mapper
      * @return output stream object
      */
     std::ostream &
-    operator<<(std::ostream &out,
-               const SparsificationMapper::InfoForPosVec &pos_vec_);
+    operator<<(std::ostream &out, const SparsificationMapper &mapper);
 
 } // end namespace
 
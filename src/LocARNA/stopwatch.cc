@@ -23,6 +23,7 @@ namespace LocARNA {
 
     bool
     StopWatch::start(const std::string &name) {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         timer_t &t = timers[name];
 
         if (t.running)
@@ -36,6 +37,7 @@ namespace LocARNA {
 
     bool
     StopWatch::stop(const std::string &name) {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         assert(timers.find(name) != timers.end());
 
         timer_t &t = timers[name];
@@ -52,6 +54,7 @@ namespace LocARNA {
 
     bool
     StopWatch::is_running(const std::string &name) const {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         map_t::const_iterator it = timers.find(name);
         assert(it != timers.end());
         const timer_t &t = it->second;
@@ -60,6 +63,7 @@ namespace LocARNA {
 
     double
     StopWatch::current_total(const std::string &name) const {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         map_t::const_iterator it = timers.find(name);
         assert(it != timers.end());
         const timer_t &t = it->second;
@@ -68,6 +72,7 @@ namespace LocARNA {
 
     size_t
     StopWatch::current_cycles(const std::string &name) const {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         map_t::const_iterator it = timers.find(name);
         assert(it != timers.end());
         const timer_t &t = it->second;
@@ -96,6 +101,7 @@ namespace LocARNA {
 
     std::ostream &
     StopWatch::print_info(std::ostream &out) const {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         if (timers.size() == 0)
             return out;
 
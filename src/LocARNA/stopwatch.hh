@@ -9,6 +9,7 @@
 #include <iosfwd>
 #include <unordered_map>
 #include <string>
+#include <mutex>
 
 namespace LocARNA {
     /**
@@ -33,6 +34,9 @@ namespace LocARNA {
 
         bool print_on_exit;
 
+        //! guards timers; the stop watch can be used from several threads
+        mutable std::recursive_mutex mutex_;
+
     public:
         /**
          * @brief Constructor
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+#include "tcoffee_library.hh"
+#include "alignment.hh"
+#include "multiple_alignment.hh"
+#include "parallel.hh"
+
+namespace LocARNA {
+
+    namespace {
+        //! magic string of the binary format
+        const std::string binary_magic = "LOCARNA_TCLIB_1\n";
+
+        //! write unsigned integer in binary format
+        void
+        write_uint(std::ostream &out, uint64_t x) {
+            out.write(reinterpret_cast<const char *>(&x), sizeof(x));
+        }
+
+        //! read unsigned integer in binary format
+        uint64_t
+        read_uint(std::istream &in) {
+            uint64_t x;
+            if (!in.read(reinterpret_cast<char *>(&x), sizeof(x))) {
+                throw failure("Unexpected end of binary library.");
+            }
+            return x;
+        }
+
+        //! write string in binary format
+        void
+        write_string(std::ostream &out, const std::string &s) {
+            write_uint(out, s.length());
+            out.write(s.data(), s.length());
+        }
+
+        //! read string in binary format
+        std::string
+        read_string(std::istream &in) {
+            std::string s(read_uint(in), ' ');
+            if (!in.read(&s[0], s.length())) {
+                throw failure("Unexpected end of binary library.");
+            }
+            return s;
+        }
+    }
+
+    TCoffeeLibrary::TCoffeeLibrary(const std::vector<std::string> &names,
+                                   const std::vector<std::string> &sequences)
+        : names_(names),
+          sequences_(sequences),
+          pairs_(names.size() * names.size()) {
+        assert(names.size() == sequences.size());
+    }
+
+    size_t
+    TCoffeeLibrary::index(const std::string &name) const {
+        auto it = std::find(names_.begin(), names_.end(), name);
+        if (it == names_.end()) {
+            throw failure("Sequence " + name +
+                          " does not occur in the library.");
+        }
+        return it - names_.begin();
+    }
+
+    void
+    TCoffeeLibrary::add_alignment(size_t a,
+                                  size_t b,
+                                  const AlignmentEdges &edges,
+                                  weight_t weight) {
+        std::vector<match_t> matches;
+        for (const auto &edge : edges) {
+            if (edge.first.is_pos() && edge.second.is_pos()) {
+                matches.push_back({edge.first, edge.second, weight});
+            }
+        }
+        add_matches(a, b, std::move(matches));
+    }
+
+    void
+    TCoffeeLibrary::add_alignment(const MultipleAlignment &ma,
+                                  weight_t weight) {
+        std::vector<size_t> idx;
+        for (size_t r = 0; r < ma.num_of_rows(); r++) {
+            const auto &entry = ma.seqentry(r);
+            idx.push_back(index(entry.name()));
+
+            std::string seq = entry.seq().str();
+            seq.erase(std::remove_if(seq.begin(), seq.end(), is_gap_symbol),
+                      seq.end());
+            if (seq != sequences_[idx.back()]) {
+                throw failure("Sequence " + entry.name() +
+                              " differs from the library.");
+            }
+        }
+
+        for (size_t x = 0; x < ma.num_of_rows(); x++) {
+            for (size_t y = x + 1; y < ma.num_of_rows(); y++) {
+                const string1 &seqx = ma.seqentry(x).seq();
+                const string1 &seqy = ma.seqentry(y).seq();
+                std::vector<match_t> matches;
+                pos_type i = 0;
+                pos_type j = 0;
+                for (size_t col = 1; col <= ma.length(); col++) {
+                    bool gapx = is_gap_symbol(seqx[col]);
+                    bool gapy = is_gap_symbol(seqy[col]);
+                    i += !gapx;
+                    j += !gapy;
+                    if (!gapx && !gapy) {
+                        matches.push_back({i, j, weight});
+                    }
+                }
+                add_matches(idx[x], idx[y], std::move(matches));
+            }
+        }
+    }
+
+    std::pair<const TCoffeeLibrary::entry_t *, const TCoffeeLibrary::entry_t *>
+    TCoffeeLibrary::row(size_t a, size_t b, pos_type i) const {
+        const auto &lib = pair_library(a, b);
+        if (lib.starts.empty()) {
+            return {nullptr, nullptr};
+        }
+        assert(1 <= i && i + 1 < lib.starts.size());
+        const entry_t *entries = lib.entries.data();
+        return {entries + lib.starts[i], entries + lib.starts[i + 1]};
+    }
+
+    TCoffeeLibrary::weight_t
+    TCoffeeLibrary::weight(size_t a, size_t b, pos_type i, pos_type j) const {
+        auto r = row(a, b, i);
+        auto it = std::lower_bound(
+            r.first, r.second, j,
+            [](const entry_t &e, pos_type j) { return e.pos < j; });
+        return (it != r.second && it->pos == j) ? it->weight : 0;
+    }
+
+    size_t
+    TCoffeeLibrary::size() const {
+        size_t size = 0;
+        for (size_t a = 0; a < num_seqs(); a++) {
+            for (size_t b = a + 1; b < num_seqs(); b++) {
+                size += pair_library(a, b).entries.size();
+            }
+        }
+        return size;
+    }
+
+    void
+    TCoffeeLibrary::add_matches(size_t a,
+                                size_t b,
+                                std::vector<match_t> matches) {
+        if (a == b || a >= num_seqs() || b >= num_seqs()) {
+            throw failure("Invalid pair of sequences for the library.");
+        }
+        for (const auto &m : matches) {
+            if (m.i < 1 || m.i > sequences_[a].length() || m.j < 1 ||
+                m.j > sequences_[b].length()) {
+                throw failure("Match out of range of the sequences " +
+                              names_[a] + " and " + names_[b] + ".");
+            }
+        }
+
+        auto old_matches = this->matches(a, b);
+        matches.insert(matches.end(), old_matches.begin(), old_matches.end());
+
+        // sort and sum up the weights of equal matches
+        auto by_pos = [](const match_t &x, const match_t &y) {
+            return std::make_pair(x.i, x.j) < std::make_pair(y.i, y.j);
+        };
+        std::stable_sort(matches.begin(), matches.end(), by_pos);
+        std::vector<match_t> merged;
+        for (const auto &m : matches) {
+            if (!merged.empty() && merged.back().i == m.i &&
+                merged.back().j == m.j) {
+                merged.back().weight += m.weight;
+            } else {
+                merged.push_back(m);
+            }
+        }
+        set_matches(a, b, merged);
+
+        for (auto &m : merged) {
+            std::swap(m.i, m.j);
+        }
+        std::sort(merged.begin(), merged.end(), by_pos);
+        set_matches(b, a, merged);
+    }
+
+    void
+    TCoffeeLibrary::set_matches(size_t a,
+                                size_t b,
+                                const std::vector<match_t> &matches) {
+        auto &lib = pair_library(a, b);
+        lib.starts.clear();
+        lib.entries.clear();
+        if (matches.empty()) {
+            return;
+        }
+
+        const size_t len = sequences_[a].length();
+        lib.starts.assign(len + 2, 0);
+        lib.entries.reserve(matches.size());
+        for (const auto &m : matches) {
+            lib.starts[m.i + 1]++;
+            lib.entries.push_back({m.j, m.weight});
+        }
+        for (size_t i = 1; i <= len; i++) {
+            lib.starts[i + 1] += lib.starts[i];
+        }
+    }
+
+    std::vector<TCoffeeLibrary::match_t>
+    TCoffeeLibrary::matches(size_t a, size_t b) const {
+        std::vector<match_t> matches;
+        const auto &lib = pair_library(a, b);
+        for (size_t i = 1; i + 1 < lib.starts.size(); i++) {
+            for (size_t k = lib.starts[i]; k < lib.starts[i + 1]; k++) {
+                matches.push_back({i, lib.entries[k].pos,
+                                   lib.entries[k].weight});
+            }
+        }
+        return matches;
+    }
+
+    std::vector<TCoffeeLibrary::match_t>
+    TCoffeeLibrary::extended_matches(size_t a, size_t b) const {
+        const size_t lenA = sequences_[a].length();
+        const size_t lenB = sequences_[b].length();
+
+        // dense accumulator for one row, with list of touched entries
+        std::vector<weight_t> acc(lenB + 1, 0);
+        std::vector<bool> touched(lenB + 1, false);
+        std::vector<pos_type> positions;
+
+        auto add = [&](pos_type j, weight_t w) {
+            if (!touched[j]) {
+                touched[j] = true;
+                positions.push_back(j);
+            }
+            acc[j] += w;
+        };
+
+        std::vector<match_t> matches;
+        for (pos_type i = 1; i <= lenA; i++) {
+            auto direct = row(a, b, i);
+            for (auto e = direct.first; e != direct.second; ++e) {
+                add(e->pos, e->weight);
+            }
+
+            // join the rows of (a,c) and (c,b)
+            for (size_t c = 0; c < num_seqs(); c++) {
+                if (c == a || c == b || pair_library(c, b).starts.empty()) {
+                    continue;
+                }
+                auto row_ac = row(a, c, i);
+                for (auto e1 = row_ac.first; e1 != row_ac.second; ++e1) {
+                    auto row_cb = row(c, b, e1->pos);
+                    for (auto e2 = row_cb.first; e2 != row_cb.second; ++e2) {
+                        add(e2->pos, std::min(e1->weight, e2->weight));
+                    }
+                }
+            }
+
+            std::sort(positions.begin(), positions.end());
+            for (pos_type j : positions) {
+                matches.push_back({i, j, acc[j]});
+                acc[j] = 0;
+                touched[j] = false;
+            }
+            positions.clear();
+        }
+        return matches;
+    }
+
+    TCoffeeLibrary
+    TCoffeeLibrary::extend(size_t threads) const {
+        TCoffeeLibrary ext(names_, sequences_);
+
+        std::vector<std::pair<size_t, size_t>> tasks;
+        for (size_t a = 0; a < num_seqs(); a++) {
+            for (size_t b = a + 1; b < num_seqs(); b++) {
+                tasks.emplace_back(a, b);
+            }
+        }
+        std::vector<std::vector<match_t>> results(tasks.size());
+
+        parallel_for(tasks.size(), std::max<size_t>(1, threads),
+                     [&](size_t k, size_t) {
+                         results[k] = extended_matches(tasks[k].first,
+                                                       tasks[k].second);
+                     });
+
+        for (size_t k = 0; k < tasks.size(); k++) {
+            ext.add_matches(tasks[k].first, tasks[k].second,
+                            std::move(results[k]));
+        }
+        return ext;
+    }
+
+    std::ostream &
+    TCoffeeLibrary::write(std::ostream &out) const {
+        out << "! TC_LIB_FORMAT_01\n" << num_seqs() << "\n";
+        for (size_t a = 0; a < num_seqs(); a++) {
+            out << names_[a] << " " << sequences_[a].length() << " "
+                << sequences_[a] << "\n";
+        }
+        for (size_t a = 0; a < num_seqs(); a++) {
+            for (size_t b = a + 1; b < num_seqs(); b++) {
+                const auto &lib = pair_library(a, b);
+                if (lib.entries.empty()) {
+                    continue;
+                }
+                out << "#" << (a + 1) << " " << (b + 1) << "\n";
+                for (const auto &m : matches(a, b)) {
+                    out << m.i << " " << m.j << " "
+                        << std::lround(m.weight) << "\n";
+                }
+            }
+        }
+        out << "! SEQ_1_TO_N\n";
+        return out;
+    }
+
+    std::ostream &
+    TCoffeeLibrary::write_binary(std::ostream &out) const {
+        out.write(binary_magic.data(), binary_magic.length());
+        write_uint(out, num_seqs());
+        for (size_t a = 0; a < num_seqs(); a++) {
+            write_string(out, names_[a]);
+            write_string(out, sequences_[a]);
+        }
+        for (size_t a = 0; a < num_seqs(); a++) {
+            for (size_t b = a + 1; b < num_seqs(); b++) {
+                auto ms = matches(a, b);
+                write_uint(out, ms.size());
+                for (const auto &m : ms) {
+                    write_uint(out, m.i);
+                    write_uint(out, m.j);
+                    out.write(reinterpret_cast<const char *>(&m.weight),
+                              sizeof(m.weight));
+                }
+            }
+        }
+        return out;
+    }
+
+    TCoffeeLibrary
+    TCoffeeLibrary::read_binary(std::istream &in) {
+        std::string magic(binary_magic.length(), ' ');
+        if (!in.read(&magic[0], magic.length()) || magic != binary_magic) {
+            throw failure("Input is not a binary T-Coffee library.");
+        }
+
+        size_t n = read_uint(in);
+        std::vector<std::string> names;
+        std::vector<std::string> sequences;
+        for (size_t a = 0; a < n; a++) {
+            names.push_back(read_string(in));
+            sequences.push_back(read_string(in));
+        }
+
+        TCoffeeLibrary lib(names, sequences);
+        for (size_t a = 0; a < n; a++) {
+            for (size_t b = a + 1; b < n; b++) {
+                std::vector<match_t> ms(read_uint(in));
+                for (auto &m : ms) {
+                    m.i = read_uint(in);
+                    m.j = read_uint(in);
+                    if (!in.read(reinterpret_cast<char *>(&m.weight),
+                                 sizeof(m.weight))) {
+                        throw failure("Unexpected end of binary library.");
+                    }
+                }
+                if (!ms.empty()) {
+                    lib.add_matches(a, b, std::move(ms));
+                }
+            }
+        }
+        return lib;
+    }
+
+} // end namespace LocARNA
@@ -0,0 +1,277 @@
+#ifndef LOCARNA_TCOFFEE_LIBRARY_HH
+#define LOCARNA_TCOFFEE_LIBRARY_HH
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aux.hh"
+
+namespace LocARNA {
+
+    class AlignmentEdges;
+    class MultipleAlignment;
+
+    /**
+     * @brief T-Coffee library of weighted position matches
+     *
+     * Holds weights of matches (i,j) between positions of pairs of
+     * sequences, like the primary library of T-Coffee, which is
+     * built from pairwise alignments. Each pair of sequences keeps
+     * its matches sparsely, as rows of (position, weight) entries
+     * sorted by position, for both orders of the pair.
+     *
+     * extend() computes the extended library (Notredame et al.,
+     * 2000): the weight of (i,j) between a and b is increased by
+     * min(w(i,k),w(k,j)) for all positions k of all other sequences
+     * c. The triplets are enumerated by joining the sparse rows of
+     * a-c and c-b, such that the cost is proportional to the
+     * number of consistent triplets instead of the cube of the
+     * sequence length.
+     *
+     * The library can be written in T-Coffee's text format
+     * (TC_LIB_FORMAT_01) and in a binary format, which can be read
+     * back by read_binary().
+     */
+    class TCoffeeLibrary {
+    public:
+        //! weight type
+        using weight_t = double;
+
+        //! entry of a row: matched position and weight
+        struct entry_t {
+            pos_type pos;    //!< position in the second sequence
+            weight_t weight; //!< weight
+        };
+
+        /**
+         * @brief Construct empty library
+         *
+         * @param names names of the sequences
+         * @param sequences sequences (without gaps)
+         */
+        TCoffeeLibrary(const std::vector<std::string> &names,
+                       const std::vector<std::string> &sequences);
+
+        /**
+         * @brief Number of sequences
+         * @return number of sequences
+         */
+        size_t
+        num_seqs() const {
+            return names_.size();
+        }
+
+        /**
+         * @brief Names of the sequences
+         * @return names
+         */
+        const std::vector<std::string> &
+        names() const {
+            return names_;
+        }
+
+        /**
+         * @brief Sequences
+         * @return sequences
+         */
+        const std::vector<std::string> &
+        sequences() const {
+            return sequences_;
+        }
+
+        /**
+         * @brief Index of a sequence
+         * @param name sequence name
+         * @return index of the sequence with this name
+         *
+         * throws failure if the name does not occur
+         */
+        size_t
+        index(const std::string &name) const;
+
+        /**
+         * @brief Add pairwise alignment
+         *
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @param edges alignment edges of a and b
+         * @param weight weight of each match
+         *
+         * Weights of matches that are already in the library are
+         * summed up.
+         */
+        void
+        add_alignment(size_t a,
+                      size_t b,
+                      const AlignmentEdges &edges,
+                      weight_t weight);
+
+        /**
+         * @brief Add the row pairs of an alignment
+         *
+         * @param ma alignment of sequences of the library (by name)
+         * @param weight weight of each match
+         *
+         * throws failure if a row does not occur in the library or
+         * its sequence differs
+         */
+        void
+        add_alignment(const MultipleAlignment &ma, weight_t weight);
+
+        /**
+         * @brief Matches of a position
+         *
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @param i position in a
+         *
+         * @return pair of begin and end of the entries of (i,.),
+         * sorted by position
+         */
+        std::pair<const entry_t *, const entry_t *>
+        row(size_t a, size_t b, pos_type i) const;
+
+        /**
+         * @brief Weight of a match
+         *
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @param i position in a
+         * @param j position in b
+         *
+         * @return weight of (i,j); 0 if not in the library
+         */
+        weight_t
+        weight(size_t a, size_t b, pos_type i, pos_type j) const;
+
+        /**
+         * @brief Number of matches
+         * @return number of matches of all pairs a<b
+         */
+        size_t
+        size() const;
+
+        /**
+         * @brief Extended library
+         *
+         * @param threads number of threads
+         * @return library with extended weights
+         *
+         * The pairs of sequences are extended in parallel; the
+         * weights are summed in fixed order, such that the result
+         * does not depend on the number of threads.
+         *
+         * @note weights should be non-negative
+         */
+        TCoffeeLibrary
+        extend(size_t threads = 1) const;
+
+        /**
+         * @brief Write in T-Coffee library format
+         *
+         * @param out output stream
+         * @return stream
+         *
+         * Weights are rounded to integers, as required by the format.
+         */
+        std::ostream &
+        write(std::ostream &out) const;
+
+        /**
+         * @brief Write in binary format
+         * @param out output stream (opened in binary mode)
+         * @return stream
+         */
+        std::ostream &
+        write_binary(std::ostream &out) const;
+
+        /**
+         * @brief Read from binary format
+         *
+         * @param in input stream (opened in binary mode)
+         * @return library
+         *
+         * throws failure if the input is not a binary library
+         */
+        static TCoffeeLibrary
+        read_binary(std::istream &in);
+
+    private:
+        //! matches of an ordered pair in compressed row format
+        struct pair_library_t {
+            //! start of the entries of each position (1-based; size
+            //! length+2); empty if there are no entries
+            std::vector<size_t> starts;
+            //! entries
+            std::vector<entry_t> entries;
+        };
+
+        //! match (i,j) with weight
+        struct match_t {
+            pos_type i;      //!< position in the first sequence
+            pos_type j;      //!< position in the second sequence
+            weight_t weight; //!< weight
+        };
+
+        std::vector<std::string> names_;      //!< sequence names
+        std::vector<std::string> sequences_;  //!< sequences
+        std::vector<pair_library_t> pairs_;   //!< libraries by pair a*N+b
+
+        //! library of pair (a,b)
+        pair_library_t &
+        pair_library(size_t a, size_t b) {
+            return pairs_[a * num_seqs() + b];
+        }
+
+        //! library of pair (a,b)
+        const pair_library_t &
+        pair_library(size_t a, size_t b) const {
+            return pairs_[a * num_seqs() + b];
+        }
+
+        /**
+         * @brief Add matches to a pair (in both orders)
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @param matches matches of a and b
+         */
+        void
+        add_matches(size_t a, size_t b, std::vector<match_t> matches);
+
+        /**
+         * @brief Set matches of an ordered pair
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @param matches matches, sorted by (i,j) without duplicates
+         */
+        void
+        set_matches(size_t a, size_t b, const std::vector<match_t> &matches);
+
+        /**
+         * @brief Matches of an ordered pair
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @return matches sorted by (i,j)
+         */
+        std::vector<match_t>
+        matches(size_t a, size_t b) const;
+
+        /**
+         * @brief Extended matches of a pair
+         * @param a index of first sequence
+         * @param b index of second sequence
+         * @return extended matches sorted by (i,j)
+         */
+        std::vector<match_t>
+        extended_matches(size_t a, size_t b) const;
+    };
+
+} // end namespace LocARNA
+
+#endif // LOCARNA_TCOFFEE_LIBRARY_HH
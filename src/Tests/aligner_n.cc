@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include "fixed_structure_data.hh"
+
+#include <string>
+#include <utility>
+
+#include <../LocARNA/aligner_n.hh>
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/scoring.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for AlignerN
+*/
+
+namespace {
+    //! score and alignment strings of an AlignerN alignment
+    std::pair<infty_score_t, std::string>
+    align(const SparseTestPair &pair,
+          const Scoring &scoring,
+          bool row_kernel,
+          int threads) {
+        AlignerN aligner{AlignerNParams(
+            AlignerParams::seqA(&pair.seqA), AlignerParams::seqB(&pair.seqB),
+            AlignerParams::scoring(&scoring),
+            AlignerParams::trace_controller(&pair.trace_controller),
+            AlignerParams::constraints(&pair.constraints),
+            AlignerNParams::sparsification_mapperA(&pair.mapperA),
+            AlignerNParams::sparsification_mapperB(&pair.mapperB),
+            AlignerNParams::threads(threads),
+            AlignerNParams::row_kernel(row_kernel))};
+        auto score = aligner.align();
+        aligner.trace();
+        MultipleAlignment ma(aligner.get_alignment());
+        return std::make_pair(score, ma.seqentry(0).seq().str() + "&" +
+                                  ma.seqentry(1).seq().str());
+    }
+}
+
+TEST_CASE("AlignerN computes the same alignment with several threads") {
+    for (const auto &rnas : fixed_structure_pairs()) {
+        SparseTestPair pair(rnas, 0.00005, 0.0001);
+        auto scoring_params = pair.scoring_params(-750);
+        Scoring scoring(pair.seqA, pair.seqB, *pair.rna_dataA,
+                        *pair.rna_dataB, pair.arc_matches, nullptr,
+                        scoring_params);
+
+        auto sequential = align(pair, scoring, false, 1);
+        REQUIRE(sequential.first.is_finite());
+
+        for (int threads : {2, 4}) {
+            auto parallel = align(pair, scoring, false, threads);
+            REQUIRE(parallel.first == sequential.first);
+            REQUIRE(parallel.second == sequential.second);
+        }
+    }
+}
+
+TEST_CASE("AlignerN computes the same alignment with the row kernel") {
+    for (const auto &rnas : fixed_structure_pairs()) {
+        SparseTestPair pair(rnas, 0.00005, 0.0001);
+
+        // with and without costs for opening gaps
+        for (score_t indel_opening : {-750, 0}) {
+            auto scoring_params =
+                pair.scoring_params(indel_opening, 2 * indel_opening);
+            Scoring scoring(pair.seqA, pair.seqB, *pair.rna_dataA,
+                            *pair.rna_dataB, pair.arc_matches, nullptr,
+                            scoring_params);
+
+            auto entries = align(pair, scoring, false, 1);
+            REQUIRE(entries.first.is_finite());
+
+            for (int threads : {1, 2}) {
+                auto rows = align(pair, scoring, true, threads);
+                REQUIRE(rows.first == entries.first);
+                REQUIRE(rows.second == entries.second);
+            }
+        }
+    }
+}
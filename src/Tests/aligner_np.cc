@@ -0,0 +1,155 @@
+#include "catch.hpp"
+#include "fixed_structure_data.hh"
+
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <../LocARNA/aligner_np.hh>
+#include <../LocARNA/aligner_p.hh>
+#include <../LocARNA/scoring.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for AlignerNP
+*/
+
+namespace {
+    //! read the probabilities written by an aligner; keys are the
+    //! positions of the lines
+    std::map<std::string, double>
+    read_probabilities(const std::string &text) {
+        std::map<std::string, double> probs;
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line)) {
+            auto pos = line.find_last_of(' ');
+            probs[line.substr(0, pos)] = std::stod(line.substr(pos + 1));
+        }
+        return probs;
+    }
+}
+
+TEST_CASE("AlignerNP computes the probabilities of AlignerP without "
+          "sparsification") {
+    // all positions and arcs are valid
+    SparseTestPair pair(fixed_structure_pairs()[0], 0, 0);
+    const Sequence &seqA = pair.seqA;
+    const Sequence &seqB = pair.seqB;
+
+    for (score_t indel_opening : {-200, 0}) {
+        auto scoring_params = pair.scoring_params(indel_opening);
+        PFScoring<double> scoring(seqA, seqB, *pair.rna_dataA,
+                                  *pair.rna_dataB, pair.arc_matches, nullptr,
+                                  scoring_params);
+
+        // AlignerP neglects the base matches in arc matches with
+        // probability below sqrt(min_am_prob)
+        using pparams_t = AlignerPParams<double>;
+        AlignerP<double> aligner_p(pparams_t(
+            AlignerParams::seqA(&seqA), AlignerParams::seqB(&seqB),
+            AlignerParams::scoring(&scoring),
+            AlignerParams::trace_controller(&pair.trace_controller),
+            AlignerParams::constraints(&pair.constraints),
+            pparams_t::min_am_prob(0), pparams_t::min_bm_prob(0.001)));
+
+        using npparams_t = AlignerNPParams<double>;
+        AlignerNP<double> aligner_np(npparams_t(
+            AlignerParams::seqA(&seqA), AlignerParams::seqB(&seqB),
+            AlignerParams::scoring(&scoring),
+            AlignerParams::trace_controller(&pair.trace_controller),
+            AlignerParams::constraints(&pair.constraints),
+            npparams_t::min_am_prob(0), npparams_t::min_bm_prob(0.001),
+            npparams_t::sparsification_mapperA(&pair.mapperA),
+            npparams_t::sparsification_mapperB(&pair.mapperB)));
+
+        double pf_p = aligner_p.align_inside();
+        double pf_np = aligner_np.align_inside();
+        REQUIRE(pf_p > 0);
+        REQUIRE(pf_np == Approx(pf_p).epsilon(1e-9));
+
+        std::ostringstream am_p, am_np, bm_p, bm_np;
+        aligner_p.align_outside();
+        aligner_p.compute_arcmatch_probabilities();
+        aligner_p.compute_basematch_probabilities(true);
+        aligner_p.write_arcmatch_probabilities(am_p);
+        aligner_p.write_basematch_probabilities(bm_p);
+
+        aligner_np.align_outside();
+        aligner_np.compute_arcmatch_probabilities();
+        aligner_np.compute_basematch_probabilities(true);
+        aligner_np.write_arcmatch_probabilities(am_np);
+        aligner_np.write_basematch_probabilities(bm_np);
+
+        for (const auto &written :
+             {std::make_pair(am_p.str(), am_np.str()),
+              std::make_pair(bm_p.str(), bm_np.str())}) {
+            auto probs_p = read_probabilities(written.first);
+            auto probs_np = read_probabilities(written.second);
+            REQUIRE(!probs_p.empty());
+
+            // entries close to the threshold can be written by only one
+            // of the aligners
+            for (const auto &x : probs_p) {
+                REQUIRE(probs_np[x.first] == Approx(x.second).epsilon(1e-6));
+            }
+            for (const auto &x : probs_np) {
+                REQUIRE(probs_p[x.first] == Approx(x.second).epsilon(1e-6));
+            }
+        }
+    }
+}
+
+TEST_CASE("AlignerNP computes probabilities over the sparsified alignments") {
+    using npparams_t = AlignerNPParams<double>;
+
+    // partition function and base match probabilities for thresholds of
+    // the sparsification
+    auto compute = [&](double threshold) {
+        SparseTestPair pair(fixed_structure_pairs()[1], threshold, threshold);
+        const Sequence &seqA = pair.seqA;
+        const Sequence &seqB = pair.seqB;
+        auto scoring_params = pair.scoring_params(-200);
+        PFScoring<double> scoring(seqA, seqB, *pair.rna_dataA,
+                                  *pair.rna_dataB, pair.arc_matches, nullptr,
+                                  scoring_params);
+
+        AlignerNP<double> aligner{npparams_t(
+            AlignerParams::seqA(&seqA), AlignerParams::seqB(&seqB),
+            AlignerParams::scoring(&scoring),
+            AlignerParams::trace_controller(&pair.trace_controller),
+            npparams_t::sparsification_mapperA(&pair.mapperA),
+            npparams_t::sparsification_mapperB(&pair.mapperB))};
+
+        double pf = aligner.align_inside();
+        aligner.align_outside();
+        aligner.compute_arcmatch_probabilities();
+        aligner.compute_basematch_probabilities(false);
+
+        for (auto &am : pair.arc_matches) {
+            double p = aligner.arcmatch_prob(am.arcA(), am.arcB());
+            REQUIRE(p >= 0);
+            REQUIRE(p <= 1 + 1e-8);
+        }
+
+        // each position is matched at most once
+        for (size_t i = 1; i <= seqA.length(); i++) {
+            double row_sum = 0;
+            for (size_t j = 1; j <= seqB.length(); j++) {
+                row_sum += aligner.basematch_prob(i, j);
+            }
+            REQUIRE(row_sum <= 1 + 1e-8);
+        }
+
+        return pf;
+    };
+
+    double pf_dense = compute(0);
+    double pf_sparse = compute(0.01);
+
+    REQUIRE(pf_sparse > 0);
+    // the sparsified alignments are a subset of all alignments
+    REQUIRE(pf_sparse <= pf_dense);
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/alignment_comparison.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for AlignmentComparison
+*/
+
+namespace {
+    //! realign the rows of ma by random gap placement
+    MultipleAlignment
+    random_realignment(const MultipleAlignment &ma, std::mt19937 &gen) {
+        std::vector<std::string> seqs;
+        size_t max_len = 0;
+        for (const auto &entry : ma) {
+            std::string seq = entry.seq().str();
+            seq.erase(std::remove(seq.begin(), seq.end(), '-'), seq.end());
+            max_len = std::max(max_len, seq.length());
+            seqs.push_back(seq);
+        }
+
+        MultipleAlignment result;
+        size_t length = max_len + 8;
+        for (size_t r = 0; r < seqs.size(); r++) {
+            std::string row(length, '-');
+            std::vector<size_t> cols(length);
+            for (size_t c = 0; c < length; c++) {
+                cols[c] = c;
+            }
+            std::shuffle(cols.begin(), cols.end(), gen);
+            cols.resize(seqs[r].length());
+            std::sort(cols.begin(), cols.end());
+            for (size_t i = 0; i < cols.size(); i++) {
+                row[cols[i]] = seqs[r][i];
+            }
+            result.append(
+                MultipleAlignment::SeqEntry(ma.seqentry(r).name(), row));
+        }
+        return result;
+    }
+}
+
+TEST_CASE("AlignmentComparison agrees with MultipleAlignment scores") {
+    MultipleAlignment ref("archaea.aln");
+    REQUIRE(ref.num_of_rows() >= 3);
+
+    std::mt19937 gen(42);
+    std::vector<MultipleAlignment> alignments = {ref};
+    for (size_t k = 0; k < 4; k++) {
+        alignments.push_back(random_realignment(ref, gen));
+    }
+
+    AlignmentComparison comparison(ref, 3);
+    auto scores = comparison.compare(alignments);
+    REQUIRE(scores.size() == alignments.size());
+
+    for (size_t k = 0; k < alignments.size(); k++) {
+        const MultipleAlignment &ma = alignments[k];
+        const auto &s = scores[k];
+        REQUIRE(s.deviation == ref.deviation(ma));
+        REQUIRE(s.realignment_score ==
+                Approx(ref.cmfinder_realignment_score(ma)));
+        REQUIRE(s.match_sps == Approx(ref.sps(ma, false)));
+        REQUIRE(s.compalign_sps == Approx(ref.sps(ma, true)));
+        REQUIRE(s.deviation_sps == Approx(ref.avg_deviation_score(ma)));
+
+        // single alignment comparison gives the same result
+        REQUIRE(comparison.compare(ma).deviation == s.deviation);
+    }
+
+    REQUIRE(scores[0].deviation == 0);
+    REQUIRE(scores[0].compalign_sps == Approx(1.0));
+
+    MultipleAlignment unknown;
+    unknown.append(MultipleAlignment::SeqEntry("unknown", "ACGU"));
+    REQUIRE_THROWS(comparison.compare(unknown));
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "fixed_structure_data.hh"
+
+#include <cassert>
+#include <memory>
+#include <string>
+
+#include <../LocARNA/anchor_constraints.hh>
+#include <../LocARNA/epm_anchors.hh>
+#include <../LocARNA/sequence.hh>
+#include <../LocARNA/sparse_sequence_index.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for anchoring at chains of exact pattern matches
+*/
+
+TEST_CASE("EPM anchors match positions of equal structure and sequence") {
+    std::string seqA = "GGGAAACCCAGCGUAAGCUGGCCAAAGGCCAGGGAAACCCU";
+    std::string seqB = "UUGCGUAAGCUGGCCAAAGGCCAGGGAAACCCUGGAAAUCC";
+    auto rna_dataA = fixed_structure_data(
+        seqA, "(((...)))((((...))))((((...))))(((...))).");
+    auto rna_dataB = fixed_structure_data(
+        seqB, "..((((...))))((((...))))(((...)))((...)).");
+
+    auto anchors = epm_anchor_annotation(
+        *rna_dataA, *rna_dataB,
+        EPMAnchorParams(EPMAnchorParams::alpha_3(0),
+                        EPMAnchorParams::min_score(30)));
+
+    REQUIRE(anchors.first.length() == seqA.length());
+    REQUIRE(anchors.second.length() == seqB.length());
+
+    AnchorConstraints constraints(seqA.length(), anchors.first.single_string(),
+                                  seqB.length(),
+                                  anchors.second.single_string(), true);
+    REQUIRE(!constraints.empty());
+
+    size_t anchored = 0;
+    for (size_t i = 1; i <= seqA.length(); i++) {
+        if (!constraints.is_anchored_a(i)) {
+            continue;
+        }
+        anchored++;
+        for (size_t j = 1; j <= seqB.length(); j++) {
+            if (constraints.get_name_b(j) == constraints.get_name_a(i)) {
+                REQUIRE(seqA[i - 1] == seqB[j - 1]);
+            }
+        }
+    }
+    // the chain covers the common hairpins of A and B
+    REQUIRE(anchored >= 10);
+}
+
+TEST_CASE("EPM anchors can be computed from sparse sequence indices") {
+    std::string seqA = "GGGAAACCCAGCGUAAGCUGGCCAAAGGCCAGGGAAACCCU";
+    std::string seqB = "UUGCGUAAGCUGGCCAAAGGCCAGGGAAACCCUGGAAAUCC";
+    auto rna_dataA = fixed_structure_data(
+        seqA, "(((...)))((((...))))((((...))))(((...))).");
+    auto rna_dataB = fixed_structure_data(
+        seqB, "..((((...))))((((...))))(((...)))((...)).");
+
+    EPMAnchorParams params(EPMAnchorParams::alpha_3(0),
+                           EPMAnchorParams::min_score(30));
+
+    SparseSequenceIndex indexA(*rna_dataA, params.min_prob_,
+                               params.prob_unpaired_in_loop_threshold_,
+                               params.prob_basepair_in_loop_threshold_, false);
+    SparseSequenceIndex indexB(*rna_dataB, params.min_prob_,
+                               params.prob_unpaired_in_loop_threshold_,
+                               params.prob_basepair_in_loop_threshold_, false);
+
+    REQUIRE(indexA.base_pairs()->seqlen() == seqA.length());
+    REQUIRE(indexA.base_pairs()->num_bps() > 0);
+
+    auto anchors = epm_anchor_annotation(*rna_dataA, *rna_dataB, params);
+    auto indexed_anchors = epm_anchor_annotation(indexA, indexB, params);
+    auto reversed_anchors = epm_anchor_annotation(indexB, indexA, params);
+
+    REQUIRE(indexed_anchors.first.single_string() ==
+            anchors.first.single_string());
+    REQUIRE(indexed_anchors.second.single_string() ==
+            anchors.second.single_string());
+    REQUIRE(reversed_anchors.first.length() == seqB.length());
+    REQUIRE(reversed_anchors.second.length() == seqA.length());
+
+    SparseSequenceIndex left_endsA(*rna_dataA, params.min_prob_,
+                                   params.prob_unpaired_in_loop_threshold_,
+                                   params.prob_basepair_in_loop_threshold_,
+                                   true);
+    SparseSequenceIndex left_endsB(*rna_dataB, params.min_prob_,
+                                   params.prob_unpaired_in_loop_threshold_,
+                                   params.prob_basepair_in_loop_threshold_,
+                                   true);
+    REQUIRE_THROWS(epm_anchor_annotation(left_endsA, left_endsB, params));
+}
@@ -0,0 +1,406 @@
+#include "catch.hpp"
+#include "fixed_structure_data.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <../LocARNA/exact_matcher.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for ExactMatcher, LCSEPM and the EPM storage
+*/
+
+namespace {
+    //! add an EPM of the given positions in A and B to map
+    void
+    add_epm(PatternPairMap &map,
+            const intVec &pat1,
+            const intVec &pat2,
+            int score) {
+        std::string id = "pat_" + std::to_string(map.size() + 1);
+        map.add(id, SinglePattern(id, "A", pat1), SinglePattern(id, "B", pat2),
+                std::string(pat1.size(), '.'), score);
+    }
+
+    /**
+     * @brief Best score of a chain of EPMs by enumerating all subsets
+     *
+     * Scores the EPMs, which lie within [i..j] in A and [k..l] in B,
+     * recursively like LCSEPM: an EPM contributes its score and the
+     * best chains in its holes, i.e. the gaps between consecutive
+     * pattern positions that are larger than min_size in A and B.
+     */
+    int
+    brute_force_chain(const PatternPairMap &map,
+                      unsigned int min_size,
+                      unsigned int i,
+                      unsigned int j,
+                      unsigned int k,
+                      unsigned int l) {
+        std::vector<const PatternPair *> epms;
+        for (const auto &x : map.getList()) {
+            const intVec &pat1 = x->getFirstPat().getPat();
+            const intVec &pat2 = x->getSecPat().getPat();
+            if (pat1.front() >= i && pat1.back() <= j && pat2.front() >= k &&
+                pat2.back() <= l) {
+                epms.push_back(x);
+            }
+        }
+        std::sort(epms.begin(), epms.end(),
+                  [](const PatternPair *x, const PatternPair *y) {
+                      return x->getFirstPat().getPat().front() <
+                          y->getFirstPat().getPat().front();
+                  });
+
+        std::vector<int> scores;
+        for (const auto &x : epms) {
+            const intVec &pat1 = x->getFirstPat().getPat();
+            const intVec &pat2 = x->getSecPat().getPat();
+            int score = x->getEPMScore();
+            for (size_t p = 1; p < pat1.size(); p++) {
+                if (pat1[p] > pat1[p - 1] + min_size &&
+                    pat2[p] > pat2[p - 1] + min_size) {
+                    score += brute_force_chain(map, min_size, pat1[p - 1] + 1,
+                                               pat1[p] - 1, pat2[p - 1] + 1,
+                                               pat2[p] - 1);
+                }
+            }
+            scores.push_back(score);
+        }
+
+        int best = 0;
+        for (size_t subset = 1; subset < (size_t(1) << epms.size());
+             subset++) {
+            int score = 0;
+            const PatternPair *last = nullptr;
+            bool is_chain = true;
+            for (size_t x = 0; x < epms.size() && is_chain; x++) {
+                if (!(subset & (size_t(1) << x))) {
+                    continue;
+                }
+                is_chain =
+                    last == nullptr ||
+                    (last->getFirstPat().getPat().back() <
+                         epms[x]->getFirstPat().getPat().front() &&
+                     last->getSecPat().getPat().back() <
+                         epms[x]->getSecPat().getPat().front());
+                score += scores[x];
+                last = epms[x];
+            }
+            if (is_chain) {
+                best = std::max(best, score);
+            }
+        }
+        return best;
+    }
+
+    //! whether EPM y lies in a hole of EPM x
+    bool
+    in_hole(const PatternPair &x, const PatternPair &y) {
+        for (const auto &h : x.getInsideBounds()) {
+            if (h.first.first < y.getFirstPat().getPat().front() &&
+                y.getFirstPat().getPat().back() < h.first.second &&
+                h.second.first < y.getSecPat().getPat().front() &&
+                y.getSecPat().getPat().back() < h.second.second) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //! whether EPM x lies before EPM y in A and B
+    bool
+    before(const PatternPair &x, const PatternPair &y) {
+        return x.getFirstPat().getPat().back() <
+            y.getFirstPat().getPat().front() &&
+            x.getSecPat().getPat().back() < y.getSecPat().getPat().front();
+    }
+
+    //! sorted ids of the EPMs of a map, separated by blanks
+    std::string
+    epm_ids(const PatternPairMap &map) {
+        std::vector<std::string> ids;
+        for (const auto &x : map.getList()) {
+            ids.push_back(x->getId());
+        }
+        std::sort(ids.begin(), ids.end());
+        std::string joined;
+        for (const auto &id : ids) {
+            joined += (joined.empty() ? "" : " ") + id;
+        }
+        return joined;
+    }
+}
+
+TEST_CASE("PatternPairMap stores EPMs by index") {
+    PatternPairMap map;
+
+    auto add = [&map](size_t size, int score) {
+        std::string id = "pat_" + std::to_string(map.size() + 1);
+        intVec pat1;
+        intVec pat2;
+        for (size_t k = 1; k <= size; k++) {
+            pat1.push_back(k);
+            pat2.push_back(k + 1);
+        }
+        map.add(id, SinglePattern(id, "A", pat1), SinglePattern(id, "B", pat2),
+                std::string(size, '.'), score);
+    };
+
+    add(3, 10);
+    const PatternPair *first = map.getPatternPairPTR(0);
+    add(5, 20);
+    add(3, 30);
+    for (size_t k = 0; k < 1000; k++) {
+        add(2, 1);
+    }
+
+    REQUIRE(map.size() == 1003);
+    REQUIRE(map.getMinPatternSize() == 2);
+
+    SECTION("PatternPairs do not move when adding") {
+        REQUIRE(map.getPatternPairPTR(0) == first);
+        REQUIRE(map.getPatternPair(0).getId() == "pat_1");
+        REQUIRE(map.getPatternPair(2).getScore() == 30);
+        REQUIRE(map.getList()[1]->getSecPat().getPat().back() == 6);
+    }
+
+    SECTION("ordered map is sorted by size, stable for equal sizes") {
+        map.makeOrderedMap();
+        const auto &ordered = map.getOrderedMap();
+        REQUIRE(ordered.size() == map.size());
+        REQUIRE(ordered[0]->getId() == "pat_2");
+        REQUIRE(ordered[1]->getId() == "pat_1");
+        REQUIRE(ordered[2]->getId() == "pat_3");
+        REQUIRE(ordered[3]->getId() == "pat_4");
+    }
+
+    SECTION("copies of PatternPairs can be added") {
+        PatternPairMap copy;
+        copy.add(map.getPatternPairPTR(1));
+        REQUIRE(copy.size() == 1);
+        REQUIRE(copy.getMapBases() == 5);
+        REQUIRE(copy.getPatternPairPTR(0) != map.getPatternPairPTR(1));
+    }
+}
+
+TEST_CASE("LCSEPM chains overlapping, nested and tied EPMs") {
+    Sequence seqA("A", std::string(20, 'A'));
+    Sequence seqB("B", std::string(20, 'A'));
+    PatternPairMap epms;
+    PatternPairMap chain;
+
+    SECTION("overlapping EPMs are not chained") {
+        add_epm(epms, {1, 2, 3, 4}, {1, 2, 3, 4}, 5);
+        add_epm(epms, {3, 4, 5, 6}, {3, 4, 5, 6}, 7);
+        add_epm(epms, {7, 8, 9}, {7, 8, 9}, 3);
+        // crosses the second EPM
+        add_epm(epms, {10, 11, 12}, {5, 6, 7}, 4);
+
+        LCSEPM(seqA, seqB, epms, chain).calculateLCSEPM(true);
+        REQUIRE(epm_ids(chain) == "pat_2 pat_3");
+    }
+
+    SECTION("EPMs in holes add to the score of the enclosing EPM") {
+        add_epm(epms, {1, 2, 10, 11}, {1, 2, 10, 11}, 6);
+        add_epm(epms, {4, 5, 6}, {4, 5, 6}, 3);
+        // no hole, better than the first EPM without the second
+        add_epm(epms, {1, 3, 5, 7, 9, 11}, {1, 3, 5, 7, 9, 11}, 8);
+
+        LCSEPM(seqA, seqB, epms, chain).calculateLCSEPM(true);
+        REQUIRE(epm_ids(chain) == "pat_1 pat_2");
+        REQUIRE(epms.getPatternPair(0).getScore() == 9);
+        REQUIRE(epms.getPatternPair(1).getScore() == 3);
+    }
+
+    SECTION("EPMs with equal holes get the same hole score") {
+        add_epm(epms, {1, 2, 8, 9}, {1, 2, 8, 9}, 4);
+        add_epm(epms, {2, 8, 10}, {2, 8, 10}, 4);
+        add_epm(epms, {4, 5, 6}, {4, 5, 6}, 3);
+
+        LCSEPM(seqA, seqB, epms, chain).calculateLCSEPM(true);
+        REQUIRE(epms.getPatternPair(0).getScore() == 7);
+        REQUIRE(epms.getPatternPair(1).getScore() == 7);
+        // of tied chains, the one ending first in B is chosen
+        REQUIRE(epm_ids(chain) == "pat_1 pat_3");
+    }
+
+    SECTION("of tied EPMs, the one ending first is chosen") {
+        add_epm(epms, {1, 2, 3}, {5, 6, 7}, 5);
+        add_epm(epms, {5, 6, 7}, {1, 2, 3}, 5);
+        add_epm(epms, {1, 2, 3}, {1, 2, 3}, 5);
+
+        LCSEPM(seqA, seqB, epms, chain).calculateLCSEPM(true);
+        REQUIRE(epm_ids(chain) == "pat_3");
+    }
+}
+
+TEST_CASE("LCSEPM computes the best chain of random EPMs") {
+    const unsigned int len = 40;
+    Sequence seqA("A", std::string(len, 'A'));
+    Sequence seqB("B", std::string(len, 'A'));
+
+    std::mt19937 rng(4711);
+    auto uniform = [&rng](unsigned int from, unsigned int to) {
+        return std::uniform_int_distribution<unsigned int>(from, to)(rng);
+    };
+
+    for (size_t instance = 0; instance < 200; instance++) {
+        PatternPairMap epms;
+        size_t num_epms = uniform(1, 10);
+        while (epms.size() < num_epms) {
+            intVec pat1{uniform(1, len / 2)};
+            intVec pat2{uniform(1, len / 2)};
+            size_t size = uniform(2, 6);
+            while (pat1.size() < size && pat1.back() < len - 8 &&
+                   pat2.back() < len - 8) {
+                // mostly adjacent positions, sometimes holes
+                bool gap = uniform(0, 3) == 0;
+                pat1.push_back(pat1.back() + (gap ? uniform(1, 8) : 1));
+                pat2.push_back(pat2.back() + (gap ? uniform(1, 8) : 1));
+            }
+            // small scores to get ties
+            add_epm(epms, pat1, pat2, uniform(1, 4));
+        }
+
+        PatternPairMap chain;
+        LCSEPM(seqA, seqB, epms, chain).calculateLCSEPM(true);
+
+        int score = 0;
+        for (const auto &x : chain.getList()) {
+            score += x->getEPMScore();
+        }
+        REQUIRE(score == brute_force_chain(epms, epms.getMinPatternSize(), 1,
+                                           len, 1, len));
+
+        // the chained EPMs are ordered or nested in holes
+        for (const auto &x : chain.getList()) {
+            for (const auto &y : chain.getList()) {
+                if (x != y) {
+                    REQUIRE((before(*x, *y) || before(*y, *x) ||
+                             in_hole(*x, *y) || in_hole(*y, *x)));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ExactMatcher computes the same EPMs with several threads") {
+    SparseTestPair pair(
+        {"GGGAAACCCAGCGUAAGCUGGCCAAAGGCCAGGGAAACCCUGCAGGGAAACCCUGC",
+         "(((...)))((((...))))((((...))))(((...)))((((((...)))))).",
+         "UUGCGUAAGCUGGCCAAAGGCCAGGGAAACCCUGGAAAUCCGCAGGGAAACCCUGCA",
+         "..((((...))))((((...))))(((...)))((...))((((((...)))))).."},
+        0.01, 0.01, false);
+    const Sequence &seqA = pair.seqA;
+    const Sequence &seqB = pair.seqB;
+    const ExtRnaData &rna_dataA = *pair.rna_dataA;
+    const ExtRnaData &rna_dataB = *pair.rna_dataB;
+
+    SparseTraceController sparse_trace_controller(pair.mapperA, pair.mapperB,
+                                                  pair.trace_controller);
+
+    // EPMs as strings of positions, structure and score
+    auto compute_EPMs = [&](size_t threads, bool suboptimal) {
+        PatternPairMap EPMs;
+        ExactMatcher em(seqA, seqB, rna_dataA, rna_dataB, pair.arc_matches,
+                        sparse_trace_controller, EPMs, 1, 5, 0, -1, 5, 10000,
+                        false, -10, false, false, threads);
+        em.compute_arcmatch_score();
+        em.trace_EPMs(suboptimal);
+
+        std::vector<std::string> result;
+        for (const auto &epm : EPMs.getList()) {
+            std::string s = epm->getId() + " " + epm->get_struct() + " " +
+                std::to_string(epm->getScore());
+            for (auto pos : epm->getFirstPat().getPat()) {
+                s += " " + std::to_string(pos);
+            }
+            for (auto pos : epm->getSecPat().getPat()) {
+                s += " " + std::to_string(pos);
+            }
+            result.push_back(s);
+        }
+        return result;
+    };
+
+    for (bool suboptimal : {false, true}) {
+        auto sequential = compute_EPMs(1, suboptimal);
+        REQUIRE(sequential.size() > 1);
+
+        for (size_t threads : {2, 4}) {
+            REQUIRE(compute_EPMs(threads, suboptimal) == sequential);
+        }
+    }
+
+    SECTION("streamed EPMs are the stored EPMs") {
+        auto trace = [&](PatternPairMap &EPMs, EPMListWriter *writer,
+                         bool suboptimal) {
+            ExactMatcher em(seqA, seqB, rna_dataA, rna_dataB,
+                            pair.arc_matches, sparse_trace_controller, EPMs,
+                            1, 5, 0, -1, 5, 10000, false, -10, false, false,
+                            2);
+            em.set_epm_writer(writer);
+            em.compute_arcmatch_score();
+            em.trace_EPMs(suboptimal);
+        };
+
+        for (bool suboptimal : {false, true}) {
+            PatternPairMap stored_EPMs;
+            trace(stored_EPMs, nullptr, suboptimal);
+            std::ostringstream stored;
+            stored << stored_EPMs.getList();
+
+            PatternPairMap EPMs;
+            std::ostringstream streamed;
+            EPMListWriter writer(streamed);
+            trace(EPMs, &writer, suboptimal);
+
+            REQUIRE(EPMs.size() == 0);
+            REQUIRE(writer.size() == (size_t)stored_EPMs.size());
+            REQUIRE(streamed.str() == stored.str());
+        }
+    }
+}
+
+TEST_CASE("EPMListWriter writes the EPM list without storing the EPMs") {
+    PatternPairMap map;
+    std::ostringstream streamed;
+    EPMListWriter writer(streamed);
+
+    auto add = [&](intVec pat1, intVec pat2, int score) {
+        std::string id = "pat_" + std::to_string(map.size() + 1);
+        std::string structure(pat1.size(), '.');
+        map.add(id, SinglePattern(id, "A", pat1), SinglePattern(id, "B", pat2),
+                structure, score);
+        return writer.write(score, structure, pat1, pat2, true);
+    };
+
+    REQUIRE(add({1, 2, 3}, {4, 5, 6}, 300));
+    REQUIRE(add({2, 3}, {5, 6}, 200));
+    REQUIRE(add({1, 2, 3}, {5, 6, 7}, 300));
+
+    std::ostringstream stored;
+    stored << map.getList();
+    REQUIRE(streamed.str() == stored.str());
+    REQUIRE(writer.size() == 3);
+
+    SECTION("duplicates are skipped") {
+        REQUIRE(!writer.write(200, "..", {2, 3}, {5, 6}, true));
+        REQUIRE(writer.size() == 3);
+        REQUIRE(writer.duplicates() == 1);
+        REQUIRE(streamed.str() == stored.str());
+    }
+
+    SECTION("duplicates are written without skipping") {
+        REQUIRE(writer.write(200, "..", {2, 3}, {5, 6}, false));
+        REQUIRE(writer.size() == 4);
+        REQUIRE(writer.duplicates() == 0);
+    }
+}
@@ -2,8 +2,11 @@
 
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 #include <../LocARNA/pfold_params.hh>
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/rna_ensemble.hh>
 #include <../LocARNA/ext_rna_data.hh>
 
 using namespace LocARNA;
@@ -53,6 +56,64 @@ TEST_CASE("ExtRnaData can fold alignments, write to file and read again") {
     }
 }
 
+TEST_CASE("ExtRnaData computes stacking and in loop probabilities on demand") {
+    PFoldParams pfoldparams(PFoldParams::args::noLP(true),
+                            PFoldParams::args::stacking(true));
+
+    MultipleAlignment ma("archaea.aln", MultipleAlignment::FormatType::CLUSTAL);
+    auto rna_ensemble =
+        std::make_shared<const RnaEnsemble>(ma, pfoldparams, true, true);
+
+    ExtRnaData eager(*rna_ensemble, 0.01, 0.0001, 0.0001, 0, 0, 0,
+                     pfoldparams);
+    ExtRnaData lazy(rna_ensemble, 0.01, 0.0001, 0.0001, 0, 0, 0,
+                    pfoldparams);
+
+    size_t len = eager.length();
+    REQUIRE(lazy.length() == len);
+
+    // arcs above cutoff
+    std::vector<std::pair<size_t, size_t>> arcs;
+    for (size_t i = 1; i <= len; i++) {
+        for (size_t j = i + 1; j <= len; j++) {
+            REQUIRE(lazy.arc_prob(i, j) == eager.arc_prob(i, j));
+            if (eager.arc_prob(i, j) > 0) {
+                arcs.push_back(std::make_pair(i, j));
+            }
+        }
+    }
+
+    for (const auto &a : arcs) {
+        size_t i = a.first;
+        size_t j = a.second;
+        REQUIRE(lazy.joint_arc_prob(i, j) == eager.joint_arc_prob(i, j));
+        for (size_t k = i + 1; k < j; k++) {
+            REQUIRE(lazy.unpaired_in_loop_prob(k, i, j) ==
+                    eager.unpaired_in_loop_prob(k, i, j));
+        }
+        for (const auto &b : arcs) {
+            REQUIRE(lazy.arc_in_loop_prob(b.first, b.second, i, j) ==
+                    eager.arc_in_loop_prob(b.first, b.second, i, j));
+        }
+    }
+    for (size_t k = 1; k <= len; k++) {
+        REQUIRE(lazy.unpaired_external_prob(k) ==
+                eager.unpaired_external_prob(k));
+    }
+
+    std::ostringstream eager_pp;
+    std::ostringstream lazy_pp;
+    eager.write_pp(eager_pp);
+    lazy.write_pp(lazy_pp);
+    REQUIRE(eager_pp.str() == lazy_pp.str());
+
+    // writing completed the lazy probabilities; look ups still agree
+    for (const auto &a : arcs) {
+        REQUIRE(lazy.joint_arc_prob(a.first, a.second) ==
+                eager.joint_arc_prob(a.first, a.second));
+    }
+}
+
 TEST_CASE(
     "ExtRnaData can initialize from fixed structure, even in the context of "
     "restricted maxBPspan") {
@@ -0,0 +1,193 @@
+#ifndef LOCARNA_TESTS_FIXED_STRUCTURE_DATA_HH
+#define LOCARNA_TESTS_FIXED_STRUCTURE_DATA_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <../LocARNA/anchor_constraints.hh>
+#include <../LocARNA/arc_matches.hh>
+#include <../LocARNA/aux.hh>
+#include <../LocARNA/ext_rna_data.hh>
+#include <../LocARNA/pfold_params.hh>
+#include <../LocARNA/scoring.hh>
+#include <../LocARNA/sparsification_mapper.hh>
+#include <../LocARNA/trace_controller.hh>
+
+/** @file RNA data of fixed structures for the unit tests
+*/
+
+namespace LocARNA {
+
+    /**
+     * @brief ExtRnaData of an alignment with fixed structure
+     *
+     * Writes the rows and the structure (as #FS line) in clustal format
+     * to a temporary file in the working directory and reads it as
+     * ExtRnaData; the file is removed after reading.
+     *
+     * @param rows aligned sequences
+     * @param structure fixed structure in dot bracket notation
+     * @return the RNA data
+     */
+    inline std::unique_ptr<ExtRnaData>
+    fixed_structure_data(const std::vector<std::string> &rows,
+                         const std::string &structure) {
+        char filename[] = "fixed_structure_XXXXXX";
+        int fd = mkstemp(filename);
+        if (fd == -1) {
+            throw failure("Cannot create temporary file.");
+        }
+        close(fd);
+
+        // remove the file also if reading fails
+        struct remove_file {
+            const char *name;
+            ~remove_file() { std::remove(name); }
+        } remove_guard{filename};
+
+        {
+            std::ofstream out(filename);
+            out << "CLUSTAL W" << std::endl << std::endl;
+            for (size_t k = 0; k < rows.size(); k++) {
+                out << "seq" << k + 1 << " " << rows[k] << std::endl;
+            }
+            out << "#FS " << structure << std::endl;
+        }
+        PFoldParams pfoldparams(PFoldParams::args::noLP(false),
+                                PFoldParams::args::stacking(false));
+        return std::make_unique<ExtRnaData>(filename, 0.01, 0.0001, 0.00005, 0,
+                                            0, 0, pfoldparams);
+    }
+
+    /**
+     * @brief ExtRnaData of a sequence with fixed structure
+     *
+     * @param seq sequence
+     * @param structure fixed structure in dot bracket notation
+     * @return the RNA data
+     */
+    inline std::unique_ptr<ExtRnaData>
+    fixed_structure_data(const std::string &seq, const std::string &structure) {
+        return fixed_structure_data(std::vector<std::string>{seq}, structure);
+    }
+
+    //! sequences and fixed structures of two RNAs
+    struct FixedStructurePair {
+        std::string seqA;
+        std::string structureA;
+        std::string seqB;
+        std::string structureB;
+    };
+
+    /**
+     * @brief RNA pairs of the alignment tests
+     *
+     * A pair of short RNAs with several hairpins and a pair of tRNAs.
+     */
+    inline const std::vector<FixedStructurePair> &
+    fixed_structure_pairs() {
+        static const std::vector<FixedStructurePair> pairs = {
+            {"GGGAAACCCAGCGUAAGCUGGCCAAAGGCCAGGGAAACCCU",
+             "(((...)))((((...))))((((...))))(((...))).",
+             "GGAAAUCCAGCGAAGCUGGCCGAAAGGCCGGGAAACCCUU",
+             "((...))((((..))))(((((...)))))(((...)))."},
+            {"GCGGAUUUAGCUCAGUUGGGAGAGCGCCAGACUGAAGAUCUGGAGGUCCUGUGUUCGAUCCACAG"
+             "AAUUCGCACCA",
+             "(((((((..((((........)))).(((((.......))))).....(((((.......)))))"
+             ")))))))....",
+             "GGGGCUAUAGCUCAGCUGGGAGAGCGCUUGCAUGGCAUGCAAGAGGUCAGCGGUUCGAUCCCGCU"
+             "UAGCUCCACCA",
+             "(((((((..((((........)))).(((((.......))))).....(((((.......)))))"
+             ")))))))...."}};
+        return pairs;
+    }
+
+    /**
+     * @brief Input of the sparse aligners for two RNAs of fixed structure
+     *
+     * Holds the RNA data, arc matches without length restriction and the
+     * sparsification mappers of both RNAs; all positions are allowed by
+     * the constraints and the trace controller.
+     */
+    struct SparseTestPair {
+        std::unique_ptr<ExtRnaData> rna_dataA;
+        std::unique_ptr<ExtRnaData> rna_dataB;
+        const Sequence &seqA;
+        const Sequence &seqB;
+        AnchorConstraints constraints;
+        TraceController trace_controller;
+        ArcMatches arc_matches;
+        SparsificationMapper mapperA;
+        SparsificationMapper mapperB;
+
+        /**
+         * @param rnas sequences and structures
+         * @param prob_unpaired_in_loop_threshold threshold of the mappers
+         * for unpaired positions
+         * @param prob_basepair_in_loop_threshold threshold of the mappers
+         * for base pairs
+         * @param index_left_ends whether the mappers are indexed by left
+         * ends
+         */
+        SparseTestPair(const FixedStructurePair &rnas,
+                       double prob_unpaired_in_loop_threshold,
+                       double prob_basepair_in_loop_threshold,
+                       bool index_left_ends = true)
+            : rna_dataA(fixed_structure_data(rnas.seqA, rnas.structureA)),
+              rna_dataB(fixed_structure_data(rnas.seqB, rnas.structureB)),
+              seqA(rna_dataA->sequence()),
+              seqB(rna_dataB->sequence()),
+              constraints(seqA.length(), "", seqB.length(), "", true),
+              trace_controller(seqA, seqB, nullptr, -1, false),
+              arc_matches(*rna_dataA,
+                          *rna_dataB,
+                          0.01,
+                          std::max(seqA.length(), seqB.length()),
+                          std::max(seqA.length(), seqB.length()),
+                          trace_controller,
+                          constraints),
+              mapperA(arc_matches.get_base_pairsA(),
+                      *rna_dataA,
+                      prob_unpaired_in_loop_threshold,
+                      prob_basepair_in_loop_threshold,
+                      index_left_ends),
+              mapperB(arc_matches.get_base_pairsB(),
+                      *rna_dataB,
+                      prob_unpaired_in_loop_threshold,
+                      prob_basepair_in_loop_threshold,
+                      index_left_ends) {}
+
+        /**
+         * @brief Scoring parameters of the tests
+         *
+         * @param indel_opening cost of opening a gap
+         * @param indel_opening_loop cost of opening a gap in a loop
+         * @return parameters with fixed match, indel and structure scores
+         * @note the scoring keeps a pointer to its parameters; store them
+         * for the lifetime of the scoring
+         */
+        ScoringParams
+        scoring_params(score_t indel_opening,
+                       score_t indel_opening_loop = -900) const {
+            return ScoringParams(
+                ScoringParams::match(50), ScoringParams::mismatch(0),
+                ScoringParams::indel(-150), ScoringParams::indel_loop(-300),
+                ScoringParams::indel_opening(indel_opening),
+                ScoringParams::indel_opening_loop(indel_opening_loop),
+                ScoringParams::struct_weight(200),
+                ScoringParams::tau_factor(100),
+                ScoringParams::exp_probA(prob_exp_f(seqA.length())),
+                ScoringParams::exp_probB(prob_exp_f(seqB.length())));
+        }
+    };
+}
+
+#endif // LOCARNA_TESTS_FIXED_STRUCTURE_DATA_HH
@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <../LocARNA/matrices.hh>
+#include <../LocARNA/guide_tree.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for GuideTree
+*/
+
+TEST_CASE("TriangularMatrix provides symmetric access") {
+    TriangularMatrix<float> m(4, 1.0f);
+    REQUIRE(m.dim() == 4);
+    REQUIRE(m(3, 0) == 1.0f);
+
+    m(1, 3) = 5.0f;
+    REQUIRE(m(3, 1) == 5.0f);
+    REQUIRE(m(2, 1) == 1.0f);
+}
+
+TEST_CASE("GuideTree constructs UPGMA and neighbor-joining trees") {
+    std::vector<std::string> names = {"A", "B", "C", "D"};
+
+    SECTION("UPGMA joins the most similar clusters") {
+        GuideTree::matrix_t sim(4);
+        sim(0, 1) = 10;
+        sim(0, 2) = 100;
+        sim(0, 3) = 20;
+        sim(1, 2) = 30;
+        sim(1, 3) = 80;
+        sim(2, 3) = 40;
+
+        GuideTree tree = GuideTree::upgma(sim);
+        REQUIRE(tree.num_leaves() == 4);
+        REQUIRE(tree.merges().size() == 3);
+        REQUIRE(tree.branch_lengths().empty());
+
+        std::ostringstream out;
+        tree.write_newick(out, names);
+        REQUIRE(out.str() == "((A,C),(B,D));");
+    }
+
+    SECTION("neighbor-joining recovers an additive tree") {
+        // tree ((A:1,B:2):3,(C:4,D:1)), rooted in the central edge
+        GuideTree::matrix_t dist(4);
+        dist(0, 1) = 3;
+        dist(0, 2) = 8;
+        dist(0, 3) = 5;
+        dist(1, 2) = 9;
+        dist(1, 3) = 6;
+        dist(2, 3) = 5;
+
+        GuideTree tree = GuideTree::neighbor_joining(dist);
+        const auto &merges = tree.merges();
+        REQUIRE(merges.size() == 3);
+        REQUIRE(merges[0] == GuideTree::merge_t(0, 1));
+        REQUIRE(tree.branch_lengths()[0] == Approx(1));
+        REQUIRE(tree.branch_lengths()[1] == Approx(2));
+
+        // the total length does not depend on the root position
+        const auto &lengths = tree.branch_lengths();
+        REQUIRE(std::accumulate(lengths.begin(), lengths.end(), 0.0) ==
+                Approx(11));
+    }
+
+    SECTION("single leaf trees are supported") {
+        GuideTree tree = GuideTree::upgma(GuideTree::matrix_t(1));
+        std::ostringstream out;
+        tree.write_newick(out, {"A"});
+        REQUIRE(out.str() == "A;");
+    }
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <../LocARNA/indexed_alignment_file.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for IndexedAlignmentFile
+*/
+
+TEST_CASE("IndexedAlignmentFile provides random access to FASTA entries") {
+    std::string filename = "test_indexed.fa";
+    std::string indexname = filename + IndexedAlignmentFile::index_suffix;
+    std::remove(indexname.c_str());
+
+    {
+        std::ofstream out(filename.c_str());
+        out << ">seqA first sequence" << std::endl
+            << "ACGUACGU" << std::endl
+            << "ACGU" << std::endl
+            << ">seqB" << std::endl
+            << "GGGAAACCC" << std::endl
+            << ">seqC" << std::endl
+            << "UUUU" << std::endl;
+    }
+
+    SECTION("the index is built and entries can be accessed by name") {
+        IndexedAlignmentFile file(filename,
+                                  MultipleAlignment::FormatType::FASTA);
+        REQUIRE(!file.index_loaded());
+        REQUIRE(file.size() == 3);
+        REQUIRE(file.name(1) == "seqB");
+        REQUIRE(file.contains("seqC"));
+        REQUIRE(!file.contains("seqD"));
+
+        MultipleAlignment ma = file.alignment("seqA");
+        REQUIRE(ma.num_of_rows() == 1);
+        REQUIRE(ma.seqentry(0).name() == "seqA");
+        REQUIRE(ma.seqentry(0).seq().str() == "ACGUACGUACGU");
+
+        REQUIRE(file.alignment(2).seqentry(0).seq().str() == "UUUU");
+        REQUIRE_THROWS(file.alignment("seqD"));
+
+        SECTION("the index is reused from the sidecar file") {
+            IndexedAlignmentFile file2(filename,
+                                       MultipleAlignment::FormatType::FASTA);
+            REQUIRE(file2.index_loaded());
+            REQUIRE(file2.size() == 3);
+            REQUIRE(file2.alignment("seqB").seqentry(0).seq().str() ==
+                    "GGGAAACCC");
+        }
+    }
+
+    std::remove(indexname.c_str());
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("IndexedAlignmentFile provides random access to Stockholm entries") {
+    std::string filename = "test_indexed.sto";
+    std::string indexname = filename + IndexedAlignmentFile::index_suffix;
+    std::remove(indexname.c_str());
+
+    {
+        std::ofstream out(filename.c_str());
+        out << "# STOCKHOLM 1.0" << std::endl
+            << "#=GF ID famA" << std::endl
+            << "#=GF AC RF00001" << std::endl
+            << "s1 ACGU-ACGU" << std::endl
+            << "s2 ACGUUACG-" << std::endl
+            << "//" << std::endl
+            << "# STOCKHOLM 1.0" << std::endl
+            << "#=GF AC RF00002" << std::endl
+            << "#=GF ID famB" << std::endl
+            << "t1 GGGAAACCC" << std::endl
+            << "t2 GGGAAUCCC" << std::endl
+            << "t3 GGGAA-CCC" << std::endl
+            << "//" << std::endl;
+    }
+
+    IndexedAlignmentFile file(filename,
+                              MultipleAlignment::FormatType::STOCKHOLM);
+    REQUIRE(file.size() == 2);
+    REQUIRE(file.name(0) == "famA");
+    REQUIRE(file.name(1) == "famB");
+
+    MultipleAlignment ma = file.alignment("RF00002");
+    REQUIRE(ma.num_of_rows() == 3);
+    REQUIRE(ma.contains("t3"));
+    REQUIRE(!ma.contains("s1"));
+
+    MultipleAlignment ma2 = file.alignment("famA");
+    REQUIRE(ma2.num_of_rows() == 2);
+    REQUIRE(ma2.length() == 9);
+
+    std::remove(indexname.c_str());
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,47 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/packed_alignment.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for PackedAlignment
+*/
+
+TEST_CASE("PackedAlignment provides the columns of a multiple alignment") {
+    MultipleAlignment ma;
+    ma.append(MultipleAlignment::SeqEntry("a", "ACGU-NRY"));
+    ma.append(MultipleAlignment::SeqEntry("b", "A-GUVC.X"));
+    ma.append(MultipleAlignment::SeqEntry("c", "UUG-~ACG"));
+
+    PackedAlignment pa(ma);
+    REQUIRE(pa.num_of_rows() == 3);
+    REQUIRE(pa.length() == 8);
+
+    SECTION("symbols match the rows, including escaped symbols") {
+        for (size_t col = 1; col <= ma.length(); col++) {
+            for (size_t row = 0; row < ma.num_of_rows(); row++) {
+                REQUIRE(pa.symbol(col, row) == ma.seqentry(row).seq()[col]);
+                REQUIRE(pa.column(col)[row] == ma.column(col)[row]);
+            }
+        }
+        REQUIRE(pa.code(5, 0) == 0);
+        REQUIRE(pa.code(5, 1) == PackedAlignment::escape_code);
+    }
+
+    SECTION("column iterators traverse all rows") {
+        for (size_t col = 1; col <= ma.length(); col++) {
+            std::string s;
+            for (const auto &c : pa.column(col)) {
+                s += c;
+            }
+            REQUIRE(s.size() == pa.column(col).size());
+            for (size_t row = 0; row < s.size(); row++) {
+                REQUIRE(s[row] == ma.seqentry(row).seq()[col]);
+            }
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <../LocARNA/parallel.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for parallel_for and parallel_levels
+*/
+
+TEST_CASE("parallel_for processes each item once") {
+    for (size_t threads : {1, 4}) {
+        for (size_t chunk : {1, 3}) {
+            const size_t n = 100;
+            std::vector<std::atomic<int>> count(n);
+            for (auto &c : count) {
+                c = 0;
+            }
+            std::atomic<bool> thread_ok(true);
+            parallel_for(n, threads,
+                         [&](size_t item, size_t thread) {
+                             count[item]++;
+                             if (thread >= threads) {
+                                 thread_ok = false;
+                             }
+                         },
+                         chunk);
+            for (auto &c : count) {
+                REQUIRE(c == 1);
+            }
+            REQUIRE(thread_ok);
+        }
+    }
+
+    SECTION("no items") {
+        parallel_for(0, 4, [](size_t, size_t) { REQUIRE(false); });
+    }
+}
+
+TEST_CASE("parallel_levels finishes each level before the next") {
+    const std::vector<size_t> sizes = {5, 0, 1, 7, 3};
+    std::vector<size_t> started;
+    std::atomic<size_t> done(0);
+    std::atomic<bool> ok(true);
+
+    // count of items finished before the start of each level
+    std::vector<size_t> done_at_start;
+
+    parallel_levels(sizes.size(), 4,
+                    [&](size_t level) {
+                        started.push_back(level);
+                        done_at_start.push_back(done);
+                        return sizes[level];
+                    },
+                    [&](size_t level, size_t item, size_t) {
+                        if (item >= sizes[level]) {
+                            ok = false;
+                        }
+                        done++;
+                    });
+
+    REQUIRE(ok);
+    REQUIRE(started == std::vector<size_t>({0, 1, 2, 3, 4}));
+    REQUIRE(done_at_start == std::vector<size_t>({0, 5, 5, 6, 13}));
+    REQUIRE(done == 16);
+}
+
+TEST_CASE("parallel_for rethrows the exception of an item") {
+    std::atomic<size_t> processed(0);
+    REQUIRE_THROWS(parallel_for(1000, 4, [&](size_t item, size_t) {
+        if (item == 10) {
+            throw std::runtime_error("item");
+        }
+        // slow items, such that the other threads cannot run through
+        // all items before the failure is recorded
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        processed++;
+    }));
+    // items after the failure are not dealt out any more
+    REQUIRE(processed < 999);
+}
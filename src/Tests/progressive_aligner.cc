@@ -0,0 +1,181 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <../LocARNA/pfold_params.hh>
+#include <../LocARNA/sequence.hh>
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/rna_ensemble.hh>
+#include <../LocARNA/rna_data.hh>
+#include <../LocARNA/progressive_aligner.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for ProgressiveAligner
+*/
+
+TEST_CASE("ProgressiveAligner rejects invalid guide trees") {
+    ProgressiveAligner aligner(
+        ScoringParams(ScoringParams::exp_probA(0.01),
+                      ScoringParams::exp_probB(0.01)),
+        ProgressiveAlignerParams());
+
+    std::vector<ProgressiveAligner::profile_t> leaves(3);
+
+    // too few merge steps
+    REQUIRE_THROWS(aligner.align(leaves, {{0, 1}}));
+    // node used twice
+    REQUIRE_THROWS(aligner.align(leaves, {{0, 1}, {1, 2}}));
+    // reference to a later merge step
+    REQUIRE_THROWS(aligner.align(leaves, {{0, 4}, {1, 2}}));
+    // no leaves
+    REQUIRE_THROWS(aligner.align({}, {}));
+
+    // alifold consensus without folding parameters
+    REQUIRE_THROWS(ProgressiveAligner(
+        ScoringParams(ScoringParams::exp_probA(0.01),
+                      ScoringParams::exp_probB(0.01)),
+        ProgressiveAlignerParams(
+            ProgressiveAlignerParams::alifold_consensus(true))));
+}
+
+TEST_CASE("progressive alignment merges independent subtrees in parallel") {
+    PFoldParams pfoldparams(PFoldParams::args::noLP(true),
+                            PFoldParams::args::stacking(false));
+
+    MultipleAlignment ma("archaea.aln");
+    REQUIRE(ma.num_of_rows() >= 4);
+
+    std::vector<ProgressiveAligner::profile_t> leaves;
+    for (size_t i = 0; i < 4; i++) {
+        std::string seqstr = ma.seqentry(i).seq().str();
+        seqstr.erase(std::remove(seqstr.begin(), seqstr.end(), '-'),
+                     seqstr.end());
+        RnaEnsemble ensemble(Sequence(ma.seqentry(i).name(), seqstr),
+                             pfoldparams, false, true);
+        leaves.push_back(
+            std::make_shared<RnaData>(ensemble, 0.01, 0, pfoldparams));
+    }
+
+    // balanced tree ((0,1),(2,3))
+    ProgressiveAligner::tree_t tree = {{0, 1}, {2, 3}, {4, 5}};
+
+    auto scoring_params = ScoringParams(ScoringParams::exp_probA(0.01),
+                                        ScoringParams::exp_probB(0.01));
+
+    ProgressiveAligner sequential(scoring_params, ProgressiveAlignerParams());
+    ProgressiveAligner parallel(scoring_params,
+                                ProgressiveAlignerParams(
+                                    ProgressiveAlignerParams::threads(4)));
+
+    auto root1 = sequential.align(leaves, tree);
+    auto root2 = parallel.align(leaves, tree);
+
+    const MultipleAlignment &ma1 = root1->multiple_alignment();
+    const MultipleAlignment &ma2 = root2->multiple_alignment();
+
+    REQUIRE(ma1.num_of_rows() == 4);
+    for (size_t i = 0; i < 4; i++) {
+        REQUIRE(ma1.contains(ma.seqentry(i).name()));
+        REQUIRE(ma1.seqentry(i).seq().str() == ma2.seqentry(i).seq().str());
+    }
+    REQUIRE(sequential.scores() == parallel.scores());
+}
+
+TEST_CASE("progressive alignment computes alifold consensus in memory") {
+    PFoldParams pfoldparams(PFoldParams::args::noLP(true),
+                            PFoldParams::args::stacking(false));
+
+    MultipleAlignment ma("archaea.aln");
+    REQUIRE(ma.num_of_rows() >= 3);
+
+    std::vector<ProgressiveAligner::profile_t> leaves;
+    for (size_t i = 0; i < 3; i++) {
+        std::string seqstr = ma.seqentry(i).seq().str();
+        seqstr.erase(std::remove(seqstr.begin(), seqstr.end(), '-'),
+                     seqstr.end());
+        RnaEnsemble ensemble(Sequence(ma.seqentry(i).name(), seqstr),
+                             pfoldparams, false, true);
+        leaves.push_back(
+            std::make_shared<RnaData>(ensemble, 0.01, 0, pfoldparams));
+    }
+
+    ProgressiveAligner::tree_t tree = {{0, 1}, {2, 3}};
+
+    ProgressiveAligner aligner(
+        ScoringParams(ScoringParams::exp_probA(0.01),
+                      ScoringParams::exp_probB(0.01)),
+        ProgressiveAlignerParams(
+            ProgressiveAlignerParams::alifold_consensus(true),
+            ProgressiveAlignerParams::pfoldparams(&pfoldparams)));
+
+    auto root = aligner.align(leaves, tree);
+    const MultipleAlignment &root_ma = root->multiple_alignment();
+    REQUIRE(root_ma.num_of_rows() == 3);
+
+    // the root profile equals folding its alignment by alifold
+    RnaEnsemble ensemble(root_ma, pfoldparams, false, true);
+    RnaData expected(ensemble, root->arc_cutoff_prob(), 0, pfoldparams);
+
+    const size_t length = root_ma.length();
+    for (size_t i = 1; i <= length; i++) {
+        for (size_t j = i + 1; j <= length; j++) {
+            REQUIRE(root->arc_prob(i, j) ==
+                    Approx(expected.arc_prob(i, j)));
+        }
+    }
+}
+
+TEST_CASE("iterative refinement does not depend on the number of threads") {
+    PFoldParams pfoldparams(PFoldParams::args::noLP(true),
+                            PFoldParams::args::stacking(false));
+
+    MultipleAlignment ma("archaea.aln");
+    REQUIRE(ma.num_of_rows() >= 5);
+
+    std::vector<ProgressiveAligner::profile_t> leaves;
+    for (size_t i = 0; i < 5; i++) {
+        std::string seqstr = ma.seqentry(i).seq().str();
+        seqstr.erase(std::remove(seqstr.begin(), seqstr.end(), '-'),
+                     seqstr.end());
+        RnaEnsemble ensemble(Sequence(ma.seqentry(i).name(), seqstr),
+                             pfoldparams, false, true);
+        leaves.push_back(
+            std::make_shared<RnaData>(ensemble, 0.01, 0, pfoldparams));
+    }
+
+    // caterpillar tree ((((0,1),2),3),4)
+    ProgressiveAligner::tree_t tree = {{0, 1}, {2, 5}, {3, 6}, {4, 7}};
+
+    auto scoring_params = ScoringParams(ScoringParams::exp_probA(0.01),
+                                        ScoringParams::exp_probB(0.01));
+
+    ProgressiveAligner sequential(scoring_params, ProgressiveAlignerParams());
+    ProgressiveAligner parallel(scoring_params,
+                                ProgressiveAlignerParams(
+                                    ProgressiveAlignerParams::threads(3)));
+
+    auto root = sequential.align(leaves, tree);
+    double mfe = alifold_mfe(root->multiple_alignment(), pfoldparams);
+
+    auto refined1 = sequential.refine(leaves, tree, root, pfoldparams, 2);
+    auto refined2 = parallel.refine(leaves, tree, root, pfoldparams, 2);
+
+    const MultipleAlignment &ma1 = refined1->multiple_alignment();
+    const MultipleAlignment &ma2 = refined2->multiple_alignment();
+
+    REQUIRE(ma1.num_of_rows() == 5);
+    REQUIRE(ma2.num_of_rows() == 5);
+    for (size_t i = 0; i < 5; i++) {
+        const std::string &name = ma.seqentry(i).name();
+        REQUIRE(ma1.contains(name));
+        REQUIRE(ma1.seqentry(name).seq().str() ==
+                ma2.seqentry(name).seq().str());
+    }
+
+    // refinement accepts only improvements
+    REQUIRE(alifold_mfe(ma1, pfoldparams) <= mfe);
+}
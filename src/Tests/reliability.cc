@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/reliability.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for ReliabilityProfile
+*/
+
+TEST_CASE("ReliabilityProfile computes reliabilities of alignment columns") {
+    MultipleAlignment ma;
+    ma.append(MultipleAlignment::SeqEntry("a", "GGAAAACC"));
+    ma.append(MultipleAlignment::SeqEntry("b", "GG-AAACC"));
+
+    MatchProbSets probs(2);
+    // matches of b and a; positions of b first
+    probs.base_matches(1, 0) = {{1, 1, 0.9}, {3, 4, 0.5}, {3, 3, 0.2}};
+    probs.arc_matches(1, 0) = {
+        {1, 7, 1, 8, 0.8}, {2, 6, 2, 7, 0.4}, {2, 5, 2, 5, 0.3}};
+    // matches of a and b
+    probs.base_matches(0, 1) = {{1, 1, 0.9}, {4, 3, 0.5}, {3, 3, 0.2}};
+    probs.arc_matches(0, 1) = {
+        {1, 8, 1, 7, 0.8}, {2, 7, 2, 6, 0.4}, {2, 5, 2, 5, 0.3}};
+
+    SECTION("consensus profile counts matches of the alignment") {
+        ReliabilityProfile profile(ma, probs);
+        REQUIRE(profile.length() == 8);
+
+        const auto &seq = profile.sequence_reliabilities();
+        const auto &str = profile.structure_reliabilities();
+        REQUIRE(seq[1] == Approx(0.9));
+        REQUIRE(seq[3] == 0.0);
+        REQUIRE(seq[4] == Approx(0.5));
+        REQUIRE(str[1] == Approx(0.8));
+        REQUIRE(str[7] == Approx(0.4));
+        REQUIRE(str[5] == 0.0);
+
+        const auto &arcs = profile.arc_reliabilities();
+        REQUIRE(arcs.size() == 2);
+        REQUIRE(arcs.at({1, 8}) == Approx(0.8));
+        REQUIRE(arcs.at({2, 7}) == Approx(0.4));
+
+        auto mws = profile.max_weight_structure(1, 0.5);
+        REQUIRE(mws.first == Approx(1.2));
+        REQUIRE(mws.second == "({....})");
+
+        std::ostringstream out;
+        profile.write_bm_reliabilities(out);
+        REQUIRE(out.str().substr(0, 10) == "1 0.9 0.8\n");
+    }
+
+    SECTION("single sequence profile includes the base pair probabilities") {
+        ReliabilityProfile::arc_reliabilities_t pair_probs;
+        pair_probs[{1, 8}] = 0.6;
+
+        ReliabilityProfile profile(ma, probs, 0, pair_probs);
+
+        REQUIRE(profile.sequence_reliabilities()[4] == Approx(0.5));
+        REQUIRE(profile.arc_reliabilities().at({1, 8}) == Approx(0.7));
+        REQUIRE(profile.arc_reliabilities().at({2, 7}) == Approx(0.2));
+    }
+
+    SECTION("short arcs do not occur in the maximum reliability structure") {
+        MatchProbSets short_probs(2);
+        short_probs.arc_matches(1, 0) = {{3, 5, 4, 6, 0.9}};
+        ReliabilityProfile profile(ma, short_probs);
+        REQUIRE(profile.arc_reliabilities().size() == 1);
+        REQUIRE(profile.max_weight_structure(1, 0.125).second == "........");
+    }
+
+    SECTION("single row alignments are rejected") {
+        MultipleAlignment single("a", "GGAAAACC");
+        REQUIRE_THROWS(ReliabilityProfile(single, MatchProbSets(1)));
+    }
+}
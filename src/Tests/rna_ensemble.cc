@@ -6,6 +6,7 @@
 #include <../LocARNA/rna_ensemble.hh>
 #include <../LocARNA/basepairs.hh>
 #include <../LocARNA/pfold_params.hh>
+#include <../LocARNA/folding_context.hh>
 
 #include <memory>
 
@@ -170,6 +171,41 @@ TEST_CASE("base pair probabilities can be predicted") {
 }
 
 
+TEST_CASE("folding context reproduces ensemble probabilities") {
+    PFoldParams pfoldparams(PFoldParams::args::noLP(true),
+                            PFoldParams::args::stacking(true));
+    FoldingContext context(pfoldparams);
+
+    // fold several sequences of different length with the same context
+    std::string testseqstrs[] = {"CCCCAGGAAAACCGGAAAACCAGGGG",
+                                 "GGGAAAUCCCGCGAAAGCGUUUCCC",
+                                 "CCCCAGGAAAACCGGAAAACCAGGGG"};
+
+    for (const auto &testseqstr : testseqstrs) {
+        Sequence seq;
+        seq.append(Sequence::SeqEntry("test", testseqstr));
+
+        RnaEnsemble rna_ensemble(seq, pfoldparams, true, false);
+        RnaEnsemble ctx_rna_ensemble(seq, context, true, false);
+
+        REQUIRE(ctx_rna_ensemble.min_free_energy() ==
+                rna_ensemble.min_free_energy());
+
+        size_t len = seq.length();
+        for (size_t i = 1; i <= len; i++) {
+            for (size_t j = i + TURN + 1; j <= len; j++) {
+                REQUIRE(ctx_rna_ensemble.arc_prob(i, j) ==
+                        Approx(rna_ensemble.arc_prob(i, j)));
+                if (j >= i + TURN + 3) {
+                    REQUIRE(ctx_rna_ensemble.arc_2_prob(i, j) ==
+                            Approx(rna_ensemble.arc_2_prob(i, j)));
+                }
+            }
+        }
+        test_in_loop_probs(seq, ctx_rna_ensemble);
+    }
+}
+
 TEST_CASE("in loop probabilities can be predicted") {
     SECTION("in loop probs are predicted for single sequences") {
         std::string testseqstr = "CCCCAGGAAAACCGGAAAACCAGGGG";
@@ -270,3 +306,38 @@ TEST_CASE("maxBPspan limits base pair span of predictions") {
         }
     }
 }
+
+TEST_CASE("local folding predicts base pairs within the span") {
+    std::string testseqstr =
+        "GGAGGAUUAGCUCAGCUGGGAGAGCAUCUGCCUUACAAGCAGAGGGUCGGCGGUUCGAGCCCGUCAUC"
+        "CUCCAGCGGAUAUAACUUAGGGGUUAAAGUUGCAGAUUGUGGCUCUGAAAACACGGGUUCGAAUCCCG"
+        "UUAUUCGCC";
+    Sequence seq;
+    seq.append(Sequence::SeqEntry("test", testseqstr));
+
+    size_t span = 40;
+
+    PFoldParams pfoldparams(PFoldParams::args::noLP(true),
+                            PFoldParams::args::stacking(true),
+                            PFoldParams::args::max_bp_span((int)span),
+                            PFoldParams::args::window_size(2 * (int)span));
+
+    REQUIRE(pfoldparams.local_folding());
+
+    SECTION("base pair and stacking probabilities are available") {
+        std::unique_ptr<RnaEnsemble> rna_ensemble;
+        REQUIRE_NOTHROW(rna_ensemble = std::make_unique<RnaEnsemble>(
+                            seq, pfoldparams, false, false));
+        REQUIRE(rna_ensemble->local_folding());
+        REQUIRE(rna_ensemble->has_stacking_probs());
+        REQUIRE(!rna_ensemble->has_in_loop_probs());
+        REQUIRE(rna_ensemble->max_bp_span() == span);
+
+        test_maxBPspan(rna_ensemble.get(), span);
+    }
+
+    SECTION("in loop probabilities are rejected") {
+        REQUIRE_THROWS(
+            std::make_unique<RnaEnsemble>(seq, pfoldparams, true, false));
+    }
+}
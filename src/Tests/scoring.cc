@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "fixed_structure_data.hh"
+
+#include <string>
+#include <vector>
+
+#include <../LocARNA/anchor_constraints.hh>
+#include <../LocARNA/arc_matches.hh>
+#include <../LocARNA/ribosum.hh>
+#include <../LocARNA/ribosum85_60.icc>
+#include <../LocARNA/scoring.hh>
+#include <../LocARNA/trace_controller.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for the base match scores of Scoring
+*/
+
+namespace {
+    //! scoring that gives access to the similarity of two columns by
+    //! their pairs of rows
+    class ColumnScoring : public PFScoring<double> {
+    public:
+        using PFScoring<double>::PFScoring;
+        using PFScoring<double>::boltzmann_weight;
+        using Scoring::sigma_;
+    };
+}
+
+TEST_CASE("Scoring computes the base match scores of the row pairs") {
+    // columns with gaps, N and other symbols; some columns have equal
+    // profiles in different orders of the rows
+    auto rna_dataA = fixed_structure_data(
+        std::vector<std::string>{"ACGU-NAC-GUYACGU", "CAGUUNACGGU-ACTU",
+                                 "AYG-RNCAGGUAAC-U"},
+        "((((......))))..");
+    auto rna_dataB = fixed_structure_data(
+        std::vector<std::string>{"AC-UNGGUACRA", "CAGU-GGUCA-A"},
+        "((....))....");
+
+    const Sequence &seqA = rna_dataA->sequence();
+    const Sequence &seqB = rna_dataB->sequence();
+    size_t lenA = seqA.length();
+    size_t lenB = seqB.length();
+
+    AnchorConstraints constraints(lenA, "", lenB, "", true);
+    TraceController trace_controller(seqA, seqB, nullptr, -1);
+    ArcMatches arc_matches(*rna_dataA, *rna_dataB, 0.01, std::max(lenA, lenB),
+                           std::max(lenA, lenB), trace_controller,
+                           constraints);
+
+    Ribosum85_60 ribosum;
+
+    for (const RibosumFreq *ribo : {(const RibosumFreq *)nullptr,
+                                    (const RibosumFreq *)&ribosum}) {
+        ScoringParams scoring_params(
+            ScoringParams::match(50), ScoringParams::mismatch(-20),
+            ScoringParams::ribosum(ribo),
+            ScoringParams::exp_probA(prob_exp_f(lenA)),
+            ScoringParams::exp_probB(prob_exp_f(lenB)));
+        ColumnScoring scoring(seqA, seqB, *rna_dataA, *rna_dataB, arc_matches,
+                              nullptr, scoring_params);
+
+        for (size_t i = 1; i <= lenA; i++) {
+            for (size_t j = 1; j <= lenB; j++) {
+                score_t sigma = scoring.sigma_(i, j);
+                REQUIRE(scoring.basematch(i, j) == sigma);
+                REQUIRE(scoring.exp_basematch(i, j) ==
+                        scoring.boltzmann_weight(sigma));
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include <../LocARNA/multiple_alignment.hh>
+#include <../LocARNA/tcoffee_library.hh>
+
+using namespace LocARNA;
+
+/** @file some unit tests for TCoffeeLibrary
+*/
+
+TEST_CASE("TCoffeeLibrary builds and extends libraries") {
+    TCoffeeLibrary lib({"a", "b", "c"}, {"ACGU", "ACU", "AGU"});
+
+    MultipleAlignment ab;
+    ab.append(MultipleAlignment::SeqEntry("a", "ACGU"));
+    ab.append(MultipleAlignment::SeqEntry("b", "AC-U"));
+    lib.add_alignment(ab, 10);
+
+    MultipleAlignment ac;
+    ac.append(MultipleAlignment::SeqEntry("c", "A-GU"));
+    ac.append(MultipleAlignment::SeqEntry("a", "ACGU"));
+    lib.add_alignment(ac, 20);
+
+    MultipleAlignment bc;
+    bc.append(MultipleAlignment::SeqEntry("b", "AC-U"));
+    bc.append(MultipleAlignment::SeqEntry("c", "A-GU"));
+    lib.add_alignment(bc, 5);
+
+    SECTION("primary library holds the matches in both orders") {
+        REQUIRE(lib.size() == 3 + 3 + 2);
+        REQUIRE(lib.weight(0, 1, 4, 3) == 10);
+        REQUIRE(lib.weight(1, 0, 3, 4) == 10);
+        REQUIRE(lib.weight(0, 2, 3, 2) == 20);
+        REQUIRE(lib.weight(0, 1, 3, 3) == 0);
+
+        auto row = lib.row(0, 1, 3);
+        REQUIRE(row.first == row.second);
+
+        lib.add_alignment(ab, 1);
+        REQUIRE(lib.weight(0, 1, 4, 3) == 11);
+    }
+
+    SECTION("extension adds consistent triplets") {
+        auto ext = lib.extend();
+        // direct weight plus min(w_ac(4,3), w_cb(3,3))
+        REQUIRE(ext.weight(0, 1, 4, 3) == 10 + 5);
+        REQUIRE(ext.weight(1, 0, 3, 4) == 10 + 5);
+        // a:2 matches only b:2, which does not match c
+        REQUIRE(ext.weight(0, 2, 2, 1) == 0);
+        REQUIRE(ext.weight(0, 2, 1, 1) == 20 + 5);
+        REQUIRE(ext.weight(1, 2, 1, 1) == 5 + 10);
+
+        SECTION("extension does not depend on the number of threads") {
+            auto ext4 = lib.extend(4);
+            std::ostringstream out1;
+            std::ostringstream out4;
+            ext.write_binary(out1);
+            ext4.write_binary(out4);
+            REQUIRE(out1.str() == out4.str());
+        }
+    }
+
+    SECTION("library is written in T-Coffee format") {
+        std::ostringstream out;
+        lib.write(out);
+        REQUIRE(out.str().substr(0, 33) ==
+                "! TC_LIB_FORMAT_01\n3\na 4 ACGU\nb 3");
+        REQUIRE(out.str().find("#1 2\n1 1 10\n2 2 10\n4 3 10\n") !=
+                std::string::npos);
+    }
+
+    SECTION("binary format can be read back") {
+        std::stringstream io;
+        lib.write_binary(io);
+        auto lib2 = TCoffeeLibrary::read_binary(io);
+        REQUIRE(lib2.names() == lib.names());
+        REQUIRE(lib2.size() == lib.size());
+        REQUIRE(lib2.weight(2, 0, 2, 3) == 20);
+
+        std::istringstream bad("no library");
+        REQUIRE_THROWS(TCoffeeLibrary::read_binary(bad));
+    }
+
+    SECTION("alignments of unknown or differing sequences are rejected") {
+        MultipleAlignment ad;
+        ad.append(MultipleAlignment::SeqEntry("a", "ACGU"));
+        ad.append(MultipleAlignment::SeqEntry("d", "ACGU"));
+        REQUIRE_THROWS(lib.add_alignment(ad, 1));
+
+        MultipleAlignment ab2;
+        ab2.append(MultipleAlignment::SeqEntry("a", "ACGU"));
+        ab2.append(MultipleAlignment::SeqEntry("b", "ACGU"));
+        REQUIRE_THROWS(lib.add_alignment(ab2, 1));
+    }
+}
@@ -2,9 +2,13 @@
 // Copyright Sebastian Will
 
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
 #include "LocARNA/multiple_alignment.hh"
+#include "LocARNA/alignment_comparison.hh"
 
 using namespace LocARNA;
 
@@ -16,11 +20,13 @@ usage() {
         << "locarna_deviation - compare an alignment to a reference alignment"
         << std::endl
         << std::endl
-        << "Usage: deviation <aln-file> <ref-aln-file>" << std::endl
+        << "Usage: deviation <aln-file>... <ref-aln-file>" << std::endl
         << std::endl
         << "Options:" << std::endl
         << std::endl
         << " <aln-file>        alignment file in clustalw format" << std::endl
+        << "                   (several files are compared in one batch)"
+        << std::endl
         << std::endl
         << " <aln-ref-file>    reference alignment file in clustalw format"
         << std::endl
@@ -47,25 +53,45 @@ main(int argc, char **argv) {
         return 0;
     }
 
-    if (argc != 3) {
+    if (argc < 3) {
         usage();
         return -1;
     }
 
-    MultipleAlignment ma((std::string)argv[1]);
-    MultipleAlignment refma((std::string)argv[2]);
+    std::vector<MultipleAlignment> alignments;
+    for (int i = 1; i < argc - 1; i++) {
+        alignments.emplace_back((std::string)argv[i]);
+    }
+    MultipleAlignment refma((std::string)argv[argc - 1]);
+
+    AlignmentComparison comparison(
+        refma, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<AlignmentComparison::scores_t> scores;
+    try {
+        scores = comparison.compare(alignments);
+    } catch (failure &f) {
+        std::cerr << "ERROR: " << f.what() << std::endl;
+        return -1;
+    }
+
+    for (size_t i = 0; i < scores.size(); i++) {
+        if (scores.size() > 1) {
+            std::cout << "# " << argv[i + 1] << std::endl;
+        }
 
-    std::cout << "Deviation:     " << refma.deviation(ma) << std::endl;
+        std::cout << "Deviation:     " << scores[i].deviation << std::endl;
 
-    std::cout << "Realig. score: " << refma.cmfinder_realignment_score(ma)
-              << std::endl;
+        std::cout << "Realig. score: " << scores[i].realignment_score
+                  << std::endl;
 
-    std::cout << "Match SPS:     " << refma.sps(ma, false) << std::endl;
+        std::cout << "Match SPS:     " << scores[i].match_sps << std::endl;
 
-    std::cout << "Compalign SPS: " << refma.sps(ma, true) << std::endl;
+        std::cout << "Compalign SPS: " << scores[i].compalign_sps
+                  << std::endl;
 
-    std::cout << "Deviation SPS: " << refma.avg_deviation_score(ma)
-              << std::endl;
+        std::cout << "Deviation SPS: " << scores[i].deviation_sps
+                  << std::endl;
+    }
 
     return 0;
 }
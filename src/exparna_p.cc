@@ -38,6 +38,7 @@
 
 #include "LocARNA/exact_matcher.hh"
 #include "LocARNA/sparsification_mapper.hh"
+#include "LocARNA/sparse_sequence_index.hh"
 #include "LocARNA/pfold_params.hh"
 #include "LocARNA/global_stopwatch.hh"
 
@@ -64,6 +65,7 @@ struct command_line_parameters {
     bool no_stacking;
 
     bool stopwatch;
+    int threads; //!< number of threads for computing and tracing the EPMs
 
     double min_prob; // only pairs with a probability of at least min_prob are
                      // taken into account
@@ -244,6 +246,9 @@ option_def my_options[] =
      {"", 0, 0, O_SECTION, 0, O_NODEFAULT, "", "Miscellaneous"},
      {"stopwatch", 0, &clp.stopwatch, O_NO_ARG, 0, O_NODEFAULT, "",
       "Print run time information."},
+     {"threads", 0, 0, O_ARG_INT, &clp.threads, "1", "threads",
+      "Number of threads for computing the arc match scores and for the "
+      "heuristic traceback"},
 
      {"", 0, 0, O_SECTION, 0, O_NODEFAULT, "", "Input files"},
      {"", 0, 0, O_ARG_STRING, &clp.fileA, O_NODEFAULT, "Input 1",
@@ -415,37 +420,31 @@ main(int argc, char **argv) {
     // construct set of relevant arc matches
     //
 
-    // initialize from RnaData
+    // the sparsification data of each sequence (base pairs and the
+    // datastructures to handle sparse matrices); the arc matches share
+    // the base pairs
+    SparseSequenceIndex indexA(*rna_dataA, clp.min_prob,
+                               clp.prob_unpaired_in_loop_threshold,
+                               clp.prob_basepair_in_loop_threshold, false);
+    SparseSequenceIndex indexB(*rna_dataB, clp.min_prob,
+                               clp.prob_unpaired_in_loop_threshold,
+                               clp.prob_basepair_in_loop_threshold, false);
+
     std::unique_ptr<ArcMatches> arc_matches = std::make_unique<ArcMatches>(
-        *rna_dataA, *rna_dataB, clp.min_prob,
+        indexA.base_pairs(), indexB.base_pairs(),
         (clp.max_diff_am != -1) ? (size_type)clp.max_diff_am
                                 : std::max(seqA.length(), seqB.length()),
         (clp.max_diff_at_am != -1) ? (size_type)clp.max_diff_at_am
                                    : std::max(seqA.length(), seqB.length()),
         trace_controller, seq_constraints);
 
-    const BasePairs &bpsA = arc_matches->get_base_pairsA();
-    const BasePairs &bpsB = arc_matches->get_base_pairsB();
-
     // ----------------------------------------
     // report on input in verbose mode
     if (clp.verbose)
         MainHelper::report_input(seqA, seqB, *arc_matches);
 
-    // ------------------------------------------------------------
-    // construct datastructures to handle sparse matrices
-    //
-
-    // time_t start_mapping = time (NULL);
-    SparsificationMapper sparse_mapperA(bpsA, *rna_dataA,
-                                        clp.prob_unpaired_in_loop_threshold,
-                                        clp.prob_basepair_in_loop_threshold,
-                                        false);
-
-    SparsificationMapper sparse_mapperB(bpsB, *rna_dataB,
-                                        clp.prob_unpaired_in_loop_threshold,
-                                        clp.prob_basepair_in_loop_threshold,
-                                        false);
+    const SparsificationMapper &sparse_mapperA = indexA.mapper();
+    const SparsificationMapper &sparse_mapperB = indexB.mapper();
 
     SparseTraceController sparse_trace_controller(sparse_mapperA,
                                                   sparse_mapperB,
@@ -457,7 +456,8 @@ main(int argc, char **argv) {
                     sparse_trace_controller, myEPMs, clp.alpha_1, clp.alpha_2,
                     clp.alpha_3, clp.difference_to_opt_score, clp.min_score,
                     clp.number_of_EPMs, clp.inexact_struct_match,
-                    clp.struct_mismatch_score, clp.add_filter, clp.verbose);
+                    clp.struct_mismatch_score, clp.add_filter, clp.verbose,
+                    std::max(1, clp.threads));
 
 #ifndef NDEBUG
     if (clp.verbose)
@@ -484,11 +484,31 @@ main(int argc, char **argv) {
                 cout << endl << "start heuristic traceback..." << endl;
         }
 
+        // without chaining, the EPMs are only written; then stream them
+        // to the output file instead of storing them
+        ofstream out_EPM_stream;
+        std::unique_ptr<EPMListWriter> epm_writer;
+        if (clp.no_chaining && clp.epm_list_output.size() > 0) {
+            if (clp.verbose) {
+                cout << "stream list of traced EPMs to file..." << endl;
+            }
+            out_EPM_stream.open(clp.epm_list_output.c_str());
+            epm_writer = std::make_unique<EPMListWriter>(out_EPM_stream);
+            em.set_epm_writer(epm_writer.get());
+        }
+
         em.trace_EPMs(clp.subopt);
 
         stopwatch.stop("EPMcomp");
 
-        if (clp.epm_list_output.size() > 0) {
+        if (epm_writer) {
+            out_EPM_stream << endl;
+            out_EPM_stream.close();
+            if (clp.verbose) {
+                cout << "wrote " << epm_writer->size() << " EPMs, skipped "
+                     << epm_writer->duplicates() << " duplicates" << endl;
+            }
+        } else if (clp.epm_list_output.size() > 0) {
             if (clp.verbose) {
                 cout << "write list of traced EPMs in file..." << endl;
             }
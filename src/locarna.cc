@@ -21,11 +21,13 @@
 #include "LocARNA/alignment.hh"
 #include "LocARNA/aligner.hh"
 #include "LocARNA/rna_data.hh"
+#include "LocARNA/ext_rna_data.hh"
 #include "LocARNA/arc_matches.hh"
 #include "LocARNA/edge_probs.hh"
 #include "LocARNA/ribosum.hh"
 #include "LocARNA/ribofit.hh"
 #include "LocARNA/anchor_constraints.hh"
+#include "LocARNA/epm_anchors.hh"
 #include "LocARNA/trace_controller.hh"
 #include "LocARNA/global_stopwatch.hh"
 #include "LocARNA/pfold_params.hh"
@@ -74,6 +76,10 @@ struct command_line_parameters
     int normalized_L; //!< normalized_L
 
     bool score_components; //!< whether to report score components
+
+    //! whether to anchor at the best chain of exact pattern matches
+    bool epm_anchors;
+    int epm_min_score; //!< minimal score of exact pattern matches
 };
 
 //! \brief holds command line parameters of locarna
@@ -254,6 +260,11 @@ option_def my_options[] =
       clp.help_text["max_bp_span"]},
      {"relaxed-anchors", 0, &clp.relaxed_anchors, O_NO_ARG, 0, O_NODEFAULT, "",
       clp.help_text["relaxed_anchors"]},
+     {"epm-anchors", 0, &clp.epm_anchors, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Anchor the alignment at the best chain of exact pattern matches, "
+      "like ExpLoc-P (replaces anchors of the input)"},
+     {"epm-min-score", 0, 0, O_ARG_INT, &clp.epm_min_score, "90", "score",
+      "Minimal score of exact pattern matches for --epm-anchors"},
 
      {"", 0, 0, O_SECTION_HIDE, 0, O_NODEFAULT, "", "Hidden Options"},
 
@@ -462,11 +473,28 @@ run_and_report() {
                             PFoldParams::args::stacking(clp.stacking || clp.new_stacking),
                             PFoldParams::args::max_bp_span(clp.max_bp_span));
 
+    // parameters of the anchoring by exact pattern matches, which
+    // also determine the in loop probabilities of the RNA data
+    EPMAnchorParams epm_anchor_params(
+        EPMAnchorParams::min_score(clp.epm_min_score),
+        EPMAnchorParams::relaxed_anchors(clp.relaxed_anchors),
+        EPMAnchorParams::quiet(!clp.verbose));
+
     std::unique_ptr<RnaData> rna_dataA;
     try {
-        rna_dataA =
-            std::make_unique<RnaData>(clp.fileA, clp.min_prob,
-                                      clp.max_bps_length_ratio, pfoldparams);
+        if (clp.epm_anchors) {
+            // anchoring requires in loop probabilities
+            rna_dataA = std::make_unique<ExtRnaData>(
+                clp.fileA, clp.min_prob,
+                epm_anchor_params.prob_basepair_in_loop_threshold_,
+                epm_anchor_params.prob_unpaired_in_loop_threshold_,
+                clp.max_bps_length_ratio,
+                epm_anchor_params.max_uil_length_ratio_,
+                epm_anchor_params.max_bpil_length_ratio_, pfoldparams);
+        } else {
+            rna_dataA = std::make_unique<RnaData>(
+                clp.fileA, clp.min_prob, clp.max_bps_length_ratio, pfoldparams);
+        }
     } catch (failure &f) {
         std::cerr << "ERROR:\tfailed to read from file " << clp.fileA
                   << std::endl
@@ -476,9 +504,19 @@ run_and_report() {
 
     std::unique_ptr<RnaData> rna_dataB;
     try {
-        rna_dataB =
-            std::make_unique<RnaData>(clp.fileB, clp.min_prob,
-                                      clp.max_bps_length_ratio, pfoldparams);
+        if (clp.epm_anchors) {
+            // anchoring requires in loop probabilities
+            rna_dataB = std::make_unique<ExtRnaData>(
+                clp.fileB, clp.min_prob,
+                epm_anchor_params.prob_basepair_in_loop_threshold_,
+                epm_anchor_params.prob_unpaired_in_loop_threshold_,
+                clp.max_bps_length_ratio,
+                epm_anchor_params.max_uil_length_ratio_,
+                epm_anchor_params.max_bpil_length_ratio_, pfoldparams);
+        } else {
+            rna_dataB = std::make_unique<RnaData>(
+                clp.fileB, clp.min_prob, clp.max_bps_length_ratio, pfoldparams);
+        }
     } catch (failure &f) {
         std::cerr << "ERROR: failed to read from file " << clp.fileB
                   << std::endl
@@ -546,6 +584,23 @@ run_and_report() {
                                                 alistr[0], alistr[1]);
     }
 
+    // ------------------------------------------------------------
+    // Anchor at the best chain of exact pattern matches (optionally)
+    //
+    if (clp.epm_anchors) {
+        stopwatch.start("EPManchors");
+        // the stacking score requires stacking probabilities
+        if (!rna_dataA->has_stacking() || !rna_dataB->has_stacking()) {
+            epm_anchor_params.alpha_3_ = 0;
+        }
+        auto anchors = epm_anchor_annotation(
+            static_cast<const ExtRnaData &>(*rna_dataA),
+            static_cast<const ExtRnaData &>(*rna_dataB), epm_anchor_params);
+        rna_dataA->set_anchors(anchors.first);
+        rna_dataB->set_anchors(anchors.second);
+        stopwatch.stop("EPManchors");
+    }
+
     // ------------------------------------------------------------
     // Handle constraints (optionally)
 
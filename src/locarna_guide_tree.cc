@@ -0,0 +1,218 @@
+/************************************************************
+ *
+ * \file locarna_guide_tree.cc
+ * \brief Construct a guide tree from a matrix of pairwise scores.
+ *
+ * Reads a square matrix of pairwise similarities (e.g. the
+ * result.matrix of mlocarna) or distances and writes the UPGMA or
+ * neighbor-joining tree in NEWICK format. The matrix is kept in
+ * packed triangular form.
+ *
+ * This program is part of the LocARNA package.
+ *
+ ************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include <LocARNA/options.hh>
+#include <LocARNA/aux.hh>
+#include <LocARNA/guide_tree.hh>
+
+using namespace LocARNA;
+
+/**
+ * \brief Structure for command line parameters
+ *
+ * Encapsulating all command line parameters in a common structure
+ * avoids name conflicts and makes downstream code more informative.
+ *
+ */
+struct command_line_parameters {
+    bool help;               //!< whether to print help
+    bool version;            //!< whether to print version
+    bool neighbor_joining;   //!< whether to use neighbor-joining
+    bool distances;          //!< whether the matrix contains distances
+    std::string names_file;  //!< file of leaf names
+    std::string matrix_file; //!< input matrix file
+};
+//! \brief holds command line parameters
+command_line_parameters clp;
+// longname,shortname,flag,arg_type,argument,default,argname,description
+//! defines command line parameters
+option_def my_options[] =
+    {{"help", 'h', &clp.help, O_NO_ARG, 0, O_NODEFAULT, "", "Help"},
+     {"version", 'V', &clp.version, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Version info"},
+     {"nj", 0, &clp.neighbor_joining, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Construct tree by neighbor-joining (default: UPGMA)"},
+     {"distances", 0, &clp.distances, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Matrix contains distances (default: similarities)"},
+     {"names", 0, 0, O_ARG_STRING, &clp.names_file, "", "file",
+      "File of leaf names in matrix order (default: 1..N)"},
+     {"", 0, 0, O_ARG_STRING, &clp.matrix_file, "-", "matrix",
+      "Matrix file"},
+     {"", 0, 0, 0, 0, O_NODEFAULT, "", ""}};
+
+/**
+ * @brief Read square matrix into packed triangular matrix
+ *
+ * @param in input stream; one row per line
+ *
+ * @return lower triangle of the matrix
+ *
+ * The dimension is determined by the first row. Only entries (i,j)
+ * with j<i are kept; the matrix is assumed to be symmetric.
+ */
+GuideTree::matrix_t
+read_matrix(std::istream &in) {
+    std::string line;
+    std::vector<float> row;
+    GuideTree::matrix_t matrix;
+
+    size_t i = 0;
+    while (getline(in, line)) {
+        std::istringstream lin(line);
+        std::string token;
+        row.clear();
+        while (lin >> token) {
+            try {
+                row.push_back(std::stof(token));
+            } catch (std::exception &e) {
+                throw failure("Cannot parse matrix entry " + token + ".");
+            }
+        }
+        if (row.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            matrix = GuideTree::matrix_t(row.size());
+        }
+        if (row.size() != matrix.dim() || i >= matrix.dim()) {
+            throw failure("Matrix is not square.");
+        }
+        for (size_t j = 0; j < i; j++) {
+            matrix(i, j) = row[j];
+        }
+        i++;
+    }
+
+    if (i != matrix.dim()) {
+        throw failure("Matrix is not square.");
+    }
+
+    return matrix;
+}
+
+/**
+ * @brief Convert between similarities and distances
+ *
+ * @param matrix similarities or distances
+ *
+ * Maps x to max-x, where max is the maximum entry; this turns
+ * similarities to non-negative distances and vice versa.
+ */
+void
+invert_matrix(GuideTree::matrix_t &matrix) {
+    float max = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < matrix.dim(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            max = std::max(max, matrix(i, j));
+        }
+    }
+    for (size_t i = 0; i < matrix.dim(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            matrix(i, j) = max - matrix(i, j);
+        }
+    }
+}
+
+/**
+ * \brief Main method of executable locarna_guide_tree
+ *
+ * @param argc argument counter
+ * @param argv argument vector
+ *
+ * @return success
+ */
+int
+main(int argc, char **argv) {
+    bool process_success = process_options(argc, argv, my_options);
+
+    if (clp.help) {
+        std::cout << "locarna_guide_tree -- construct guide tree from "
+                     "pairwise similarities or distances"
+                  << std::endl;
+        print_help(argv[0], my_options);
+        return 0;
+    }
+
+    if (clp.version) {
+        std::cout << "locarna_guide_tree (" << PACKAGE_STRING << ")"
+                  << std::endl;
+        return 0;
+    }
+
+    if (!process_success) {
+        std::cerr << "ERROR --- " << O_error_msg << std::endl;
+        print_usage(argv[0], my_options);
+        return -1;
+    }
+
+    try {
+        GuideTree::matrix_t matrix;
+        if (clp.matrix_file == "-") {
+            matrix = read_matrix(std::cin);
+        } else {
+            std::ifstream in(clp.matrix_file.c_str());
+            if (!in.is_open()) {
+                throw failure("Cannot open file " + clp.matrix_file +
+                              " for reading.");
+            }
+            matrix = read_matrix(in);
+        }
+
+        std::vector<std::string> names;
+        if (clp.names_file != "") {
+            std::ifstream in(clp.names_file.c_str());
+            if (!in.is_open()) {
+                throw failure("Cannot open file " + clp.names_file +
+                              " for reading.");
+            }
+            std::string name;
+            while (in >> name) {
+                names.push_back(name);
+            }
+        } else {
+            for (size_t i = 0; i < matrix.dim(); i++) {
+                names.push_back(std::to_string(i + 1));
+            }
+        }
+
+        // UPGMA maximizes similarity; neighbor-joining requires distances
+        if (clp.distances != clp.neighbor_joining) {
+            invert_matrix(matrix);
+        }
+
+        GuideTree tree = clp.neighbor_joining
+            ? GuideTree::neighbor_joining(std::move(matrix))
+            : GuideTree::upgma(std::move(matrix));
+
+        tree.write_newick(std::cout, names) << std::endl;
+    } catch (failure &f) {
+        std::cerr << "ERROR: " << f.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -18,7 +18,10 @@
 #include "LocARNA/sequence.hh"
 #include "LocARNA/basepairs.hh"
 #include "LocARNA/aligner_p.hh"
+#include "LocARNA/aligner_np.hh"
 #include "LocARNA/rna_data.hh"
+#include "LocARNA/ext_rna_data.hh"
+#include "LocARNA/sparsification_mapper.hh"
 #include "LocARNA/arc_matches.hh"
 #include "LocARNA/edge_probs.hh"
 #include "LocARNA/ribosum.hh"
@@ -80,6 +83,16 @@ struct command_line_parameters
     double pf_scale;
 
     int temperature_alipf; //!< temperature for alignment partition functions
+
+    bool sparse; //!< sparsify the alignments like sparse
+
+    double prob_unpaired_in_loop_threshold; //!< threshold for
+                                            //! prob_unpaired_in_loop
+    double prob_basepair_in_loop_threshold; //!< threshold for
+                                            //! prob_basepair_in_loop
+
+    double max_uil_length_ratio;  // max unpaired in loop length ratio
+    double max_bpil_length_ratio; // max base pairs in loop length ratio
 };
 
 //! \brief holds command line parameters of locarna
@@ -170,6 +183,24 @@ option_def my_options[] =
       clp.help_text["max_diff_relax"]},
      {"min-trace-probability", 0, 0, O_ARG_DOUBLE, &clp.min_trace_probability,
       "1e-5", "probability", clp.help_text["min_trace_probability"]},
+     {"sparse", 0, &clp.sparse, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Compute the probabilities over the alignments of sparse, which "
+      "align only positions and base pairs with sufficient probabilities "
+      "in loops (ignores max-diff)"},
+     {"prob-unpaired-in-loop-threshold", 0, 0, O_ARG_DOUBLE,
+      &clp.prob_unpaired_in_loop_threshold, "0.00005", "threshold",
+      "Threshold for prob_unpaired_in_loop (with --sparse)"},
+     {"prob-basepair-in-loop-threshold", 0, 0, O_ARG_DOUBLE,
+      &clp.prob_basepair_in_loop_threshold, "0.0001", "threshold",
+      "Threshold for prob_basepair_in_loop (with --sparse)"},
+     {"max-uil-length-ratio", 0, 0, O_ARG_DOUBLE, &clp.max_uil_length_ratio,
+      "0.0", "factor",
+      "Maximal ratio of #unpaired bases in loops divided by sequence length "
+      "(def: no effect)"},
+     {"max-bpil-length-ratio", 0, 0, O_ARG_DOUBLE, &clp.max_bpil_length_ratio,
+      "0.0", "factor",
+      "Maximal ratio of #base pairs in loops divided by loop length (def: no "
+      "effect)"},
 
      {"", 0, 0, O_SECTION, 0, O_NODEFAULT, "", "Computed probabilities"},
 
@@ -271,6 +302,12 @@ main(int argc, char **argv) {
         return -1;
     }
 
+    if (clp.sparse && clp.fragment_match_probs != "") {
+        std::cerr << "Fragment match probabilities are not supported "
+                  << "with --sparse." << std::endl;
+        return -1;
+    }
+
     if (clp.stopwatch) {
         stopwatch.set_print_on_exit(true);
     }
@@ -295,6 +332,73 @@ main(int argc, char **argv) {
 }
 
 
+/**
+ * \brief Compute, report and write the probabilities of an aligner
+ *
+ * @param aligner aligner (AlignerP or AlignerNP)
+ *
+ * @return success
+ */
+template <class Aligner>
+int
+compute_probabilities(Aligner &aligner) {
+    if (clp.verbose) {
+        std::cout << "Run inside algorithm." << std::endl;
+    }
+
+    auto pf = aligner.align_inside();
+
+    if (!clp.quiet) {
+        std::cout << "Partition function: " << pf << std::endl;
+    }
+
+    if (clp.verbose) {
+        std::cout << "Run outside algorithm." << std::endl;
+    }
+
+    aligner.align_outside();
+
+    if (clp.verbose) {
+        std::cout << "Compute probabilities." << std::endl;
+    }
+
+    aligner.compute_arcmatch_probabilities();
+
+    if (clp.write_arcmatch_probs) {
+        if (clp.verbose) {
+            std::cout << "Write Arc-match probabilities to file "
+                      << clp.arcmatch_probs_file << "." << std::endl;
+        }
+        ofstream out(clp.arcmatch_probs_file.c_str());
+        if (out.good()) {
+            aligner.write_arcmatch_probabilities(out);
+        } else {
+            cerr << "Cannot write to " << clp.arcmatch_probs_file << "! Exit."
+                 << std::endl;
+            return -1;
+        }
+    }
+
+    aligner.compute_basematch_probabilities(clp.include_am_in_bm);
+
+    if (clp.write_basematch_probs) {
+        if (clp.verbose) {
+            std::cout << "Write Base-match probabilities to file "
+                      << clp.basematch_probs_file << "." << std::endl;
+        }
+        ofstream out(clp.basematch_probs_file.c_str());
+        if (out.good()) {
+            aligner.write_basematch_probabilities(out);
+        } else {
+            cerr << "Cannot write to " << clp.basematch_probs_file << "! Exit."
+                 << std::endl;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 template <typename pf_score_t>
 int
 run_and_report() {
@@ -312,9 +416,18 @@ run_and_report() {
 
     std::unique_ptr<RnaData> rna_dataA;
     try {
-        rna_dataA =
-            std::make_unique<RnaData>(clp.fileA, clp.min_prob,
-                                      clp.max_bps_length_ratio, pfoldparams);
+        if (clp.sparse) {
+            // sparsification requires the in loop probabilities
+            rna_dataA = std::make_unique<ExtRnaData>(
+                clp.fileA, clp.min_prob, clp.prob_basepair_in_loop_threshold,
+                clp.prob_unpaired_in_loop_threshold, clp.max_bps_length_ratio,
+                clp.max_uil_length_ratio, clp.max_bpil_length_ratio,
+                pfoldparams);
+        } else {
+            rna_dataA = std::make_unique<RnaData>(
+                clp.fileA, clp.min_prob, clp.max_bps_length_ratio,
+                pfoldparams);
+        }
     } catch (failure &f) {
         std::cerr << "ERROR: failed to read from file " << clp.fileA
                   << std::endl
@@ -324,9 +437,18 @@ run_and_report() {
 
     std::unique_ptr<RnaData> rna_dataB;
     try {
-        rna_dataB =
-            std::make_unique<RnaData>(clp.fileB, clp.min_prob,
-                                      clp.max_bps_length_ratio, pfoldparams);
+        if (clp.sparse) {
+            // sparsification requires the in loop probabilities
+            rna_dataB = std::make_unique<ExtRnaData>(
+                clp.fileB, clp.min_prob, clp.prob_basepair_in_loop_threshold,
+                clp.prob_unpaired_in_loop_threshold, clp.max_bps_length_ratio,
+                clp.max_uil_length_ratio, clp.max_bpil_length_ratio,
+                pfoldparams);
+        } else {
+            rna_dataB = std::make_unique<RnaData>(
+                clp.fileB, clp.min_prob, clp.max_bps_length_ratio,
+                pfoldparams);
+        }
     } catch (failure &f) {
         std::cerr << "ERROR: failed to read from file " << clp.fileB
                   << std::endl
@@ -463,6 +585,40 @@ run_and_report() {
     // Computation of the alignment score
     //
 
+    if (clp.sparse) {
+        // sparsification mapping of the loops by their left ends
+        SparsificationMapper mapperA(
+            arc_matches->get_base_pairsA(),
+            dynamic_cast<const ExtRnaData &>(*rna_dataA),
+            clp.prob_unpaired_in_loop_threshold,
+            clp.prob_basepair_in_loop_threshold, true);
+        SparsificationMapper mapperB(
+            arc_matches->get_base_pairsB(),
+            dynamic_cast<const ExtRnaData &>(*rna_dataB),
+            clp.prob_unpaired_in_loop_threshold,
+            clp.prob_basepair_in_loop_threshold, true);
+
+        using npparams_t = AlignerNPParams<pf_score_t>;
+        // initialize aligner-np object, which computes the probabilities
+        // over the sparsified alignments
+        AlignerNP<pf_score_t> aligner(
+            npparams_t(AlignerParams::seqA(&seqA), AlignerParams::seqB(&seqB),
+                       AlignerParams::scoring(&scoring),
+                       AlignerParams::trace_controller(&trace_controller),
+                       AlignerParams::constraints(&seq_constraints),
+                       typename npparams_t::min_am_prob(clp.min_am_prob),
+                       typename npparams_t::min_bm_prob(clp.min_bm_prob),
+                       typename npparams_t::pf_scale((pf_score_t)clp.pf_scale),
+                       typename npparams_t::sparsification_mapperA(&mapperA),
+                       typename npparams_t::sparsification_mapperB(&mapperB)));
+
+        int result = compute_probabilities(aligner);
+
+        stopwatch.stop("total");
+
+        return result;
+    }
+
     using apparams_t =  AlignerPParams<pf_score_t>;
     // initialize aligner-p object, which does the alignment computation
     AlignerP<pf_score_t> aligner(
@@ -476,58 +632,9 @@ run_and_report() {
                    typename apparams_t::min_bm_prob(clp.min_bm_prob),
                    typename apparams_t::pf_scale((pf_score_t)clp.pf_scale)));
 
-    if (clp.verbose) {
-        std::cout << "Run inside algorithm." << std::endl;
-    }
-
-    pf_score_t pf = aligner.align_inside();
-
-    if (!clp.quiet) {
-        std::cout << "Partition function: " << pf << std::endl;
-    }
-
-    if (clp.verbose) {
-        std::cout << "Run outside algorithm." << std::endl;
-    }
-
-    aligner.align_outside();
-
-    if (clp.verbose) {
-        std::cout << "Compute probabilities." << std::endl;
-    }
-
-    aligner.compute_arcmatch_probabilities();
-
-    if (clp.write_arcmatch_probs) {
-        if (clp.verbose) {
-            std::cout << "Write Arc-match probabilities to file "
-                      << clp.arcmatch_probs_file << "." << std::endl;
-        }
-        ofstream out(clp.arcmatch_probs_file.c_str());
-        if (out.good()) {
-            aligner.write_arcmatch_probabilities(out);
-        } else {
-            cerr << "Cannot write to " << clp.arcmatch_probs_file << "! Exit."
-                 << std::endl;
-            return -1;
-        }
-    }
-
-    aligner.compute_basematch_probabilities(clp.include_am_in_bm);
-
-    if (clp.write_basematch_probs) {
-        if (clp.verbose) {
-            std::cout << "Write Base-match probabilities to file "
-                      << clp.basematch_probs_file << "." << std::endl;
-        }
-        ofstream out(clp.basematch_probs_file.c_str());
-        if (out.good()) {
-            aligner.write_basematch_probabilities(out);
-        } else {
-            cerr << "Cannot write to " << clp.basematch_probs_file << "! Exit."
-                 << std::endl;
-            return -1;
-        }
+    int result = compute_probabilities(aligner);
+    if (result != 0) {
+        return result;
     }
 
     // ----------------------------------------
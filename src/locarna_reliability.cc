@@ -0,0 +1,262 @@
+/************************************************************
+ *
+ * \file locarna_reliability.cc
+ * \brief Compute reliability profiles of a multiple alignment.
+ *
+ * Reads a multiple alignment and the base and arc match
+ * probabilities of its sequences, as written by mlocarna
+ * --probabilistic (options --write-bm-probs and --write-am-probs),
+ * and writes the base match and arc match reliabilities, reliability
+ * dot plots and maximum reliability structures like mlocarna
+ * --write-reliabilities. Profiles of single sequences are written one
+ * after the other, such that only one profile is kept in memory.
+ *
+ * This program is part of the LocARNA package.
+ *
+ ************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <cctype>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <LocARNA/options.hh>
+#include <LocARNA/aux.hh>
+#include <LocARNA/multiple_alignment.hh>
+#include <LocARNA/pfold_params.hh>
+#include <LocARNA/rna_data.hh>
+#include <LocARNA/reliability.hh>
+
+using namespace LocARNA;
+
+/**
+ * \brief Structure for command line parameters
+ *
+ * Encapsulating all command line parameters in a common structure
+ * avoids name conflicts and makes downstream code more informative.
+ *
+ */
+struct command_line_parameters {
+    bool help;              //!< whether to print help
+    bool version;           //!< whether to print version
+    bool bars;              //!< whether to print reliability bars
+    std::string pp_dir;     //!< directory of pp files of the sequences
+    std::string out_dir;    //!< output directory
+    std::string suffix;     //!< suffix of the consensus output files
+    double struct_weight;   //!< weight of arcs in max reliability structure
+    double threshold;       //!< threshold for strong pairs
+    std::string aln_file;   //!< alignment file
+    std::string bmprobs_dir; //!< directory of base match probabilities
+    std::string amprobs_dir; //!< directory of arc match probabilities
+};
+//! \brief holds command line parameters
+command_line_parameters clp;
+// longname,shortname,flag,arg_type,argument,default,argname,description
+//! defines command line parameters
+option_def my_options[] =
+    {{"help", 'h', &clp.help, O_NO_ARG, 0, O_NODEFAULT, "", "Help"},
+     {"version", 'V', &clp.version, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Version info"},
+     {"bars", 0, &clp.bars, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Print reliability bars of the consensus"},
+     {"pp-dir", 0, 0, O_ARG_STRING, &clp.pp_dir, "", "dir",
+      "Directory of the pp files of the sequences (named by normalized "
+      "names, like the input directory of mlocarna); if given, write "
+      "profiles of the single sequences"},
+     {"out-dir", 0, 0, O_ARG_STRING, &clp.out_dir, ".", "dir",
+      "Output directory"},
+     {"suffix", 0, 0, O_ARG_STRING, &clp.suffix, "", "suffix",
+      "Suffix of the names of the consensus output files (e.g. -cbt "
+      "for result.bmreliability-cbt, result.amreliability-cbt and "
+      "reldot-cbt.ps)"},
+     {"struct-weight", 0, 0, O_ARG_DOUBLE, &clp.struct_weight, "1", "f",
+      "Weight of arc reliabilities in maximum reliability structures"},
+     {"threshold", 0, 0, O_ARG_DOUBLE, &clp.threshold, "0.125", "f",
+      "Minimum reliability of pairs written as '()'"},
+     {"", 0, 0, O_ARG_STRING, &clp.aln_file, O_NODEFAULT, "aln-file",
+      "Alignment file"},
+     {"", 0, 0, O_ARG_STRING, &clp.bmprobs_dir, O_NODEFAULT, "bmprobs",
+      "Directory of base match probabilities"},
+     {"", 0, 0, O_ARG_STRING, &clp.amprobs_dir, O_NODEFAULT, "amprobs",
+      "Directory of arc match probabilities"},
+     {"", 0, 0, 0, 0, O_NODEFAULT, "", ""}};
+
+/**
+ * @brief Normalize sequence name like mlocarna
+ *
+ * @param name sequence name
+ * @param names already normalized names
+ *
+ * @return name of at most 16 alpha-numeric characters or '_' that
+ * does not occur in names
+ */
+std::string
+normalize_name(std::string name, const std::vector<std::string> &names) {
+    const size_t maxlen = 16;
+
+    for (auto &c : name) {
+        if (!std::isalnum((unsigned char)c)) {
+            c = '_';
+        }
+    }
+    name = name.substr(0, maxlen);
+
+    for (size_t i = 1;
+         std::find(names.begin(), names.end(), name) != names.end(); i++) {
+        std::string suffix = std::to_string(i);
+        name = name.substr(0, maxlen - suffix.length() - 1) + "_" + suffix;
+    }
+    return name;
+}
+
+/**
+ * @brief Open output file
+ * @param filename name of the file
+ * @return stream
+ */
+std::ofstream
+open_output(const std::string &filename) {
+    std::ofstream out(filename.c_str());
+    if (!out.is_open()) {
+        throw failure("Cannot open file " + filename + " for writing.");
+    }
+    return out;
+}
+
+/**
+ * @brief Write reliabilities and dot plot of a profile
+ *
+ * @param profile reliability profile
+ * @param prefix prefix of the file names
+ * @param suffix suffix of the file names of the reliabilities
+ * @param dotplot_file name of the dot plot file
+ * @param sequence sequence string of the dot plot
+ */
+void
+write_profile(const ReliabilityProfile &profile,
+              const std::string &prefix,
+              const std::string &suffix,
+              const std::string &dotplot_file,
+              const std::string &sequence) {
+    auto bm_out = open_output(prefix + ".bmreliability" + suffix);
+    profile.write_bm_reliabilities(bm_out);
+    auto am_out = open_output(prefix + ".amreliability" + suffix);
+    profile.write_am_reliabilities(am_out);
+    auto dp_out = open_output(dotplot_file);
+    profile.write_dotplot(dp_out, sequence);
+}
+
+/**
+ * \brief Main method of executable locarna_reliability
+ *
+ * @param argc argument counter
+ * @param argv argument vector
+ *
+ * @return success
+ */
+int
+main(int argc, char **argv) {
+    bool process_success = process_options(argc, argv, my_options);
+
+    if (clp.help) {
+        std::cout << "locarna_reliability -- compute reliability profiles "
+                     "of a multiple alignment"
+                  << std::endl;
+        print_help(argv[0], my_options);
+        return 0;
+    }
+
+    if (clp.version) {
+        std::cout << "locarna_reliability (" << PACKAGE_STRING << ")"
+                  << std::endl;
+        return 0;
+    }
+
+    if (!process_success) {
+        std::cerr << "ERROR --- " << O_error_msg << std::endl;
+        print_usage(argv[0], my_options);
+        return -1;
+    }
+
+    try {
+        MultipleAlignment ma(clp.aln_file);
+
+        std::vector<std::string> names;
+        for (size_t r = 0; r < ma.num_of_rows(); r++) {
+            names.push_back(normalize_name(ma.seqentry(r).name(), names));
+        }
+
+        MatchProbSets probs(ma.num_of_rows());
+        probs.read_base_match_probs(clp.bmprobs_dir, names);
+        probs.read_arc_match_probs(clp.amprobs_dir, names);
+
+        {
+            ReliabilityProfile profile(ma, probs);
+
+            auto rel_str =
+                profile.max_weight_structure(clp.struct_weight, clp.threshold)
+                    .second;
+            std::cout << "max. reliability   " << rel_str << std::endl;
+
+            if (clp.bars) {
+                profile.write_bars(std::cout);
+            }
+
+            write_profile(profile, clp.out_dir + "/result", clp.suffix,
+                          clp.out_dir + "/reldot" + clp.suffix + ".ps",
+                          ma.consensus_sequence());
+        }
+
+        if (clp.pp_dir != "") {
+            std::string single_dir = clp.out_dir + "/single_reliabilities";
+            mkdir(single_dir.c_str(), 0777);
+
+            PFoldParams pfoldparams;
+
+            for (size_t r = 0; r < ma.num_of_rows(); r++) {
+                RnaData rna_data(clp.pp_dir + "/" + names[r], 0, 0,
+                                 pfoldparams);
+
+                ReliabilityProfile::arc_reliabilities_t pair_probs;
+                const size_type len = rna_data.length();
+                for (pos_type i = 1; i <= len; i++) {
+                    for (pos_type j = i + 1; j <= len; j++) {
+                        double p = rna_data.arc_prob(i, j);
+                        if (p > 0) {
+                            pair_probs[{i, j}] = p;
+                        }
+                    }
+                }
+
+                ReliabilityProfile profile(ma, probs, r, pair_probs);
+
+                auto rel_str =
+                    profile
+                        .max_weight_structure(clp.struct_weight,
+                                              clp.threshold)
+                        .second;
+                std::string label = ma.seqentry(r).name();
+                label.resize(std::max<size_t>(label.length(), 18), ' ');
+                std::cout << label << " " << rel_str << std::endl;
+
+                write_profile(profile, single_dir + "/" + names[r], "",
+                              single_dir + "/" + names[r] + "_reldot.ps",
+                              ma.seqentry(r).seq().str());
+            }
+        }
+    } catch (failure &f) {
+        std::cerr << "ERROR: " << f.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -9,6 +9,12 @@
  *
  * locarna_rnafold_pp folds a sequence or multiple alignment using
  * partition function folding and writes the result in pp 2.0 format.
+ * Single sequences can be folded locally (like RNAplfold), which
+ * avoids quadratic memory for long sequences.
+ *
+ * In batch mode, the program folds all entries of a multi-FASTA file
+ * (or all alignment files in a directory) in parallel threads and
+ * writes one pp file per entry.
  *
  * This program is part of the LocARNA package. It is intended for
  * computing pair probabilities of the input sequences.
@@ -26,13 +32,24 @@
 #include <string.h>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include <LocARNA/options.hh>
 #include <LocARNA/multiple_alignment.hh>
 #include <LocARNA/pfold_params.hh>
+#include <LocARNA/folding_context.hh>
 #include <LocARNA/rna_ensemble.hh>
 #include <LocARNA/rna_data.hh>
 #include <LocARNA/ext_rna_data.hh>
+#include <LocARNA/parallel.hh>
 
 using namespace LocARNA;
 
@@ -51,6 +68,8 @@ struct command_line_parameters {
     bool use_struct_constraints; //!< -C use structural constraints
     bool no_lonely_pairs;        //!< no lonely pairs option
     int max_bp_span;             //!< maximum base pair span
+    int plfold_span;             //!< span for local folding
+    int plfold_winsize;          //!< window size for local folding
     bool stacking;               //!< whether to stacking
     int dangling;                //!< dangling option value
     bool in_loop;                //!< whether to compute in-loop probabilities
@@ -61,6 +80,9 @@ struct command_line_parameters {
                                             //!prob_basepait_in_loop
     std::string output_file;                //!< output file name
     bool force_alifold; //!< use alifold even for single sequences.
+    bool batch;         //!< batch mode
+    std::string output_dir; //!< output directory in batch mode
+    int threads;        //!< number of threads in batch mode
 };
 //! \brief holds command line parameters of locarna
 command_line_parameters clp;
@@ -77,6 +99,10 @@ option_def my_options[] =
       "No lonely pairs"},
      {"maxBPspan", 0, 0, O_ARG_INT, &clp.max_bp_span, "-1", "span",
       "Limit maximum base pair span (default=off)"},
+     {"plfold-span", 0, 0, O_ARG_INT, &clp.plfold_span, "-1", "span",
+      "Fold locally with maximum base pair span (default=off)"},
+     {"plfold-winsize", 0, 0, O_ARG_INT, &clp.plfold_winsize, "-1", "size",
+      "Window size for local folding (default=2*span)"},
      {"stacking", 0, &clp.stacking, O_NO_ARG, 0, O_NODEFAULT, "",
       "Compute stacking terms"},
      {"dangling", 0, 0, O_ARG_INT, &clp.dangling, "2", "",
@@ -96,9 +122,322 @@ option_def my_options[] =
       "Output file"},
      {"force-alifold", 0, &clp.force_alifold, O_NO_ARG, 0, O_NODEFAULT, "",
       "Force alifold for single sequences"},
+     {"batch", 0, &clp.batch, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Batch mode: fold each entry of a multi-FASTA input file or each "
+      "alignment file of an input directory"},
+     {"output-dir", 0, 0, O_ARG_STRING, &clp.output_dir, ".", "dir",
+      "Output directory for pp files in batch mode"},
+     {"threads", 0, 0, O_ARG_INT, &clp.threads, "1", "threads",
+      "Number of threads in batch mode"},
      {"", 0, 0, O_ARG_STRING, &clp.input_file, "-", "filename", "Input file"},
      {"", 0, 0, 0, 0, O_NODEFAULT, "", ""}};
 
+/**
+ * @brief Read sequence or multiple alignment
+ *
+ * Autodetects FASTA or CLUSTAL format.
+ *
+ * @param filename name of input file
+ * @param content content of the input if read from stdin (filename "-")
+ *
+ * @return multiple alignment; nullptr if reading fails
+ */
+std::unique_ptr<MultipleAlignment>
+read_input(const std::string &filename, const std::string &content) {
+    std::unique_ptr<MultipleAlignment> mseq;
+
+    for (auto format : {MultipleAlignment::FormatType::FASTA,
+                        MultipleAlignment::FormatType::CLUSTAL}) {
+        try {
+            if (filename.compare("-") != 0) {
+                mseq = std::make_unique<MultipleAlignment>(filename, format);
+            } else {
+                std::istringstream in(content);
+                mseq = std::make_unique<MultipleAlignment>(in, format);
+            }
+            // even if reading does not fail, we still want to
+            // make sure that the result is reasonable. Otherwise,
+            // we assume that the file is in a different format.
+            if (mseq->is_proper() && !mseq->empty()) {
+                return mseq;
+            }
+        } catch (failure &f) {
+            // try next format
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Prepare input for folding
+ *
+ * Drops structure constraints unless they are used.
+ *
+ * @param mseq sequence or alignment
+ * @param warn whether to warn about ignored constraints
+ *
+ * @return whether to use alifold
+ */
+bool
+prepare_input(MultipleAlignment &mseq, bool warn) {
+    if (mseq.has_annotation(MultipleAlignment::AnnoType::structure) &&
+        !clp.use_struct_constraints) {
+        if (warn) {
+            std::cerr << "Warning locarna_rnafold_pp: structure constraints "
+                         "will be ignored"
+                      << std::endl;
+        }
+        mseq.set_annotation(MultipleAlignment::AnnoType::structure,
+                            SequenceAnnotation());
+    }
+
+    // use alifold unless the input has only one sequence and alifold
+    // is not forced
+    return clp.force_alifold || mseq.num_of_rows() != 1;
+}
+
+/**
+ * @brief Fold and write pp output
+ *
+ * @param mseq sequence or alignment
+ * @param context folding context (holds the folding parameters)
+ * @param use_alifold whether to use alifold
+ * @param out output stream
+ */
+void
+fold_and_write(const MultipleAlignment &mseq,
+               FoldingContext &context,
+               bool use_alifold,
+               std::ostream &out) {
+    const PFoldParams &pfoldparams = context.params();
+    RnaEnsemble rna_ensemble(mseq, context, clp.in_loop, use_alifold);
+
+    if (clp.in_loop) {
+        ExtRnaData ext_rna_data(
+            rna_ensemble, clp.min_prob, clp.prob_basepair_in_loop_threshold,
+            clp.prob_unpaired_in_loop_threshold,
+            0, // don't filter output by max_bps_length_ratio
+            0, // don't filter output by max_uil_length_ratio
+            0, // don't filter output by max_bpil_length_ratio
+            pfoldparams);
+
+        if (clp.verbose && !clp.batch) {
+            ext_rna_data.write_size_info(std::cout);
+            std::cout << std::endl;
+        }
+
+        ext_rna_data.write_pp(out); // (no need to filter again => don't
+                                    // specify output cutoff)
+    } else {
+        RnaData rna_data(rna_ensemble, clp.min_prob,
+                         0, // don't filter output by max_bps_length_ratio
+                         pfoldparams);
+
+        if (clp.verbose && !clp.batch) {
+            rna_data.write_size_info(std::cout);
+            std::cout << std::endl;
+        }
+
+        rna_data.write_pp(out); // (no need to filter again => don't
+                                // specify output cutoff)
+    }
+}
+
+/**
+ * @brief File name for entry in batch mode
+ *
+ * @param name sequence or file name
+ *
+ * @return name, where special characters are replaced by '_',
+ * with suffix .pp
+ */
+std::string
+batch_output_filename(const std::string &name) {
+    std::string fname = name;
+    for (auto &c : fname) {
+        if (!isalnum(c) && c != '.' && c != '-') {
+            c = '_';
+        }
+    }
+    return clp.output_dir + "/" + fname + ".pp";
+}
+
+/**
+ * @brief Entry of batch mode
+ */
+struct batch_entry_t {
+    std::string name; //!< name of entry (determines output file)
+    std::unique_ptr<MultipleAlignment> mseq; //!< sequence or alignment
+};
+
+/**
+ * @brief Collect entries for batch mode
+ *
+ * @param entries[out] vector of entries
+ *
+ * If the input is a directory, each file is read as sequence or
+ * alignment; otherwise, each sequence of the (multi-FASTA) input is
+ * an entry.
+ *
+ * @return whether all entries could be read
+ */
+bool
+read_batch_entries(std::vector<batch_entry_t> &entries) {
+    struct stat st;
+    if (clp.input_file != "-" && stat(clp.input_file.c_str(), &st) == 0 &&
+        S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(clp.input_file.c_str());
+        if (dir == nullptr) {
+            std::cerr << "Cannot open directory " << clp.input_file
+                      << std::endl;
+            return false;
+        }
+        std::vector<std::string> filenames;
+        while (struct dirent *de = readdir(dir)) {
+            std::string filename = de->d_name;
+            if (filename[0] == '.') {
+                continue;
+            }
+            filenames.push_back(filename);
+        }
+        closedir(dir);
+
+        // process in deterministic order
+        std::sort(filenames.begin(), filenames.end());
+
+        bool ok = true;
+        for (const auto &filename : filenames) {
+            auto mseq = read_input(clp.input_file + "/" + filename, "");
+            if (!mseq) {
+                std::cerr << "Error in input format of " << filename
+                          << std::endl;
+                ok = false;
+                continue;
+            }
+            // strip extension for the entry name
+            entries.push_back(
+                {filename.substr(0, filename.find_last_of('.')),
+                 std::move(mseq)});
+        }
+        return ok;
+    }
+
+    std::unique_ptr<MultipleAlignment> mseq;
+    try {
+        if (clp.input_file != "-") {
+            mseq = std::make_unique<MultipleAlignment>(
+                clp.input_file, MultipleAlignment::FormatType::FASTA);
+        } else {
+            mseq = std::make_unique<MultipleAlignment>(
+                std::cin, MultipleAlignment::FormatType::FASTA);
+        }
+    } catch (failure &f) {
+        std::cerr << "Error in input format: " << f.what() << std::endl;
+        return false;
+    }
+
+    for (const auto &seqentry : *mseq) {
+        entries.push_back({seqentry.name(),
+                           std::make_unique<MultipleAlignment>(
+                               seqentry.name(), seqentry.seq().str())});
+    }
+    return true;
+}
+
+/**
+ * @brief Check that batch entries write to distinct files
+ *
+ * Distinct entry names can map to the same output file name (e.g.
+ * "a/1" and "a_1", or duplicate names); their outputs would overwrite
+ * each other.
+ *
+ * @param entries vector of entries
+ *
+ * @return whether all output file names are distinct
+ */
+bool
+check_batch_output_filenames(const std::vector<batch_entry_t> &entries) {
+    std::map<std::string, std::string> entry_of_filename;
+    bool ok = true;
+    for (const auto &entry : entries) {
+        std::string filename = batch_output_filename(entry.name);
+        auto res = entry_of_filename.insert({filename, entry.name});
+        if (!res.second) {
+            std::cerr << "Entries " << res.first->second << " and "
+                      << entry.name << " would both be written to "
+                      << filename << "." << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * @brief Fold all entries of the batch in parallel
+ *
+ * @param pfoldparams folding parameters
+ *
+ * @return exit code
+ */
+int
+run_batch(const PFoldParams &pfoldparams) {
+    std::vector<batch_entry_t> entries;
+    std::atomic<bool> ok(read_batch_entries(entries));
+
+    if (!check_batch_output_filenames(entries)) {
+        std::cerr << "ERROR --- output file names are not unique."
+                  << std::endl;
+        return -1;
+    }
+
+    std::mutex io_mutex;
+
+    size_t num_threads =
+        std::max(1, std::min(clp.threads, (int)entries.size()));
+
+    // since every RnaEnsemble owns its ViennaRNA fold compound,
+    // threads share only the (read-only) folding parameters. Each
+    // thread reuses the energy parameter tables of its own folding
+    // context.
+    std::vector<std::unique_ptr<FoldingContext>> contexts;
+    for (size_t t = 0; t < num_threads; t++) {
+        contexts.push_back(std::make_unique<FoldingContext>(pfoldparams));
+    }
+
+    parallel_for(entries.size(), num_threads, [&](size_t idx, size_t thread) {
+        auto &entry = entries[idx];
+        bool use_alifold = prepare_input(*entry.mseq, false);
+        std::string filename = batch_output_filename(entry.name);
+        try {
+            std::ofstream out(filename.c_str());
+            if (!out.is_open()) {
+                throw failure("Cannot open file " + filename +
+                              " for writing.");
+            }
+            fold_and_write(*entry.mseq, *contexts[thread], use_alifold, out);
+        } catch (std::exception &e) {
+            // catch all errors (failures as well as errors like
+            // bad_alloc) to report them per entry, such that the
+            // other entries are still folded
+            std::lock_guard<std::mutex> lock(io_mutex);
+            std::cerr << "ERROR --- " << entry.name << ": " << e.what()
+                      << std::endl;
+            ok = false;
+            entry.mseq.reset();
+            return;
+        }
+        if (clp.verbose) {
+            std::lock_guard<std::mutex> lock(io_mutex);
+            std::cout << entry.name << " -> " << filename << std::endl;
+        }
+        // free memory of processed entry
+        entry.mseq.reset();
+    });
+
+    return ok ? 0 : -1;
+}
+
 /**
  * \brief Main function of locarna_rnafold_pp when Vienna RNA lib is linked
  */
@@ -133,6 +472,42 @@ main(int argc, char **argv) {
         return -1;
     }
 
+    // local folding
+    int max_bp_span = clp.max_bp_span;
+    int window_size = -1;
+    if (clp.plfold_span > 0) {
+        if (clp.force_alifold) {
+            std::cerr << "Local folding is not supported for alignments."
+                      << std::endl;
+            return -1;
+        }
+        if (clp.in_loop) {
+            std::cerr << "Cannot compute in-loop probabilities with local "
+                         "folding."
+                      << std::endl;
+            return -1;
+        }
+        window_size =
+            clp.plfold_winsize > 0 ? clp.plfold_winsize : 2 * clp.plfold_span;
+        if (max_bp_span < 0 || clp.plfold_span < max_bp_span) {
+            max_bp_span = clp.plfold_span;
+        }
+    } else if (clp.plfold_winsize > 0) {
+        std::cerr << "Warning locarna_rnafold_pp: window size given, but no "
+                     "span. Window size ignored."
+                  << std::endl;
+    }
+
+    PFoldParams pfoldparams(PFoldParams::args::noLP(clp.no_lonely_pairs),
+                            PFoldParams::args::stacking(clp.stacking),
+                            PFoldParams::args::max_bp_span(max_bp_span),
+                            PFoldParams::args::window_size(window_size),
+                            PFoldParams::args::dangling(clp.dangling));
+
+    if (clp.batch) {
+        return run_batch(pfoldparams);
+    }
+
     // Reading from stdinput with autodetect of file format works by copying the
     // entire stdinput
     // to memory. Then, autodetection can work on this copy.
@@ -146,89 +521,22 @@ main(int argc, char **argv) {
         stdin_content = stdin.str();
     }
 
-    // todo: check that input is proper and catch the wrong inputs
-    // MultipleAlignment::FormatType::type input_format;
-    MultipleAlignment *mseq = NULL;
-    // try fasta format
-    bool failed = false;
-    try {
-        if (clp.input_file.compare("-") != 0) {
-            mseq = new MultipleAlignment(clp.input_file,
-                                         MultipleAlignment::FormatType::FASTA);
-        } else {
-            std::istringstream in(stdin_content);
-            mseq =
-                new MultipleAlignment(in, MultipleAlignment::FormatType::FASTA);
-        }
-        // even if reading does not fail, we still want to
-        // make sure that the result is reasonable. Otherwise,
-        // we assume that the file is in a different format.
-        if (!mseq->is_proper() || mseq->empty()) {
-            failed = true;
-        }
-    } catch (failure &f) {
-        failed = true;
-        //      std::cerr << "Not a FASTA file" << std::endl;
-        //      std::cerr << f.what() << std::endl;
-    }
+    std::unique_ptr<MultipleAlignment> mseq =
+        read_input(clp.input_file, stdin_content);
 
-    if (!failed) {
-        // input_format = MultipleAlignment::FormatType::FASTA;
-    } else { //
-        failed = false;
-        try {
-            try {
-                // std::cerr << "Try reading clustal "<<filename<<"
-                // ..."<<std::endl;
-                if (clp.input_file.compare("-") != 0) {
-                    mseq = new MultipleAlignment(
-                        clp.input_file, MultipleAlignment::FormatType::CLUSTAL);
-                } else {
-                    std::stringstream in(stdin_content);
-                    mseq = new MultipleAlignment(
-                        in, MultipleAlignment::FormatType::CLUSTAL);
-
-                    // make sure that the result is reasonable. Otherwise,
-                }
-                // even if reading does not fail, we still want to
-                // we assume that the file is in a different format.
-                if (!mseq->is_proper() || mseq->empty()) {
-                    failed = true;
-                }
-            } catch (syntax_error_failure &f) {
-                throw failure((std::string)"Cannot read input data from clustal file.\n\t"+f.what());
-            }
-        } catch (failure &f) {
-            failed = true;
-            //          std::cerr << f.what() << std::endl;
-        }
-        if (failed) {
-            std::cerr << "Error in input format" << std::endl;
-            return -1;
-        }
+    if (!mseq) {
+        std::cerr << "Error in input format" << std::endl;
+        return -1;
     }
 
-    bool use_alifold = true;
+    bool use_alifold = prepare_input(*mseq, true);
 
-    // if the input has only one sequence and forced to do alifold
-    if (!clp.force_alifold && mseq->num_of_rows() == 1)
-        use_alifold = false;
-    if (mseq->has_annotation(MultipleAlignment::AnnoType::structure) &&
-        !clp.use_struct_constraints) {
-        std::cerr << "Warning locarna_rnafold_pp: structure constraints will "
-                     "be ignored"
+    if (use_alifold && pfoldparams.local_folding()) {
+        std::cerr << "Local folding is not supported for alignments."
                   << std::endl;
-        mseq->set_annotation(MultipleAlignment::AnnoType::structure,
-                             SequenceAnnotation());
+        return -1;
     }
 
-    PFoldParams pfoldparams(PFoldParams::args::noLP(clp.no_lonely_pairs),
-                            PFoldParams::args::stacking(clp.stacking),
-                            PFoldParams::args::max_bp_span(clp.max_bp_span),
-                            PFoldParams::args::dangling(clp.dangling));
-
-    RnaEnsemble rna_ensemble(*mseq, pfoldparams, clp.in_loop, use_alifold);
-
     // write pp file
 
     // set the appropriate ostream from input_file or std::cout
@@ -242,35 +550,8 @@ main(int argc, char **argv) {
     }
     std::ostream out_stream(buff);
 
-    if (clp.in_loop) {
-        ExtRnaData ext_rna_data(
-            rna_ensemble, clp.min_prob, clp.prob_basepair_in_loop_threshold,
-            clp.prob_unpaired_in_loop_threshold,
-            0, // don't filter output by max_bps_length_ratio
-            0, // don't filter output by max_uil_length_ratio
-            0, // don't filter output by max_bpil_length_ratio
-            pfoldparams);
-
-        if (clp.verbose) {
-            ext_rna_data.write_size_info(std::cout);
-            std::cout << std::endl;
-        }
-
-        ext_rna_data.write_pp(out_stream); // (no need to filter again => don't
-                                           // specify output cutoff)
-    } else {
-        RnaData rna_data(rna_ensemble, clp.min_prob,
-                         0, // don't filter output by max_bps_length_ratio
-                         pfoldparams);
-
-        if (clp.verbose) {
-            rna_data.write_size_info(std::cout);
-            std::cout << std::endl;
-        }
-
-        rna_data.write_pp(out_stream); // (no need to filter again => don't
-                                       // specify output cutoff)
-    }
+    FoldingContext context(pfoldparams);
+    fold_and_write(*mseq, context, use_alifold, out_stream);
 
     return 0;
 }
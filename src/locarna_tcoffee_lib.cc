@@ -0,0 +1,244 @@
+/************************************************************
+ *
+ * \file locarna_tcoffee_lib.cc
+ * \brief Build (extended) T-Coffee libraries from pairwise alignments.
+ *
+ * Reads pairwise alignments in (extended) clustal format, as written
+ * by locarna and mlocarna, from the files given in a list file, and
+ * writes the T-Coffee primary library of these alignments, like
+ * locarnate. Optionally, the library is extended by triplet
+ * consistency before writing. Sequences are numbered in the
+ * alphanumeric order of their names.
+ *
+ * This program is part of the LocARNA package.
+ *
+ ************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <algorithm>
+
+#include <LocARNA/options.hh>
+#include <LocARNA/aux.hh>
+#include <LocARNA/multiple_alignment.hh>
+#include <LocARNA/tcoffee_library.hh>
+
+using namespace LocARNA;
+
+/**
+ * \brief Structure for command line parameters
+ *
+ * Encapsulating all command line parameters in a common structure
+ * avoids name conflicts and makes downstream code more informative.
+ *
+ */
+struct command_line_parameters {
+    bool help;              //!< whether to print help
+    bool version;           //!< whether to print version
+    bool extend;            //!< whether to extend the library
+    bool binary;            //!< whether to write in binary format
+    int threads;            //!< number of threads
+    std::string weight;     //!< type of match weights
+    std::string output;     //!< output file
+    std::string aln_list;   //!< file listing the alignment files
+};
+//! \brief holds command line parameters
+command_line_parameters clp;
+// longname,shortname,flag,arg_type,argument,default,argname,description
+//! defines command line parameters
+option_def my_options[] =
+    {{"help", 'h', &clp.help, O_NO_ARG, 0, O_NODEFAULT, "", "Help"},
+     {"version", 'V', &clp.version, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Version info"},
+     {"extend", 0, &clp.extend, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Extend the library by triplet consistency"},
+     {"threads", 0, 0, O_ARG_INT, &clp.threads, "0", "int",
+      "Number of threads for extension (0: number of cores)"},
+     {"weight", 0, 0, O_ARG_STRING, &clp.weight, "score", "type",
+      "Weight of the matches of an alignment: 'score' (alignment score "
+      "from the clustal header; negative scores count 0) or 'identity' "
+      "(percent identity)"},
+     {"binary", 0, &clp.binary, O_NO_ARG, 0, O_NODEFAULT, "",
+      "Write the library in binary format"},
+     {"output", 'o', 0, O_ARG_STRING, &clp.output, "-", "file",
+      "Output file ('-': standard output)"},
+     {"", 0, 0, O_ARG_STRING, &clp.aln_list, O_NODEFAULT, "aln-list",
+      "File listing the pairwise alignment files, one per line ('-': "
+      "standard input)"},
+     {"", 0, 0, 0, 0, O_NODEFAULT, "", ""}};
+
+/**
+ * @brief Weight of a pairwise alignment
+ *
+ * @param file alignment file
+ * @param ma alignment read from file
+ *
+ * @return weight according to clp.weight
+ */
+double
+alignment_weight(const std::string &file, const MultipleAlignment &ma) {
+    if (clp.weight == "identity") {
+        const string1 &seqA = ma.seqentry(0).seq();
+        const string1 &seqB = ma.seqentry(1).seq();
+        size_t matches = 0;
+        size_t identities = 0;
+        for (size_t col = 1; col <= ma.length(); col++) {
+            if (!is_gap_symbol(seqA[col]) && !is_gap_symbol(seqB[col])) {
+                matches++;
+                identities += (seqA[col] == seqB[col]);
+            }
+        }
+        return matches == 0 ? 0 : 100.0 * identities / matches;
+    }
+
+    std::ifstream in(file.c_str());
+    std::string header;
+    std::getline(in, header);
+    size_t pos = header.find("Score: ");
+    if (pos == std::string::npos) {
+        throw failure("Cannot extract score from " + file + ".");
+    }
+    std::istringstream score_in(header.substr(pos + 7));
+    double score;
+    if (!(score_in >> score)) {
+        // e.g. -inf for failed alignments
+        score = 0;
+    }
+    return std::max(score, 0.0);
+}
+
+/**
+ * \brief Main method of executable locarna_tcoffee_lib
+ *
+ * @param argc argument counter
+ * @param argv argument vector
+ *
+ * @return success
+ */
+int
+main(int argc, char **argv) {
+    bool process_success = process_options(argc, argv, my_options);
+
+    if (clp.help) {
+        std::cout << "locarna_tcoffee_lib -- build (extended) T-Coffee "
+                     "libraries from pairwise alignments"
+                  << std::endl;
+        print_help(argv[0], my_options);
+        return 0;
+    }
+
+    if (clp.version) {
+        std::cout << "locarna_tcoffee_lib (" << PACKAGE_STRING << ")"
+                  << std::endl;
+        return 0;
+    }
+
+    if (!process_success) {
+        std::cerr << "ERROR --- " << O_error_msg << std::endl;
+        print_usage(argv[0], my_options);
+        return -1;
+    }
+
+    if (clp.weight != "score" && clp.weight != "identity") {
+        std::cerr << "ERROR --- unknown weight type " << clp.weight
+                  << std::endl;
+        print_usage(argv[0], my_options);
+        return -1;
+    }
+
+    try {
+        std::vector<std::string> files;
+        {
+            std::ifstream list_file;
+            if (clp.aln_list != "-") {
+                list_file.open(clp.aln_list.c_str());
+                if (!list_file.is_open()) {
+                    throw failure("Cannot open file " + clp.aln_list +
+                                  " for reading.");
+                }
+            }
+            std::istream &list = clp.aln_list != "-" ? list_file : std::cin;
+            std::string file;
+            while (list >> file) {
+                files.push_back(file);
+            }
+        }
+
+        std::vector<MultipleAlignment> alignments;
+        std::vector<double> weights;
+        std::map<std::string, std::string> sequences;
+        for (const auto &file : files) {
+            alignments.emplace_back(file);
+            const auto &ma = alignments.back();
+            if (ma.num_of_rows() != 2) {
+                throw failure("File " + file +
+                              " is not a pairwise alignment.");
+            }
+            weights.push_back(alignment_weight(file, ma));
+
+            for (size_t r = 0; r < 2; r++) {
+                std::string seq = ma.seqentry(r).seq().str();
+                seq.erase(
+                    std::remove_if(seq.begin(), seq.end(), is_gap_symbol),
+                    seq.end());
+                auto it = sequences.insert({ma.seqentry(r).name(), seq});
+                if (it.first->second != seq) {
+                    throw failure("Sequence " + ma.seqentry(r).name() +
+                                  " differs between alignments.");
+                }
+            }
+        }
+
+        // std::map orders the sequences by name
+        std::vector<std::string> names;
+        std::vector<std::string> seqs;
+        for (const auto &x : sequences) {
+            names.push_back(x.first);
+            seqs.push_back(x.second);
+        }
+
+        TCoffeeLibrary lib(names, seqs);
+        for (size_t k = 0; k < alignments.size(); k++) {
+            lib.add_alignment(alignments[k], weights[k]);
+        }
+
+        if (clp.extend) {
+            size_t threads = clp.threads > 0
+                ? clp.threads
+                : std::max(1u, std::thread::hardware_concurrency());
+            lib = lib.extend(threads);
+        }
+
+        std::ofstream out_file;
+        if (clp.output != "-") {
+            out_file.open(clp.output.c_str(),
+                          clp.binary ? std::ios::out | std::ios::binary
+                                     : std::ios::out);
+            if (!out_file.is_open()) {
+                throw failure("Cannot open file " + clp.output +
+                              " for writing.");
+            }
+        }
+        std::ostream &out = clp.output != "-" ? out_file : std::cout;
+
+        if (clp.binary) {
+            lib.write_binary(out);
+        } else {
+            lib.write(out);
+        }
+    } catch (failure &f) {
+        std::cerr << "ERROR: " << f.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
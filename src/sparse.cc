@@ -26,6 +26,7 @@
 #include "LocARNA/trace_controller.hh"
 #include "LocARNA/multiple_alignment.hh"
 #include "LocARNA/sparsification_mapper.hh"
+#include "LocARNA/sparse_sequence_index.hh"
 #include "LocARNA/global_stopwatch.hh"
 #include "LocARNA/pfold_params.hh"
 #include "LocARNA/main_helper.icc"
@@ -72,6 +73,8 @@ struct command_line_parameters
 
     bool special_gap_symbols; //!< whether to use special gap
                               //! symbols in the alignment result
+
+    int threads; //!< number of threads for the alignment computation
 };
 
 //! \brief holds command line parameters of locarna
@@ -165,6 +168,8 @@ option_def my_options[] = {
      "sparsification"},
     {"stopwatch", 0, &clp.stopwatch, O_NO_ARG, 0, O_NODEFAULT, "",
      clp.help_text["stopwatch"]},
+    {"threads", 0, 0, O_ARG_INT, &clp.threads, "1", "threads",
+     "Number of threads for aligning the loops of arc matches"},
 
     {"", 0, 0, O_SECTION, 0, O_NODEFAULT, "",
      "Heuristics for speed accuracy trade off"},
@@ -589,6 +594,9 @@ run_and_report() {
     // construct set of relevant arc matches
     //
     std::unique_ptr<ArcMatches> arc_matches;
+    // sparsification data of the sequences
+    std::unique_ptr<SparseSequenceIndex> indexA;
+    std::unique_ptr<SparseSequenceIndex> indexB;
 
     // ------------------------------------------------------------
     // handle reading and writing of arcmatch_scores
@@ -611,16 +619,22 @@ run_and_report() {
                                      : std::max(lenA, lenB),
             trace_controller, seq_constraints);
     } else {
-        // initialize from RnaData
-        arc_matches =
-            std::make_unique<ArcMatches>(*rna_dataA.get(), *rna_dataB.get(),
-                                         clp.min_prob, clp.max_diff_am != -1
-                                             ? (size_type)clp.max_diff_am
-                                             : std::max(lenA, lenB),
-                                         clp.max_diff_at_am != -1
-                                             ? (size_type)clp.max_diff_at_am
-                                             : std::max(lenA, lenB),
-                                         trace_controller, seq_constraints);
+        // initialize from the sparsification data of each sequence, which
+        // provides the base pairs
+        indexA = std::make_unique<SparseSequenceIndex>(
+            *rna_dataA, clp.min_prob, clp.prob_unpaired_in_loop_threshold,
+            clp.prob_basepair_in_loop_threshold, true);
+        indexB = std::make_unique<SparseSequenceIndex>(
+            *rna_dataB, clp.min_prob, clp.prob_unpaired_in_loop_threshold,
+            clp.prob_basepair_in_loop_threshold, true);
+
+        arc_matches = std::make_unique<ArcMatches>(
+            indexA->base_pairs(), indexB->base_pairs(),
+            clp.max_diff_am != -1 ? (size_type)clp.max_diff_am
+                                  : std::max(lenA, lenB),
+            clp.max_diff_at_am != -1 ? (size_type)clp.max_diff_at_am
+                                     : std::max(lenA, lenB),
+            trace_controller, seq_constraints);
     }
 
     const BasePairs &bpsA = arc_matches->get_base_pairsA();
@@ -631,13 +645,23 @@ run_and_report() {
     if (clp.verbose)
         MainHelper::report_input(seqA, seqB, *arc_matches);
 
-    // construct sparsification mapper for seqs A,B
-    SparsificationMapper mapperA(bpsA, *rna_dataA.get(),
-                                 clp.prob_unpaired_in_loop_threshold,
-                                 clp.prob_basepair_in_loop_threshold, true);
-    SparsificationMapper mapperB(bpsB, *rna_dataB.get(),
-                                 clp.prob_unpaired_in_loop_threshold,
-                                 clp.prob_basepair_in_loop_threshold, true);
+    // construct sparsification mapper for seqs A,B, unless given by the
+    // sparsification data of the sequences (the base pairs of read arc
+    // match scores differ)
+    std::unique_ptr<SparsificationMapper> read_mapperA;
+    std::unique_ptr<SparsificationMapper> read_mapperB;
+    if (!indexA) {
+        read_mapperA = std::make_unique<SparsificationMapper>(
+            bpsA, *rna_dataA, clp.prob_unpaired_in_loop_threshold,
+            clp.prob_basepair_in_loop_threshold, true);
+        read_mapperB = std::make_unique<SparsificationMapper>(
+            bpsB, *rna_dataB, clp.prob_unpaired_in_loop_threshold,
+            clp.prob_basepair_in_loop_threshold, true);
+    }
+    const SparsificationMapper &mapperA =
+        indexA ? indexA->mapper() : *read_mapperA;
+    const SparsificationMapper &mapperB =
+        indexB ? indexB->mapper() : *read_mapperB;
 
     // ------------------------------------------------------------
     // Sequence match probabilities (for MEA-Alignment)
@@ -756,7 +780,8 @@ run_and_report() {
                                                clp.new_stacking),
                        AlignerParams::constraints(&seq_constraints),
                        AlignerNParams::sparsification_mapperA(&mapperA),
-                       AlignerNParams::sparsification_mapperB(&mapperB)));
+                       AlignerNParams::sparsification_mapperB(&mapperB),
+                       AlignerNParams::threads(clp.threads)));
 
     infty_score_t score;
 